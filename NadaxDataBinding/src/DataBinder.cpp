@@ -29,6 +29,10 @@
 #include "exception.h"
 #include "log.h"
 
+// Size of the chunks of the arena for
+// data rules keep until the binder is reset
+#define BINDER_ARENA_CHUNK_SIZE  4096
+
 
 namespace binding {
 
@@ -39,7 +43,110 @@ public:
     virtual ~BindingException() { }
 };
 
-DataBinder::DataBinder() {
+const char* Attributes::get(const char* name, const char* defaultValue) const {
+
+	for (int i = 0; m_attribs[i]; i += 2)
+		if (strcmp(m_attribs[i], name) == 0)
+			return m_attribs[i + 1];
+
+	return defaultValue;
+}
+
+int Attributes::size() const {
+
+	int i = 0;
+	while (m_attribs[i * 2])
+		i++;
+
+	return i;
+}
+
+void Attributes::copyTo(std::map<std::string, std::string>& attribMap) const {
+
+	for (int i = 0; m_attribs[i]; i += 2)
+		attribMap.insert(std::pair<std::string, std::string>(m_attribs[i], m_attribs[i + 1]));
+}
+
+
+DataBinderRules::DataBinderRules() {
+}
+
+DataBinderRules::DataBinderRules(const DataBinderRules& rules)
+	: m_beginRules(rules.m_beginRules), m_endRules(rules.m_endRules) {
+
+	for (size_t i = 0; i < rules.m_patterns.size(); i++) {
+
+		const std::pair<bool, int>& pattern = rules.m_patterns[i];
+
+		m_patterns.push_back(pattern);
+		m_automaton.add(pattern.first ? m_endRules[pattern.second].path.str() : m_beginRules[pattern.second].path.str());
+	}
+}
+
+void DataBinderRules::addBeginRule(const char* pathStr, BeginElementCallback callback) {
+
+	m_beginRules.push_back(BeginRule(pathStr, callback));
+	m_patterns.push_back(std::make_pair(false, (int) m_beginRules.size() - 1));
+	m_automaton.add(pathStr);
+}
+
+void DataBinderRules::addBeginRule(const char* pathStr, BeginElementViewCallback callback) {
+
+	m_beginRules.push_back(BeginRule(pathStr, callback));
+	m_patterns.push_back(std::make_pair(false, (int) m_beginRules.size() - 1));
+	m_automaton.add(pathStr);
+}
+
+void DataBinderRules::addEndRule(const char* pathStr, EndElementCallback callback) {
+
+	m_endRules.push_back(EndRule(pathStr, callback, (int) m_endRules.size()));
+	m_patterns.push_back(std::make_pair(true, (int) m_endRules.size() - 1));
+	m_automaton.add(pathStr);
+}
+
+void DataBinderRules::compile() {
+
+	m_automaton.compile();
+
+	int numStates = m_automaton.getNumStates();
+
+	m_beginMatches.assign(numStates, std::vector<BeginRule*>());
+	m_endMatches.assign(numStates, std::vector<EndRule*>());
+
+	for (int state = 0; state < numStates; state++) {
+
+		const std::vector<int>& matches = m_automaton.getMatches(state);
+
+		for (size_t i = 0; i < matches.size(); i++) {
+
+			std::pair<bool, int>& pattern = m_patterns[matches[i]];
+
+			if (pattern.first)
+				m_endMatches[state].push_back(&m_endRules[pattern.second]);
+			else
+				m_beginMatches[state].push_back(&m_beginRules[pattern.second]);
+		}
+	}
+
+	TRACE("Compiled %d binding rules to %d states.", m_patterns.size(), numStates);
+}
+
+void DataBinderRules::debug() {
+
+	std::cout << "  Begin Rules: " << std::endl;
+	for (std::deque<BeginRule>::iterator i = m_beginRules.begin(); i != m_beginRules.end(); i++)
+		std::cout << "    Trigger On: " << i->path << std::endl;
+
+	std::cout << std::endl << "  End Rules: " << std::endl;
+	for (std::deque<EndRule>::iterator i = m_endRules.begin(); i != m_endRules.end(); i++)
+		std::cout << "    Trigger On: " << i->path << std::endl;
+
+	if (m_automaton.isCompiled())
+		std::cout << std::endl << "  Compiled to " << m_automaton.getNumStates() << " states" << std::endl;
+}
+
+
+DataBinder::DataBinder() : m_arena(BINDER_ARENA_CHUNK_SIZE), m_rules(new DataBinderRules()) {
 
     m_binding = false;
     
@@ -47,6 +154,11 @@ DataBinder::DataBinder() {
     m_addTextToBody = true;
     m_bodyIsCData = false;
 
+    m_skipUnbound = false;
+    m_bindOnce = false;
+    m_complete = false;
+    m_unfiredRules = 0;
+
     m_root = NULL;
 }
 
@@ -77,14 +189,20 @@ bool DataBinder::lock() {
 void DataBinder::reset() {
 
 	m_path.reset();
+	m_states.clear();
 
     m_body.clear();
-    m_body.str("");
 
     m_trimBody = true;
     m_addTextToBody = true;
     m_bodyIsCData = false;
 
+    m_complete = false;
+    m_boundStates.clear();
+    m_firedRules.clear();
+
+    m_arena.reset();
+
     m_root = NULL;
     m_variables.clear();
     
@@ -94,22 +212,52 @@ void DataBinder::reset() {
     }
 }
 
+DataBinderRules* DataBinder::getMutableRules() {
+
+	// Compiled rules may be shared so rules are
+	// added to a copy that is compiled once used
+	if (m_rules->isCompiled() || !m_rules.unique())
+		m_rules = DataBinderRulesPtr(new DataBinderRules(*m_rules));
+
+	return m_rules.get();
+}
+
 void DataBinder::addBeginRule(const char* pathStr, BeginElementCallback callback) {
 
-	Path path(pathStr);
-	std::list<BeginRule>* rules = &m_beginRules[path.leaf()];
-	rules->push_back(BeginRule(pathStr, callback));
+	getMutableRules()->addBeginRule(pathStr, callback);
+}
+
+void DataBinder::addBeginRule(const char* pathStr, BeginElementViewCallback callback) {
+
+	getMutableRules()->addBeginRule(pathStr, callback);
 }
 
 void DataBinder::addEndRule(const char* pathStr, EndElementCallback callback) {
 
-	Path path(pathStr);
-	std::list<EndRule>* rules = &m_endRules[path.leaf()];
-	rules->push_back(EndRule(pathStr, callback));
+	getMutableRules()->addEndRule(pathStr, callback);
+}
+
+DataBinderRulesPtr DataBinder::getRules() {
+
+	if (!m_rules->isCompiled())
+		m_rules->compile();
+
+	return m_rules;
+}
+
+void DataBinder::setRules(DataBinderRulesPtr rules) {
+
+	if (!rules->isCompiled())
+		rules->compile();
+
+	m_rules = rules;
 }
 
 void DataBinder::startElement(const char* name, const char** attribs) {
 
+	if (m_complete)
+		return;
+
 	const char* elemName = strchr(name, ':');
 	elemName = (elemName ? elemName + 1 : name);
 
@@ -118,168 +266,188 @@ void DataBinder::startElement(const char* name, const char** attribs) {
     TRACE("Begin parsing Element at path: %s", m_path.str());
 
     m_body.clear();
-    m_body.str("");
 
-    if (!m_path.isTagged())
-    {
-    	std::ostringstream attribPath;
-    	std::string attribPathName;
-        std::map<std::string, std::string> attribMap;
+    if (!m_rules->isCompiled())
+    	m_rules->compile();
 
-		const char* attribName;
-		const char* attribValue;
+    int state = m_rules->next(m_states.empty() ? m_rules->getStart() : m_states.back(), elemName);
+    m_states.push_back(state);
 
-		for (int i = 0; attribs[i]; i += 2) {
+    // Elements of a path that was already bound are skipped
+    if (m_bindOnce && !m_path.isTagged() && this->isBound(state))
+    	m_path.tag(1);
 
-    		attribName = attribs[i];
-    		attribValue = attribs[i + 1];
+    if (m_path.isTagged())
+    	return;
 
-    		attribMap.insert(std::pair<std::string, std::string>(attribName, attribValue));
-		}
+    // The attribute map is only built if a rule
+    // that takes the attributes as a map fires
+    Attributes attribView(attribs);
+    std::map<std::string, std::string> attribMap;
+
+    const std::vector<BeginRule*>& rules = m_rules->getBeginRules(state);
+    if (!rules.empty())
+    	this->beginRules(rules, elemName, attribView, attribMap);
+
+    if (!m_rules->hasAttributeRules(state))
+    	return;
+
+    const char* attribName;
+    const char* attribValue;
+
+    for (int i = 0; attribs[i]; i += 2) {
+
+    	attribName = attribs[i];
+    	attribValue = attribs[i + 1];
+
+    	int attribState = m_rules->nextAttribute(state, attribName);
 
-    	if (m_beginRules.find(elemName) != m_beginRules.end()) {
+    	const std::vector<BeginRule*>& attribBeginRules = m_rules->getBeginRules(attribState);
+    	const std::vector<EndRule*>& attribEndRules = m_rules->getEndRules(attribState);
 
-        	std::list<BeginRule>* rules = &m_beginRules[elemName];
-        	std::list<BeginRule>::iterator end = rules->end();
+    	if (attribBeginRules.empty() && attribEndRules.empty())
+    		continue;
+    	if (m_bindOnce && this->isBound(attribState))
+    		continue;
 
-        	for (std::list<BeginRule>::iterator rule = rules->begin(); rule != end; rule++) {
+    	m_attribPath = '@';
+    	m_attribPath += attribName;
+    	m_path.push(m_attribPath.c_str());
 
-    			m_rulePath = &rule->path;
-        		if (m_path == *m_rulePath) {
-        			TRACE("Triggering begin binding handler for: %s", m_path.str());
-        			rule->callback(this, elemName, attribMap);
-        		}
-    			m_rulePath = NULL;
-        	}
+    	if (!attribBeginRules.empty())
+    		this->beginRules(attribBeginRules, attribName, attribView, attribMap);
+
+    	for (std::vector<EndRule*>::const_iterator rule = attribEndRules.begin(); rule != attribEndRules.end(); rule++) {
+
+    		m_rulePath = &(*rule)->path;
+    		TRACE("Triggering end binding handler for attribute path: %s with value %s", m_path.str(), attribValue);
+    		(*rule)->callback(this, attribName, attribValue);
+    		m_rulePath = NULL;
     	}
 
-		for (int i = 0; attribs[i]; i += 2) {
-            
-            attribName = attribs[i];
-            attribValue = attribs[i + 1];
+    	if (m_bindOnce)
+    		this->setBound(attribState, attribEndRules);
 
-    		attribPath << '@' << attribName;
-    		attribPathName = attribPath.str();
-    		m_path.push(attribPathName.c_str());
+    	m_path.pop();
+    }
+}
 
-    		if (m_beginRules.find(attribPathName) != m_beginRules.end()) {
+void DataBinder::beginRules(const std::vector<BeginRule*>& rules, const char* name,
+	const Attributes& attribs, std::map<std::string, std::string>& attribMap) {
 
-        		std::list<BeginRule>* rules = &m_beginRules[attribPathName];
-            	std::list<BeginRule>::iterator end = rules->end();
+	for (std::vector<BeginRule*>::const_iterator rule = rules.begin(); rule != rules.end(); rule++) {
 
-            	for (std::list<BeginRule>::iterator rule = rules->begin(); rule != end; rule++) {
+		m_rulePath = &(*rule)->path;
+		TRACE("Triggering begin binding handler for: %s", m_path.str());
 
-        			m_rulePath = &rule->path;
-            		if (m_path == *m_rulePath) {
-            		    TRACE("Triggering begin binding handler for attribute path: %s with value %s", m_path.str(), attribValue);
-            			rule->callback(this, attribName, attribMap);
-            		}
-        			m_rulePath = NULL;
-            	}
-    		}
+		if ((*rule)->viewCallback) {
 
-    		if (m_endRules.find(attribPathName) != m_endRules.end()) {
+			(*rule)->viewCallback(this, name, attribs);
 
-        		std::list<EndRule>* rules = &m_endRules[attribPathName];
-            	std::list<EndRule>::iterator end = rules->end();
+		} else {
 
-            	for (std::list<EndRule>::iterator rule = rules->begin(); rule != end; rule++) {
+			if (attribMap.empty())
+				attribs.copyTo(attribMap);
 
-        			m_rulePath = &rule->path;
-            		if (m_path == *m_rulePath) {
-            		    TRACE("Triggering end binding handler for attribute path: %s with value %s", m_path.str(), attribValue);
-            			rule->callback(this, attribName, attribValue);
-            		}
-        			m_rulePath = NULL;
-            	}
-    		}
+			(*rule)->callback(this, name, attribMap);
+		}
 
-    		m_path.pop();
-    		attribPath.clear();
-    		attribPath.str("");
-    	}
-    }
+		m_rulePath = NULL;
+	}
+}
+
+bool DataBinder::isBound(int state) {
+
+	if (m_boundStates.empty()) {
+
+		m_boundStates.assign(m_rules->getNumStates(), 0);
+		m_firedRules.assign(m_rules->getNumEndRules(), 0);
+		m_unfiredRules = m_rules->getNumEndRules();
+	}
+
+	return m_boundStates[state] != 0;
+}
+
+void DataBinder::setBound(int state, const std::vector<EndRule*>& rules) {
+
+	m_boundStates[state] = 1;
+
+	for (std::vector<EndRule*>::const_iterator rule = rules.begin(); rule != rules.end(); rule++) {
+
+		if (!m_firedRules[(*rule)->id]) {
+
+			m_firedRules[(*rule)->id] = 1;
+			m_unfiredRules--;
+		}
+	}
+
+	if (m_unfiredRules == 0) {
+
+		TRACE("All binding rules have fired at path: %s", m_path.str());
+		m_complete = true;
+	}
 }
 
 void DataBinder::endElement(const char* name) {
 
+	if (m_complete)
+		return;
+
 	const char* elemName = strchr(name, ':');
 	elemName = (elemName ? elemName + 1 : name);
 
-    if (!m_path.isTagged())
+	const std::vector<EndRule*>& rules = m_rules->getEndRules(m_states.back());
+
+    if (!m_path.isTagged() && !rules.empty())
     {
-    	if (m_endRules.find(elemName) != m_endRules.end()) {
-
-    		std::list<EndRule>* rules = &m_endRules[elemName];
-        	std::list<EndRule>::iterator end = rules->end();
-
-        	std::string body = m_body.str();
-        	int len = body.length();
-    		char* text = (char *) body.c_str();
-
-    		if (m_trimBody && !m_bodyIsCData) {
-
-        		// Trim leading spaces
-    			while (len > 0) {
-
-    				if (*text==' ' || *text=='\t' || *text=='\r' || *text =='\n') {
-    					text++;
-    					len--;
-    				} else {
-    					break;
-    				}
-    			}
-    			if (len > 0) {
-
-    				// Trim trailing spaces
-    				char* last = ((char* ) text) + len - 1;
-    				while (len > 0) {
-
-    					if (*last==' ' || *last=='\t' || *last=='\r' || *last =='\n') {
-    						last--;
-    						len--;
-    					} else {
-    						break;
-    					}
-    				}
-
-    				*(text + len) = 0;
-    			}
-    		}
-
-        	for (std::list<EndRule>::iterator rule = rules->begin(); rule != end; rule++) {
-
-    			m_rulePath = &rule->path;
-        		if (m_path == *m_rulePath) {
-        		    TRACE("Triggering end binding handler for: %s with body %s", m_path.str(), text);
-        			rule->callback(this, elemName, text);
-        		}
-    			m_rulePath = NULL;
-        	}
+    	// The body is trimmed in place
+    	char* text = &m_body[0];
+    	size_t len = m_body.length();
+
+		if (m_trimBody && !m_bodyIsCData) {
+
+			while (len > 0 && (*text==' ' || *text=='\t' || *text=='\r' || *text =='\n')) {
+				text++;
+				len--;
+			}
+			while (len > 0 && (text[len - 1]==' ' || text[len - 1]=='\t' || text[len - 1]=='\r' || text[len - 1] =='\n'))
+				len--;
+
+			text[len] = 0;
+		}
+
+    	for (std::vector<EndRule*>::const_iterator rule = rules.begin(); rule != rules.end(); rule++) {
+
+			m_rulePath = &(*rule)->path;
+		    TRACE("Triggering end binding handler for: %s with body %s", m_path.str(), text);
+			(*rule)->callback(this, elemName, text);
+			m_rulePath = NULL;
     	}
+
+    	if (m_bindOnce)
+    		this->setBound(m_states.back(), rules);
     }
 
     m_addTextToBody = true;
     m_bodyIsCData = false;
 
     m_body.clear();
-    m_body.str("");
 
     TRACE("End parsing Element at path: %s", m_path.str());
 
     m_path.pop();
+    m_states.pop_back();
 }
 
 void DataBinder::characters(const char* text, int len) {
 
-	if (m_addTextToBody)
-		m_body.write(text, len);
+	if (m_addTextToBody && !m_complete)
+		m_body.append(text, len);
 }
 
 void DataBinder::startCDataSection() {
 
     m_body.clear();
-    m_body.str("");
 }
 void DataBinder::endCDataSection() {
 
@@ -293,29 +461,7 @@ void DataBinder::debug(const char* msg) {
 	std::cout << "Debug output for DataBinder instance '" << msg;
 	std::cout << "' : " << std::endl;
 
-	boost::unordered_map<std::string, std::list<BeginRule> >::iterator i;
-	std::list<BeginRule>::iterator j;
-
-	std::cout << "  Begin Rules: " << std::endl;
-	for (i = m_beginRules.begin(); i != m_beginRules.end(); i++) {
-
-		std::cout << "    Element Name: " << i->first << std::endl;
-		for (j = i->second.begin(); j != i->second.end(); j++) {
-			std::cout << "      Trigger On: " << j->path;
-		}
-	}
-
-	boost::unordered_map<std::string, std::list<EndRule> >::iterator k;
-	std::list<EndRule>::iterator l;
-
-	std::cout << std::endl << "  End Rules: " << std::endl;
-	for (k = m_endRules.begin(); k != m_endRules.end(); k++) {
-
-		std::cout << "    Element Name: " << k->first << std::endl;
-		for (l = k->second.begin(); l != k->second.end(); l++) {
-			std::cout << "      Trigger On: " << l->path;
-		}
-	}
+	m_rules->debug();
 
 	std::cout << std::endl;
 }
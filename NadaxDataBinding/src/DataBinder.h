@@ -25,6 +25,8 @@
 
 #include <list>
 #include <map>
+#include <deque>
+#include <vector>
 #include "boost/unordered_map.hpp"
 #include <string>
 #include <sstream>
@@ -32,7 +34,10 @@
 #include "boost/shared_ptr.hpp"
 #include "boost/thread.hpp"
 
+#include "arena.h"
+
 #include "Path.h"
+#include "PathAutomaton.h"
 
 #define GET_BINDER(BinderType) \
 	BinderType* dataBinder = (BinderType *) binder;
@@ -47,30 +52,146 @@ class DataBinder;
 typedef boost::shared_ptr<DataBinder> DataBinderPtr;
 
     
+/* A view of the attributes of an element over the NULL terminated
+ * array of names and values given by the parser. Nothing is copied
+ * so the view is only valid within the callback it is passed to.
+ */
+class Attributes {
+
+public:
+	Attributes(const char** attribs) : m_attribs(attribs) { };
+
+	/* Returns the value of the named attribute or
+	 * the given default if there is no such attribute */
+	const char* get(const char* name, const char* defaultValue = NULL) const;
+
+	bool has(const char* name) const {
+		return this->get(name) != NULL;
+	}
+
+	int size() const;
+
+	const char* getName(int i) const {
+		return m_attribs[i * 2];
+	}
+	const char* getValue(int i) const {
+		return m_attribs[i * 2 + 1];
+	}
+
+	void copyTo(std::map<std::string, std::string>& attribMap) const;
+
+private:
+	const char** m_attribs;
+};
+
 typedef void (*BeginElementCallback)(void* m_binder, const char *element, std::map<std::string, std::string>& attribs);
+typedef void (*BeginElementViewCallback)(void* m_binder, const char *element, const Attributes& attribs);
 typedef void (*EndElementCallback)(void* m_binder, const char *element, const char *m_body);
 
+/* A begin rule either takes the attributes as a map which is built
+ * for each element it fires on or as a view that costs nothing */
 class BeginRule {
 
 public:
-	BeginRule(const char* pathStr, BeginElementCallback callback) : path(pathStr), callback(callback) { };
-	BeginRule(const BeginRule& rule) : path(rule.path), callback(rule.callback) { };
+	BeginRule(const char* pathStr, BeginElementCallback callback) : path(pathStr), callback(callback), viewCallback(NULL) { };
+	BeginRule(const char* pathStr, BeginElementViewCallback callback) : path(pathStr), callback(NULL), viewCallback(callback) { };
+	BeginRule(const BeginRule& rule) : path(rule.path), callback(rule.callback), viewCallback(rule.viewCallback) { };
 
 	Path path;
 	BeginElementCallback callback;
+	BeginElementViewCallback viewCallback;
 };
 
 
 class EndRule {
 
 public:
-	EndRule(const char* pathStr, EndElementCallback callback) : path(pathStr), callback(callback) { };
-	EndRule(const EndRule& rule) : path(rule.path), callback(rule.callback) { };
+	EndRule(const char* pathStr, EndElementCallback callback, int id = 0) : path(pathStr), callback(callback), id(id) { };
+	EndRule(const EndRule& rule) : path(rule.path), callback(rule.callback), id(rule.id) { };
 
 	Path path;
 	EndElementCallback callback;
+
+	// Index of the rule within the binder's end rules
+	int id;
 };
 
+/* The rules of a binder compiled to an automaton over the path
+ * of the element being bound. Once compiled the rules are not
+ * changed and are shared by binders created with the same rules.
+ */
+class DataBinderRules {
+
+public:
+	DataBinderRules();
+	DataBinderRules(const DataBinderRules& rules);
+
+	void addBeginRule(const char* pathStr, BeginElementCallback callback);
+	void addBeginRule(const char* pathStr, BeginElementViewCallback callback);
+	void addEndRule(const char* pathStr, EndElementCallback callback);
+
+	void compile();
+
+	bool isCompiled() {
+		return m_automaton.isCompiled();
+	}
+
+	int getStart() {
+		return m_automaton.getStart();
+	}
+	int getNumStates() {
+		return m_automaton.getNumStates();
+	}
+	int getNumEndRules() {
+		return (int) m_endRules.size();
+	}
+	int next(int state, const char* element) {
+		return m_automaton.next(state, element);
+	}
+	int nextAttribute(int state, const char* attribute) {
+		return m_automaton.nextAttribute(state, attribute);
+	}
+
+	/* Rules that match the paths of the given state */
+	const std::vector<BeginRule*>& getBeginRules(int state) {
+		return m_beginMatches[state];
+	}
+	const std::vector<EndRule*>& getEndRules(int state) {
+		return m_endMatches[state];
+	}
+
+	/* Whether any rule matches the element whose path
+	 * is given by the state or any of its descendants */
+	bool isLive(int state) {
+		return m_automaton.isLive(state);
+	}
+
+	/* Whether any rule matches an attribute of the
+	 * element whose path is given by the state */
+	bool hasAttributeRules(int state) {
+		return m_automaton.hasAttributeMatches(state);
+	}
+
+	void debug();
+
+private:
+
+	std::deque<BeginRule> m_beginRules;
+	std::deque<EndRule> m_endRules;
+
+	// Each pattern of the automaton is the path of a begin
+	// rule or an end rule given by its index in the rules
+	std::vector<std::pair<bool, int> > m_patterns;
+
+	PathAutomaton m_automaton;
+
+	std::vector<std::vector<BeginRule*> > m_beginMatches;
+	std::vector<std::vector<EndRule*> > m_endMatches;
+};
+
+typedef boost::shared_ptr<DataBinderRules> DataBinderRulesPtr;
+
+
 class DataBinder {
 
 public:
@@ -91,7 +212,7 @@ public:
 	virtual void endCDataSection();
 
 	const char* getBody() { 
-        return m_body.str().c_str(); 
+        return m_body.c_str(); 
     }
 
 	void skipParent(short level = 1) { 
@@ -122,11 +243,57 @@ public:
         m_trimBody = trim; 
     }
 
+	/* Memory for data that rules need until the end of the
+	 * document. It is released when the binder is reset. */
+	MemoryArena& getArena() {
+		return m_arena;
+	}
+
+	/* If set the parser skips the content of elements that
+	 * no rule can match without tokenizing it where the
+	 * parser is able to */
+	void setSkipUnbound(bool skip) {
+		m_skipUnbound = skip;
+	}
+	bool isSkipUnbound() {
+		return m_skipUnbound;
+	}
+
+	/* Whether the content of the element that was just
+	 * started can be skipped as it will not be bound */
+	bool canSkipElement() {
+		return m_skipUnbound && (m_path.isTagged() || !m_rules->isLive(m_states.back()));
+	}
+
+	/* If set each path is bound by the first element it
+	 * matches only. Once every end rule has fired the
+	 * binding is complete and the rest of the document
+	 * can be discarded. */
+	void setBindOnce(bool bindOnce) {
+		m_bindOnce = bindOnce;
+	}
+
+	/* Completes the binding so the rest of the document is
+	 * ignored and may be discarded by the parser. May be
+	 * called by a rule once it has what it needs. */
+	void stopBinding() {
+		m_complete = true;
+	}
+	bool isComplete() {
+		return m_complete;
+	}
+
 	void debug(const char* msg);
 
+    /* Returns the compiled rules so they can be
+     * shared by binders created with the same rules */
+    DataBinderRulesPtr getRules();
+    void setRules(DataBinderRulesPtr rules);
+
 protected:
 
     void addBeginRule(const char *pathStr, BeginElementCallback callback);
+    void addBeginRule(const char *pathStr, BeginElementViewCallback callback);
     void addEndRule(const char *pathStr, EndElementCallback callback);
 
     void* m_root;
@@ -134,17 +301,45 @@ protected:
     Path m_path;
     Path* m_rulePath;
 
+    MemoryArena m_arena;
+
 private:
 
-    boost::unordered_map<std::string, std::list<BeginRule> > m_beginRules;
-    boost::unordered_map<std::string, std::list<EndRule> > m_endRules;
+    DataBinderRules* getMutableRules();
+
+    DataBinderRulesPtr m_rules;
+
+    // States of the rules' automaton for the
+    // path of each element being bound
+    std::vector<int> m_states;
+
+    void beginRules(const std::vector<BeginRule*>& rules, const char* name,
+    	const Attributes& attribs, std::map<std::string, std::string>& attribMap);
 
-    std::stringstream m_body;
+    bool isBound(int state);
+    void setBound(int state, const std::vector<EndRule*>& rules);
+
+    // Body of the current element which is cleared rather than
+    // released so it is not reallocated for each element
+    std::string m_body;
+
+    // Path of an attribute with bound rules
+    std::string m_attribPath;
 
     bool m_trimBody;
     bool m_addTextToBody;
     bool m_bodyIsCData;
 
+    bool m_skipUnbound;
+    bool m_bindOnce;
+    bool m_complete;
+
+    // States whose elements were bound and the end rules
+    // that have not fired yet when binding once
+    std::vector<char> m_boundStates;
+    std::vector<char> m_firedRules;
+    int m_unfiredRules;
+
     boost::unordered_map<std::string, std::string> m_variables;
     
     boost::shared_mutex m_bindingLock;
@@ -24,13 +24,20 @@
 
 #include <iostream>
 #include <iomanip>
+#include <sstream>
+#include <locale>
+#include <list>
+#include <new>
 #include "boost/unordered_map.hpp"
+#include "boost/enable_shared_from_this.hpp"
+#include "boost/make_shared.hpp"
 
-#include "boost/algorithm/string.hpp"
+#include "arena.h"
 
 #include "log.h"
 #include "exception.h"
 #include "number.h"
+#include "scalar.h"
 
 #define ATTEMPT_TO_ADD_KEY_TO_LIST        "You cannot add key to a list node."
 #define ATTEMPT_TO_ADD_TO_MAP             "You cannot add a node to a map node."
@@ -39,6 +46,12 @@
 
 #define INDENT  4
 
+// Chunk size of the arena of a compact document
+#define COMPACT_CHUNK_SIZE  4096
+
+// Maps with up to this many keys are searched linearly
+#define COMPACT_SMALL_MAP   8
+
 #ifdef LOG_LEVEL_TRACE
 static Number<long> instanceCount(0);
 #endif
@@ -47,6 +60,10 @@ static Number<long> instanceCount(0);
 namespace binding {
 
 
+class CompactTable;
+class CompactRow;
+
+
 class DynaModelException : public CException {
 public:
 	DynaModelException(const char* source, int lineNumber) : CException(source, lineNumber) { }
@@ -54,6 +71,45 @@ public:
 };
 
 
+// Numbers and booleans are written as JSON literals and
+// timestamps as the strings they were bound from
+static void scalarToJson(std::ostream& cout, const char* text, const DynaModel::Scalar& scalar) {
+
+	switch (scalar.type) {
+
+		case DynaModel::VAL_INT64:
+			cout << scalar.integer;
+			break;
+
+		case DynaModel::VAL_DOUBLE: {
+
+			// The shortest of the precisions that reads back the same
+			std::ostringstream number;
+			number.imbue(std::locale::classic());
+			number << std::setprecision(15) << scalar.real;
+
+			double value;
+			if (!parseDouble(number.str().c_str(), value) || value != scalar.real) {
+
+				number.str("");
+				number << std::setprecision(17) << scalar.real;
+			}
+
+			cout << number.str();
+			break;
+		}
+
+		case DynaModel::VAL_BOOL:
+			cout << (scalar.integer ? "true" : "false");
+			break;
+
+		default:
+			cout << '"' << text << '"';
+			break;
+	}
+}
+
+
 class Node : public DynaModel {
 
 public:
@@ -76,9 +132,15 @@ public:
 	void setValue(const char* key, const char* value);
 	void addValue(const char* value);
 
+	void setValue(const char* key, const char* value, const Scalar& scalar);
+	void addValue(const char* value, const Scalar& scalar);
+
 	virtual void toJson(std::ostream& cout, int level = -1);
 
 private:
+	void setValueNode(const char* key, DynaModelNode dataNode);
+	void addValueNode(DynaModelNode dataNode);
+
 	DynaModel::Type m_type;
 
 	boost::unordered_map<std::string, int> m_childRefs;
@@ -105,6 +167,355 @@ private:
 	friend class DynaModelBinder;
 };
 
+class TypedValueNode : public ValueNode {
+
+public:
+	TypedValueNode(const char* value, const Scalar& scalar) : ValueNode(value), m_scalar(scalar) { }
+
+	const Scalar* scalar() { return &m_scalar; }
+
+	virtual void toJson(std::ostream& cout, int level = -1) { scalarToJson(cout, this->value(), m_scalar); }
+
+private:
+	Scalar m_scalar;
+};
+
+
+// The nodes of a compact document are placed in an arena owned by
+// the document and are never destroyed individually. Handles to
+// them share ownership of the document, so a document is released
+// with its arena once the last handle to any of its nodes is gone.
+// Keys are interned in the document so maps compare key pointers.
+class CompactDocument : public boost::enable_shared_from_this<CompactDocument> {
+
+public:
+	CompactDocument();
+	~CompactDocument();
+
+	DynaModel* createNode(DynaModel::Type type);
+	DynaModel* createValue(const char* value, const DynaModel::Scalar* scalar = NULL);
+	DynaModel* createColumnarList();
+
+	// Creates the columns of a columnar list which
+	// are deleted with the document
+	CompactTable* createTable();
+
+	DynaModelNode handle(DynaModel* node) {
+		return DynaModelNode(this->shared_from_this(), node);
+	}
+
+	// Returns the interned copy of the key adding it if required
+	const char* intern(const char* key);
+	// Returns the interned copy of the key or NULL if no node of
+	// the document has the key
+	const char* findKey(const char* key);
+
+	// Keeps a node of another document or a heap node added
+	// to the document and returns where its handle is kept
+	DynaModelNode* adopt(DynaModelNode node);
+
+	MemoryArena& getArena() {
+		return m_arena;
+	}
+
+	size_t getCapacity();
+
+private:
+	size_t findSlot(const char* key, size_t hash);
+
+	MemoryArena m_arena;
+
+	// Open addressed table of the interned keys
+	std::vector<const char*> m_keys;
+	size_t m_numKeys;
+
+	std::list<DynaModelNode> m_adopted;
+
+	std::vector<CompactTable*> m_tables;
+};
+
+class CompactNode : public DynaModel {
+
+public:
+	CompactNode(CompactDocument* document, DynaModel::Type type);
+
+	Type getType() {
+		return (Type) m_type;
+	}
+
+	int size() {
+		return (int) m_size;
+	}
+	bool containsKey(const char* key);
+	std::list<std::string> keys();
+
+	DynaModelNode get(const char* key);
+	DynaModelNode get(unsigned int index);
+
+	void add(DynaModelNode node, const char* key = NULL);
+	DynaModelNode add(const char* key, Type type = MAP);
+	DynaModelNode add(Type type = MAP);
+
+	void setValue(const char* key, const char* value);
+	void addValue(const char* value);
+
+	void setValue(const char* key, const char* value, const Scalar& scalar);
+	void addValue(const char* value, const Scalar& scalar);
+
+	DynaModelNode createNode(Type type = MAP);
+	DynaModelNode createColumnarList();
+
+	const void* getDocument() {
+		return m_document;
+	}
+	size_t getDocumentCapacity() {
+		return m_document->getCapacity();
+	}
+
+	virtual void toJson(std::ostream& cout, int level = -1);
+
+protected:
+	// Children of other documents are referred to through their
+	// handle kept by the document, which is marked in the low bit
+	struct Entry {
+
+		DynaModel* node() {
+			return (ref & 1 ? ((DynaModelNode *) (ref & ~(uintptr_t) 1))->get() : (DynaModel *) ref);
+		}
+
+		const char* key;
+		uintptr_t ref;
+	};
+
+	uintptr_t reference(DynaModelNode& node);
+	DynaModelNode handle(Entry& entry);
+
+	int find(const char* key);
+
+	void append(const char* key, uintptr_t ref);
+	void remove(unsigned int i);
+
+	void indexKey(const char* key, unsigned int i);
+	void buildIndex();
+
+	void setValueNode(const char* key, DynaModel* node);
+	void addValueNode(DynaModel* node);
+
+	CompactDocument* m_document;
+	unsigned int m_type;
+
+	// Children in the order they were added
+	Entry* m_entries;
+	unsigned int m_size;
+	unsigned int m_capacity;
+
+	// Hash of the interned keys to their entry + 1 built
+	// once a map has more keys than are searched linearly
+	unsigned int* m_index;
+	unsigned int m_indexSize;
+	unsigned int m_numKeys;
+
+	friend class CompactRow;
+};
+
+class CompactValue : public DynaModel {
+
+public:
+	CompactValue(const char* value) : m_value(value) { }
+
+	DynaModel::Type getType() { return VALUE; }
+
+	const char* value() { return m_value; }
+
+	virtual void toJson(std::ostream& cout, int level = -1) { cout << '"' << m_value << '"'; }
+
+private:
+	const char* m_value;
+};
+
+class CompactTypedValue : public CompactValue {
+
+public:
+	CompactTypedValue(const char* value, const Scalar& scalar) : CompactValue(value), m_scalar(scalar) { }
+
+	const Scalar* scalar() { return &m_scalar; }
+
+	virtual void toJson(std::ostream& cout, int level = -1) { scalarToJson(cout, this->value(), m_scalar); }
+
+private:
+	Scalar m_scalar;
+};
+
+
+// Columns of the rows of a columnar list. The cells of the row that
+// is being bound are buffered here until the row is added to the
+// list, when they are appended to the columns if their keys are
+// keys of the columns in the same order and their types match.
+class CompactTable {
+
+public:
+	struct Column {
+
+		const char* key;
+		DynaModel::ValueType type;
+
+		std::vector<unsigned int> codes;
+		std::vector<long long> integers;
+		std::vector<double> reals;
+
+		// Value nodes by their code and the codes
+		// open addressed by the hash of their text
+		std::vector<DynaModel*> dictionary;
+		std::vector<unsigned int> slots;
+	};
+
+	CompactTable(CompactDocument* document);
+	~CompactTable();
+
+	CompactRow* getPending() {
+		return m_pending;
+	}
+	void setPending(CompactRow* row);
+
+	void setCell(const char* key, const char* value, const DynaModel::Scalar* scalar);
+
+	// Appends the buffered cells as a row of the columns
+	// or returns false if they do not match the columns
+	bool appendRow();
+
+	unsigned int getRowCount() {
+		return m_rows;
+	}
+	std::vector<Column*>& getColumns() {
+		return m_columns;
+	}
+	Column* getColumn(const char* key);
+
+	size_t getCapacity();
+
+private:
+	struct Cell {
+
+		const char* key;
+		size_t offset;
+		bool isTyped;
+		DynaModel::Scalar scalar;
+	};
+
+	unsigned int encode(Column* column, const Cell& cell);
+
+	CompactDocument* m_document;
+
+	std::vector<Column*> m_columns;
+	unsigned int m_rows;
+
+	CompactRow* m_pending;
+	std::vector<Cell> m_cells;
+	std::string m_text;
+
+	friend class CompactRow;
+};
+
+// A list whose rows are created as CompactRows that are kept in
+// the columns of a table. Other nodes can still be added to the
+// list but its columns can then no longer be read.
+class CompactColumnarList : public CompactNode {
+
+public:
+	CompactColumnarList(CompactDocument* document);
+
+	using CompactNode::add;
+	using CompactNode::addValue;
+
+	void add(DynaModelNode node, const char* key = NULL);
+	DynaModelNode add(Type type = MAP);
+
+	void addValue(const char* value);
+	void addValue(const char* value, const Scalar& scalar);
+
+	// Maps created for the list are rows of its table
+	DynaModelNode createNode(Type type = MAP);
+
+	bool getColumn(const char* key, DynaModelColumn& column);
+
+private:
+	CompactTable* m_table;
+
+	// Whether each child is the row of the columns at its index
+	bool m_columnar;
+
+	friend class CompactRow;
+};
+
+// A map created for a columnar list. Its values are buffered in the
+// table of the list until it is added to the list and are then read
+// from the columns. It is turned into a map of its own if it cannot
+// be added to the columns or it is changed once it has been added.
+class CompactRow : public DynaModel {
+
+public:
+	CompactRow(CompactColumnarList* list);
+
+	Type getType() {
+		return MAP;
+	}
+
+	int size();
+	bool containsKey(const char* key);
+	std::list<std::string> keys();
+
+	DynaModelNode get(const char* key);
+	DynaModelNode get(unsigned int index);
+
+	void add(DynaModelNode node, const char* key = NULL);
+	DynaModelNode add(const char* key, Type type = MAP);
+	DynaModelNode add(Type type = MAP);
+
+	void setValue(const char* key, const char* value);
+	void addValue(const char* value);
+
+	void setValue(const char* key, const char* value, const Scalar& scalar);
+	void addValue(const char* value, const Scalar& scalar);
+
+	DynaModelNode createNode(Type type = MAP);
+	DynaModelNode createColumnarList();
+
+	const void* getDocument() {
+		return m_list->m_document;
+	}
+	size_t getDocumentCapacity() {
+		return m_list->m_document->getCapacity();
+	}
+
+	virtual void toJson(std::ostream& cout, int level = -1);
+
+private:
+	enum State {
+		PENDING,   // Cells are buffered in the table
+		COLUMNAR,  // Cells are in the columns
+		MAPPED     // Cells are in a map of the row
+	};
+
+	// Returns the map of the row creating it if required
+	CompactNode* map();
+
+	// Returns the value of the row in the given column
+	DynaModel* cell(CompactTable::Column* column) {
+
+		unsigned int code = column->codes[m_row];
+		return (code ? column->dictionary[code] : NULL);
+	}
+
+	CompactColumnarList* m_list;
+	unsigned int m_state;
+	unsigned int m_row;
+
+	CompactNode* m_map;
+
+	friend class CompactTable;
+	friend class CompactColumnarList;
+};
+
 
 // **** DataMap Implementation ****
 
@@ -120,6 +531,111 @@ DynaModelNode DynaModel::create(Type type) {
 	return DynaModelNode(new Node(type));
 }
 
+bool DynaModel::parseScalar(ValueType type, const char* text, Scalar& scalar) {
+
+	bool value;
+	scalar.type = type;
+
+	switch (type) {
+
+		case VAL_INT64:
+			return parseInt64(text, scalar.integer);
+
+		case VAL_DOUBLE:
+			return parseDouble(text, scalar.real);
+
+		case VAL_BOOL:
+			if (!parseBool(text, value))
+				return false;
+
+			scalar.integer = value;
+			return true;
+
+		case VAL_TIMESTAMP:
+			return parseTimestamp(text, scalar.integer);
+
+		default:
+			return false;
+	}
+}
+
+long long DynaModel::intValue(long long defaultValue) {
+
+	const Scalar* scalar = this->scalar();
+	if (scalar)
+		return (scalar->type == VAL_DOUBLE ? (long long) scalar->real : scalar->integer);
+
+	const char* text = this->value();
+	long long value;
+
+	return (text && parseInt64(text, value) ? value : defaultValue);
+}
+
+double DynaModel::doubleValue(double defaultValue) {
+
+	const Scalar* scalar = this->scalar();
+	if (scalar)
+		return (scalar->type == VAL_DOUBLE ? scalar->real : (double) scalar->integer);
+
+	const char* text = this->value();
+	double value;
+
+	return (text && parseDouble(text, value) ? value : defaultValue);
+}
+
+bool DynaModel::boolValue(bool defaultValue) {
+
+	const Scalar* scalar = this->scalar();
+	if (scalar)
+		return (scalar->type == VAL_DOUBLE ? scalar->real != 0.0 : scalar->integer != 0);
+
+	const char* text = this->value();
+	bool value;
+
+	return (text && parseBool(text, value) ? value : defaultValue);
+}
+
+long long DynaModel::timestampValue(long long defaultValue) {
+
+	const Scalar* scalar = this->scalar();
+	if (scalar)
+		return (scalar->type == VAL_DOUBLE ? (long long) scalar->real : scalar->integer);
+
+	const char* text = this->value();
+	long long value;
+
+	return (text && parseTimestamp(text, value) ? value : defaultValue);
+}
+
+int DynaModel::compare(DynaModel& other) {
+
+	const Scalar* scalar = this->scalar();
+	const Scalar* otherScalar = other.scalar();
+
+	if (scalar && otherScalar) {
+
+		if (scalar->type != VAL_DOUBLE && otherScalar->type != VAL_DOUBLE)
+			return (scalar->integer < otherScalar->integer ? -1 : scalar->integer > otherScalar->integer);
+
+		double value = (scalar->type == VAL_DOUBLE ? scalar->real : (double) scalar->integer);
+		double otherValue = (otherScalar->type == VAL_DOUBLE ? otherScalar->real : (double) otherScalar->integer);
+
+		return (value < otherValue ? -1 : value > otherValue);
+	}
+
+	const char* value = this->value();
+	const char* otherValue = other.value();
+
+	int result = strcmp(value ? value : "", otherValue ? otherValue : "");
+	return (result < 0 ? -1 : result > 0);
+}
+
+DynaModelNode DynaModel::createCompact(Type type) {
+
+	boost::shared_ptr<CompactDocument> document = boost::make_shared<CompactDocument>();
+	return document->handle(document->createNode(type));
+}
+
 std::ostream& operator<< (std::ostream& cout, const DynaModelNode data) {
 
 	data->toJson(cout);
@@ -256,10 +772,24 @@ DynaModelNode Node::add(Type type) {
 }
 
 void Node::setValue(const char* key, const char* value) {
+	this->setValueNode(key, DynaModelNode(new ValueNode(value)));
+}
 
-	if (m_type == DynaModel::MAP) {
+void Node::addValue(const char* value) {
+	this->addValueNode(DynaModelNode(new ValueNode(value)));
+}
 
-		DynaModelNode dataNode = DynaModelNode(new ValueNode(value));
+void Node::setValue(const char* key, const char* value, const Scalar& scalar) {
+	this->setValueNode(key, DynaModelNode(new TypedValueNode(value, scalar)));
+}
+
+void Node::addValue(const char* value, const Scalar& scalar) {
+	this->addValueNode(DynaModelNode(new TypedValueNode(value, scalar)));
+}
+
+void Node::setValueNode(const char* key, DynaModelNode dataNode) {
+
+	if (m_type == DynaModel::MAP) {
 
 		boost::unordered_map<std::string, int>::iterator ref = m_childRefs.find(key);
 		if (ref == m_childRefs.end()) {
@@ -269,7 +799,7 @@ void Node::setValue(const char* key, const char* value) {
 			m_childRefs[key] = i;
 
 			TRACE( "Added DataMap VALUE Node: %s = %s @ index %d to %p",
-				key, value, i, this );
+				key, dataNode->value(), i, this );
 
 		} else
 			m_childNodes[ref->second] = dataNode;
@@ -277,11 +807,10 @@ void Node::setValue(const char* key, const char* value) {
 		THROW(DynaModelException, EXCEP_MSSG(ATTEMPT_TO_ADD_KEY_VALUE_TO_LIST));
 }
 
-void Node::addValue(const char* value) {
+void Node::addValueNode(DynaModelNode dataNode) {
 
 	if (m_type == DynaModel::LIST) {
 
-		DynaModelNode dataNode = DynaModelNode(new ValueNode(value));
 		m_childNodes.push_back(dataNode);
 
 		TRACE( "Added DataMap VALUE Node @ index %d to %p",
@@ -401,24 +930,1023 @@ void Node::toJson(std::ostream& cout, int level) {
 }
 
 
-// **** DynaModelBindingConfig Implementation ****
+// **** CompactDocument Implementation ****
 
-void DynaModelBindingConfig::beginBindingConfigElement(std::map<std::string, std::string>& attribs) {
+static inline size_t hashKey(const char* key) {
 
-	const char* pathStr = attribs["path"].c_str();
-	std::string& type = attribs["type"];
+	size_t hash = 2166136261u;
 
-	Path path(pathStr);
-	m_pathDepth.push(path.length());
-	m_path.append(path);
+	while (*key)
+		hash = (hash ^ (unsigned char) *key++) * 16777619u;
 
-	DynaModelBinding binding(
-		m_path.str(),
+	return hash;
+}
+
+static inline size_t hashInternedKey(const char* key) {
+
+	// Interned keys are aligned in the arena
+	size_t hash = ((size_t) key >> 4) * 2654435761u;
+	return hash ^ (hash >> 16);
+}
+
+CompactDocument::CompactDocument() : m_arena(COMPACT_CHUNK_SIZE), m_keys(16, (const char*) NULL) {
+	m_numKeys = 0;
+}
+
+CompactDocument::~CompactDocument() {
+
+	for (size_t i = 0; i < m_tables.size(); i++)
+		delete m_tables[i];
+}
+
+DynaModel* CompactDocument::createNode(DynaModel::Type type) {
+	return new (m_arena.allocate(sizeof(CompactNode))) CompactNode(this, type);
+}
+
+DynaModel* CompactDocument::createColumnarList() {
+	return new (m_arena.allocate(sizeof(CompactColumnarList))) CompactColumnarList(this);
+}
+
+CompactTable* CompactDocument::createTable() {
+
+	m_tables.push_back(new CompactTable(this));
+	return m_tables.back();
+}
+
+size_t CompactDocument::getCapacity() {
+
+	size_t capacity = m_arena.getCapacity() + m_keys.capacity() * sizeof(const char*);
+
+	for (size_t i = 0; i < m_tables.size(); i++)
+		capacity += m_tables[i]->getCapacity();
+
+	return capacity;
+}
+
+DynaModel* CompactDocument::createValue(const char* value, const DynaModel::Scalar* scalar) {
+
+	const char* copy = m_arena.copy(value);
+
+	if (scalar)
+		return new (m_arena.allocate(sizeof(CompactTypedValue))) CompactTypedValue(copy, *scalar);
+	else
+		return new (m_arena.allocate(sizeof(CompactValue))) CompactValue(copy);
+}
+
+inline size_t CompactDocument::findSlot(const char* key, size_t hash) {
+
+	size_t mask = m_keys.size() - 1;
+	size_t i = hash & mask;
+
+	while (m_keys[i] && strcmp(m_keys[i], key))
+		i = (i + 1) & mask;
+
+	return i;
+}
+
+const char* CompactDocument::intern(const char* key) {
+
+	size_t hash = hashKey(key);
+	size_t slot = findSlot(key, hash);
+
+	if (m_keys[slot])
+		return m_keys[slot];
+
+	if ((m_numKeys + 1) * 2 > m_keys.size()) {
+
+		std::vector<const char*> keys(m_keys.size() * 2, (const char*) NULL);
+		keys.swap(m_keys);
+
+		for (size_t i = 0; i < keys.size(); i++)
+			if (keys[i])
+				m_keys[this->findSlot(keys[i], hashKey(keys[i]))] = keys[i];
+
+		slot = this->findSlot(key, hash);
+	}
+
+	m_numKeys++;
+	return (m_keys[slot] = m_arena.copy(key));
+}
+
+const char* CompactDocument::findKey(const char* key) {
+	return m_keys[this->findSlot(key, hashKey(key))];
+}
+
+DynaModelNode* CompactDocument::adopt(DynaModelNode node) {
+
+	m_adopted.push_back(node);
+	return &m_adopted.back();
+}
+
+
+// **** CompactNode Implementation ****
+
+CompactNode::CompactNode(CompactDocument* document, DynaModel::Type type) {
+
+	m_document = document;
+	m_type = type;
+
+	m_entries = NULL;
+	m_size = 0;
+	m_capacity = 0;
+
+	m_index = NULL;
+	m_indexSize = 0;
+	m_numKeys = 0;
+}
+
+inline uintptr_t CompactNode::reference(DynaModelNode& node) {
+
+	if (node.get() && node->getDocument() == m_document)
+		return (uintptr_t) node.get();
+	else
+		return (uintptr_t) m_document->adopt(node) | 1;
+}
+
+inline DynaModelNode CompactNode::handle(Entry& entry) {
+
+	if (entry.ref & 1)
+		return *((DynaModelNode *) (entry.ref & ~(uintptr_t) 1));
+	else
+		return m_document->handle((DynaModel *) entry.ref);
+}
+
+int CompactNode::find(const char* key) {
+
+	if (!m_numKeys)
+		return -1;
+
+	if (m_index) {
+
+		unsigned int mask = m_indexSize - 1;
+		unsigned int i = hashInternedKey(key) & mask;
+
+		for (; m_index[i]; i = (i + 1) & mask)
+			if (m_entries[m_index[i] - 1].key == key)
+				return m_index[i] - 1;
+
+	} else {
+
+		for (unsigned int i = 0; i < m_size; i++)
+			if (m_entries[i].key == key)
+				return i;
+	}
+
+	return -1;
+}
+
+void CompactNode::append(const char* key, uintptr_t ref) {
+
+	if (m_size == m_capacity) {
+
+		// Outgrown entries are left in the arena
+		unsigned int capacity = (m_capacity ? m_capacity * 2 : 4);
+		Entry* entries = (Entry *) m_document->getArena().allocate(capacity * sizeof(Entry));
+
+		if (m_size)
+			memcpy(entries, m_entries, m_size * sizeof(Entry));
+
+		m_entries = entries;
+		m_capacity = capacity;
+	}
+
+	unsigned int i = m_size++;
+	m_entries[i].key = key;
+	m_entries[i].ref = ref;
+
+	if (key) {
+
+		m_numKeys++;
+
+		if (m_index && m_numKeys * 2 <= m_indexSize)
+			this->indexKey(key, i);
+		else if (m_numKeys > COMPACT_SMALL_MAP)
+			this->buildIndex();
+	}
+}
+
+void CompactNode::remove(unsigned int i) {
+
+	if (m_entries[i].key)
+		m_numKeys--;
+
+	memmove(m_entries + i, m_entries + i + 1, (m_size - i - 1) * sizeof(Entry));
+	m_size--;
+
+	// Entries after the removed one have moved
+	m_index = NULL;
+	m_indexSize = 0;
+
+	if (m_numKeys > COMPACT_SMALL_MAP)
+		this->buildIndex();
+}
+
+inline void CompactNode::indexKey(const char* key, unsigned int i) {
+
+	unsigned int mask = m_indexSize - 1;
+	unsigned int slot = hashInternedKey(key) & mask;
+
+	while (m_index[slot])
+		slot = (slot + 1) & mask;
+
+	m_index[slot] = i + 1;
+}
+
+void CompactNode::buildIndex() {
+
+	unsigned int size = 16;
+	while (size < m_numKeys * 4)
+		size *= 2;
+
+	m_index = (unsigned int *) m_document->getArena().allocate(size * sizeof(unsigned int));
+	m_indexSize = size;
+	memset(m_index, 0, size * sizeof(unsigned int));
+
+	for (unsigned int i = 0; i < m_size; i++)
+		if (m_entries[i].key)
+			this->indexKey(m_entries[i].key, i);
+}
+
+bool CompactNode::containsKey(const char* key) {
+
+	const char* internedKey = m_document->findKey(key);
+	return internedKey && this->find(internedKey) >= 0;
+}
+
+std::list<std::string> CompactNode::keys() {
+
+	std::list<std::string> keys;
+
+	for (unsigned int i = 0; i < m_size; i++)
+		if (m_entries[i].key)
+			keys.push_back(m_entries[i].key);
+
+	return keys;
+}
+
+DynaModelNode CompactNode::get(const char* key) {
+
+	const char* internedKey = m_document->findKey(key);
+	int i = (internedKey ? this->find(internedKey) : -1);
+
+	if (i >= 0)
+		return this->handle(m_entries[i]);
+	else
+		return DynaModelNode();
+}
+
+DynaModelNode CompactNode::get(unsigned int index) {
+
+	if (index < m_size)
+		return this->handle(m_entries[index]);
+	else
+		return DynaModelNode();
+}
+
+void CompactNode::add(DynaModelNode node, const char* key) {
+
+	const char* internedKey = NULL;
+
+	if (key) {
+
+		internedKey = m_document->intern(key);
+
+		int i = this->find(internedKey);
+		if (i >= 0)
+			this->remove(i);
+	}
+
+	this->append(internedKey, this->reference(node));
+
+	TRACE( "Added DataMap Node: %s = %p @ index %d to %p",
+		(key ? key : "-"), node.get(), m_size - 1, this );
+}
+
+DynaModelNode CompactNode::add(const char* key, Type type) {
+
+	if (m_type == DynaModel::MAP) {
+
+		const char* internedKey = m_document->intern(key);
+
+		int i = this->find(internedKey);
+		if (i < 0) {
+
+			DynaModel* node = m_document->createNode(type);
+			this->append(internedKey, (uintptr_t) node);
+
+			TRACE( "Added DataMap Node: %s = %s @ index %d to %p",
+				key, type == MAP ? "MAP" : "LIST", m_size - 1, this );
+
+			return m_document->handle(node);
+
+		} else {
+
+			Entry& entry = m_entries[i];
+			DynaModel* node = entry.node();
+
+			if (!node || node->getType() == VALUE) {
+
+				entry.ref = (uintptr_t) m_document->createNode(type);
+
+				TRACE( "Replacing value DataMap Node @ %d with new Node: %s = %s to %p",
+					i, key, type == MAP ? "MAP" : "LIST", this );
+			}
+
+			return this->handle(entry);
+		}
+	} else
+		THROW(DynaModelException, EXCEP_MSSG(ATTEMPT_TO_ADD_KEY_TO_LIST));
+
+	return DynaModelNode();
+}
+
+DynaModelNode CompactNode::add(Type type) {
+
+	if (m_type == DynaModel::LIST) {
+
+		DynaModel* node = m_document->createNode(type);
+		this->append(NULL, (uintptr_t) node);
+
+		TRACE("Added DataMap %s Node @ index %d to %p",
+			type == MAP ? "MAP" : "LIST", m_size - 1, this );
+
+		return m_document->handle(node);
+
+	} else
+		THROW(DynaModelException, EXCEP_MSSG(ATTEMPT_TO_ADD_TO_MAP));
+
+	return DynaModelNode();
+}
+
+void CompactNode::setValue(const char* key, const char* value) {
+	this->setValueNode(key, m_document->createValue(value));
+}
+
+void CompactNode::addValue(const char* value) {
+	this->addValueNode(m_document->createValue(value));
+}
+
+void CompactNode::setValue(const char* key, const char* value, const Scalar& scalar) {
+	this->setValueNode(key, m_document->createValue(value, &scalar));
+}
+
+void CompactNode::addValue(const char* value, const Scalar& scalar) {
+	this->addValueNode(m_document->createValue(value, &scalar));
+}
+
+void CompactNode::setValueNode(const char* key, DynaModel* node) {
+
+	if (m_type == DynaModel::MAP) {
+
+		const char* internedKey = m_document->intern(key);
+
+		int i = this->find(internedKey);
+		if (i < 0) {
+
+			this->append(internedKey, (uintptr_t) node);
+
+			TRACE( "Added DataMap VALUE Node: %s = %s @ index %d to %p",
+				key, node->value(), m_size - 1, this );
+
+		} else
+			m_entries[i].ref = (uintptr_t) node;
+	} else
+		THROW(DynaModelException, EXCEP_MSSG(ATTEMPT_TO_ADD_KEY_VALUE_TO_LIST));
+}
+
+void CompactNode::addValueNode(DynaModel* node) {
+
+	if (m_type == DynaModel::LIST) {
+
+		this->append(NULL, (uintptr_t) node);
+
+		TRACE( "Added DataMap VALUE Node @ index %d to %p",
+			m_size - 1, this);
+
+	} else
+		THROW(DynaModelException, EXCEP_MSSG(ATTEMPT_TO_ADD_VALUE_TO_MAP));
+}
+
+DynaModelNode CompactNode::createNode(Type type) {
+	return m_document->handle(m_document->createNode(type));
+}
+
+DynaModelNode CompactNode::createColumnarList() {
+	return m_document->handle(m_document->createColumnarList());
+}
+
+void CompactNode::toJson(std::ostream& cout, int level) {
+
+	unsigned int i;
+
+	if (m_numKeys > 0) {
+
+		bool first = true;
+
+		cout << '{';
+		if (level >= 0)
+			cout << std::endl;
+
+		for (i = 0; i < m_size; i++) {
+
+			if (!m_entries[i].key)
+				continue;
+
+			if (!first)
+				cout << (level >= 0 ? ",\n" : ",");
+			first = false;
+
+			if (level >= 0) {
+
+				cout.width((level + 1) * INDENT);
+				cout << '"' << m_entries[i].key << "\": ";
+				m_entries[i].node()->toJson(cout, level + 1);
+
+			} else {
+
+				cout << '"' << m_entries[i].key << "\":";
+				m_entries[i].node()->toJson(cout);
+			}
+		}
+
+		if (level >= 0) {
+
+			cout << std::endl;
+			cout.width(level * INDENT);
+		}
+
+		cout << '}';
+
+	} else if (level >= 0) {
+
+		DynaModel* node = NULL;
+
+		cout << '[';
+
+		for (i = 0; i < m_size; i++) {
+
+			node = m_entries[i].node();
+
+			if (node->getType() == DynaModel::VALUE) {
+				cout << std::endl;
+				cout.width((level + 1) * INDENT);
+			} else if (i == 0)
+				cout << ' ';
+
+			node->toJson(cout, level);
+			cout << (i + 1 != m_size ? ", " : " ");
+		}
+
+		if (node && node->getType() == DynaModel::VALUE) {
+			cout << std::endl;
+			cout.width(level * INDENT);
+		}
+
+		cout << ']';
+
+	} else {
+
+		cout << '[';
+
+		for (i = 0; i < m_size; i++) {
+
+			if (i)
+				cout << ',';
+			m_entries[i].node()->toJson(cout);
+		}
+
+		cout << ']';
+	}
+}
+
+
+// **** CompactTable Implementation ****
+
+CompactTable::CompactTable(CompactDocument* document) {
+
+	m_document = document;
+	m_rows = 0;
+	m_pending = NULL;
+}
+
+CompactTable::~CompactTable() {
+
+	for (size_t i = 0; i < m_columns.size(); i++)
+		delete m_columns[i];
+}
+
+void CompactTable::setPending(CompactRow* row) {
+
+	// Only one row is buffered at a time
+	if (m_pending)
+		m_pending->map();
+
+	m_pending = row;
+	m_cells.clear();
+	m_text.clear();
+}
+
+void CompactTable::setCell(const char* key, const char* value, const DynaModel::Scalar* scalar) {
+
+	const char* internedKey = m_document->intern(key);
+	size_t i;
+
+	for (i = 0; i < m_cells.size() && m_cells[i].key != internedKey; i++);
+
+	if (i == m_cells.size()) {
+
+		m_cells.push_back(Cell());
+		m_cells[i].key = internedKey;
+	}
+
+	Cell& cell = m_cells[i];
+	cell.offset = m_text.length();
+	cell.isTyped = (scalar != NULL);
+	if (scalar)
+		cell.scalar = *scalar;
+
+	m_text.append(value, strlen(value) + 1);
+}
+
+bool CompactTable::appendRow() {
+
+	size_t i, c;
+
+	// The columns are the keys of the first row
+	if (m_rows == 0 && m_columns.empty() && m_cells.size() > 0) {
+
+		for (i = 0; i < m_cells.size(); i++) {
+
+			Column* column = new Column();
+			column->key = m_cells[i].key;
+			column->type = (m_cells[i].isTyped ? m_cells[i].scalar.type : DynaModel::VAL_STRING);
+			column->dictionary.push_back(NULL);
+
+			m_columns.push_back(column);
+		}
+	}
+
+	for (i = 0, c = 0; i < m_cells.size(); i++, c++) {
+
+		for (; c < m_columns.size() && m_columns[c]->key != m_cells[i].key; c++);
+
+		if (c == m_columns.size())
+			break;
+		if (m_columns[c]->type != (m_cells[i].isTyped ? m_cells[i].scalar.type : DynaModel::VAL_STRING))
+			break;
+	}
+
+	if (i < m_cells.size() || m_columns.empty()) {
+
+		m_pending->map();
+		return false;
+	}
+
+	for (c = 0; c < m_columns.size(); c++) {
+
+		Column* column = m_columns[c];
+		column->codes.push_back(0);
+
+		if (column->type == DynaModel::VAL_DOUBLE)
+			column->reals.push_back(0.0);
+		else if (column->type != DynaModel::VAL_STRING)
+			column->integers.push_back(0);
+	}
+
+	for (i = 0, c = 0; i < m_cells.size(); i++, c++) {
+
+		for (; m_columns[c]->key != m_cells[i].key; c++);
+
+		Column* column = m_columns[c];
+		column->codes.back() = this->encode(column, m_cells[i]);
+
+		if (column->type == DynaModel::VAL_DOUBLE)
+			column->reals.back() = m_cells[i].scalar.real;
+		else if (column->type != DynaModel::VAL_STRING)
+			column->integers.back() = m_cells[i].scalar.integer;
+	}
+
+	m_pending->m_state = CompactRow::COLUMNAR;
+	m_pending->m_row = m_rows++;
+	m_pending = NULL;
+
+	return true;
+}
+
+unsigned int CompactTable::encode(Column* column, const Cell& cell) {
+
+	const char* text = m_text.c_str() + cell.offset;
+	size_t mask;
+	size_t slot;
+
+	if (column->dictionary.size() * 2 > column->slots.size()) {
+
+		std::vector<unsigned int> slots(column->slots.size() ? column->slots.size() * 2 : 16, 0);
+		mask = slots.size() - 1;
+
+		for (unsigned int code = 1; code < column->dictionary.size(); code++) {
+
+			for (slot = hashKey(column->dictionary[code]->value()) & mask; slots[slot]; slot = (slot + 1) & mask);
+			slots[slot] = code;
+		}
+
+		column->slots.swap(slots);
+	}
+
+	mask = column->slots.size() - 1;
+
+	for (slot = hashKey(text) & mask; column->slots[slot]; slot = (slot + 1) & mask)
+		if (!strcmp(column->dictionary[column->slots[slot]]->value(), text))
+			return column->slots[slot];
+
+	column->dictionary.push_back(m_document->createValue(text, cell.isTyped ? &cell.scalar : NULL));
+	column->slots[slot] = (unsigned int) column->dictionary.size() - 1;
+
+	return column->slots[slot];
+}
+
+CompactTable::Column* CompactTable::getColumn(const char* key) {
+
+	const char* internedKey = m_document->findKey(key);
+
+	for (size_t c = 0; internedKey && c < m_columns.size(); c++)
+		if (m_columns[c]->key == internedKey)
+			return m_columns[c];
+
+	return NULL;
+}
+
+size_t CompactTable::getCapacity() {
+
+	size_t capacity = sizeof(CompactTable) + m_cells.capacity() * sizeof(Cell) + m_text.capacity();
+
+	for (size_t c = 0; c < m_columns.size(); c++) {
+
+		Column* column = m_columns[c];
+
+		capacity += sizeof(Column) +
+			column->codes.capacity() * sizeof(unsigned int) +
+			column->integers.capacity() * sizeof(long long) +
+			column->reals.capacity() * sizeof(double) +
+			column->dictionary.capacity() * sizeof(DynaModel*) +
+			column->slots.capacity() * sizeof(unsigned int);
+	}
+
+	return capacity;
+}
+
+
+// **** CompactColumnarList Implementation ****
+
+CompactColumnarList::CompactColumnarList(CompactDocument* document) : CompactNode(document, LIST) {
+
+	m_table = document->createTable();
+	m_columnar = true;
+}
+
+void CompactColumnarList::add(DynaModelNode node, const char* key) {
+
+	CompactRow* row = m_table->getPending();
+
+	if (row && node.get() == row && m_table->appendRow()) {
+
+		const char* internedKey = NULL;
+
+		if (key) {
+
+			internedKey = m_document->intern(key);
+
+			int i = this->find(internedKey);
+			if (i >= 0) {
+
+				this->remove(i);
+				m_columnar = false;
+			}
+		}
+
+		this->append(internedKey, (uintptr_t) row);
+
+		TRACE( "Added DataMap row: %s = %p @ index %d to %p",
+			(key ? key : "-"), row, m_size - 1, this );
+
+	} else {
+
+		m_columnar = false;
+		CompactNode::add(node, key);
+	}
+}
+
+DynaModelNode CompactColumnarList::add(Type type) {
+
+	m_columnar = false;
+	return CompactNode::add(type);
+}
+
+void CompactColumnarList::addValue(const char* value) {
+
+	m_columnar = false;
+	CompactNode::addValue(value);
+}
+
+void CompactColumnarList::addValue(const char* value, const Scalar& scalar) {
+
+	m_columnar = false;
+	CompactNode::addValue(value, scalar);
+}
+
+DynaModelNode CompactColumnarList::createNode(Type type) {
+
+	if (type != MAP)
+		return CompactNode::createNode(type);
+
+	CompactRow* row = new (m_document->getArena().allocate(sizeof(CompactRow))) CompactRow(this);
+	m_table->setPending(row);
+
+	return m_document->handle(row);
+}
+
+bool CompactColumnarList::getColumn(const char* key, DynaModelColumn& column) {
+
+	if (!m_columnar || m_table->getRowCount() != m_size)
+		return false;
+
+	CompactTable::Column* data = m_table->getColumn(key);
+	if (!data)
+		return false;
+
+	column.m_list = m_document->handle(this);
+	column.m_key = data->key;
+	column.m_type = data->type;
+	column.m_size = m_size;
+
+	column.m_codes = (m_size ? &data->codes[0] : NULL);
+	column.m_integers = (m_size && data->integers.size() ? &data->integers[0] : NULL);
+	column.m_reals = (m_size && data->reals.size() ? &data->reals[0] : NULL);
+
+	column.m_dictionary = &data->dictionary[0];
+	column.m_dictionarySize = (unsigned int) data->dictionary.size();
+
+	return true;
+}
+
+
+// **** CompactRow Implementation ****
+
+CompactRow::CompactRow(CompactColumnarList* list) {
+
+	m_list = list;
+	m_state = PENDING;
+	m_row = 0;
+	m_map = NULL;
+}
+
+CompactNode* CompactRow::map() {
+
+	if (m_map)
+		return m_map;
+
+	CompactDocument* document = m_list->m_document;
+	CompactTable* table = m_list->m_table;
+
+	m_map = (CompactNode *) document->createNode(MAP);
+
+	if (m_state == PENDING) {
+
+		for (size_t i = 0; i < table->m_cells.size(); i++) {
+
+			CompactTable::Cell& cell = table->m_cells[i];
+			const char* value = table->m_text.c_str() + cell.offset;
+
+			if (cell.isTyped)
+				m_map->setValue(cell.key, value, cell.scalar);
+			else
+				m_map->setValue(cell.key, value);
+		}
+
+		table->m_pending = NULL;
+
+	} else {
+
+		// The values in the columns are shared with the map
+		std::vector<CompactTable::Column*>& columns = table->getColumns();
+
+		for (size_t c = 0; c < columns.size(); c++) {
+
+			DynaModel* value = this->cell(columns[c]);
+			if (value)
+				m_map->setValueNode(columns[c]->key, value);
+		}
+
+		m_list->m_columnar = false;
+	}
+
+	m_state = MAPPED;
+	return m_map;
+}
+
+int CompactRow::size() {
+
+	if (m_state != COLUMNAR)
+		return this->map()->size();
+
+	std::vector<CompactTable::Column*>& columns = m_list->m_table->getColumns();
+	int size = 0;
+
+	for (size_t c = 0; c < columns.size(); c++)
+		if (columns[c]->codes[m_row])
+			size++;
+
+	return size;
+}
+
+bool CompactRow::containsKey(const char* key) {
+
+	if (m_state != COLUMNAR)
+		return this->map()->containsKey(key);
+
+	CompactTable::Column* column = m_list->m_table->getColumn(key);
+	return (column && this->cell(column));
+}
+
+std::list<std::string> CompactRow::keys() {
+
+	if (m_state != COLUMNAR)
+		return this->map()->keys();
+
+	std::vector<CompactTable::Column*>& columns = m_list->m_table->getColumns();
+	std::list<std::string> keys;
+
+	for (size_t c = 0; c < columns.size(); c++)
+		if (this->cell(columns[c]))
+			keys.push_back(columns[c]->key);
+
+	return keys;
+}
+
+DynaModelNode CompactRow::get(const char* key) {
+
+	if (m_state != COLUMNAR)
+		return this->map()->get(key);
+
+	CompactTable::Column* column = m_list->m_table->getColumn(key);
+	DynaModel* value = (column ? this->cell(column) : NULL);
+
+	return (value ? m_list->m_document->handle(value) : DynaModelNode());
+}
+
+DynaModelNode CompactRow::get(unsigned int index) {
+
+	if (m_state != COLUMNAR)
+		return this->map()->get(index);
+
+	std::vector<CompactTable::Column*>& columns = m_list->m_table->getColumns();
+
+	for (size_t c = 0; c < columns.size(); c++) {
+
+		DynaModel* value = this->cell(columns[c]);
+		if (value && index-- == 0)
+			return m_list->m_document->handle(value);
+	}
+
+	return DynaModelNode();
+}
+
+void CompactRow::add(DynaModelNode node, const char* key) {
+	this->map()->add(node, key);
+}
+
+DynaModelNode CompactRow::add(const char* key, Type type) {
+	return this->map()->add(key, type);
+}
+
+DynaModelNode CompactRow::add(Type type) {
+	return this->map()->add(type);
+}
+
+void CompactRow::setValue(const char* key, const char* value) {
+
+	if (m_state == PENDING)
+		m_list->m_table->setCell(key, value, NULL);
+	else
+		this->map()->setValue(key, value);
+}
+
+void CompactRow::addValue(const char* value) {
+	this->map()->addValue(value);
+}
+
+void CompactRow::setValue(const char* key, const char* value, const Scalar& scalar) {
+
+	if (m_state == PENDING)
+		m_list->m_table->setCell(key, value, &scalar);
+	else
+		this->map()->setValue(key, value, scalar);
+}
+
+void CompactRow::addValue(const char* value, const Scalar& scalar) {
+	this->map()->addValue(value, scalar);
+}
+
+DynaModelNode CompactRow::createNode(Type type) {
+	return m_list->m_document->handle(m_list->m_document->createNode(type));
+}
+
+DynaModelNode CompactRow::createColumnarList() {
+	return m_list->m_document->handle(m_list->m_document->createColumnarList());
+}
+
+void CompactRow::toJson(std::ostream& cout, int level) {
+
+	if (m_state != COLUMNAR) {
+
+		this->map()->toJson(cout, level);
+		return;
+	}
+
+	std::vector<CompactTable::Column*>& columns = m_list->m_table->getColumns();
+	bool first = true;
+
+	for (size_t c = 0; c < columns.size(); c++) {
+
+		DynaModel* value = this->cell(columns[c]);
+		if (!value)
+			continue;
+
+		if (first) {
+
+			cout << '{';
+			if (level >= 0)
+				cout << std::endl;
+
+		} else
+			cout << (level >= 0 ? ",\n" : ",");
+
+		first = false;
+
+		if (level >= 0) {
+
+			cout.width((level + 1) * INDENT);
+			cout << '"' << columns[c]->key << "\": ";
+			value->toJson(cout, level + 1);
+
+		} else {
+
+			cout << '"' << columns[c]->key << "\":";
+			value->toJson(cout);
+		}
+	}
+
+	// Rows without values are written as empty lists like other maps
+	if (first) {
+
+		cout << "[]";
+
+	} else {
+
+		if (level >= 0) {
+
+			cout << std::endl;
+			cout.width(level * INDENT);
+		}
+
+		cout << '}';
+	}
+}
+
+
+// **** DynaModelBindingConfig Implementation ****
+
+static DynaModel::ValueType valueTypeOf(const std::string& type) {
+
+	return ( type == "int64" ? DynaModel::VAL_INT64 :
+		type == "double" ? DynaModel::VAL_DOUBLE :
+		type == "bool" ? DynaModel::VAL_BOOL :
+		type == "timestamp" ? DynaModel::VAL_TIMESTAMP : DynaModel::VAL_STRING );
+}
+
+void DynaModelBindingConfig::beginBindingsConfigElement(std::map<std::string, std::string>& attribs) {
+
+	m_skipUnbound = (attribs["skipUnbound"] == "true");
+	m_bindOnce = (attribs["bindOnce"] == "true");
+}
+
+void DynaModelBindingConfig::beginBindingConfigElement(std::map<std::string, std::string>& attribs) {
+
+	const char* pathStr = attribs["path"].c_str();
+	std::string& type = attribs["type"];
+
+	Path path(pathStr);
+	m_pathDepth.push(path.length());
+	m_path.append(path);
+
+	DynaModelBinding binding(
+		m_path.str(),
 		attribs["key"].c_str(),
 		attribs["ref"].c_str(),
 		attribs["index"] == "true",
 		type == "map" ? DynaModel::MAP :
-		type == "list" ? DynaModel::LIST : DynaModel::VALUE );
+		type == "list" ? DynaModel::LIST : DynaModel::VALUE,
+		valueTypeOf(type) );
 
 	m_bindings.push_back(binding);
 
@@ -451,6 +1979,7 @@ void DynaModelBindingConfig::beginParseRule(std::map<std::string, std::string>&
     DynaModelBinding::ParseRule& parseRule = binding.m_parseRules.back();
     
     parseRule.key = attribs["key"];
+    parseRule.valueType = valueTypeOf(attribs["type"]);
     
     if (attribs.find("offset") != attribEnd)
         parseRule.offset = atoi(attribs["offset"].c_str());
@@ -490,11 +2019,20 @@ void DynaModelBindingConfig::beginParseValueMapping(std::map<std::string, std::s
 // **** DynaModelBinder Implementation ****
 
 DynaModelBinder::DynaModelBinder() {
+	m_compact = true;
+	m_columnar = true;
 }
 
 DynaModelBinder::DynaModelBinder(DynaModelBindingConfig* config) {
 
+    m_compact = true;
+    m_columnar = true;
+
+    boost::lock_guard<boost::mutex> lock(config->m_rulesLock);
+
     int i, size = config->m_bindings.size();
+    bool isCompiled = (config->m_rules && config->m_numRuleBindings == (size_t) size);
+
     for (i = 0; i < size; i++) {
         
         DynaModelBinding& binding = config->m_bindings[i];
@@ -502,6 +2040,9 @@ DynaModelBinder::DynaModelBinder(DynaModelBindingConfig* config) {
         const char* path = binding.m_path.c_str();
         m_bindingMap[path] = binding;
 
+        if (isCompiled)
+            continue;
+
         switch (binding.m_type) {
                 
             case DynaModel::MAP:
@@ -522,6 +2063,20 @@ DynaModelBinder::DynaModelBinder(DynaModelBindingConfig* config) {
                 break;
         }
     }
+
+    DataBinder::setSkipUnbound(config->m_skipUnbound);
+    DataBinder::setBindOnce(config->m_bindOnce);
+
+    // The rules are compiled once for all binders of the config
+    if (isCompiled) {
+
+        DataBinder::setRules(config->m_rules);
+
+    } else {
+
+        config->m_rules = DataBinder::getRules();
+        config->m_numRuleBindings = size;
+    }
 }
 
 void DynaModelBinder::addBinding(
@@ -562,9 +2117,19 @@ void DynaModelBinder::addBinding(
 	DataBinder::addEndRule(path, bindValue);
 }
 
+void DynaModelBinder::addBinding(
+	const char* path,
+	const char* key,
+	DynaModel::ValueType valueType,
+	bool isIdx ) {
+
+	m_bindingMap[path] = DynaModelBinding(path, key ? key : "", "", isIdx, DynaModel::VALUE, valueType);
+	DataBinder::addEndRule(path, bindValue);
+}
+
 void DynaModelBinder::beginBinding() {
 
-	m_bindingNode.push(DynaModel::create());
+	m_bindingNode.push(m_compact ? DynaModel::createCompact() : DynaModel::create());
 	this->setRoot(m_bindingNode.top());
 
 	m_listBindingProcessed = NULL;
@@ -588,6 +2153,38 @@ void DynaModelBinder::reset() {
 	TypedDataBinder<DynaModel>::reset();
 }
 
+inline DynaModelNode DynaModelBinder::createNode(DynaModel::Type type) {
+
+	// Bound nodes are created in the document of the root
+	if (m_bindingNode.empty())
+		return DynaModel::create(type);
+	else if (type == DynaModel::LIST && m_columnar)
+		return m_bindingNode.top()->createColumnarList();
+	else
+		return m_bindingNode.top()->createNode(type);
+}
+
+// Typed values are parsed once as they are bound and
+// values that cannot be parsed are bound as strings
+static inline void bindScalar(DynaModelNode& node, const char* key, const char* value, DynaModel::ValueType type) {
+
+	DynaModel::Scalar scalar;
+
+	if (type == DynaModel::VAL_STRING) {
+
+		node->setValue(key, value);
+
+	} else if (DynaModel::parseScalar(type, value, scalar)) {
+
+		node->setValue(key, value, scalar);
+
+	} else {
+
+		TRACE("Unable to parse the value '%s' of '%s' which was bound as a string.", value, key);
+		node->setValue(key, value);
+	}
+}
+
 inline void DynaModelBinder::addNodeToParent(const DynaModelBinding* binding) {
 
     if (m_bindingNode.empty()) {
@@ -628,16 +2225,25 @@ inline void DynaModelBinder::addNodeToParent(const DynaModelBinding* binding) {
 
 	} else if (binding->m_key.c_str() > 0) {
 
-		std::vector<std::string> dynModelKeyPath;
-		boost::split(dynModelKeyPath, binding->m_ref, boost::is_any_of("/"), boost::token_compress_on);
-
-		int numKeys = dynModelKeyPath.size();
-		int i = 0;
+		// The referenced path is split in a copy in the arena
+		// rather than into strings allocated for each element
+		char* key = m_arena.copy(binding->m_ref.c_str(), binding->m_ref.length());
+		char* next;
 
 		DynaModelNode node = this->getRootPtr();
 
-		while (node.get() && i < numKeys)
-			node = node->get(dynModelKeyPath[i++].c_str());
+		while (node.get()) {
+
+			if ((next = strchr(key, '/')))
+				*next = 0;
+
+			node = node->get(key);
+
+			if (!next)
+				break;
+
+			for (key = next + 1; *key == '/'; key++);
+		}
 
 		if (node.get()) {
 
@@ -667,11 +2273,11 @@ inline void DynaModelBinder::finalizeListElemProcessing() {
 	}
 }
 
-void DynaModelBinder::beginMap(void* binder, const char *element, std::map<std::string, std::string>& attribs) {
+void DynaModelBinder::beginMap(void* binder, const char *element, const Attributes& attribs) {
 
 	GET_BINDER(DynaModelBinder);
 	dataBinder->finalizeListElemProcessing();
-	dataBinder->m_bindingNode.push(DynaModel::create());
+	dataBinder->m_bindingNode.push(dataBinder->createNode(DynaModel::MAP));
 	dataBinder->m_index.push("");
 }
 
@@ -687,7 +2293,7 @@ void DynaModelBinder::endMap(void* binder, const char* element, const char* body
     dataBinder->m_lastBoundPath = dataBinder->m_path.str();
 }
 
-void DynaModelBinder::beginList(void* binder, const char* element, std::map<std::string, std::string>& attribs) {
+void DynaModelBinder::beginList(void* binder, const char* element, const Attributes& attribs) {
 
 	GET_BINDER(DynaModelBinder);
     
@@ -703,7 +2309,7 @@ void DynaModelBinder::beginList(void* binder, const char* element, std::map<std:
         dataBinder->finalizeListElemProcessing();
     }
 
-    dataBinder->m_bindingNode.push(DynaModel::create(DynaModel::LIST));
+    dataBinder->m_bindingNode.push(dataBinder->createNode(DynaModel::LIST));
     dataBinder->m_index.push("");
 }
 
@@ -758,7 +2364,7 @@ void DynaModelBinder::bindValue(void* binder, const char* element, const char* b
 
 		if (curr->getType() == DynaModel::LIST) {
 
-			curr = DynaModel::create();
+			curr = dataBinder->createNode(DynaModel::MAP);
 			dataBinder->m_bindingNode.push(curr);
 		}
         
@@ -819,15 +2425,15 @@ void DynaModelBinder::bindValue(void* binder, const char* element, const char* b
                 if ( parseRule->valueMapping.size() > 0 &&
                     parseRule->valueMapping.find(parsedValue) != parseRule->valueMapping.end() ) {
 
-                    curr->setValue(parseRule->key.c_str(), parseRule->valueMapping[parsedValue].c_str());
+                    bindScalar(curr, parseRule->key.c_str(), parseRule->valueMapping[parsedValue].c_str(), parseRule->valueType);
                 } else
-                    curr->setValue(parseRule->key.c_str(), parsedValue.c_str());
+                    bindScalar(curr, parseRule->key.c_str(), parsedValue.c_str(), parseRule->valueType);
                 
                 offset = nextOffset;
             }
             
         } else
-            curr->setValue(binding.m_key.c_str(), body);
+            bindScalar(curr, binding.m_key.c_str(), body, binding.m_valueType);
         
         if (binding.m_isIdx) {
         	dataBinder->m_index.pop();
@@ -38,6 +38,7 @@ namespace binding {
 
 
 class DynaModel;
+class DynaModelColumn;
 class DynaModelBindingConfig;
 
 typedef boost::shared_ptr<DynaModel> DynaModelNode;
@@ -54,6 +55,24 @@ public:
 		VALUE
 	};
 
+	enum ValueType {
+		VAL_STRING,
+		VAL_INT64,
+		VAL_DOUBLE,
+		VAL_BOOL,
+		VAL_TIMESTAMP   // Milli-seconds since the epoch
+	};
+
+	// Unboxed value of a typed scalar. Booleans and
+	// timestamps are held as integers.
+	struct Scalar {
+		ValueType type;
+		union {
+			long long integer;
+			double real;
+		};
+	};
+
 public:
 	DynaModel(DynaModelNode node) {
 		m_node = node;
@@ -65,6 +84,31 @@ public:
 
 	static DynaModelNode create(Type type = MAP);
 
+	// Creates the root of a compact document whose nodes, values
+	// and keys are allocated together in an arena that is released
+	// when the last node of the document is no longer referenced
+	static DynaModelNode createCompact(Type type = MAP);
+
+	// Creates a node that can be added to this one. Nodes of a
+	// compact document are created in the same document.
+	virtual DynaModelNode createNode(Type type = MAP) { return create(type); }
+
+	// Creates a list that keeps its rows in columns while the rows
+	// are maps of values that share their keys. Lists of nodes that
+	// are not compact are always kept as rows.
+	virtual DynaModelNode createColumnarList() { return this->createNode(LIST); }
+
+	// Returns the values of the given key of each row of a columnar
+	// list. This fails if any row of the list is not in the columns
+	// or has been changed after it was added.
+	virtual bool getColumn(const char* key, DynaModelColumn& column) { return false; }
+
+	// The compact document the node belongs to if any
+	virtual const void* getDocument() { return NULL; }
+
+	// Bytes held by the compact document the node belongs to
+	virtual size_t getDocumentCapacity() { return 0; }
+
 	bool isValid() { return this->getType() != NUL; }
 
 	virtual Type getType() { return NUL; }
@@ -75,6 +119,29 @@ public:
 
 	virtual const char* value() { return NULL; }
 
+	// Parses the text of a value of the given type
+	static bool parseScalar(ValueType type, const char* text, Scalar& scalar);
+
+	// The scalar of a value bound with a type which is parsed
+	// once when it is bound or NULL for string values
+	virtual const Scalar* scalar() { return NULL; }
+
+	ValueType valueType() {
+		const Scalar* value = this->scalar();
+		return (value ? value->type : VAL_STRING);
+	}
+
+	// Typed accessors that convert the scalar of typed values and
+	// parse string values returning the default if they cannot be
+	long long intValue(long long defaultValue = 0);
+	double doubleValue(double defaultValue = 0.0);
+	bool boolValue(bool defaultValue = false);
+	long long timestampValue(long long defaultValue = 0);
+
+	// Compares the values of two nodes as numbers if both are typed
+	// and as strings otherwise, returning -1, 0 or 1
+	int compare(DynaModel& other);
+
 	virtual DynaModelNode get(const char* key) { return DynaModelNode(); }
 	virtual DynaModelNode get(unsigned int index) { return DynaModelNode(); }
 
@@ -85,6 +152,10 @@ public:
 	virtual void setValue(const char* key, const char* value) { };
 	virtual void addValue(const char* value) { };
 
+	// Adds a typed value keeping the text it was parsed from
+	virtual void setValue(const char* key, const char* value, const Scalar& scalar) { };
+	virtual void addValue(const char* value, const Scalar& scalar) { };
+
 	virtual void toJson(std::ostream& cout, int level = -1) { };
 
 	DynaModel operator[](const char* key) {
@@ -106,16 +177,104 @@ private:
 };
 
 
+// The values of one key of the rows of a columnar list. Cells of
+// typed columns are kept unboxed in arrays for scans and the text of
+// every cell is encoded as the code of a value in the dictionary of
+// the column, with 0 for rows without the key. The arrays are only
+// valid until rows are added to the list.
+class DynaModelColumn {
+
+public:
+	DynaModelColumn() : m_key(NULL), m_type(DynaModel::VAL_STRING), m_size(0),
+		m_codes(NULL), m_integers(NULL), m_reals(NULL), m_dictionary(NULL), m_dictionarySize(0) { }
+
+	const char* getKey() { return m_key; }
+	DynaModel::ValueType getType() { return m_type; }
+
+	// Number of rows
+	unsigned int size() { return m_size; }
+
+	// Cells of VAL_INT64, VAL_BOOL and VAL_TIMESTAMP columns
+	const long long* integers() { return m_integers; }
+	// Cells of VAL_DOUBLE columns
+	const double* reals() { return m_reals; }
+
+	const unsigned int* codes() { return m_codes; }
+
+	// Number of codes including 0
+	unsigned int dictionarySize() { return m_dictionarySize; }
+	DynaModel* dictionaryValue(unsigned int code) { return m_dictionary[code]; }
+
+	bool hasValue(unsigned int row) { return m_codes[row] != 0; }
+	const char* value(unsigned int row) { return (m_codes[row] ? m_dictionary[m_codes[row]]->value() : NULL); }
+
+	// Unboxed cells of typed columns which are 0 for string columns
+	long long intValue(unsigned int row) {
+		return (m_integers ? m_integers[row] : m_reals ? (long long) m_reals[row] : 0);
+	}
+	double doubleValue(unsigned int row) {
+		return (m_reals ? m_reals[row] : m_integers ? (double) m_integers[row] : 0.0);
+	}
+
+	class Iterator {
+
+	public:
+		Iterator(DynaModelColumn* column, unsigned int row) : m_column(column), m_row(row) { }
+
+		bool operator==(const Iterator& other) const { return m_row == other.m_row; }
+		bool operator!=(const Iterator& other) const { return m_row != other.m_row; }
+
+		Iterator& operator++() {
+			m_row++;
+			return *this;
+		}
+
+		unsigned int row() { return m_row; }
+
+		bool hasValue() { return m_column->hasValue(m_row); }
+		const char* value() { return m_column->value(m_row); }
+		long long intValue() { return m_column->intValue(m_row); }
+		double doubleValue() { return m_column->doubleValue(m_row); }
+
+	private:
+		DynaModelColumn* m_column;
+		unsigned int m_row;
+	};
+
+	Iterator begin() { return Iterator(this, 0); }
+	Iterator end() { return Iterator(this, m_size); }
+
+private:
+	// Keeps the document of the list
+	DynaModelNode m_list;
+
+	const char* m_key;
+	DynaModel::ValueType m_type;
+	unsigned int m_size;
+
+	const unsigned int* m_codes;
+	const long long* m_integers;
+	const double* m_reals;
+
+	DynaModel* const* m_dictionary;
+	unsigned int m_dictionarySize;
+
+	friend class CompactColumnarList;
+};
+
+
 class DynaModelBinding {
 
 public:
-	DynaModelBinding() { }
+	DynaModelBinding() : m_valueType(DynaModel::VAL_STRING) { }
 
-	DynaModelBinding(const char* path, const char* key, const char* ref, bool isIdx, DynaModel::Type type )
-		: m_path(path), m_key(key), m_ref(ref), m_isIdx(isIdx), m_type(type) { }
+	DynaModelBinding(const char* path, const char* key, const char* ref, bool isIdx, DynaModel::Type type,
+		DynaModel::ValueType valueType = DynaModel::VAL_STRING )
+		: m_path(path), m_key(key), m_ref(ref), m_isIdx(isIdx), m_type(type), m_valueType(valueType) { }
 
 	DynaModelBinding(const DynaModelBinding& binding)
-		: m_path(binding.m_path), m_key(binding.m_key), m_ref(binding.m_ref), m_isIdx(binding.m_isIdx), m_type(binding.m_type) { 
+		: m_path(binding.m_path), m_key(binding.m_key), m_ref(binding.m_ref), m_isIdx(binding.m_isIdx), m_type(binding.m_type),
+		  m_valueType(binding.m_valueType) { 
         
         m_parseRules.insert(m_parseRules.begin(), binding.m_parseRules.begin(), binding.m_parseRules.end());
     }
@@ -126,6 +285,7 @@ private:
 	std::string m_ref;
 	bool m_isIdx;
 	DynaModel::Type m_type;
+	DynaModel::ValueType m_valueType;
 
 	struct ParseRule {
 
@@ -137,6 +297,7 @@ private:
 			const_cast<ParseRule*>(this)->length = rule->length;
 			const_cast<ParseRule*>(this)->strip = rule->strip;
 			const_cast<ParseRule*>(this)->replace = rule->replace;
+			const_cast<ParseRule*>(this)->valueType = rule->valueType;
 			const_cast<ParseRule*>(this)->valueMapping.insert(rule->valueMapping.begin(), rule->valueMapping.end());
 
 			return *(const_cast<ParseRule*>(this));
@@ -154,6 +315,7 @@ private:
 	    std::string replace;
 
 	    std::string key;
+	    DynaModel::ValueType valueType;
 
 	    boost::unordered_map<std::string, std::string> valueMapping;
 	};
@@ -168,7 +330,9 @@ private:
 class DynaModelBindingConfig {
 
 public:
-    
+	DynaModelBindingConfig() : m_skipUnbound(false), m_bindOnce(false), m_numRuleBindings(0) { }
+
+    void beginBindingsConfigElement(std::map<std::string, std::string>& attribs);
     void beginBindingConfigElement(std::map<std::string, std::string>& attribs);
     void endBindingConfigElement();
     
@@ -181,6 +345,16 @@ private:
     Path m_path;
     std::stack<int> m_pathDepth;
 
+    // Binding modes of the binders created from the config
+    bool m_skipUnbound;
+    bool m_bindOnce;
+
+    // Rules compiled for the bindings which are
+    // shared by all binders created from the config
+    DataBinderRulesPtr m_rules;
+    size_t m_numRuleBindings;
+    boost::mutex m_rulesLock;
+
     friend class DynaModelBinding;
     friend class DynaModelBinder;
 };
@@ -203,29 +377,52 @@ public:
 		const char* key = NULL,
 		bool isIdx = false);
 
+	// Binds values of the given type which are parsed once here
+	void addBinding(
+		const char* path,
+		const char* key,
+		DynaModel::ValueType valueType,
+		bool isIdx = false);
+
 	void beginBinding();
 	void endBinding();
 
 	void reset();
 
+	// Bound models are compact documents unless switched off
+	void setCompact(bool compact) {
+		m_compact = compact;
+	}
+
+	// Lists of compact models are bound as columns while their rows
+	// share their keys unless switched off
+	void setColumnar(bool columnar) {
+		m_columnar = columnar;
+	}
+
 	void addNodeToParent(const DynaModelBinding* binding);
 	void finalizeListElemProcessing();
 
-	static void beginMap(void* binder, const char *element, std::map<std::string, std::string>& attribs);
+	static void beginMap(void* binder, const char *element, const Attributes& attribs);
 	static void endMap(void* binder, const char *element, const char *body);
 
-	static void beginList(void* binder, const char *element, std::map<std::string, std::string>& attribs);
+	static void beginList(void* binder, const char *element, const Attributes& attribs);
 	static void endList(void* binder, const char *element, const char *body);
 
 	static void bindValue(void* binder, const char *element, const char *body);
 
 private:
+	DynaModelNode createNode(DynaModel::Type type);
+
 	boost::unordered_map<std::string, DynaModelBinding> m_bindingMap;
 
 	std::stack<DynaModelNode> m_bindingNode;
 	const DynaModelBinding* m_listBindingProcessed;
 	std::stack<std::string> m_index;
     std::string m_lastBoundPath;
+
+    bool m_compact;
+    bool m_columnar;
     
     friend class DynaModelBinding;
 };
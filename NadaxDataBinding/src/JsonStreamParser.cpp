@@ -22,17 +22,752 @@
 
 #include "JsonStreamParser.h"
 
+#include <stdlib.h>
+#include <sstream>
+
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "exception.h"
+
+// Exception Messages
+#define PARSER_CREATION_ERROR  "Unable to allocate enough memory to create a new parser"
+
+#define DEFAULT_ROOT_NAME  "item"
+
+#define REPLACEMENT_CHARACTER  0xFFFD
+
 
 namespace parser {
 
 
-JsonStreamParser::JsonStreamParser() {
-	// TODO Auto-generated constructor stub
+class JsonParsingException : public CException {
+
+public:
+	JsonParsingException(const char* source, int lineNumber) : CException(source, lineNumber) { }
+    virtual ~JsonParsingException() { }
+};
+
+
+const char* _noAttribs[] = { NULL };
+
+// Returns the first quote, backslash or control character of a
+// string's contents. Most strings are scanned 16 bytes at a time.
+inline const char* findStringDelimiter(const char* p, const char* end) {
+
+#if defined(__SSE2__) && defined(__GNUC__)
+
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i backslash = _mm_set1_epi8('\\');
+	const __m128i control = _mm_set1_epi8(0x1F);
+
+	for (; end - p >= 16; p += 16) {
+
+		__m128i chars = _mm_loadu_si128((const __m128i *) p);
+
+		// A byte is a control character if its
+		// unsigned minimum with 0x1F is itself
+		__m128i delimiters = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(chars, quote), _mm_cmpeq_epi8(chars, backslash)),
+			_mm_cmpeq_epi8(_mm_min_epu8(chars, control), chars) );
+
+		int mask = _mm_movemask_epi8(delimiters);
+		if (mask)
+			return p + __builtin_ctz(mask);
+	}
+
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+
+	const uint8x16_t quote = vdupq_n_u8('"');
+	const uint8x16_t backslash = vdupq_n_u8('\\');
+	const uint8x16_t control = vdupq_n_u8(0x1F);
+
+	for (; end - p >= 16; p += 16) {
+
+		uint8x16_t chars = vld1q_u8((const uint8_t *) p);
+
+		uint8x16_t delimiters = vorrq_u8(
+			vorrq_u8(vceqq_u8(chars, quote), vceqq_u8(chars, backslash)),
+			vcleq_u8(chars, control) );
+
+		// The delimiter is found among these 16 bytes below
+		if (vmaxvq_u8(delimiters))
+			break;
+	}
+
+#endif
+
+	for (; p < end; p++) {
+
+		unsigned char c = (unsigned char) *p;
+		if (c == '"' || c == '\\' || c < 0x20)
+			return p;
+	}
+
+	return end;
+}
+
+inline bool isLiteralChar(char c) {
+	return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '-' || c == '+' || c == '.';
+}
+
+inline bool isNumber(const std::string& literal) {
+
+	const char* p = literal.c_str();
+
+	if (*p == '-')
+		p++;
 
+	if (*p == '0')
+		p++;
+	else if (*p >= '1' && *p <= '9')
+		while (*p >= '0' && *p <= '9') p++;
+	else
+		return false;
+
+	if (*p == '.') {
+
+		if (*(++p) < '0' || *p > '9')
+			return false;
+		while (*p >= '0' && *p <= '9') p++;
+	}
+
+	if (*p == 'e' || *p == 'E') {
+
+		if (*(++p) == '+' || *p == '-')
+			p++;
+		if (*p < '0' || *p > '9')
+			return false;
+		while (*p >= '0' && *p <= '9') p++;
+	}
+
+	return (*p == 0);
+}
+
+
+JsonStreamParser::JsonStreamParser() : m_rootName(DEFAULT_ROOT_NAME) {
+
+	m_buffer = NULL;
+	resetParser();
 }
 
 JsonStreamParser::~JsonStreamParser() {
-	// TODO Auto-generated destructor stub
+
+	if (m_buffer)
+		free(m_buffer);
+}
+
+void JsonStreamParser::resetParser() {
+
+	m_containers.clear();
+
+	m_state = VALUE;
+	m_target = TEXT;
+
+	m_name.clear();
+	m_isAttribute = false;
+
+	m_token.clear();
+
+	m_codePoint = 0;
+	m_hexDigits = 0;
+	m_highSurrogate = 0;
+
+	m_attribs.clear();
+
+	m_error = NULL;
+	m_chunk = NULL;
+	m_chunkIndex = 0;
+	m_byteIndex = 0;
+	m_lineIndex = 0;
+	m_lineNumber = 1;
+}
+
+bool JsonStreamParser::parseLocalBuffer(int size, bool isFinal) {
+
+	return parse(m_buffer, m_buffer + (size > 0 ? size : 0), isFinal);
+}
+
+bool JsonStreamParser::parseExternalBuffer(const char* data, int size, bool isFinal) {
+
+	return parse(data, data + (size > 0 ? size : 0), isFinal);
+}
+
+bool JsonStreamParser::parse(const char* data, const char* end, bool isFinal) {
+
+	if (m_error)
+		return false;
+
+	const char* p = data;
+	m_chunk = data;
+
+	while (p < end) {
+
+		// States within a token that may span chunks
+		switch (m_state) {
+
+			case STRING:
+
+				if (!(p = scanString(p, end)))
+					return false;
+				continue;
+
+			case ESCAPE: {
+
+				char c = *p;
+
+				switch (c) {
+					case '"':
+					case '\\':
+					case '/':
+						break;
+					case 'b':
+						c = '\b';
+						break;
+					case 'f':
+						c = '\f';
+						break;
+					case 'n':
+						c = '\n';
+						break;
+					case 'r':
+						c = '\r';
+						break;
+					case 't':
+						c = '\t';
+						break;
+					case 'u':
+						m_codePoint = 0;
+						m_hexDigits = 0;
+						m_state = UNICODE;
+						p++;
+						continue;
+					default:
+						return fail(p, "Invalid escape sequence in string");
+				}
+
+				appendText(&c, 1);
+				m_state = STRING;
+				p++;
+				continue;
+			}
+
+			case UNICODE:
+
+				for (; p < end && m_hexDigits < 4; p++, m_hexDigits++) {
+
+					char c = *p;
+					int digit;
+
+					if (c >= '0' && c <= '9')
+						digit = c - '0';
+					else if (c >= 'a' && c <= 'f')
+						digit = c - 'a' + 10;
+					else if (c >= 'A' && c <= 'F')
+						digit = c - 'A' + 10;
+					else
+						return fail(p, "Invalid unicode escape sequence in string");
+
+					m_codePoint = (m_codePoint << 4) | digit;
+				}
+
+				if (m_hexDigits == 4) {
+
+					if (m_codePoint >= 0xD800 && m_codePoint <= 0xDBFF) {
+
+						flushSurrogate();
+						m_highSurrogate = m_codePoint;
+
+					} else if (m_codePoint >= 0xDC00 && m_codePoint <= 0xDFFF) {
+
+						if (m_highSurrogate) {
+
+							appendCodePoint(0x10000 + ((m_highSurrogate - 0xD800) << 10) + (m_codePoint - 0xDC00));
+							m_highSurrogate = 0;
+
+						} else
+							appendCodePoint(REPLACEMENT_CHARACTER);
+
+					} else {
+
+						flushSurrogate();
+						appendCodePoint(m_codePoint);
+					}
+
+					m_state = STRING;
+				}
+				continue;
+
+			case LITERAL:
+
+				if (!(p = scanLiteral(p, end)))
+					return false;
+				continue;
+
+			default:
+				break;
+		}
+
+		char c = *p;
+
+		if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+
+			if (c == '\n') {
+
+				m_lineNumber++;
+				m_lineIndex = m_chunkIndex + (p - data) + 1;
+			}
+
+			p++;
+			continue;
+		}
+
+		switch (m_state) {
+
+			case FIRST_VALUE:
+
+				if (c == ']') {
+
+					endContainer();
+					p++;
+					break;
+				}
+				// Otherwise the first value of the array
+
+			case VALUE:
+			case END:
+
+				if (!(p = beginValue(p)))
+					return false;
+				break;
+
+			case FIRST_KEY:
+			case KEY:
+
+				if (c == '"') {
+
+					m_target = MEMBER_KEY;
+					m_token.clear();
+					m_state = STRING;
+
+				} else if (c == '}' && m_state == FIRST_KEY)
+					endContainer();
+				else
+					return fail(p, "Expected the key of an object member");
+
+				p++;
+				break;
+
+			case COLON:
+
+				if (c != ':')
+					return fail(p, "Expected a colon after the key of an object member");
+
+				m_state = VALUE;
+				p++;
+				break;
+
+			case NEXT:
+
+				if (c == ',')
+					m_state = (m_containers.back().isArray ? VALUE : KEY);
+				else if (c == (m_containers.back().isArray ? ']' : '}'))
+					endContainer();
+				else
+					return fail(p, "Expected a comma or the end of an object or array");
+
+				p++;
+				break;
+
+			default:
+				break;
+		}
+	}
+
+	if (isFinal) {
+
+		// A top-level number ends with the document
+		if (m_state == LITERAL && !endLiteral())
+			return fail(end, "Invalid literal value");
+
+		if (m_state != END)
+			return fail(end, "Unexpected end of document");
+	}
+
+	m_chunkIndex += (end - data);
+	m_byteIndex = m_chunkIndex;
+
+	return true;
+}
+
+const char* JsonStreamParser::beginValue(const char* p) {
+
+	char c = *p;
+
+	if (m_containers.empty())
+		m_name = m_rootName;
+	else if (m_containers.back().isArray)
+		m_name = m_containers.back().name;
+
+	if (c == '"') {
+
+		if (m_isAttribute) {
+
+			m_target = ATTRIBUTE;
+			m_token.clear();
+
+		} else {
+
+			m_target = TEXT;
+			startElement(m_name.c_str(), _noAttribs);
+		}
+
+		m_state = STRING;
+		return p + 1;
+	}
+
+	if (c == '{' || c == '[') {
+
+		// Only scalars are attributes
+		if (m_isAttribute) {
+
+			m_isAttribute = false;
+			startPending();
+		}
+
+		if (c == '{') {
+
+			// Members of the top-level object are top-level elements
+			m_containers.push_back(Container(false, m_name, !m_containers.empty()));
+			m_attribs.clear();
+			m_state = FIRST_KEY;
+
+		} else {
+
+			// An array within an array is an element
+			// named like the values of both arrays
+			bool isNested = (!m_containers.empty() && m_containers.back().isArray);
+
+			m_containers.push_back(Container(true, m_name, isNested));
+			m_state = FIRST_VALUE;
+
+			if (isNested) {
+
+				startElement(m_name.c_str(), _noAttribs);
+				m_containers.back().isPending = false;
+			}
+		}
+
+		return p + 1;
+	}
+
+	if (isLiteralChar(c)) {
+
+		m_token.clear();
+		m_state = LITERAL;
+		return p;
+	}
+
+	fail(p, "Expected a value");
+	return NULL;
+}
+
+const char* JsonStreamParser::scanString(const char* p, const char* end) {
+
+	const char* text = p;
+	p = findStringDelimiter(p, end);
+
+	if (p > text)
+		appendText(text, p - text);
+
+	if (p == end)
+		return p;
+
+	if (*p == '"') {
+
+		endString();
+		return p + 1;
+	}
+
+	if (*p == '\\') {
+
+		m_state = ESCAPE;
+		return p + 1;
+	}
+
+	fail(p, "Invalid control character in string");
+	return NULL;
+}
+
+const char* JsonStreamParser::scanLiteral(const char* p, const char* end) {
+
+	const char* literal = p;
+
+	while (p < end && isLiteralChar(*p))
+		p++;
+
+	m_token.append(literal, p - literal);
+
+	// The literal may continue in the next chunk
+	if (p == end)
+		return p;
+
+	if (!endLiteral()) {
+
+		fail(p, "Invalid literal value");
+		return NULL;
+	}
+
+	return p;
+}
+
+bool JsonStreamParser::endLiteral() {
+
+	bool isNull = (m_token == "null");
+
+	if (!isNull && m_token != "true" && m_token != "false" && !isNumber(m_token))
+		return false;
+
+	if (m_isAttribute) {
+
+		m_attribs.push_back(m_name.substr(1));
+		m_attribs.push_back(isNull ? std::string() : m_token);
+
+	} else {
+
+		startElement(m_name.c_str(), _noAttribs);
+		if (!isNull)
+			characters(m_token.c_str(), (int) m_token.length());
+		endElement(m_name.c_str());
+	}
+
+	endValue();
+	return true;
+}
+
+void JsonStreamParser::endString() {
+
+	flushSurrogate();
+
+	switch (m_target) {
+
+		case MEMBER_KEY:
+
+			m_name = m_token;
+
+			// Attributes lead the members of an object
+			m_isAttribute = (m_containers.back().isPending && m_name.length() > 1 && m_name[0] == '@');
+			if (!m_isAttribute)
+				startPending();
+
+			m_state = COLON;
+			break;
+
+		case ATTRIBUTE:
+
+			m_attribs.push_back(m_name.substr(1));
+			m_attribs.push_back(m_token);
+			endValue();
+			break;
+
+		case TEXT:
+
+			endElement(m_name.c_str());
+			endValue();
+			break;
+	}
+}
+
+void JsonStreamParser::endValue() {
+
+	m_isAttribute = false;
+	m_state = (m_containers.empty() ? END : NEXT);
+}
+
+void JsonStreamParser::endContainer() {
+
+	startPending();
+
+	Container& container = m_containers.back();
+	if (container.hasElement)
+		endElement(container.name.c_str());
+
+	m_containers.pop_back();
+	endValue();
+}
+
+void JsonStreamParser::emit(const char* text, size_t len) {
+
+	if (m_target == TEXT)
+		characters(text, (int) len);
+	else
+		m_token.append(text, len);
+}
+
+void JsonStreamParser::appendText(const char* text, size_t len) {
+
+	flushSurrogate();
+	emit(text, len);
+}
+
+void JsonStreamParser::appendCodePoint(unsigned long codePoint) {
+
+	char utf8[4];
+	size_t len;
+
+	if (codePoint < 0x80) {
+
+		utf8[0] = (char) codePoint;
+		len = 1;
+
+	} else if (codePoint < 0x800) {
+
+		utf8[0] = (char) (0xC0 | (codePoint >> 6));
+		utf8[1] = (char) (0x80 | (codePoint & 0x3F));
+		len = 2;
+
+	} else if (codePoint < 0x10000) {
+
+		utf8[0] = (char) (0xE0 | (codePoint >> 12));
+		utf8[1] = (char) (0x80 | ((codePoint >> 6) & 0x3F));
+		utf8[2] = (char) (0x80 | (codePoint & 0x3F));
+		len = 3;
+
+	} else {
+
+		utf8[0] = (char) (0xF0 | (codePoint >> 18));
+		utf8[1] = (char) (0x80 | ((codePoint >> 12) & 0x3F));
+		utf8[2] = (char) (0x80 | ((codePoint >> 6) & 0x3F));
+		utf8[3] = (char) (0x80 | (codePoint & 0x3F));
+		len = 4;
+	}
+
+	emit(utf8, len);
+}
+
+void JsonStreamParser::flushSurrogate() {
+
+	// A high surrogate without its pair
+	if (m_highSurrogate) {
+
+		m_highSurrogate = 0;
+		appendCodePoint(REPLACEMENT_CHARACTER);
+	}
+}
+
+void JsonStreamParser::startPending() {
+
+	if (m_containers.empty() || !m_containers.back().isPending)
+		return;
+
+	Container& container = m_containers.back();
+
+	m_attribPtrs.clear();
+	for (size_t i = 0; i < m_attribs.size(); i++)
+		m_attribPtrs.push_back(m_attribs[i].c_str());
+	m_attribPtrs.push_back(NULL);
+
+	startElement(container.name.c_str(), &m_attribPtrs[0]);
+
+	m_attribs.clear();
+	container.isPending = false;
+}
+
+bool JsonStreamParser::fail(const char* p, const char* error) {
+
+	m_error = error;
+	m_byteIndex = m_chunkIndex + (p - m_chunk);
+
+	return false;
+}
+
+
+JsonBinder::JsonBinder(binding::DataBinder* binder) {
+
+	m_binder = binder;
+	m_binding = false;
+}
+
+JsonBinder::JsonBinder(binding::DataBinderPtr binder) {
+
+	m_binderPtr = binder;
+	m_binder = m_binderPtr.get();
+	m_binding = false;
+}
+
+JsonBinder::~JsonBinder() {
+}
+
+void* JsonBinder::initialize(int size) {
+
+	void* buffer = NULL;
+
+	if (size > 0 && !(buffer = getBuffer(size))) {
+		THROW(JsonParsingException, EXCEP_MSSG(PARSER_CREATION_ERROR));
+	}
+
+	resetParser();
+	return buffer;
+}
+
+void JsonBinder::reset() {
+
+	if (m_binder)
+		m_binder->reset();
+	m_binding = false;
+
+	resetParser();
+}
+
+void JsonBinder::parse(int size, bool isFinal) {
+
+	if (!m_binding) {
+		m_binder->beginBinding();
+		m_binding = true;
+	}
+
+	// The rest of a document that completed the binding is discarded
+	if (!m_binder->isComplete() && !parseLocalBuffer(size, isFinal)) {
+		THROW(JsonParsingException, EXCEP_MSSG(getParsingErrorMessage()));
+	}
+
+	if (isFinal) {
+		m_binder->endBinding();
+		m_binding = false;
+	}
+}
+
+void JsonBinder::parse(const char* data, int size, bool isFinal) {
+
+	if (!m_binding) {
+		m_binder->beginBinding();
+		m_binding = true;
+	}
+
+	// The rest of a document that completed the binding is discarded
+	if (!m_binder->isComplete() && !parseExternalBuffer(data, size, isFinal)) {
+		THROW(JsonParsingException, EXCEP_MSSG(getParsingErrorMessage()));
+	}
+
+	if (isFinal) {
+		m_binder->endBinding();
+		m_binding = false;
+	}
+}
+
+const char* JsonBinder::getParsingErrorMessage() {
+
+	std::ostringstream oss;
+
+	oss << "Parsing error at line " << getCurrentLineNumber()
+		<< " and column " <<  getCurrentColumnNumber()
+		<< " : " << getError();
+
+	m_errorMessage = oss.str();
+	return m_errorMessage.c_str();
 }
 
 
@@ -23,13 +23,231 @@
 #ifndef JSONSTREAMPARSER_H_
 #define JSONSTREAMPARSER_H_
 
+#include <string>
+#include <vector>
+
+#include "Unmarshaller.h"
+#include "DataBinder.h"
+
+
 namespace parser {
 
 
+/* An incremental JSON tokenizer that can be fed a document in
+ * chunks split at any byte. The document is reported with the
+ * same element events as the XML parser so the rules of a data
+ * binder apply to JSON unchanged:
+ *
+ *   - each member of an object is an element named by its key
+ *   - each value of an array is an element named by the array's
+ *     key so {"a":[1,2]} is reported like <a>1</a><a>2</a>
+ *   - scalar members whose key begins with '@' that precede all
+ *     other members of an object are the element's attributes
+ *   - strings, numbers and booleans are the element's text and
+ *     null is an empty element
+ *
+ * The members of the top-level object are reported as top-level
+ * elements. Values of a top-level array and top-level scalars are
+ * reported as elements with the root name. A stream may contain
+ * more than one top-level value separated by whitespace.
+ *
+ * String values are reported in pieces as they are scanned without
+ * copying them unless they contain escapes.
+ */
 class JsonStreamParser {
+
 public:
 	JsonStreamParser();
 	virtual ~JsonStreamParser();
+
+	void setRootName(const char* rootName) {
+		m_rootName = rootName;
+	}
+
+protected:
+
+	// **** JSON parser creation and parsing ****
+
+	void resetParser();
+
+	/* Returns false if the data is not valid JSON in
+	 * which case the parser must be reset for reuse */
+	bool parseLocalBuffer(int size, bool isFinal);
+	bool parseExternalBuffer(const char* data, int size, bool isFinal);
+
+	char* getBuffer(int size) {
+		return (m_buffer = (char *) malloc(size));
+	}
+
+	// **** JSON error handling ****
+
+	const char* getError() {
+		return m_error;
+	}
+
+	long getCurrentByteIndex() {
+		return m_byteIndex;
+	}
+
+	int getCurrentLineNumber() {
+		return m_lineNumber;
+	}
+
+	int getCurrentColumnNumber() {
+		return (int) (m_byteIndex - m_lineIndex);
+	}
+
+	// **** Parsing events ****
+
+	virtual void startElement(const char* name, const char** attribs) { }
+	virtual void endElement(const char* name) { }
+	virtual void characters(const char* text, int len) { }
+
+private:
+
+	enum State {
+		VALUE,            // Expecting a value
+		FIRST_VALUE,      // Expecting a value or the end of an array
+		FIRST_KEY,        // Expecting a key or the end of an object
+		KEY,              // Expecting a key
+		COLON,            // Expecting the colon after a key
+		NEXT,             // Expecting a comma or the end of a container
+		STRING,           // Within a string
+		ESCAPE,           // Within an escape sequence of a string
+		UNICODE,          // Within the hex digits of a unicode escape
+		LITERAL,          // Within a number, true, false or null
+		END               // Expecting whitespace or another top-level value
+	};
+
+	// What a string is being scanned for
+	enum Target {
+		TEXT,             // An element's text
+		MEMBER_KEY,       // The key of an object member
+		ATTRIBUTE         // The value of an attribute
+	};
+
+	struct Container {
+
+		Container(bool isArray, const std::string& name, bool hasElement)
+			: isArray(isArray), name(name), hasElement(hasElement), isPending(hasElement) { }
+
+		bool isArray;
+
+		// Name of the object's element or of the
+		// elements of the array's values
+		std::string name;
+
+		bool hasElement;
+		// The object's element is started once all of
+		// the attributes that lead its members are known
+		bool isPending;
+	};
+
+	bool parse(const char* data, const char* end, bool isFinal);
+
+	const char* beginValue(const char* p);
+	const char* scanString(const char* p, const char* end);
+	const char* scanLiteral(const char* p, const char* end);
+
+	bool endLiteral();
+	void endString();
+	void endValue();
+	void endContainer();
+
+	void emit(const char* text, size_t len);
+	void appendText(const char* text, size_t len);
+	void appendCodePoint(unsigned long codePoint);
+
+	void startPending();
+	void startMember(const std::string& name);
+
+	void flushSurrogate();
+
+	bool fail(const char* p, const char* error);
+
+	std::string m_rootName;
+
+	std::vector<Container> m_containers;
+
+	State m_state;
+	Target m_target;
+
+	// Name of the element of the value being parsed
+	std::string m_name;
+	bool m_isAttribute;
+
+	// Key, attribute value or literal being
+	// accumulated across chunks
+	std::string m_token;
+
+	// Escaped unicode code point being parsed and
+	// a high surrogate waiting for its pair
+	unsigned long m_codePoint;
+	int m_hexDigits;
+	unsigned long m_highSurrogate;
+
+	std::vector<std::string> m_attribs;
+	std::vector<const char*> m_attribPtrs;
+
+	const char* m_error;
+	const char* m_chunk;
+	long m_chunkIndex;
+	long m_byteIndex;
+	long m_lineIndex;
+	int m_lineNumber;
+
+	char* m_buffer;
+};
+
+
+class JsonBinder : public binding::Unmarshaller, public JsonStreamParser {
+
+public:
+	JsonBinder(binding::DataBinder* binder);
+	JsonBinder(binding::DataBinderPtr binder = binding::DataBinderPtr());
+	virtual ~JsonBinder();
+
+	void* initialize(int size = -1);
+	void reset();
+
+	void setDataBinder(binding::DataBinderPtr binder) {
+		m_binderPtr = binder;
+		m_binder = m_binderPtr.get();
+	}
+
+	void parse(int size, bool isFinal);
+	void parse(const char* buffer, int size, bool isFinal);
+
+	void* getResult() {
+		return m_binder->detachRoot();
+	}
+
+	bool isComplete() {
+		return m_binder->isComplete();
+	}
+
+protected:
+
+	virtual void startElement(const char* name, const char** attribs) {
+		m_binder->startElement(name, attribs);
+	}
+	virtual void endElement(const char* name) {
+		m_binder->endElement(name);
+	}
+	virtual void characters(const char* text, int len) {
+		m_binder->characters(text, len);
+	}
+
+private:
+
+	const char* getParsingErrorMessage();
+
+	binding::DataBinderPtr m_binderPtr;
+	binding::DataBinder* m_binder;
+
+	std::string m_errorMessage;
+
+	bool m_binding;
 };
 
 
@@ -0,0 +1,295 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "PathAutomaton.h"
+
+#include <string.h>
+#include <map>
+#include <deque>
+#include <algorithm>
+
+#include "hash.h"
+
+#define ANY_ELEMENT  -1
+#define NO_SYMBOL    -1
+
+
+namespace binding {
+
+
+PathAutomaton::PathAutomaton() {
+
+	m_symbolMask = 0;
+
+	m_numSymbols = 1;
+	m_numStates = 1;
+
+	// Until compiled the empty path is the only state
+	m_transitions.push_back(0);
+	m_matches.resize(1);
+	m_attributeMatches.resize(1, 0);
+	m_live.resize(1, 0);
+
+	m_compiled = false;
+}
+
+PathAutomaton::~PathAutomaton() {
+}
+
+int PathAutomaton::add(const char* pattern) {
+
+	m_patternStrs.push_back(pattern);
+	m_compiled = false;
+
+	return (int) m_patternStrs.size() - 1;
+}
+
+void PathAutomaton::compile() {
+
+	m_patterns.clear();
+	m_symbols.assign(1, std::string());
+
+	std::map<std::string, int> symbols;
+
+	for (size_t i = 0; i < m_patternStrs.size(); i++) {
+
+		const std::string& patternStr = m_patternStrs[i];
+		Pattern pattern;
+		pattern.isWildRoot = false;
+
+		size_t start = 0, end;
+
+		do {
+
+			end = patternStr.find('/', start);
+			std::string element = patternStr.substr(start, end == std::string::npos ? std::string::npos : end - start);
+
+			if (start == 0 && element == "*") {
+
+				pattern.isWildRoot = true;
+
+			} else if (element == "?") {
+
+				pattern.elements.push_back(ANY_ELEMENT);
+
+			} else {
+
+				std::map<std::string, int>::iterator symbol = symbols.find(element);
+				if (symbol == symbols.end())
+					symbol = symbols.insert(std::make_pair(element, this->addSymbol(element))).first;
+
+				pattern.elements.push_back(symbol->second);
+			}
+
+			start = end + 1;
+
+		} while (end != std::string::npos);
+
+		m_patterns.push_back(pattern);
+	}
+
+	m_numSymbols = (int) m_symbols.size();
+
+	// Index the symbols by name leaving the table at most half full
+	size_t tableSize = 8;
+	while (tableSize < m_symbols.size() * 2)
+		tableSize <<= 1;
+
+	m_symbolTable.assign(tableSize, NO_SYMBOL);
+	m_symbolMask = tableSize - 1;
+
+	for (int i = 1; i < m_numSymbols; i++) {
+
+		unsigned long long j = hash(NULL, m_symbols[i].c_str()) & m_symbolMask;
+		while (m_symbolTable[j] != NO_SYMBOL)
+			j = (j + 1) & m_symbolMask;
+
+		m_symbolTable[j] = i;
+	}
+
+	// Each position within a pattern is a state of the equivalent
+	// non-deterministic automaton. The states of the deterministic
+	// automaton are the sets of positions reachable by a path.
+	std::vector<int> positionPattern;
+	std::vector<int> positionIndex;
+	std::vector<int> patternStart;
+
+	for (size_t i = 0; i < m_patterns.size(); i++) {
+
+		patternStart.push_back((int) positionPattern.size());
+
+		for (size_t j = 0; j <= m_patterns[i].elements.size(); j++) {
+
+			positionPattern.push_back((int) i);
+			positionIndex.push_back((int) j);
+		}
+	}
+
+	typedef std::vector<int> PositionSet;
+
+	std::map<PositionSet, int> states;
+	std::deque<PositionSet> pending;
+
+	PositionSet start;
+	for (size_t i = 0; i < m_patterns.size(); i++)
+		start.push_back(patternStart[i]);
+
+	states[start] = 0;
+	pending.push_back(start);
+
+	m_transitions.clear();
+	m_matches.clear();
+
+	for (int state = 0; !pending.empty(); state++) {
+
+		PositionSet positions = pending.front();
+		pending.pop_front();
+
+		m_matches.push_back(std::vector<int>());
+		for (size_t i = 0; i < positions.size(); i++) {
+
+			const Pattern& pattern = m_patterns[positionPattern[positions[i]]];
+			if (positionIndex[positions[i]] == (int) pattern.elements.size())
+				m_matches.back().push_back(positionPattern[positions[i]]);
+		}
+
+		for (int symbol = 0; symbol < m_numSymbols; symbol++) {
+
+			PositionSet next;
+
+			for (size_t i = 0; i < m_patterns.size(); i++) {
+
+				// A wild root may match any number of leading elements
+				if (m_patterns[i].isWildRoot)
+					next.push_back(patternStart[i]);
+			}
+
+			for (size_t i = 0; i < positions.size(); i++) {
+
+				int position = positions[i];
+				const Pattern& pattern = m_patterns[positionPattern[position]];
+				int index = positionIndex[position];
+
+				if ( index < (int) pattern.elements.size() &&
+					(pattern.elements[index] == ANY_ELEMENT || pattern.elements[index] == symbol) )
+					next.push_back(position + 1);
+			}
+
+			std::sort(next.begin(), next.end());
+			next.erase(std::unique(next.begin(), next.end()), next.end());
+
+			std::map<PositionSet, int>::iterator nextState = states.find(next);
+			if (nextState == states.end()) {
+
+				nextState = states.insert(std::make_pair(next, (int) states.size())).first;
+				pending.push_back(next);
+			}
+
+			m_transitions.push_back(nextState->second);
+		}
+	}
+
+	m_numStates = (int) states.size();
+
+	// An attribute is either named by a symbol
+	// prefixed with '@' or is any other name
+	m_attributeMatches.assign(m_numStates, 0);
+
+	for (int state = 0; state < m_numStates; state++) {
+
+		for (int symbol = 0; symbol < m_numSymbols; symbol++) {
+
+			if ( (symbol == 0 || m_symbols[symbol][0] == '@') &&
+				!m_matches[m_transitions[state * m_numSymbols + symbol]].empty() ) {
+
+				m_attributeMatches[state] = 1;
+				break;
+			}
+		}
+	}
+
+	// A state is live if it matches or leads to a live state
+	m_live.assign(m_numStates, 0);
+
+	for (bool changed = true; changed; ) {
+
+		changed = false;
+
+		for (int state = 0; state < m_numStates; state++) {
+
+			if (m_live[state])
+				continue;
+
+			bool live = !m_matches[state].empty();
+
+			for (int symbol = 0; !live && symbol < m_numSymbols; symbol++)
+				live = (m_live[m_transitions[state * m_numSymbols + symbol]] != 0);
+
+			if (live) {
+
+				m_live[state] = 1;
+				changed = true;
+			}
+		}
+	}
+
+	m_compiled = true;
+}
+
+int PathAutomaton::addSymbol(const std::string& name) {
+
+	m_symbols.push_back(name);
+	return (int) m_symbols.size() - 1;
+}
+
+int PathAutomaton::symbol(const char* prefix, const char* name) const {
+
+	if (m_symbolTable.empty())
+		return 0;
+
+	size_t prefixLen = (prefix ? strlen(prefix) : 0);
+	unsigned long long i = hash(prefix, name) & m_symbolMask;
+
+	for (int symbol; (symbol = m_symbolTable[i]) != NO_SYMBOL; i = (i + 1) & m_symbolMask) {
+
+		const char* symbolName = m_symbols[symbol].c_str();
+
+		if ( (!prefixLen || strncmp(symbolName, prefix, prefixLen) == 0) &&
+			strcmp(symbolName + prefixLen, name) == 0 )
+			return symbol;
+	}
+
+	return 0;
+}
+
+unsigned long long PathAutomaton::hash(const char* prefix, const char* name) {
+
+	unsigned long long hash = FNV1A_64_INIT;
+
+	if (prefix)
+		hash = fnv1a64(prefix, strlen(prefix), hash);
+
+	return fnv1a64(name, strlen(name), hash);
+}
+
+
+}  // namespace : binding
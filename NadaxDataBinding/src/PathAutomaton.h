@@ -0,0 +1,137 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef PATHAUTOMATON_H_
+#define PATHAUTOMATON_H_
+
+#include <string>
+#include <vector>
+
+
+namespace binding {
+
+
+/**
+ * A deterministic automaton that matches the path of
+ * elements being parsed against a set of path patterns
+ * with one transition per element.
+ *
+ * Patterns match like Path::equals. A leading '*' matches
+ * any number of leading elements and a '?' matches any
+ * one element. Patterns are compiled once after which the
+ * automaton is immutable and may be shared by threads.
+ */
+class PathAutomaton {
+
+public:
+	PathAutomaton();
+	virtual ~PathAutomaton();
+
+	/* Adds a pattern before the automaton is compiled
+	 * and returns the pattern's index */
+	int add(const char* pattern);
+
+	void compile();
+
+	bool isCompiled() const {
+		return m_compiled;
+	}
+
+	/* The state of the empty path */
+	int getStart() const {
+		return 0;
+	}
+
+	int getNumStates() const {
+		return m_numStates;
+	}
+
+	/* The state of the path extended by the given element */
+	int next(int state, const char* element) const {
+		return m_transitions[state * m_numSymbols + this->symbol(NULL, element)];
+	}
+
+	/* The state of the path extended by the given attribute
+	 * which is matched as an element named '@' attribute */
+	int nextAttribute(int state, const char* attribute) const {
+		return m_transitions[state * m_numSymbols + this->symbol("@", attribute)];
+	}
+
+	/* Indexes of the patterns that match the paths of
+	 * the given state in the order they were added */
+	const std::vector<int>& getMatches(int state) const {
+		return m_matches[state];
+	}
+
+	/* Whether any pattern matches the path of the
+	 * state or any path that extends it */
+	bool isLive(int state) const {
+		return m_live[state] != 0;
+	}
+
+	/* Whether any pattern matches an attribute of
+	 * the element whose path is given by the state */
+	bool hasAttributeMatches(int state) const {
+		return m_attributeMatches[state] != 0;
+	}
+
+private:
+
+	struct Pattern {
+
+		bool isWildRoot;
+
+		// Symbols of the elements that follow any
+		// wild root where ANY matches any element
+		std::vector<int> elements;
+	};
+
+	int symbol(const char* prefix, const char* name) const;
+	int addSymbol(const std::string& name);
+
+	static unsigned long long hash(const char* prefix, const char* name);
+
+	std::vector<std::string> m_patternStrs;
+	std::vector<Pattern> m_patterns;
+
+	// Element names used by the patterns where symbol
+	// 0 is any other name. Names are looked up in an
+	// open addressed table of symbols.
+	std::vector<std::string> m_symbols;
+	std::vector<int> m_symbolTable;
+	unsigned long long m_symbolMask;
+
+	int m_numSymbols;
+	int m_numStates;
+
+	std::vector<int> m_transitions;
+	std::vector<std::vector<int> > m_matches;
+	std::vector<char> m_attributeMatches;
+	std::vector<char> m_live;
+
+	bool m_compiled;
+};
+
+
+}  // namespace : binding
+
+#endif /* PATHAUTOMATON_H_ */
@@ -23,6 +23,7 @@
 #ifndef UNMARSHALLER_H_
 #define UNMARSHALLER_H_
 
+#include "DataBinder.h"
 
 namespace binding {
 
@@ -35,11 +36,30 @@ public:
 	virtual void* initialize(int size = -1) = 0;
 	virtual void reset() = 0;
 
+	/* Sets the binder the parsed document is bound with
+	 * so a pooled unmarshaller can be reused by binders of
+	 * different requests. Resetting the unmarshaller also
+	 * resets the binder it was last given. */
+	virtual void setDataBinder(DataBinderPtr binder) = 0;
+
     virtual void parse(int size, bool isFinal) = 0;
     virtual void parse(const char* buffer, int size, bool isFinal) = 0;
 
+    /* Parses a complete document that the unmarshaller may modify
+     * as it is parsed. Unmarshallers that parse documents in place
+     * override this to avoid copying the document. */
+    virtual void parseDocument(char* buffer, int size) {
+        parse(buffer, size, true);
+    }
+
     virtual void* getResult() = 0;
 
+    /* Whether the binding is complete and the rest
+     * of the document can be discarded unparsed */
+    virtual bool isComplete() {
+        return false;
+    }
+
     void parse(int size) {
         parse(size, size == 0);
     }
@@ -0,0 +1,842 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "XmlInSituParser.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sstream>
+
+#include "exception.h"
+#include "log.h"
+
+// Exception Messages
+#define PARSER_CREATION_ERROR  "Unable to allocate enough memory to create a new parser"
+
+// Parsing errors worded as expat reports them
+#define ERROR_SYNTAX              "syntax error"
+#define ERROR_NO_ELEMENTS         "no element found"
+#define ERROR_INVALID_TOKEN       "not well-formed (invalid token)"
+#define ERROR_UNCLOSED_TOKEN      "unclosed token"
+#define ERROR_TAG_MISMATCH        "mismatched tag"
+#define ERROR_DUPLICATE_ATTRIBUTE "duplicate attribute"
+#define ERROR_JUNK_AFTER_ROOT     "junk after document element"
+#define ERROR_UNDEFINED_ENTITY    "undefined entity"
+#define ERROR_BAD_CHAR_REF        "reference to invalid character number"
+#define ERROR_UNCLOSED_CDATA      "unclosed CDATA section"
+
+#define UTF8_BOM  "\xEF\xBB\xBF"
+
+
+namespace parser {
+
+
+class InSituParsingException : public CException {
+
+public:
+	InSituParsingException(const char* source, int lineNumber) : CException(source, lineNumber) { }
+    virtual ~InSituParsingException() { }
+};
+
+
+inline bool isSpace(char c) {
+	return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+inline bool isNameStart(char c) {
+	return (unsigned char) c >= 0x80 || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == ':';
+}
+
+inline bool isNameChar(char c) {
+	return isNameStart(c) || (c >= '0' && c <= '9') || c == '-' || c == '.';
+}
+
+inline bool startsWith(const char* p, const char* end, const char* prefix, size_t len) {
+	return (size_t) (end - p) >= len && memcmp(p, prefix, len) == 0;
+}
+
+// Returns the first occurrence of the delimiter
+// which is at least two characters long or NULL
+inline char* findDelimiter(char* p, char* end, const char* delimiter, size_t len) {
+
+	while ((size_t) (end - p) >= len) {
+
+		p = (char *) memchr(p, delimiter[0], end - p - len + 1);
+		if (!p)
+			return NULL;
+		if (memcmp(p + 1, delimiter + 1, len - 1) == 0)
+			return p;
+		p++;
+	}
+
+	return NULL;
+}
+
+// Writes the code point as UTF-8 which is never longer than its reference
+inline char* encodeUtf8(unsigned long codePoint, char* out) {
+
+	if (codePoint < 0x80) {
+		*out++ = (char) codePoint;
+	} else if (codePoint < 0x800) {
+		*out++ = (char) (0xC0 | (codePoint >> 6));
+		*out++ = (char) (0x80 | (codePoint & 0x3F));
+	} else if (codePoint < 0x10000) {
+		*out++ = (char) (0xE0 | (codePoint >> 12));
+		*out++ = (char) (0x80 | ((codePoint >> 6) & 0x3F));
+		*out++ = (char) (0x80 | (codePoint & 0x3F));
+	} else {
+		*out++ = (char) (0xF0 | (codePoint >> 18));
+		*out++ = (char) (0x80 | ((codePoint >> 12) & 0x3F));
+		*out++ = (char) (0x80 | ((codePoint >> 6) & 0x3F));
+		*out++ = (char) (0x80 | (codePoint & 0x3F));
+	}
+
+	return out;
+}
+
+inline bool isValidCharacter(unsigned long codePoint) {
+
+	if (codePoint < 0x20)
+		return codePoint == '\t' || codePoint == '\n' || codePoint == '\r';
+
+	return (codePoint < 0xD800 || (codePoint > 0xDFFF && codePoint < 0xFFFE) || (codePoint > 0xFFFF && codePoint <= 0x10FFFF));
+}
+
+
+// **** XmlInSituParser ****
+
+XmlInSituParser::XmlInSituParser() {
+
+	m_skipDepth = 0;
+	m_stopped = false;
+
+	m_error = NULL;
+	m_data = NULL;
+	m_byteIndex = 0;
+}
+
+XmlInSituParser::~XmlInSituParser() {
+}
+
+bool XmlInSituParser::canParseInSitu(const char* data, int size) {
+
+	const char* p = data;
+	const char* end = data + size;
+
+	// UTF-16 with or without a byte order mark
+	if (size >= 2 && (p[0] == 0 || p[1] == 0 || (unsigned char) p[0] == 0xFE || (unsigned char) p[0] == 0xFF))
+		return false;
+
+	if (startsWith(p, end, UTF8_BOM, 3))
+		p += 3;
+
+	if (startsWith(p, end, "<?xml", 5) && p + 5 < end && isSpace(p[5])) {
+
+		const char* declEnd = findDelimiter((char *) p, (char *) end, "?>", 2);
+		if (!declEnd)
+			return true;
+
+		std::string decl(p, declEnd - p);
+		size_t encoding = decl.find("encoding");
+
+		if (encoding != std::string::npos) {
+
+			size_t quote = decl.find_first_of("\"'", encoding);
+			size_t close = (quote != std::string::npos ? decl.find(decl[quote], quote + 1) : std::string::npos);
+
+			if (close != std::string::npos) {
+
+				std::string name = decl.substr(quote + 1, close - quote - 1);
+				if (strcasecmp(name.c_str(), "UTF-8") != 0 && strcasecmp(name.c_str(), "US-ASCII") != 0)
+					return false;
+			}
+		}
+
+		p = declEnd + 2;
+	}
+
+	// A document type declaration follows the declaration
+	// and may only be preceded by comments and PIs
+	while (p < end) {
+
+		if (isSpace(*p)) {
+			p++;
+		} else if (startsWith(p, end, "<!--", 4)) {
+			if (!(p = findDelimiter((char *) p + 4, (char *) end, "-->", 3)))
+				return true;
+			p += 3;
+		} else if (startsWith(p, end, "<?", 2)) {
+			if (!(p = findDelimiter((char *) p + 2, (char *) end, "?>", 2)))
+				return true;
+			p += 2;
+		} else {
+			return !startsWith(p, end, "<!DOCTYPE", 9);
+		}
+	}
+
+	return true;
+}
+
+bool XmlInSituParser::parseInSitu(char* data, int size) {
+
+	m_openElements.clear();
+	m_skipDepth = 0;
+	m_stopped = false;
+
+	m_error = NULL;
+	m_data = data;
+	m_byteIndex = 0;
+
+	char* p = data;
+	char* end = data + size;
+
+	if (startsWith(p, end, UTF8_BOM, 3))
+		p += 3;
+
+	if (!(p = skipMisc(p, end)))
+		return false;
+
+	if (p == end)
+		return fail(p, ERROR_NO_ELEMENTS);
+	if (*p != '<')
+		return fail(p, ERROR_SYNTAX);
+
+	// The root element with its content
+	do {
+
+		p = (*p == '<' ? parseMarkup(p, end) : parseText(p, end));
+
+		if (!p)
+			return false;
+		if (m_stopped)
+			return true;
+
+	} while (!m_openElements.empty() && p < end);
+
+	if (!m_openElements.empty())
+		return fail(p, ERROR_NO_ELEMENTS);
+
+	if (!(p = skipMisc(p, end)))
+		return false;
+
+	if (p != end)
+		return fail(p, ERROR_JUNK_AFTER_ROOT);
+
+	return true;
+}
+
+int XmlInSituParser::getCurrentLineNumber() {
+
+	// Line breaks normalized within the text before
+	// the error may be counted more than once
+	int line = 1;
+
+	if (m_data) {
+
+		for (const char* p = m_data; p < m_data + m_byteIndex; p++)
+			if (*p == '\n')
+				line++;
+	}
+
+	return line;
+}
+
+int XmlInSituParser::getCurrentColumnNumber() {
+
+	if (!m_data)
+		return 0;
+
+	const char* p = m_data + m_byteIndex;
+	while (p > m_data && p[-1] != '\n')
+		p--;
+
+	return (int) (m_data + m_byteIndex - p);
+}
+
+char* XmlInSituParser::parseMarkup(char* p, char* end) {
+
+	if (p + 1 == end)
+		return fail(p, ERROR_UNCLOSED_TOKEN);
+
+	switch (p[1]) {
+
+		case '/':
+			return parseEndTag(p, end);
+
+		case '?':
+			return skipPI(p, end);
+
+		case '!':
+
+			if (startsWith(p, end, "<!--", 4))
+				return skipComment(p, end);
+			if (startsWith(p, end, "<![CDATA[", 9) && !m_openElements.empty())
+				return parseCData(p, end);
+
+			return fail(p, ERROR_INVALID_TOKEN);
+
+		default:
+			return parseStartTag(p, end);
+	}
+}
+
+char* XmlInSituParser::parseStartTag(char* p, char* end) {
+
+	char* name = p + 1;
+	char* q = name;
+
+	if (!isNameStart(*q))
+		return fail(q, ERROR_INVALID_TOKEN);
+
+	while (q < end && isNameChar(*q))
+		q++;
+
+	char* nameEnd = q;
+	bool isEmpty = false;
+
+	if (q < end && !isSpace(*q) && *q != '/' && *q != '>')
+		return fail(q, ERROR_INVALID_TOKEN);
+
+	if (m_skipDepth) {
+
+		// The attributes of skipped elements are not decoded
+		for (;;) {
+
+			while (q < end && *q != '>' && *q != '"' && *q != '\'')
+				q++;
+
+			if (q == end)
+				return fail(p, ERROR_UNCLOSED_TOKEN);
+			if (*q == '>')
+				break;
+
+			char* quote = q;
+			if (!(q = (char *) memchr(q + 1, *q, end - q - 1)))
+				return fail(quote, ERROR_UNCLOSED_TOKEN);
+			q++;
+		}
+
+		isEmpty = (q[-1] == '/');
+		*nameEnd = 0;
+
+		if (!isEmpty) {
+
+			m_openElements.push_back(name);
+			m_skipDepth++;
+		}
+
+		return q + 1;
+	}
+
+	m_attribs.clear();
+
+	for (;;) {
+
+		char* separator = q;
+		while (q < end && isSpace(*q))
+			q++;
+
+		if (q == end)
+			return fail(p, ERROR_UNCLOSED_TOKEN);
+
+		if (*q == '>') {
+			q++;
+			break;
+		}
+
+		if (*q == '/') {
+
+			if (q + 1 == end)
+				return fail(p, ERROR_UNCLOSED_TOKEN);
+			if (q[1] != '>')
+				return fail(q, ERROR_INVALID_TOKEN);
+
+			isEmpty = true;
+			q += 2;
+			break;
+		}
+
+		// Attributes are separated by whitespace
+		if (q == separator || !isNameStart(*q))
+			return fail(q, ERROR_INVALID_TOKEN);
+
+		char* attribName = q;
+		while (q < end && isNameChar(*q))
+			q++;
+
+		char* attribNameEnd = q;
+		while (q < end && isSpace(*q))
+			q++;
+
+		if (q == end)
+			return fail(p, ERROR_UNCLOSED_TOKEN);
+		if (*q != '=')
+			return fail(q, ERROR_INVALID_TOKEN);
+
+		q++;
+		while (q < end && isSpace(*q))
+			q++;
+
+		if (q == end)
+			return fail(p, ERROR_UNCLOSED_TOKEN);
+		if (*q != '"' && *q != '\'')
+			return fail(q, ERROR_INVALID_TOKEN);
+
+		*attribNameEnd = 0;
+
+		for (size_t i = 0; i < m_attribs.size(); i += 2) {
+			if (strcmp(m_attribs[i], attribName) == 0)
+				return fail(attribName, ERROR_DUPLICATE_ATTRIBUTE);
+		}
+
+		char quote = *q++;
+		char* value = q;
+
+		char* close = (char *) memchr(value, quote, end - value);
+		if (!close)
+			return fail(value - 1, ERROR_UNCLOSED_TOKEN);
+
+		// The value is decoded and its whitespace normalized in place
+		char* out = value;
+
+		while (q < close) {
+
+			switch (*q) {
+
+				case '<':
+					return fail(q, ERROR_INVALID_TOKEN);
+
+				case '&':
+					if (!(q = decodeReference(q, close, out)))
+						return NULL;
+					break;
+
+				case '\r':
+					*out++ = ' ';
+					if (++q < close && *q == '\n')
+						q++;
+					break;
+
+				case '\n':
+				case '\t':
+					*out++ = ' ';
+					q++;
+					break;
+
+				default:
+					*out++ = *q++;
+			}
+		}
+
+		*out = 0;
+		q = close + 1;
+
+		m_attribs.push_back(attribName);
+		m_attribs.push_back(value);
+	}
+
+	*nameEnd = 0;
+	m_attribs.push_back(NULL);
+
+	m_openElements.push_back(name);
+	startElement(name, &m_attribs[0]);
+
+	if (isEmpty) {
+
+		m_openElements.pop_back();
+		m_skipDepth = 0;
+
+		if (!m_stopped)
+			endElement(name);
+	}
+
+	return q;
+}
+
+char* XmlInSituParser::parseEndTag(char* p, char* end) {
+
+	char* name = p + 2;
+	char* q = name;
+
+	while (q < end && isNameChar(*q))
+		q++;
+
+	size_t len = q - name;
+
+	while (q < end && isSpace(*q))
+		q++;
+
+	if (q == end)
+		return fail(p, ERROR_UNCLOSED_TOKEN);
+	if (*q != '>' || len == 0)
+		return fail(q, ERROR_INVALID_TOKEN);
+
+	if (m_openElements.empty())
+		return fail(p, ERROR_TAG_MISMATCH);
+
+	const char* open = m_openElements.back();
+	if (strncmp(open, name, len) != 0 || open[len] != 0)
+		return fail(p, ERROR_TAG_MISMATCH);
+
+	m_openElements.pop_back();
+
+	// Only the end of the skipped element itself is reported
+	if (!m_skipDepth || --m_skipDepth == 0)
+		endElement(open);
+
+	return q + 1;
+}
+
+char* XmlInSituParser::parseText(char* p, char* end) {
+
+	char* lt = (char *) memchr(p, '<', end - p);
+	if (!lt)
+		lt = end;
+
+	if (m_skipDepth)
+		return lt;
+
+	char* q = p;
+	while (q < lt && *q != '&' && *q != '\r')
+		q++;
+
+	// Text with references or carriage
+	// returns is decoded in place
+	char* out = q;
+
+	while (q < lt) {
+
+		switch (*q) {
+
+			case '&':
+				if (!(q = decodeReference(q, lt, out)))
+					return NULL;
+				break;
+
+			case '\r':
+				*out++ = '\n';
+				if (++q < lt && *q == '\n')
+					q++;
+				break;
+
+			default:
+				*out++ = *q++;
+		}
+	}
+
+	characters(p, (int) (out - p));
+	return lt;
+}
+
+char* XmlInSituParser::parseCData(char* p, char* end) {
+
+	char* text = p + 9;
+
+	char* close = findDelimiter(text, end, "]]>", 3);
+	if (!close)
+		return fail(p, ERROR_UNCLOSED_CDATA);
+
+	if (m_skipDepth)
+		return close + 3;
+
+	char* q = (char *) memchr(text, '\r', close - text);
+	char* out = q;
+
+	if (q) {
+
+		while (q < close) {
+
+			if (*q == '\r') {
+
+				*out++ = '\n';
+				if (++q < close && *q == '\n')
+					q++;
+
+			} else {
+				*out++ = *q++;
+			}
+		}
+	} else {
+		out = close;
+	}
+
+	startCDataSection();
+
+	if (out > text && !m_stopped)
+		characters(text, (int) (out - text));
+
+	if (!m_stopped)
+		endCDataSection();
+
+	return close + 3;
+}
+
+char* XmlInSituParser::skipMisc(char* p, char* end) {
+
+	while (p < end) {
+
+		if (isSpace(*p)) {
+			p++;
+		} else if (startsWith(p, end, "<?", 2)) {
+			if (!(p = skipPI(p, end)))
+				return NULL;
+		} else if (startsWith(p, end, "<!--", 4)) {
+			if (!(p = skipComment(p, end)))
+				return NULL;
+		} else {
+			break;
+		}
+	}
+
+	return p;
+}
+
+char* XmlInSituParser::skipComment(char* p, char* end) {
+
+	char* close = findDelimiter(p + 4, end, "-->", 3);
+	return (close ? close + 3 : fail(p, ERROR_UNCLOSED_TOKEN));
+}
+
+char* XmlInSituParser::skipPI(char* p, char* end) {
+
+	char* close = findDelimiter(p + 2, end, "?>", 2);
+	return (close ? close + 2 : fail(p, ERROR_UNCLOSED_TOKEN));
+}
+
+char* XmlInSituParser::decodeReference(char* p, char* end, char*& out) {
+
+	char* semicolon = (char *) memchr(p + 1, ';', end - p - 1);
+	if (!semicolon)
+		return fail(p, ERROR_INVALID_TOKEN);
+
+	char* name = p + 1;
+	size_t len = semicolon - name;
+
+	if (len > 1 && name[0] == '#') {
+
+		bool isHex = (name[1] == 'x');
+		char* digits = name + (isHex ? 2 : 1);
+
+		if (digits == semicolon)
+			return fail(p, ERROR_INVALID_TOKEN);
+
+		unsigned long codePoint = 0;
+
+		for (char* d = digits; d < semicolon; d++) {
+
+			int digit;
+
+			if (*d >= '0' && *d <= '9')
+				digit = *d - '0';
+			else if (isHex && *d >= 'a' && *d <= 'f')
+				digit = *d - 'a' + 10;
+			else if (isHex && *d >= 'A' && *d <= 'F')
+				digit = *d - 'A' + 10;
+			else
+				return fail(d, ERROR_INVALID_TOKEN);
+
+			codePoint = codePoint * (isHex ? 16 : 10) + digit;
+			if (codePoint > 0x10FFFF)
+				return fail(p, ERROR_BAD_CHAR_REF);
+		}
+
+		if (!isValidCharacter(codePoint))
+			return fail(p, ERROR_BAD_CHAR_REF);
+
+		out = encodeUtf8(codePoint, out);
+
+	} else if (len == 2 && name[0] == 'l' && name[1] == 't') {
+		*out++ = '<';
+	} else if (len == 2 && name[0] == 'g' && name[1] == 't') {
+		*out++ = '>';
+	} else if (len == 3 && memcmp(name, "amp", 3) == 0) {
+		*out++ = '&';
+	} else if (len == 4 && memcmp(name, "apos", 4) == 0) {
+		*out++ = '\'';
+	} else if (len == 4 && memcmp(name, "quot", 4) == 0) {
+		*out++ = '"';
+	} else {
+		return fail(p, (len > 0 && isNameStart(name[0]) ? ERROR_UNDEFINED_ENTITY : ERROR_INVALID_TOKEN));
+	}
+
+	return semicolon + 1;
+}
+
+char* XmlInSituParser::fail(const char* p, const char* error) {
+
+	m_error = error;
+	m_byteIndex = (long) (p - m_data);
+
+	return NULL;
+}
+
+
+// **** XmlDocumentBinder ****
+
+XmlDocumentBinder::XmlDocumentBinder(binding::DataBinder* binder) {
+
+	m_binder = binder;
+	m_localBuffer = NULL;
+	m_localSize = 0;
+	m_fallback = NULL;
+	m_usingFallback = false;
+}
+
+XmlDocumentBinder::XmlDocumentBinder(binding::DataBinderPtr binder) {
+
+	m_binderPtr = binder;
+	m_binder = m_binderPtr.get();
+	m_localBuffer = NULL;
+	m_localSize = 0;
+	m_fallback = NULL;
+	m_usingFallback = false;
+}
+
+XmlDocumentBinder::~XmlDocumentBinder() {
+
+	delete m_fallback;
+
+	if (m_localBuffer)
+		free(m_localBuffer);
+}
+
+void* XmlDocumentBinder::initialize(int size) {
+
+	if (size > 0) {
+
+		if (m_localBuffer)
+			free(m_localBuffer);
+
+		if (!(m_localBuffer = (char *) malloc(size))) {
+			THROW(InSituParsingException, EXCEP_MSSG(PARSER_CREATION_ERROR));
+		}
+
+		m_localSize = size;
+	}
+
+	return m_localBuffer;
+}
+
+void XmlDocumentBinder::reset() {
+
+	// The fallback resets the binder along with expat
+	if (m_usingFallback)
+		m_fallback->reset();
+	else if (m_binder)
+		m_binder->reset();
+
+	m_usingFallback = false;
+	m_document.clear();
+}
+
+void XmlDocumentBinder::setDataBinder(binding::DataBinderPtr binder) {
+
+	m_binderPtr = binder;
+	m_binder = m_binderPtr.get();
+
+	if (m_fallback)
+		m_fallback->setDataBinder(binder);
+}
+
+void XmlDocumentBinder::parse(int size, bool isFinal) {
+
+	// A document read whole into the local
+	// buffer is parsed where it was read
+	if (isFinal && m_document.empty())
+		this->parseDocument(m_localBuffer, size);
+	else
+		this->parse(m_localBuffer, size, isFinal);
+}
+
+void XmlDocumentBinder::parse(const char* data, int size, bool isFinal) {
+
+	// The buffer is not owned by the binder so
+	// the document is collected to be parsed
+	if (size > 0)
+		m_document.append(data, size);
+
+	if (isFinal) {
+
+		this->parseDocument(&m_document[0], (int) m_document.length());
+		m_document.clear();
+	}
+}
+
+void XmlDocumentBinder::parseDocument(char* buffer, int size) {
+
+	if (!canParseInSitu(buffer, size)) {
+
+		TRACE("Binding a document of %d bytes that cannot be parsed in place with expat.", size);
+
+		if (!m_fallback) {
+
+			m_fallback = (m_binderPtr ? new XmlBinder(m_binderPtr) : new XmlBinder(m_binder));
+			m_fallback->initialize();
+		}
+
+		m_usingFallback = true;
+		m_fallback->parse(buffer, size, true);
+		return;
+	}
+
+	m_binder->beginBinding();
+
+	if (!parseInSitu(buffer, size)) {
+		THROW(InSituParsingException, EXCEP_MSSG(getParsingErrorMessage()));
+	}
+
+	m_binder->endBinding();
+}
+
+void XmlDocumentBinder::startElement(const char* name, const char** attribs) {
+
+	m_binder->startElement(name, attribs);
+
+	if (m_binder->isComplete())
+		stopParser();
+	else if (m_binder->canSkipElement())
+		skipElement();
+}
+
+void XmlDocumentBinder::endElement(const char* name) {
+
+	m_binder->endElement(name);
+
+	if (m_binder->isComplete())
+		stopParser();
+}
+
+const char* XmlDocumentBinder::getParsingErrorMessage() {
+
+	std::ostringstream oss;
+
+	oss << "Parsing error at line " << getCurrentLineNumber()
+		<< " and column " <<  getCurrentColumnNumber()
+		<< " : " << getError();
+
+	m_errorMessage = oss.str();
+	return m_errorMessage.c_str();
+}
+
+
+}  // namespace : parser
@@ -0,0 +1,205 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef XMLINSITUPARSER_H_
+#define XMLINSITUPARSER_H_
+
+#include <string>
+#include <vector>
+
+#include "Unmarshaller.h"
+#include "DataBinder.h"
+#include "XmlStreamParser.h"
+
+
+namespace parser {
+
+
+/* A non-streaming XML parser for documents that are available
+ * whole. The document is tokenized where it is: names and
+ * attribute values are terminated in place and references are
+ * decoded over the text they replace, so element names,
+ * attributes and text are reported as pointers into the parsed
+ * buffer without being copied. The buffer is modified by the
+ * parse and must remain valid while the events are handled.
+ *
+ * Only documents encoded as UTF-8 without a document type
+ * declaration can be parsed in place, which the prolog of a
+ * document can be checked for with canParseInSitu(). Characters
+ * are not validated against the XML character classes.
+ */
+class XmlInSituParser {
+
+public:
+	XmlInSituParser();
+	virtual ~XmlInSituParser();
+
+	/* Returns false if the document has a document type declaration,
+	 * is encoded as UTF-16 or declares an encoding other than UTF-8
+	 * in which case it must be parsed with expat.
+	 */
+	static bool canParseInSitu(const char* data, int size);
+
+protected:
+
+	// **** XML parsing ****
+
+	/* Parses the complete document modifying it in place.
+	 * Returns false if the document is not well-formed. */
+	bool parseInSitu(char* data, int size);
+
+	/* Stops the parse from within an event handler
+	 * without reporting the rest of the document. */
+	void stopParser() {
+		m_stopped = true;
+	}
+
+	/* Skips the content of the element whose start was just
+	 * reported. Only its end is reported of the element. */
+	void skipElement() {
+		m_skipDepth = 1;
+	}
+
+	// **** XML error handling ****
+
+	const char* getError() {
+		return m_error;
+	}
+
+	long getCurrentByteIndex() {
+		return m_byteIndex;
+	}
+
+	int getCurrentLineNumber();
+	int getCurrentColumnNumber();
+
+	// **** Parsing events ****
+
+	virtual void startElement(const char* name, const char** attribs) { }
+	virtual void endElement(const char* name) { }
+	virtual void characters(const char* text, int len) { }
+
+	virtual void startCDataSection() { }
+	virtual void endCDataSection() { }
+
+private:
+
+	char* parseMarkup(char* p, char* end);
+	char* parseStartTag(char* p, char* end);
+	char* parseEndTag(char* p, char* end);
+	char* parseText(char* p, char* end);
+	char* parseCData(char* p, char* end);
+
+	char* skipMisc(char* p, char* end);
+	char* skipComment(char* p, char* end);
+	char* skipPI(char* p, char* end);
+
+	char* decodeReference(char* p, char* end, char*& out);
+
+	char* fail(const char* p, const char* error);
+
+	// Names of the open elements which are
+	// terminated within the document
+	std::vector<const char*> m_openElements;
+	std::vector<const char*> m_attribs;
+
+	// Depth of the element being skipped
+	// within the skipped element
+	int m_skipDepth;
+	bool m_stopped;
+
+	const char* m_error;
+	const char* m_data;
+	long m_byteIndex;
+};
+
+
+/* Binds a complete document that is parsed in place. Chunks given
+ * to parse() are collected until the final chunk and a document
+ * given to parseDocument() is parsed in the caller's buffer. A
+ * document that cannot be parsed in place is bound by an XmlBinder.
+ */
+class XmlDocumentBinder : public binding::Unmarshaller, public XmlInSituParser {
+
+public:
+	XmlDocumentBinder(binding::DataBinder* binder);
+	XmlDocumentBinder(binding::DataBinderPtr binder = binding::DataBinderPtr());
+	virtual ~XmlDocumentBinder();
+
+	void* initialize(int size = -1);
+	void reset();
+
+	void setDataBinder(binding::DataBinderPtr binder);
+
+	void parse(int size, bool isFinal);
+	void parse(const char* buffer, int size, bool isFinal);
+
+	void parseDocument(char* buffer, int size);
+
+	void* getResult() {
+		return m_binder->detachRoot();
+	}
+
+	bool isComplete() {
+		return m_binder->isComplete();
+	}
+
+protected:
+
+	virtual void startElement(const char* name, const char** attribs);
+	virtual void endElement(const char* name);
+
+	virtual void characters(const char* text, int len) {
+		m_binder->characters(text, len);
+	}
+
+	virtual void startCDataSection() {
+		m_binder->startCDataSection();
+	}
+	virtual void endCDataSection() {
+		m_binder->endCDataSection();
+	}
+
+private:
+
+	const char* getParsingErrorMessage();
+
+	binding::DataBinderPtr m_binderPtr;
+	binding::DataBinder* m_binder;
+
+	char* m_localBuffer;
+	int m_localSize;
+
+	// Chunks of the document parsed so far
+	std::string m_document;
+
+	// Binds the documents that cannot be parsed in place
+	XmlBinder* m_fallback;
+	bool m_usingFallback;
+
+	std::string m_errorMessage;
+};
+
+
+}  // namespace : parser
+
+#endif /* XMLINSITUPARSER_H_ */
@@ -22,14 +22,30 @@
 
 #include "XmlStreamParser.h"
 
+#include <string.h>
+#include <strings.h>
 #include <iostream>
 #include <sstream>
 
+#include "boost/thread/tss.hpp"
+
 #include "exception.h"
+#include "log.h"
 
 // Exception Messages
 #define PARSER_CREATION_ERROR  "Unable to allocate enough memory to create a new parser"
 #define PARSER_RESET_ERROR  "Unable to reset parser for reuse"
+#define SKIPPED_ELEMENT_NOT_CLOSED  "The document ended within an element that was being skipped"
+
+#define XML_BINDER_HANDLERS  ( EnableElementHandlers| \
+	EnableCharacterDataHandler| \
+	EnableCdataSectionHandlers| \
+	EnableXmlDeclHandler| \
+	EnableDoctypeDeclHandlers )
+
+// Content shorter than this is parsed rather
+// than skipped which restarts the parser
+#define SKIP_MIN_LENGTH  1024
 
 
 namespace parser {
@@ -42,17 +58,174 @@ public:
     virtual ~XmlParsingException() { }
 };
 
+
+// **** Expat memory suite ****
+
+// The arena is only borrowed by the thread
+static void releaseCurrentArena(XmlParserArena* arena) { }
+
+static boost::thread_specific_ptr<XmlParserArena> _currentArena(releaseCurrentArena);
+
+XmlParserArena::XmlParserArena(size_t chunkSize) : m_arena(chunkSize) {
+
+	memset(m_freeBlocks, 0, sizeof(m_freeBlocks));
+
+	m_allocations = 0;
+	m_heapAllocations = 0;
+}
+
+XmlParserArena::~XmlParserArena() {
+}
+
+void XmlParserArena::reset() {
+
+	memset(m_freeBlocks, 0, sizeof(m_freeBlocks));
+	m_arena.reset();
+}
+
+const XML_Memory_Handling_Suite* XmlParserArena::getMemorySuite() {
+
+	static const XML_Memory_Handling_Suite suite = { allocateBlock, reallocateBlock, freeBlock };
+	return &suite;
+}
+
+XmlParserArena::Scope::Scope(XmlParserArena* arena) {
+
+	m_prior = _currentArena.get();
+	_currentArena.reset(arena);
+}
+
+XmlParserArena::Scope::~Scope() {
+
+	_currentArena.reset(m_prior);
+}
+
+void* XmlParserArena::allocateBlock(size_t size) {
+
+	XmlParserArena* arena = _currentArena.get();
+
+	if (arena)
+		return arena->allocate(size);
+
+	// Expat was called outside the scope of its arena
+	Block* block = (Block *) malloc(sizeof(Block) + size);
+	if (!block)
+		return NULL;
+
+	block->arena = NULL;
+	block->sizeClass = size;
+
+	return block + 1;
+}
+
+void* XmlParserArena::reallocateBlock(void* ptr, size_t size) {
+
+	if (!ptr)
+		return allocateBlock(size);
+
+	Block* block = (Block *) ptr - 1;
+	size_t blockSize = getBlockSize(block);
+
+	if (size <= blockSize && block->arena)
+		return ptr;
+
+	void* data = allocateBlock(size);
+
+	if (data) {
+
+		memcpy(data, ptr, (size < blockSize ? size : blockSize));
+		freeBlock(ptr);
+	}
+
+	return data;
+}
+
+void XmlParserArena::freeBlock(void* ptr) {
+
+	if (!ptr)
+		return;
+
+	Block* block = (Block *) ptr - 1;
+
+	if (block->arena)
+		block->arena->release(block);
+	else
+		free(block);
+}
+
+size_t XmlParserArena::getBlockSize(Block* block) {
+
+	// Heap blocks keep their size in place of the size class
+	return (block->arena ? MIN_BLOCK_SIZE << block->sizeClass : block->sizeClass);
+}
+
+void* XmlParserArena::allocate(size_t size) {
+
+	++m_allocations;
+
+	size_t sizeClass = 0;
+	while (sizeClass < NUM_SIZE_CLASSES && (MIN_BLOCK_SIZE << sizeClass) < size)
+		++sizeClass;
+
+	Block* block;
+
+	if (sizeClass == NUM_SIZE_CLASSES) {
+
+		// Large blocks are not worth keeping around
+		if (!(block = (Block *) malloc(sizeof(Block) + size)))
+			return NULL;
+
+		++m_heapAllocations;
+
+		block->arena = NULL;
+		block->sizeClass = size;
+
+		return block + 1;
+	}
+
+	if ((block = m_freeBlocks[sizeClass])) {
+
+		m_freeBlocks[sizeClass] = *((Block **) (block + 1));
+
+	} else if (!(block = (Block *) m_arena.allocate(sizeof(Block) + (MIN_BLOCK_SIZE << sizeClass))))
+		return NULL;
+
+	block->arena = this;
+	block->sizeClass = sizeClass;
+
+	return block + 1;
+}
+
+void XmlParserArena::release(Block* block) {
+
+	// The free list is linked through the freed blocks
+	*((Block **) (block + 1)) = m_freeBlocks[block->sizeClass];
+	m_freeBlocks[block->sizeClass] = block;
+}
+
 XmlBinder::XmlBinder(binding::DataBinder* binder) {
     
     m_binder = binder;
+    m_localBuffer = NULL;
     m_binding = false;
+    m_trackTags = false;
+    m_chunkIndex = 0;
+    m_parsedBytes = 0;
+    m_skipPending = false;
+    m_skipping = false;
 }
 
 XmlBinder::XmlBinder(binding::DataBinderPtr binder) {
 
     m_binderPtr = binder;
 	m_binder = m_binderPtr.get();
+	m_localBuffer = NULL;
 	m_binding = false;
+	m_trackTags = false;
+	m_chunkIndex = 0;
+	m_parsedBytes = 0;
+	m_skipPending = false;
+	m_skipping = false;
 }
 
 XmlBinder::~XmlBinder() {
@@ -67,21 +240,27 @@ void* XmlBinder::initialize(int size) {
     }
     
 	if (size > 0)
-		buffer = getBuffer(size);
+		buffer = m_localBuffer = getBuffer(size);
 
-	enableHandlers(
-		EnableElementHandlers|
-		EnableCharacterDataHandler|
-		EnableCdataSectionHandlers );
+	enableHandlers(XML_BINDER_HANDLERS);
 
 	return buffer;
 }
     
 void XmlBinder::reset() {
     
-	m_binder->reset();
+	if (m_binder)
+		m_binder->reset();
 	m_binding = false;
 
+	m_trackTags = false;
+	m_openTags.clear();
+	m_openTagStarts.clear();
+
+	m_parsedBytes = 0;
+	m_skipPending = false;
+	m_skipping = false;
+
     if (!resetParser()) {
         THROW(XmlParsingException, EXCEP_MSSG(PARSER_RESET_ERROR));
     }
@@ -89,35 +268,331 @@ void XmlBinder::reset() {
 
 void XmlBinder::parse(int size, bool isFinal) {
 
+	this->parse(m_localBuffer, size, isFinal);
+}
+
+void XmlBinder::parse(const char* data, int size, bool isFinal) {
+
 	if (!m_binding) {
+
 		m_binder->beginBinding();
 		m_binding = true;
-	}
 
-	if (!parseLocalBuffer(size, isFinal)) {
-		THROW(XmlParsingException, EXCEP_MSSG(getParsingErrorMessage()));
+		// The replayed start tags are UTF-8 so skipping
+		// is only possible for documents encoded as such
+		m_trackTags = ( m_binder->isSkipUnbound() && !( size >= 2 &&
+			(data[0] == 0 || data[1] == 0 || (unsigned char) data[0] == 0xFE || (unsigned char) data[0] == 0xFF) ) );
 	}
 
+	this->parseData(data, size, isFinal);
+
 	if (isFinal) {
 		m_binder->endBinding();
 		m_binding = false;
 	}
 }
 
-void XmlBinder::parse(const char* data, int size, bool isFinal) {
+void XmlBinder::parseData(const char* data, int size, bool isFinal) {
 
-	if (!m_binding) {
-		m_binder->beginBinding();
-		m_binding = true;
+	// The rest of a document that completed the binding is discarded
+	if (m_binder->isComplete())
+		return;
+
+	if (m_skipping) {
+
+		int end = this->skipContent(data, size);
+
+		if (end < 0) {
+
+			if (isFinal)
+				THROW(XmlParsingException, EXCEP_MSSG(SKIPPED_ELEMENT_NOT_CLOSED));
+
+			return;
+		}
+
+		this->restartParser();
+
+		data += end;
+		size -= end;
 	}
 
-	if (!parseExternalBuffer(data, size, isFinal)) {
-		THROW(XmlParsingException, EXCEP_MSSG(getParsingErrorMessage()));
+	enum XML_Status status = this->parseChunk(data, size, isFinal);
+
+	for (;;) {
+
+		if (status == XML_STATUS_ERROR) {
+
+			// The parser was stopped once the binding completed
+			if (m_binder->isComplete())
+				return;
+
+			THROW(XmlParsingException, EXCEP_MSSG(getParsingErrorMessage()));
+		}
+
+		if (status == XML_STATUS_OK)
+			return;
+
+		// An empty element ends before it can be skipped
+		if (!m_skipPending) {
+
+			status = resumeParser();
+			continue;
+		}
+
+		m_skipPending = false;
+
+		int offset = (int) (m_skipFrom - m_chunkIndex);
+		const char* content = data + offset;
+		int contentSize = size - offset;
+
+		m_skipState = SKIP_TEXT;
+		m_skipDepth = 0;
+		m_skipCarry = false;
+
+		int end = this->skipContent(content, contentSize);
+
+		if (end < 0) {
+
+			TRACE("Skipping unbound element content beyond the current %d bytes.", contentSize);
+			m_skipping = true;
+
+			if (isFinal)
+				THROW(XmlParsingException, EXCEP_MSSG(SKIPPED_ELEMENT_NOT_CLOSED));
+
+			return;
+		}
+
+		if (end < SKIP_MIN_LENGTH) {
+
+			status = resumeParser();
+			continue;
+		}
+
+		TRACE("Skipped %d bytes of unbound element content.", end);
+		this->restartParser();
+
+		data = content + end;
+		size = contentSize - end;
+
+		status = this->parseChunk(data, size, isFinal);
 	}
+}
 
-	if (isFinal) {
-		m_binder->endBinding();
-		m_binding = false;
+enum XML_Status XmlBinder::parseChunk(const char* data, int size, bool isFinal) {
+
+	m_chunkIndex = m_parsedBytes;
+	m_parsedBytes += size;
+
+	return parseBuffer(data, size, isFinal);
+}
+
+void XmlBinder::startElement(const XML_Char* name, const XML_Char** attribs) {
+
+	m_binder->startElement(name, attribs);
+
+	if (m_binder->isComplete()) {
+
+		XML_StopParser(getParser(), XML_FALSE);
+		return;
+	}
+
+	if (!m_trackTags)
+		return;
+
+	m_openTagStarts.push_back(m_openTags.length());
+	m_openTags += '<';
+	m_openTags += name;
+	m_openTags += '>';
+
+	if (m_binder->canSkipElement()) {
+
+		m_skipFrom = XML_GetCurrentByteIndex(getParser()) + XML_GetCurrentByteCount(getParser());
+
+		// The content can only be skipped if it
+		// is within the data being parsed
+		if (m_skipFrom >= m_chunkIndex && XML_StopParser(getParser(), XML_TRUE) == XML_STATUS_OK)
+			m_skipPending = true;
+	}
+}
+
+void XmlBinder::endElement(const XML_Char* name) {
+
+	m_binder->endElement(name);
+
+	if (m_trackTags && !m_openTagStarts.empty()) {
+
+		m_skipPending = false;
+
+		m_openTags.resize(m_openTagStarts.back());
+		m_openTagStarts.pop_back();
+	}
+
+	if (m_binder->isComplete())
+		XML_StopParser(getParser(), XML_FALSE);
+}
+
+void XmlBinder::xmlDecl(const XML_Char* version, const XML_Char* encoding, bool isStandAlone) {
+
+	if (encoding && strcasecmp(encoding, "UTF-8") != 0 && strcasecmp(encoding, "US-ASCII") != 0)
+		m_trackTags = false;
+}
+
+void XmlBinder::startDoctypeDecl( const XML_Char* name,
+	const XML_Char* systemId, const XML_Char* publicId, bool hasInternalSubset ) {
+
+	// Entities declared by the document would be
+	// lost when the parser is restarted
+	if (hasInternalSubset)
+		m_trackTags = false;
+}
+
+int XmlBinder::skipContent(const char* data, int size) {
+
+	const char* p = data;
+	const char* end = data + size;
+
+	while (p < end) {
+
+		if (m_skipState == SKIP_TEXT) {
+
+			p = (const char *) memchr(p, '<', end - p);
+			if (!p)
+				return -1;
+
+			m_skipState = SKIP_MARKUP;
+			p++;
+			continue;
+		}
+
+		char c = *p++;
+
+		switch (m_skipState) {
+
+			case SKIP_MARKUP:
+
+				if (c == '/') {
+
+					// The end tag of the skipped element whose '<'
+					// may have been at the end of the previous data
+					if (m_skipDepth == 0) {
+
+						if (p - 1 > data)
+							return (int) (p - 2 - data);
+
+						m_skipCarry = true;
+						return 0;
+					}
+
+					m_skipDepth--;
+					m_skipState = SKIP_END_TAG;
+
+				} else if (c == '!') {
+
+					m_skipState = SKIP_BANG;
+
+				} else if (c == '?') {
+
+					m_skipState = SKIP_PI;
+					m_skipMatch = 0;
+
+				} else {
+
+					m_skipState = SKIP_START_TAG;
+					m_skipMatch = 0;
+					m_skipQuote = 0;
+				}
+				break;
+
+			case SKIP_BANG:
+
+				m_skipState = (c == '-' ? SKIP_COMMENT : c == '[' ? SKIP_CDATA : SKIP_DECL);
+				m_skipMatch = 0;
+				break;
+
+			case SKIP_START_TAG:
+
+				if (m_skipQuote) {
+
+					if (c == m_skipQuote)
+						m_skipQuote = 0;
+
+				} else if (c == '"' || c == '\'') {
+
+					m_skipQuote = c;
+
+				} else if (c == '>') {
+
+					// An empty element does not nest
+					if (!m_skipMatch)
+						m_skipDepth++;
+
+					m_skipState = SKIP_TEXT;
+				}
+
+				m_skipMatch = (!m_skipQuote && c == '/');
+				break;
+
+			case SKIP_END_TAG:
+			case SKIP_DECL:
+
+				if (c == '>')
+					m_skipState = SKIP_TEXT;
+				break;
+
+			case SKIP_COMMENT:
+
+				if (c == '>' && m_skipMatch >= 2)
+					m_skipState = SKIP_TEXT;
+				else
+					m_skipMatch = (c == '-' ? m_skipMatch + 1 : 0);
+				break;
+
+			case SKIP_CDATA:
+
+				if (c == '>' && m_skipMatch >= 2)
+					m_skipState = SKIP_TEXT;
+				else
+					m_skipMatch = (c == ']' ? m_skipMatch + 1 : 0);
+				break;
+
+			case SKIP_PI:
+
+				if (c == '>' && m_skipMatch)
+					m_skipState = SKIP_TEXT;
+				else
+					m_skipMatch = (c == '?');
+				break;
+
+			default:
+				break;
+		}
+	}
+
+	return -1;
+}
+
+void XmlBinder::restartParser() {
+
+	m_skipping = false;
+
+	if (!resetParser()) {
+		THROW(XmlParsingException, EXCEP_MSSG(PARSER_RESET_ERROR));
+	}
+
+	// The start tags of the open elements are replayed
+	// without handlers to restore expat's element stack
+	enableHandlers(0);
+
+	m_parsedBytes = 0;
+	enum XML_Status status = this->parseChunk(m_openTags.data(), (int) m_openTags.length(), false);
+
+	if (status == XML_STATUS_OK && m_skipCarry)
+		status = this->parseChunk("<", 1, false);
+
+	enableHandlers(XML_BINDER_HANDLERS);
+
+	if (status != XML_STATUS_OK) {
+		THROW(XmlParsingException, EXCEP_MSSG(getParsingErrorMessage()));
 	}
 }
 
@@ -24,8 +24,10 @@
 #define XMLSTREAMPARSER_H_
 
 #include <string>
+#include <vector>
 
 #include "expat.h"
+#include "arena.h"
 #include "Unmarshaller.h"
 #include "DataBinder.h"
 
@@ -42,8 +44,83 @@
 #define EnableDefaultHandler                1<<15  // Enable/Disable default handler
 
 
+// Size of the chunks expat's memory is allocated in
+#define XML_ARENA_CHUNK_SIZE  16384
+
+
 namespace parser {
 
+/* Memory of an expat parser. Expat's memory suite is given blocks
+ * from an arena that are recycled by size when expat frees them, so
+ * a parser that is reused for many documents stops allocating from
+ * the heap once its arena has grown to the needs of its documents.
+ * All of the parser's memory is released at once when it is reset.
+ *
+ * Expat's memory functions are not given the parser they allocate
+ * for, so the arena is made current for the calling thread while
+ * the parser that owns it is called.
+ */
+class XmlParserArena {
+
+public:
+	XmlParserArena(size_t chunkSize = XML_ARENA_CHUNK_SIZE);
+	virtual ~XmlParserArena();
+
+	// Releases all blocks for a new parser
+	void reset();
+
+	// Number of blocks expat has allocated
+	long getAllocationCount() {
+		return m_allocations;
+	}
+
+	// Number of heap allocations for chunks and large blocks
+	long getHeapAllocationCount() {
+		return m_arena.getChunkCount() + m_heapAllocations;
+	}
+
+	static const XML_Memory_Handling_Suite* getMemorySuite();
+
+	// Makes an arena current for expat calls on this thread
+	class Scope {
+
+	public:
+		Scope(XmlParserArena* arena);
+		~Scope();
+
+	private:
+		XmlParserArena* m_prior;
+	};
+
+private:
+
+	// Blocks are sized in powers of two from the smallest size
+	// class and larger blocks are allocated from the heap
+	static const int NUM_SIZE_CLASSES = 12;
+	static const size_t MIN_BLOCK_SIZE = 32;
+
+	struct Block {
+		XmlParserArena* arena;
+		size_t sizeClass;
+	};
+
+	static void* XMLCALL allocateBlock(size_t size);
+	static void* XMLCALL reallocateBlock(void* ptr, size_t size);
+	static void XMLCALL freeBlock(void* ptr);
+
+	static size_t getBlockSize(Block* block);
+
+	void* allocate(size_t size);
+	void release(Block* block);
+
+	MemoryArena m_arena;
+	Block* m_freeBlocks[NUM_SIZE_CLASSES];
+
+	long m_allocations;
+	long m_heapAllocations;
+};
+
+
 template <class HandlerT>
 class XmlStreamParser {
 
@@ -51,6 +128,18 @@ public:
 	XmlStreamParser();
 	virtual ~XmlStreamParser();
 
+	/* Whether expat allocates from an arena owned by the parser
+	 * rather than the heap. This should be set before the parser
+	 * is created and is on by default. */
+	void setUseArena(bool useArena) {
+		m_useArena = useArena;
+	}
+
+	// Arena of the parser or NULL if expat uses the heap
+	XmlParserArena* getArena() {
+		return m_arena;
+	}
+
 protected:
 
 	// **** Expat parser creation and parsing ****
@@ -61,6 +150,9 @@ protected:
 	bool parseLocalBuffer(int size, bool isFinal);
 	bool parseExternalBuffer(const char* data, int size, bool isFinal);
 
+	enum XML_Status parseBuffer(const char* data, int size, bool isFinal);
+	enum XML_Status resumeParser();
+
 	void enableHandlers(unsigned int handlers);
 
 	char* getBuffer(int size) {
@@ -197,8 +289,12 @@ private:
 
 	XML_Parser m_parser;
     XML_Char* m_charEncoding;
+    XML_Char* m_namespaceSep;
 
     unsigned int m_activeHandlers;
+
+    bool m_useArena;
+    XmlParserArena* m_arena;
     
 	char* m_buffer;
 };
@@ -208,16 +304,25 @@ template <class HandlerT>
 XmlStreamParser<HandlerT>::XmlStreamParser() {
     m_parser = NULL;
     m_charEncoding = NULL;
+    m_namespaceSep = NULL;
+    m_activeHandlers = 0;
+    m_useArena = true;
+    m_arena = NULL;
 	m_buffer = NULL;
 }
 
 template <class HandlerT>
 XmlStreamParser<HandlerT>::~XmlStreamParser() {
 
+	// The parser frees its blocks into its arena
 	if (m_parser)
 		XML_ParserFree(m_parser);
+	if (m_arena)
+		delete m_arena;
     if (m_charEncoding)
         free(m_charEncoding);
+    if (m_namespaceSep)
+        free(m_namespaceSep);
 	if (m_buffer)
 		free(m_buffer);
 }
@@ -230,10 +335,21 @@ bool XmlStreamParser<HandlerT>::createParser(const XML_Char* encoding, const XML
     else
         m_charEncoding = strdup(encoding);
     
-    if (sep != NULL && sep[0] == 0)
-        sep = NULL;
+    if (sep == NULL || sep[0] == 0)
+        m_namespaceSep = NULL;
+    else
+        m_namespaceSep = strdup(sep);
+
+    if (m_useArena) {
+
+    	m_arena = new XmlParserArena();
+
+    	XmlParserArena::Scope scope(m_arena);
+    	m_parser = XML_ParserCreate_MM(m_charEncoding, XmlParserArena::getMemorySuite(), m_namespaceSep);
+
+    } else
+    	m_parser = XML_ParserCreate_MM(m_charEncoding, NULL, m_namespaceSep);
 
-	m_parser = XML_ParserCreate_MM(m_charEncoding, NULL, sep);
 	if (!m_parser)
 		return false;
 
@@ -245,29 +361,54 @@ bool XmlStreamParser<HandlerT>::createParser(const XML_Char* encoding, const XML
 template <class HandlerT>
 bool XmlStreamParser<HandlerT>::resetParser() {
     
-    if (XML_ParserReset(m_parser, m_charEncoding)) {
-        
-        XML_SetUserData(m_parser, (void *) this);
-        enableHandlers(m_activeHandlers);
-        
-        return true;
-    }
-    
-    return false;
+    if (m_arena) {
+
+    	// A new parser is created in the rewound arena
+    	// which releases all memory of the prior one
+    	XmlParserArena::Scope scope(m_arena);
+
+    	XML_ParserFree(m_parser);
+    	m_arena->reset();
+
+    	m_parser = XML_ParserCreate_MM(m_charEncoding, XmlParserArena::getMemorySuite(), m_namespaceSep);
+    	if (!m_parser)
+    		return false;
+
+    } else if (!XML_ParserReset(m_parser, m_charEncoding))
+    	return false;
+
+    XML_SetUserData(m_parser, (void *) this);
+    enableHandlers(m_activeHandlers);
+
+    return true;
 }
 
 template <class HandlerT>
 bool XmlStreamParser<HandlerT>::parseLocalBuffer(int size, bool isFinal) {
 
-	return XML_Parse(m_parser, m_buffer, size, isFinal);
+	return parseBuffer(m_buffer, size, isFinal);
 }
 
 template <class HandlerT>
 bool XmlStreamParser<HandlerT>::parseExternalBuffer(const char* data, int size, bool isFinal) {
 
+	return parseBuffer(data, size, isFinal);
+}
+
+template <class HandlerT>
+enum XML_Status XmlStreamParser<HandlerT>::parseBuffer(const char* data, int size, bool isFinal) {
+
+	XmlParserArena::Scope scope(m_arena);
 	return XML_Parse(m_parser, data, size, isFinal);
 }
 
+template <class HandlerT>
+enum XML_Status XmlStreamParser<HandlerT>::resumeParser() {
+
+	XmlParserArena::Scope scope(m_arena);
+	return XML_ResumeParser(m_parser);
+}
+
 template <class HandlerT>
 void XmlStreamParser<HandlerT>::enableHandlers(unsigned int handlers) {
     
@@ -335,11 +476,16 @@ class XmlBinder : public binding::Unmarshaller, public XmlStreamParser<XmlBinder
     
 public:
     XmlBinder(binding::DataBinder* binder);
-    XmlBinder(binding::DataBinderPtr binder);
+    XmlBinder(binding::DataBinderPtr binder = binding::DataBinderPtr());
     virtual ~XmlBinder();
     
     void* initialize(int size = -1);
     void reset();
+
+    void setDataBinder(binding::DataBinderPtr binder) {
+    	m_binderPtr = binder;
+    	m_binder = m_binderPtr.get();
+    }
     
     void parse(int size, bool isFinal);
     void parse(const char* buffer, int size, bool isFinal);
@@ -348,12 +494,13 @@ public:
     	return m_binder->detachRoot();
     }
 
-    virtual void startElement(const XML_Char* name, const XML_Char** attribs) {
-        m_binder->startElement(name, attribs);
-    }
-    virtual void endElement(const XML_Char* name) {
-        m_binder->endElement(name);
+    bool isComplete() {
+    	return m_binder->isComplete();
     }
+
+    virtual void startElement(const XML_Char* name, const XML_Char** attribs);
+    virtual void endElement(const XML_Char* name);
+
     virtual void characters(const XML_Char* text, int len) {
         m_binder->characters(text, len);
     }
@@ -364,17 +511,66 @@ public:
     virtual void endCDataSection() {
         m_binder->endCDataSection();
     }
+
+    virtual void xmlDecl(const XML_Char* version, const XML_Char* encoding, bool isStandAlone);
+    virtual void startDoctypeDecl( const XML_Char* name,
+    	const XML_Char* systemId, const XML_Char* publicId, bool hasInternalSubset );
     
 private:
+
+    // State of the scan for the end of a skipped element
+    enum SkipState {
+    	SKIP_TEXT,
+    	SKIP_MARKUP,      // After a '<'
+    	SKIP_BANG,        // After a '<!'
+    	SKIP_START_TAG,
+    	SKIP_END_TAG,
+    	SKIP_COMMENT,
+    	SKIP_CDATA,
+    	SKIP_PI,
+    	SKIP_DECL
+    };
+
+    void parseData(const char* data, int size, bool isFinal);
+    enum XML_Status parseChunk(const char* data, int size, bool isFinal);
+
+    int skipContent(const char* data, int size);
+    void restartParser();
     
     const char* getParsingErrorMessage();
     
     binding::DataBinderPtr m_binderPtr;
     binding::DataBinder* m_binder;
+
+    char* m_localBuffer;
     
     std::string m_errorMessage;
 
     bool m_binding;
+
+    // Elements that are not bound are skipped by scanning for
+    // their end tag and restarting expat with the start tags
+    // of the open elements replayed. Skipping is disabled for
+    // documents that expat could not be restarted for.
+    bool m_trackTags;
+
+    std::string m_openTags;
+    std::vector<size_t> m_openTagStarts;
+
+    // Index of the data being parsed and the bytes
+    // given to expat since the parser was restarted
+    long m_chunkIndex;
+    long m_parsedBytes;
+
+    bool m_skipPending;
+    bool m_skipping;
+    bool m_skipCarry;
+    long m_skipFrom;
+
+    SkipState m_skipState;
+    int m_skipDepth;
+    int m_skipMatch;
+    char m_skipQuote;
 };
 
 }
@@ -0,0 +1,239 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "ConcurrencyLimiter.h"
+
+#include <list>
+
+#include "clock.h"
+#include "log.h"
+
+#include "HttpMetrics.h"
+
+// Weight given to the latest sample in the smoothed averages
+#define SMOOTHING_FACTOR        0.1
+// Number of samples after which the baseline RTT is re-learned
+#define BASELINE_RESET_SAMPLES  1000
+
+
+namespace mb {
+	namespace http {
+
+
+// **** ConcurrencyLimiter Implementation ****
+
+ConcurrencyLimiter::ConcurrencyLimiter(int initialLimit, int minLimit, int maxLimit, int maxQueue, long maxQueueWait) {
+
+	m_minLimit = (minLimit < 1 ? 1 : minLimit);
+	m_maxLimit = (maxLimit < m_minLimit ? m_minLimit : maxLimit);
+	m_limit = (initialLimit < m_minLimit ? m_minLimit : initialLimit > m_maxLimit ? m_maxLimit : initialLimit);
+
+	m_maxQueue = (maxQueue < 0 ? 0 : maxQueue);
+	m_maxQueueWait = maxQueueWait;
+
+	m_rttTolerance = 2.0;
+	m_backoffRatio = 0.9;
+
+	m_inFlight = 0;
+
+	m_baselineRtt = 0;
+	m_smoothedRtt = 0;
+	m_lastDecrease = 0;
+	m_samples = 0;
+
+	m_queueDelay = 0;
+	m_maxQueueDelay = 0;
+	m_shed = 0;
+	m_completed = 0;
+	m_failed = 0;
+}
+
+ConcurrencyLimiter::~ConcurrencyLimiter() {
+}
+
+bool ConcurrencyLimiter::submit(boost::shared_ptr<Executor> executor, Task task, RejectHandler reject) {
+
+	long long now = currentTimeMicros();
+
+	{ boost::lock_guard<boost::mutex> lock(m_lock);
+
+		if (canDispatch()) {
+
+			m_inFlight++;
+
+		} else if (m_queue.size() < m_maxQueue) {
+
+			TRACE("Concurrency limit of %d reached. Queuing request behind %d others.", (int) m_limit, m_queue.size());
+
+			m_queue.push_back(PendingTask(executor, task, reject, now));
+			return true;
+
+		} else {
+
+			m_shed++;
+			task.clear();
+		}
+	}
+
+	if (task) {
+
+		executor->submit(boost::bind(&ConcurrencyLimiter::run, this, task, now));
+		return true;
+	}
+
+	WARN("Concurrency limit of %d reached and request queue is full. Shedding request.", (int) m_limit);
+
+	reject();
+	return false;
+}
+
+void ConcurrencyLimiter::run(Task task, long long enqueueTime) {
+
+	long long start = currentTimeMicros();
+	long long delay = start - enqueueTime;
+
+	{ boost::lock_guard<boost::mutex> lock(m_lock);
+
+		m_queueDelay = m_queueDelay * (1 - SMOOTHING_FACTOR) + delay * SMOOTHING_FACTOR;
+		if (delay > m_maxQueueDelay)
+			m_maxQueueDelay = delay;
+	}
+
+	bool success = false;
+
+	try {
+
+		success = task();
+
+	} catch (...) {
+
+		ERROR("Unknown exception caught while executing a concurrency limited task.");
+	}
+
+	complete(currentTimeMicros() - start, success);
+}
+
+void ConcurrencyLimiter::complete(long long rtt, bool success) {
+
+	std::list<PendingTask> dispatched;
+	std::list<PendingTask> rejected;
+
+	{ boost::lock_guard<boost::mutex> lock(m_lock);
+
+		long long now = currentTimeMicros();
+
+		m_inFlight--;
+		m_completed++;
+
+		if (m_samples++)
+			m_smoothedRtt = m_smoothedRtt * (1 - SMOOTHING_FACTOR) + rtt * SMOOTHING_FACTOR;
+		else
+			m_smoothedRtt = rtt;
+
+		if (success && (m_baselineRtt == 0 || rtt < m_baselineRtt))
+			m_baselineRtt = rtt;
+		else if (m_samples % BASELINE_RESET_SAMPLES == 0)
+			// Allow the baseline to follow a change in the no load
+			// latency of the service (i.e. a change in network)
+			m_baselineRtt = (long long) m_smoothedRtt;
+
+		if (!success || rtt > m_baselineRtt * m_rttTolerance) {
+
+			if (!success)
+				m_failed++;
+
+			// Back off at most once per round trip so a burst of slow
+			// responses that were in flight together is a single signal
+			if (now - m_lastDecrease > m_smoothedRtt) {
+
+				m_limit = m_limit * m_backoffRatio;
+				if (m_limit < m_minLimit)
+					m_limit = m_minLimit;
+
+				m_lastDecrease = now;
+
+				TRACE( "Concurrency limit decreased to %d. RTT was %lld us against a baseline of %lld us.",
+					(int) m_limit, rtt, m_baselineRtt );
+			}
+
+		} else if (m_inFlight + 1 >= m_limit / 2) {
+
+			// Only grow the limit if it is actually being used
+			m_limit += 1.0 / m_limit;
+			if (m_limit > m_maxLimit)
+				m_limit = m_maxLimit;
+		}
+
+		while (canDispatch() && !m_queue.empty()) {
+
+			PendingTask pending = m_queue.front();
+			m_queue.pop_front();
+
+			if (m_maxQueueWait > 0 && (now - pending.enqueueTime) / 1000 > m_maxQueueWait) {
+
+				m_shed++;
+				rejected.push_back(pending);
+
+			} else {
+
+				m_inFlight++;
+				dispatched.push_back(pending);
+			}
+		}
+	}
+
+	for (std::list<PendingTask>::iterator i = dispatched.begin(); i != dispatched.end(); i++)
+		i->executor->submit(boost::bind(&ConcurrencyLimiter::run, this, i->task, i->enqueueTime));
+
+	for (std::list<PendingTask>::iterator i = rejected.begin(); i != rejected.end(); i++) {
+
+		WARN("Request waited longer than %ld ms in the concurrency limiter queue. Shedding request.", m_maxQueueWait);
+		i->reject();
+	}
+}
+
+void ConcurrencyLimiter::getMetrics(NameValueMap& metrics) {
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+
+	metrics["concurrency.limit"] = metricValue((int) m_limit);
+	metrics["concurrency.inFlight"] = metricValue(m_inFlight);
+	metrics["concurrency.queued"] = metricValue(m_queue.size());
+	metrics["concurrency.queueDelayAvgMs"] = metricValue(m_queueDelay / 1000);
+	metrics["concurrency.queueDelayMaxMs"] = metricValue(m_maxQueueDelay / 1000.0);
+	metrics["concurrency.rttMs"] = metricValue(m_smoothedRtt / 1000);
+	metrics["concurrency.baselineRttMs"] = metricValue(m_baselineRtt / 1000.0);
+	metrics["concurrency.shed"] = metricValue(m_shed);
+	metrics["concurrency.completed"] = metricValue(m_completed);
+	metrics["concurrency.failed"] = metricValue(m_failed);
+}
+
+void ConcurrencyLimiter::log(std::ostream& cout) {
+
+	cout << "\tConcurrency limit - " << m_minLimit << " <= " << (int) m_limit << " <= " << m_maxLimit << std::endl;
+	cout << "\tConcurrency queue - max " << m_maxQueue << " requests / " << m_maxQueueWait << " ms" << std::endl;
+	cout << "\tConcurrency RTT tolerance - " << m_rttTolerance << ", backoff ratio - " << m_backoffRatio << std::endl;
+}
+
+
+	}  // namespace : http
+}  // namespace : mb
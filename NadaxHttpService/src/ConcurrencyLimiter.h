@@ -0,0 +1,136 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef CONCURRENCYLIMITER_H_
+#define CONCURRENCYLIMITER_H_
+
+#include <deque>
+
+#include "boost/function.hpp"
+#include "boost/shared_ptr.hpp"
+#include "boost/thread.hpp"
+
+#include "executor.h"
+
+#include "Service.h"
+
+
+namespace mb {
+	namespace http {
+
+
+/* Adaptive concurrency limiter for a single service. The
+ * limit follows an AIMD (additive increase, multiplicative
+ * decrease) scheme driven by the observed round trip time
+ * of each request. While requests complete within the
+ * tolerated RTT of the baseline the limit grows by one for
+ * every limit's worth of completions. When the RTT exceeds
+ * the tolerance or a request fails the limit is cut by the
+ * backoff ratio. Requests submitted while the limit has
+ * been reached are queued without blocking the caller and
+ * are shed once the queue is full or a queued request has
+ * waited longer than the maximum queue wait time.
+ */
+class ConcurrencyLimiter {
+
+public:
+	/* A limited task returns whether the request succeeded */
+	typedef boost::function<bool ()> Task;
+	/* Called when a task is shed instead of being executed */
+	typedef boost::function<void ()> RejectHandler;
+
+public:
+	ConcurrencyLimiter(int initialLimit, int minLimit, int maxLimit, int maxQueue, long maxQueueWait);
+	virtual ~ConcurrencyLimiter();
+
+	void setRttTolerance(double rttTolerance) {
+		m_rttTolerance = rttTolerance;
+	}
+	void setBackoffRatio(double backoffRatio) {
+		m_backoffRatio = backoffRatio;
+	}
+
+	/* Submits a task for execution. The task is dispatched to the
+	 * executor immediately if the limit permits, otherwise it is
+	 * queued. If the task is shed the reject handler is called and
+	 * false is returned.
+	 */
+	bool submit(boost::shared_ptr<Executor> executor, Task task, RejectHandler reject);
+
+	void getMetrics(NameValueMap& metrics);
+	void log(std::ostream& cout);
+
+private:
+
+	struct PendingTask {
+
+		PendingTask(boost::shared_ptr<Executor> executor, Task task, RejectHandler reject, long long enqueueTime)
+			: executor(executor), task(task), reject(reject), enqueueTime(enqueueTime) { }
+
+		boost::shared_ptr<Executor> executor;
+		Task task;
+		RejectHandler reject;
+		long long enqueueTime;
+	};
+
+	void run(Task task, long long enqueueTime);
+	void complete(long long rtt, bool success);
+
+	bool canDispatch() {
+		return m_inFlight < (int) m_limit;
+	}
+
+	boost::mutex m_lock;
+
+	double m_limit;
+	int m_minLimit;
+	int m_maxLimit;
+
+	size_t m_maxQueue;
+	long m_maxQueueWait;
+
+	double m_rttTolerance;
+	double m_backoffRatio;
+
+	int m_inFlight;
+	std::deque<PendingTask> m_queue;
+
+	// RTT statistics in micro-seconds
+	long long m_baselineRtt;
+	double m_smoothedRtt;
+	long long m_lastDecrease;
+	long m_samples;
+
+	// Queue statistics
+	double m_queueDelay;
+	long long m_maxQueueDelay;
+	long m_shed;
+	long m_completed;
+	long m_failed;
+};
+
+
+	}  // namespace : http
+}  // namespace : mb
+
+
+#endif /* CONCURRENCYLIMITER_H_ */
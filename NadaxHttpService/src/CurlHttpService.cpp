@@ -28,9 +28,17 @@
 #include "staticinit.h"
 #include "log.h"
 #include "executor.h"
+#include "clock.h"
+#include "hash.h"
 
 #include "OpenSSLInit.h"
 #include "HttpService.h"
+#include "ConcurrencyLimiter.h"
+#include "HedgingPolicy.h"
+#include "HttpResponseCache.h"
+#include "HttpTransferTimings.h"
+#include "HttpMetrics.h"
+#include "MessageBusManager.h"
 
 
 #define DEFAULT_POOL_SIZE            5
@@ -40,6 +48,10 @@
 #define DEFAULT_POOL_LINGER_TIME     30000
 #define DEFAULT_POOL_EVICT_CHECKS    -1
 
+#define DEFAULT_PREWARM_CONNECTIONS  1
+
+#define DEFAULT_SERVICE_GROUP        "default"
+
 
 namespace mb {
 	namespace http {
@@ -55,12 +67,13 @@ int curlTrace(CURL* curl, curl_infotype infotype, char* text, size_t len, void*
 class HttpConnection {
 
 public:
-	HttpConnection() {
+	HttpConnection(CURLSH* share) {
 
 		m_curlHandle = curl_easy_init();
 		if (m_curlHandle) {
 
 		    curl_easy_setopt(m_curlHandle, CURLOPT_ERRORBUFFER, m_error);
+		    curl_easy_setopt(m_curlHandle, CURLOPT_SHARE, share);
 		    curl_easy_setopt(m_curlHandle, CURLOPT_NOSIGNAL, 1L);
 		    curl_easy_setopt(m_curlHandle, CURLOPT_DEBUGFUNCTION, curlTrace);
 		    curl_easy_setopt(m_curlHandle, CURLOPT_VERBOSE, 1L);
@@ -128,16 +141,17 @@ public:
 class HttpConnectionPool : public ObjectPool<HttpConnection> {
 
 public:
-	HttpConnectionPool(int maxCachedConnections) {
+	HttpConnectionPool(int maxCachedConnections, CURLSH* share) {
 
 		m_maxCachedConnections = maxCachedConnections;
+		m_share = share;
 	}
 
 protected:
 
 	virtual HttpConnection* create() {
 
-		HttpConnection* connection = new HttpConnection();
+		HttpConnection* connection = new HttpConnection(m_share);
 		if (!connection->m_curlHandle) {
 
 			FATAL("Unable to create cURL handle.");
@@ -159,8 +173,183 @@ protected:
 
 private:
 	int m_maxCachedConnections;
+	CURLSH* m_share;
+};
+
+
+// Executor and cURL handle pool of a group of services. Each
+// group is a bulkhead so a service that is slow or misbehaving
+// can only exhaust the threads and handles of its own group.
+// Services that are not assigned a group share the default
+// group configured by the curlhttpservice element.
+//
+// The handles of a group share their DNS cache, TLS sessions
+// and connection cache so a connection opened by any handle,
+// i.e. when pre-warming, can be reused by all the others.
+class HttpServiceGroup {
+
+public:
+	HttpServiceGroup(const std::string& name, std::map<std::string, std::string>& attribs)
+		: m_name(name) {
+
+		m_share = curl_share_init();
+		curl_share_setopt(m_share, CURLSHOPT_LOCKFUNC, lockShare);
+		curl_share_setopt(m_share, CURLSHOPT_UNLOCKFUNC, unlockShare);
+		curl_share_setopt(m_share, CURLSHOPT_USERDATA, this);
+		curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+		curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900
+		curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+
+		// cURL handle pool configuration
+		int size = DEFAULT_POOL_SIZE;
+		int max = DEFAULT_POOL_MAX;
+		int timeout = DEFAULT_POOL_TIMEOUT;
+		int evictInterval = DEFAULT_POOL_EVICT_INTERVAL;
+		int lingerTime = DEFAULT_POOL_LINGER_TIME;
+		int evictChecks = DEFAULT_POOL_EVICT_CHECKS;
+
+		// cURL internal cache size (number of connections
+		// cached within each cURL handle defaults to 5)
+		int maxCachedConnections = -1;
+
+		if (attribs.find("poolSize") != attribs.end())
+			size = atoi(attribs["poolSize"].c_str());
+		if (attribs.find("poolMax") != attribs.end())
+			max = atoi(attribs["poolMax"].c_str());
+		if (attribs.find("poolTimeout") != attribs.end())
+			timeout = atoi(attribs["poolTimeout"].c_str());
+		if (attribs.find("poolEvictInterval") != attribs.end())
+			evictInterval = atoi(attribs["poolEvictInterval"].c_str());
+		if (attribs.find("poolLingerTime") != attribs.end())
+			lingerTime = atoi(attribs["poolLingerTime"].c_str());
+		if (attribs.find("poolEvictChecks") != attribs.end())
+			evictChecks = atoi(attribs["poolEvictChecks"].c_str());
+		if (attribs.find("maxCachedConnections") != attribs.end())
+			maxCachedConnections = atoi(attribs["maxCachedConnections"].c_str());
+
+		m_pool = boost::shared_ptr<HttpConnectionPool>(new HttpConnectionPool(maxCachedConnections, m_share));
+		m_pool->setPoolSize(size, max, timeout);
+		m_pool->setPoolManagement(evictInterval, lingerTime, evictChecks);
+
+		// Concurrency is the number of threads the executor will make available for
+		// asynchronous execution. The executor does not grow the thread count but will
+		// instead queue work items if all threads are busy.
+		m_concurrency = size;
+		if (attribs.find("concurrency") != attribs.end())
+			m_concurrency = atoi(attribs["concurrency"].c_str());
+
+		m_executor = boost::shared_ptr<Executor>(new Executor((size_t) m_concurrency));
+
+		m_requests = 0;
+		m_queueTime = 0;
+		m_maxQueueTime = 0;
+	}
+
+	~HttpServiceGroup() {
+
+		// The handles must be released before the data they share
+		m_executor.reset();
+		m_pool.reset();
+
+		curl_share_cleanup(m_share);
+	}
+
+	const std::string& getName() {
+		return m_name;
+	}
+
+	boost::shared_ptr<Executor> getExecutor() {
+		return m_executor;
+	}
+
+	boost::shared_ptr<HttpConnectionPool> getPool() {
+		return m_pool;
+	}
+
+	// Records the time a request waited for an executor thread
+	void recordQueueTime(long long queueTime) {
+
+		boost::lock_guard<boost::mutex> lock(m_lock);
+
+		m_requests++;
+		m_queueTime += queueTime;
+		if (queueTime > m_maxQueueTime)
+			m_maxQueueTime = queueTime;
+	}
+
+	void getMetrics(NameValueMap& metrics) {
+
+		metrics["group.name"] = m_name;
+		metrics["group.concurrency"] = metricValue(m_concurrency);
+		metrics["group.pool.allocated"] = metricValue(m_pool->getAllocatedSize());
+		metrics["group.pool.waits"] = metricValue(m_pool->getWaitCount());
+		metrics["group.pool.exhausted"] = metricValue(m_pool->getExhaustedCount());
+
+		boost::lock_guard<boost::mutex> lock(m_lock);
+
+		metrics["group.requests"] = metricValue(m_requests);
+		metrics["group.queue.mean"] = metricValue(m_requests ? m_queueTime / m_requests : 0);
+		metrics["group.queue.max"] = metricValue(m_maxQueueTime);
+	}
+
+private:
+
+	static void lockShare(CURL* handle, curl_lock_data data, curl_lock_access access, void* userptr) {
+		((HttpServiceGroup *) userptr)->m_shareLocks[data].lock();
+	}
+
+	static void unlockShare(CURL* handle, curl_lock_data data, void* userptr) {
+		((HttpServiceGroup *) userptr)->m_shareLocks[data].unlock();
+	}
+
+	std::string m_name;
+	int m_concurrency;
+
+	CURLSH* m_share;
+	boost::mutex m_shareLocks[CURL_LOCK_DATA_LAST];
+
+	boost::shared_ptr<HttpConnectionPool> m_pool;
+	boost::shared_ptr<Executor> m_executor;
+
+	boost::mutex m_lock;
+	long m_requests;
+	long long m_queueTime;
+	long long m_maxQueueTime;
 };
 
+typedef boost::shared_ptr<HttpServiceGroup> HttpServiceGroupPtr;
+
+std::map<std::string, HttpServiceGroupPtr> _groups;
+boost::mutex _groupsLock;
+
+// Groups replaced by a configuration reload while they
+// were still executing requests. A group is released
+// once idle so its threads are never joined by one of
+// its own requests.
+std::list<HttpServiceGroupPtr> _retiredGroups;
+
+void addGroup(HttpServiceGroupPtr group) {
+
+	boost::lock_guard<boost::mutex> lock(_groupsLock);
+
+	std::list<HttpServiceGroupPtr>::iterator i = _retiredGroups.begin();
+	while (i != _retiredGroups.end()) {
+
+		if (i->unique())
+			i = _retiredGroups.erase(i);
+		else
+			i++;
+	}
+
+	std::map<std::string, HttpServiceGroupPtr>::iterator current = _groups.find(group->getName());
+	if (current != _groups.end())
+		_retiredGroups.push_back(current->second);
+
+	_groups[group->getName()] = group;
+}
+
 
 int curlTrace(CURL* curl, curl_infotype infotype, char* text, size_t len, void* userdata) {
 
@@ -169,8 +358,379 @@ int curlTrace(CURL* curl, curl_infotype infotype, char* text, size_t len, void*
 }
 
 
-boost::shared_ptr<Executor> _executor;
-boost::shared_ptr<HttpConnectionPool> _pool;
+// State of an HTTP request shared by all attempts to
+// execute it. A request will have more than one attempt
+// only if it was hedged.
+class HttpRequest {
+
+public:
+	HttpRequest(MessagePtr message, MessagePtr response)
+		: message(message), response(response) {
+
+		isPoll = message->isAdaptivePoll();
+		isPost = false;
+		timeout = 0;
+
+		queueTime = currentTimeMicros();
+
+		cacheBodyLimit = 0;
+
+		m_winner = -1;
+		m_running = 0;
+	}
+
+	// Claims the response for the given attempt. Only the
+	// first attempt to receive a response may stream it.
+	bool claim(int attempt) {
+		boost::lock_guard<boost::mutex> lock(m_lock);
+		if (m_winner == -1)
+			m_winner = attempt;
+		return (m_winner == attempt);
+	}
+
+	// Returns true if the request's message was cancelled
+	bool isCancelled() {
+		return message->isCancelled();
+	}
+
+	// Returns true if the response was claimed
+	// by an attempt other than the given one.
+	bool isCancelled(int attempt) {
+		boost::lock_guard<boost::mutex> lock(m_lock);
+		return (m_winner != -1 && m_winner != attempt);
+	}
+
+	bool hasResponse() {
+		boost::lock_guard<boost::mutex> lock(m_lock);
+		return (m_winner != -1);
+	}
+
+	void beginAttempt() {
+		boost::lock_guard<boost::mutex> lock(m_lock);
+		m_running++;
+	}
+
+	// Ends an attempt and returns true if the attempt should
+	// complete the response. A failed attempt completes the
+	// response only if no other attempt is still running.
+	bool endAttempt(int attempt, bool success) {
+		boost::lock_guard<boost::mutex> lock(m_lock);
+		m_running--;
+		if (m_winner == -1 && (success || m_running == 0))
+			m_winner = attempt;
+		return (m_winner == attempt);
+	}
+
+	MessagePtr message;
+	MessagePtr response;
+
+	// The response of an adaptive poll is buffered
+	// and posted only if its content has changed
+	bool isPoll;
+
+	std::string url;
+	std::string body;
+	std::list<std::string> headers;
+	// Body streamed instead of the rendered body
+	HttpRequestBodyPtr upload;
+
+	bool isPost;
+	long timeout;
+
+	// Time the request was queued for execution
+	long long queueTime;
+	// Group whose executor and handles execute the request
+	HttpServiceGroupPtr group;
+
+	// Key of the response in the service's response cache
+	std::string cacheKey;
+	size_t cacheBodyLimit;
+	// Stale cached response being revalidated
+	CachedResponsePtr cached;
+	// Model the response was bound to
+	boost::shared_ptr<binding::DynaModel> model;
+
+private:
+
+	boost::mutex m_lock;
+
+	int m_winner;
+	int m_running;
+};
+
+typedef boost::shared_ptr<HttpRequest> HttpRequestPtr;
+
+
+// State of a single HTTP transfer passed to the cURL callbacks
+struct HttpTransfer {
+
+	HttpTransfer(HttpRequestPtr request, int attempt)
+		: request(request), attempt(attempt) {
+
+		startTime = currentTimeMicros();
+		firstByteTime = 0;
+
+		bodyOverflow = false;
+		contentHash = FNV1A_64_INIT;
+
+		bytesReceived = 0;
+		isStopped = false;
+	}
+
+	HttpRequestPtr request;
+	int attempt;
+
+	long long startTime;
+	long long firstByteTime;
+
+	// Response body and headers retained for the response
+	// cache or for comparison with the previous poll response
+	std::string body;
+	bool bodyOverflow;
+	unsigned long long contentHash;
+
+	std::string etag;
+	std::string lastModified;
+	std::string cacheControl;
+	std::string expires;
+
+	// Size of the response body after it was decoded
+	long long bytesReceived;
+
+	// The receivers of the response needed no more
+	// data so the rest of the transfer was dropped
+	bool isStopped;
+};
+
+size_t curlWrite(char* data, size_t size, size_t nmemb, void* userdata) {
+
+	HttpTransfer* transfer = (HttpTransfer *) userdata;
+	size_t len = size * nmemb;
+
+	if (transfer->request->isCancelled())
+		return 0;
+
+	if (!transfer->firstByteTime) {
+
+		transfer->firstByteTime = currentTimeMicros();
+
+		// Abort the transfer if another attempt claimed the response
+		if (!transfer->request->claim(transfer->attempt))
+			return 0;
+	}
+
+	if (len) {
+
+		HttpRequest* request = transfer->request.get();
+		transfer->bytesReceived += len;
+
+		if (request->isPoll || request->cacheKey.length()) {
+
+			transfer->contentHash = fnv1a64(data, len, transfer->contentHash);
+
+			if (!transfer->bodyOverflow) {
+
+				// Poll responses are always buffered in full
+				if (!request->isPoll && transfer->body.length() + len > request->cacheBodyLimit) {
+
+					transfer->bodyOverflow = true;
+					transfer->body.clear();
+
+				} else
+					transfer->body.append(data, len);
+			}
+		}
+
+		if (!request->isPoll && !SEND_DATA(request->response, data, len) && !request->isCancelled()) {
+
+			transfer->isStopped = true;
+			return 0;
+		}
+	}
+
+	return len;
+}
+
+size_t curlHeader(char* data, size_t size, size_t nitems, void* userdata) {
+
+	HttpTransfer* transfer = (HttpTransfer *) userdata;
+	size_t len = size * nitems;
+
+	if (!transfer->request->cacheKey.length())
+		return len;
+
+	std::string header(data, len);
+
+	if (header.compare(0, 5, "HTTP/") == 0) {
+
+		// Headers of an interim or redirect response are discarded
+		transfer->etag.clear();
+		transfer->lastModified.clear();
+		transfer->cacheControl.clear();
+		transfer->expires.clear();
+		return len;
+	}
+
+	size_t colon = header.find(':');
+	if (colon == std::string::npos)
+		return len;
+
+	std::string name = header.substr(0, colon);
+	std::string value;
+
+	size_t begin = header.find_first_not_of(" \t", colon + 1);
+	size_t end = header.find_last_not_of(" \t\r\n");
+	if (begin != std::string::npos && end >= begin)
+		value = header.substr(begin, end - begin + 1);
+
+	if (strcasecmp(name.c_str(), "ETag") == 0)
+		transfer->etag = value;
+	else if (strcasecmp(name.c_str(), "Last-Modified") == 0)
+		transfer->lastModified = value;
+	else if (strcasecmp(name.c_str(), "Cache-Control") == 0)
+		transfer->cacheControl = value;
+	else if (strcasecmp(name.c_str(), "Expires") == 0)
+		transfer->expires = value;
+
+	return len;
+}
+
+size_t curlDiscard(char* data, size_t size, size_t nmemb, void* userdata) {
+
+	return size * nmemb;
+}
+
+size_t curlRead(char* buffer, size_t size, size_t nitems, void* userdata) {
+
+	HttpTransfer* transfer = (HttpTransfer *) userdata;
+
+	if (transfer->request->isCancelled())
+		return CURL_READFUNC_ABORT;
+
+	long len = transfer->request->upload->read(buffer, size * nitems);
+	return (len < 0 ? CURL_READFUNC_ABORT : (size_t) len);
+}
+
+int curlSeek(void* userdata, curl_off_t offset, int origin) {
+
+	HttpTransfer* transfer = (HttpTransfer *) userdata;
+
+	// The body is only ever resent from its beginning,
+	// i.e. when following a redirect
+	if (offset == 0 && origin == SEEK_SET && transfer->request->upload->rewind())
+		return CURL_SEEKFUNC_OK;
+
+	return CURL_SEEKFUNC_CANTSEEK;
+}
+
+int curlProgress(void* userdata, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow) {
+
+	HttpTransfer* transfer = (HttpTransfer *) userdata;
+	HttpRequest* request = transfer->request.get();
+
+	return (request->isCancelled(transfer->attempt) || request->isCancelled() ? 1 : 0);
+}
+
+long curlHttpVersion(const std::string& version) {
+
+	if (version == "1.0")
+		return CURL_HTTP_VERSION_1_0;
+	else if (version == "1.1")
+		return CURL_HTTP_VERSION_1_1;
+	else if (version == "2")
+		return CURL_HTTP_VERSION_2_0;
+	else if (version == "2-prior-knowledge")
+		return CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE;
+	else
+		return CURL_HTTP_VERSION_NONE;
+}
+
+// Reads the timing breakdown and sizes of the last transfer
+void getTransferTiming(CURL* curl, TransferTiming& timing) {
+
+	curl_off_t value = 0;
+
+	// Times elapsed since the start of the transfer
+	if (curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME_T, &value) == CURLE_OK)
+		timing.nameLookup = value;
+	if (curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &value) == CURLE_OK)
+		timing.connect = value;
+	if (curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &value) == CURLE_OK)
+		timing.appConnect = value;
+	if (curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &value) == CURLE_OK)
+		timing.startTransfer = value;
+	if (curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &value) == CURLE_OK)
+		timing.total = value;
+
+	// The download size is as received before any decoding
+	if (curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &value) == CURLE_OK)
+		timing.downloadSize = value;
+	if (curl_easy_getinfo(curl, CURLINFO_SIZE_UPLOAD_T, &value) == CURLE_OK)
+		timing.uploadSize = value;
+
+	long headerSize = 0, connects = 0;
+	if (curl_easy_getinfo(curl, CURLINFO_HEADER_SIZE, &headerSize) == CURLE_OK)
+		timing.headerSize = headerSize;
+	if (curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects) == CURLE_OK)
+		timing.isReused = (connects == 0);
+}
+
+// Appends a rendered request template to the query string of the url
+void appendQueryString(std::string& url, const std::string& query) {
+
+	size_t begin = query.find_first_not_of(" \t\r\n");
+	if (begin == std::string::npos)
+		return;
+
+	size_t end = query.find_last_not_of(" \t\r\n");
+
+	url += (url.find('?') == std::string::npos ? '?' : '&');
+	url += query.substr(begin, end - begin + 1);
+}
+
+void setTransferError(MessagePtr response, CURLcode code, long status, const char* error) {
+
+	if (code != CURLE_OK) {
+
+		Message::Error errorType;
+
+		switch (code) {
+
+			case CURLE_OPERATION_TIMEDOUT:
+				errorType = Message::ERR_EXECUTION_TIMEOUT;
+				break;
+
+			case CURLE_COULDNT_RESOLVE_PROXY:
+			case CURLE_COULDNT_RESOLVE_HOST:
+			case CURLE_COULDNT_CONNECT:
+				errorType = Message::ERR_CONNECTION_ERROR;
+				break;
+
+			default:
+				errorType = Message::ERR_CONNECTION_BREAK;
+				break;
+		}
+
+		response->setError(errorType, code, (error && *error ? error : curl_easy_strerror(code)));
+
+	} else if (status >= 400) {
+
+		std::ostringstream description;
+		description << "HTTP request failed with status " << status << '.';
+
+		response->setError(Message::ERR_SERVICE, status, description.str().c_str());
+	}
+}
+
+
+void cacheBoundData(void* context, MessagePtr message, void* data) {
+
+	HttpRequest* request = (HttpRequest *) context;
+	request->model = *((boost::shared_ptr<binding::DynaModel> *) data);
+}
+
+
+boost::shared_ptr<Executor> _scheduler;
 
 
 STATIC_INIT_NULL_IMPL(CurlHttpService)
@@ -179,6 +739,11 @@ CurlHttpService::CurlHttpService(const std::string& subject, const std::string&
 	: HttpService(subject, url) {
 
 	Service::setType("curl");
+
+	m_prewarmConnections = 0;
+	m_prewarmRequests = 0;
+	m_prewarmed = 0;
+	m_prewarmFailures = 0;
 }
 
 CurlHttpService::~CurlHttpService() {
@@ -186,10 +751,607 @@ CurlHttpService::~CurlHttpService() {
 
 mb::Message* CurlHttpService::createMessage() {
 
-	return NULL;
+	return HttpService::createMessage();
+}
+
+void CurlHttpService::execute(MessagePtr message, MessagePtr response, std::string& body) {
+
+	HttpServiceGroupPtr group = this->getGroup();
+
+	if (!group || !_scheduler) {
+
+		ERROR("The cURL HTTP services have not been configured. Unable to execute request for service '%s'.", this->getSubject());
+
+		response->setError(Message::ERR_SERVICE, 1, "HTTP services have not been configured.");
+		this->endResponse(HttpRequestPtr(new HttpRequest(message, response)));
+		return;
+	}
+
+	http::HttpMessage* httpMessage = (http::HttpMessage *) message.get();
+	HttpRequestPtr request(new HttpRequest(message, response));
+	request->group = group;
+
+	std::list<Message::NameValue>::iterator i;
+	bool hasContentType = false;
+
+	for (i = m_headers.begin(); i != m_headers.end(); i++) {
+		request->headers.push_back(i->name + ": " + i->value);
+		hasContentType = hasContentType || (strcasecmp(i->name.c_str(), "Content-Type") == 0);
+	}
+	std::list<Message::NameValue>& messageHeaders = httpMessage->getHeaders();
+	for (i = messageHeaders.begin(); i != messageHeaders.end(); i++) {
+		request->headers.push_back(i->name + ": " + i->value);
+		hasContentType = hasContentType || (strcasecmp(i->name.c_str(), "Content-Type") == 0);
+	}
+
+	request->url = m_url;
+	request->timeout = m_timeout;
+
+	HttpRequestBodyPtr upload = httpMessage->getRequestBody();
+
+	if (upload) {
+
+		if (!hasContentType)
+			request->headers.push_back("Content-Type: " + upload->getContentType());
+
+		request->isPost = true;
+		request->upload = upload;
+
+		appendQueryString(request->url, body);
+
+	} else if (m_method == http::HttpMessage::POST) {
+
+		if (!hasContentType) {
+
+			if (m_contentType == Message::CNT_XML)
+				request->headers.push_back("Content-Type: text/xml");
+			else if (m_contentType == Message::CNT_JSON)
+				request->headers.push_back("Content-Type: application/json");
+		}
+
+		request->isPost = true;
+		request->body = body;
+
+	} else {
+
+		// The request template of a GET service
+		// renders the query string of the URL
+		appendQueryString(request->url, body);
+	}
+
+	// Streamed bodies are not cached as the body
+	// is part of the key of a cached POST request
+	if (m_responseCache && !upload && (!request->isPost || m_responseCache->isIncludePost())) {
+
+		request->cacheKey = request->url;
+		for (std::list<std::string>::iterator j = request->headers.begin(); j != request->headers.end(); j++)
+			request->cacheKey += '\n' + *j;
+		if (request->isPost)
+			request->cacheKey += "\n\n" + request->body;
+
+		request->cacheBodyLimit = m_responseCache->getMaxBodySize();
+
+		bool isModel = (response->getMetaData()[DATA_IS_DYNA_MODEL] == CSTR_TRUE);
+		CachedResponsePtr cached = m_responseCache->lookup(request->cacheKey, isModel);
+
+		if (cached) {
+
+			if (cached->isFresh(currentTimeMillis())) {
+
+				TRACE("Returning cached response for service '%s' with url '%s'.", this->getSubject(), request->url.c_str());
+
+				m_responseCache->recordHit(cached->body.length());
+				this->sendCachedResponse(request, cached, HTTP_CACHE_STATUS_HIT);
+				return;
+			}
+
+			if (cached->hasValidator()) {
+
+				TRACE("Revalidating cached response for service '%s' with url '%s'.", this->getSubject(), request->url.c_str());
+
+				request->cached = cached;
+
+				if (cached->etag.length())
+					request->headers.push_back("If-None-Match: " + cached->etag);
+				if (cached->lastModified.length())
+					request->headers.push_back("If-Modified-Since: " + cached->lastModified);
+			}
+		}
+	}
+
+	if (m_concurrencyLimiter) {
+
+		m_concurrencyLimiter->submit( group->getExecutor(),
+			boost::bind(&CurlHttpService::performRequest, this, request),
+			boost::bind(&CurlHttpService::rejectRequest, this, request) );
+
+	} else
+		group->getExecutor()->submit(boost::bind(&CurlHttpService::performRequest, this, request));
+}
+
+HttpServiceGroupPtr CurlHttpService::getGroup() {
+
+	boost::lock_guard<boost::mutex> lock(_groupsLock);
+
+	// A service whose group has not been configured
+	// falls back to the default group
+	std::map<std::string, HttpServiceGroupPtr>::iterator group = _groups.find(m_group);
+	if (group == _groups.end())
+		group = _groups.find(DEFAULT_SERVICE_GROUP);
+
+	return (group != _groups.end() ? group->second : HttpServiceGroupPtr());
+}
+
+void CurlHttpService::start() {
+
+	this->prewarm();
+}
+
+void CurlHttpService::resume(std::istream* input) {
+
+	// Idle connections may have been dropped while in the background
+	this->prewarm();
+}
+
+void CurlHttpService::getMetrics(NameValueMap& metrics) {
+
+	HttpService::getMetrics(metrics);
+
+	HttpServiceGroupPtr group = this->getGroup();
+	if (group)
+		group->getMetrics(metrics);
+
+	if (m_prewarmConnections) {
+
+		boost::lock_guard<boost::mutex> lock(m_prewarmLock);
+
+		metrics["prewarm.requests"] = metricValue(m_prewarmRequests);
+		metrics["prewarm.connections"] = metricValue(m_prewarmed);
+		metrics["prewarm.failures"] = metricValue(m_prewarmFailures);
+	}
+}
+
+void CurlHttpService::prewarm() {
+
+	if (m_prewarmConnections <= 0)
+		return;
+
+	HttpServiceGroupPtr group = this->getGroup();
+	if (!group) {
+
+		TRACE("The cURL HTTP services have not been configured. Connections for service '%s' will not be pre-warmed.", this->getSubject());
+		return;
+	}
+
+	TRACE("Pre-warming %d connections for service '%s' with url '%s'.", m_prewarmConnections, this->getSubject(), m_url.c_str());
+
+	group->getExecutor()->submit(boost::bind(&CurlHttpService::prewarmConnections, this, group));
+}
+
+void CurlHttpService::prewarmConnections(HttpServiceGroupPtr group) {
+
+	std::vector< boost::shared_ptr<HttpConnection> > connections;
+	CURLM* multi = curl_multi_init();
+
+	// The requests are sent concurrently on different handles as
+	// otherwise each would reuse the connection of the one before
+	for (int i = 0; i < m_prewarmConnections; i++) {
+
+		boost::shared_ptr<HttpConnection> connection;
+
+		try {
+
+			connection = group->getPool()->getObject();
+
+		} catch (pool_error& e) {
+
+			WARN( "Unable to retrieve a cURL handle from the pool of group '%s' to pre-warm service '%s'.",
+				group->getName().c_str(), this->getSubject() );
+
+			boost::lock_guard<boost::mutex> lock(m_prewarmLock);
+			m_prewarmFailures += m_prewarmConnections - i;
+			break;
+		}
+
+		CURL* curl = connection->m_curlHandle;
+
+		// A HEAD request resolves the host and leaves an idle connection
+		// in the group's shared connection cache. Connections opened with
+		// CURLOPT_CONNECT_ONLY are not reused by cURL so are of no use here.
+		curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
+		curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+		curl_easy_setopt(curl, CURLOPT_URL, m_url.c_str());
+		curl_easy_setopt(curl, CURLOPT_TIMEOUT, m_timeout);
+		curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, curlDiscard);
+		curl_easy_setopt(curl, CURLOPT_WRITEDATA, NULL);
+		curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, curlDiscard);
+		curl_easy_setopt(curl, CURLOPT_HEADERDATA, NULL);
+		curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, curlHttpVersion(m_httpVersion));
+
+		connection->m_error[0] = 0;
+		curl_multi_add_handle(multi, curl);
+		connections.push_back(connection);
+	}
+
+	int running = (int) connections.size();
+	while (running) {
+
+		if (curl_multi_perform(multi, &running) != CURLM_OK)
+			break;
+		if (running)
+			curl_multi_wait(multi, NULL, 0, 1000, NULL);
+	}
+
+	CURLMsg* message;
+	int queued;
+
+	while ((message = curl_multi_info_read(multi, &queued))) {
+
+		if (message->msg != CURLMSG_DONE)
+			continue;
+
+		std::vector< boost::shared_ptr<HttpConnection> >::iterator i;
+		for (i = connections.begin(); i != connections.end() && (*i)->m_curlHandle != message->easy_handle; i++);
+
+		CURLcode code = message->data.result;
+		long connects = 0;
+		curl_easy_getinfo(message->easy_handle, CURLINFO_NUM_CONNECTS, &connects);
+
+		boost::lock_guard<boost::mutex> lock(m_prewarmLock);
+
+		if (code == CURLE_OK) {
+
+			// A connection that was still open was reused
+			m_prewarmRequests++;
+			m_prewarmed += connects;
+
+		} else {
+
+			const char* error = (i != connections.end() && (*i)->m_error[0] ? (*i)->m_error : curl_easy_strerror(code));
+			WARN("Unable to pre-warm a connection for service '%s' with cURL error %d: %s", this->getSubject(), code, error);
+
+			m_prewarmFailures++;
+		}
+	}
+
+	for (std::vector< boost::shared_ptr<HttpConnection> >::iterator i = connections.begin(); i != connections.end(); i++) {
+
+		curl_multi_remove_handle(multi, (*i)->m_curlHandle);
+		curl_easy_setopt((*i)->m_curlHandle, CURLOPT_NOBODY, 0L);
+
+		group->getPool()->returnObject(*i);
+	}
+
+	curl_multi_cleanup(multi);
+}
+
+
+bool CurlHttpService::performRequest(HttpRequestPtr request) {
+
+	request->group->recordQueueTime(currentTimeMicros() - request->queueTime);
+
+	if (!request->isPost && m_hedgingPolicy) {
+
+			long delay = m_hedgingPolicy->beginRequest();
+			if (delay >= 0)
+				_scheduler->schedule(boost::bind(&CurlHttpService::hedgeRequest, this, request), delay);
+	}
+
+	return performAttempt(request, 0);
 }
 
-void CurlHttpService::execute(MessagePtr message, std::string& request) {
+void CurlHttpService::hedgeRequest(HttpRequestPtr request) {
+
+	if (request->hasResponse() || request->isCancelled() || !m_hedgingPolicy->acquireHedge())
+		return;
+
+	TRACE("No response received in time for request to service '%s'. Sending hedged request.", this->getSubject());
+
+	request->beginAttempt();
+	request->group->getExecutor()->submit(boost::bind(&CurlHttpService::performAttempt, this, request, 1));
+}
+
+bool CurlHttpService::performAttempt(HttpRequestPtr request, int attempt) {
+
+	MessagePtr response = request->response;
+	boost::shared_ptr<HttpConnection> connection;
+
+	if (attempt == 0)
+		request->beginAttempt();
+
+	// A request cancelled while it was queued is not sent
+	if (request->isCancelled()) {
+
+		this->cancelAttempt(request, attempt);
+		return true;
+	}
+
+	// Every attempt sends a streamed body from its beginning
+	if (request->upload && !request->upload->rewind()) {
+
+		ERROR("The streamed request body for service '%s' cannot be sent again.", this->getSubject());
+
+		if (request->endAttempt(attempt, false)) {
+
+			response->setError(Message::ERR_SERVICE, 1, "The request body cannot be sent again.");
+			this->endResponse(request);
+		}
+		return false;
+	}
+
+	try {
+
+		connection = request->group->getPool()->getObject();
+
+	} catch (pool_error& e) {
+
+		ERROR( "Unable to retrieve a cURL handle from the pool of group '%s' for service '%s'.",
+			request->group->getName().c_str(), this->getSubject() );
+
+		if (request->endAttempt(attempt, false)) {
+
+			response->setError(Message::ERR_CONNECTION_ERROR, 1, "No HTTP connection available.");
+			this->endResponse(request);
+		}
+		return false;
+	}
+
+	CURL* curl = connection->m_curlHandle;
+	struct curl_slist* headers = NULL;
+
+	for (std::list<std::string>::iterator i = request->headers.begin(); i != request->headers.end(); i++)
+		headers = curl_slist_append(headers, i->c_str());
+
+	HttpTransfer transfer(request, attempt);
+
+	if (request->upload) {
+
+		// The body is read into cURL's upload buffer as it is sent. A
+		// body of unknown length is sent chunked over HTTP/1.1.
+		curl_easy_setopt(curl, CURLOPT_POST, 1L);
+		curl_easy_setopt(curl, CURLOPT_POSTFIELDS, (char *) NULL);
+		curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t) request->upload->getLength());
+		curl_easy_setopt(curl, CURLOPT_READFUNCTION, curlRead);
+		curl_easy_setopt(curl, CURLOPT_READDATA, &transfer);
+		curl_easy_setopt(curl, CURLOPT_SEEKFUNCTION, curlSeek);
+		curl_easy_setopt(curl, CURLOPT_SEEKDATA, &transfer);
+
+	} else if (request->isPost) {
+
+		curl_easy_setopt(curl, CURLOPT_POST, 1L);
+		curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request->body.c_str());
+		curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (long) request->body.length());
+
+	} else
+		curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
+
+	curl_easy_setopt(curl, CURLOPT_URL, request->url.c_str());
+	curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+	curl_easy_setopt(curl, CURLOPT_TIMEOUT, request->timeout);
+	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, curlWrite);
+	curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer);
+	curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, curlHeader);
+	curl_easy_setopt(curl, CURLOPT_HEADERDATA, &transfer);
+	curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, curlProgress);
+	curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &transfer);
+	curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+	curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, curlHttpVersion(m_httpVersion));
+
+	// A compressed response is decoded incrementally by cURL
+	// so the data is streamed to the binder as it arrives
+	curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, (m_compression ? m_acceptEncoding.c_str() : NULL));
+
+	TRACE("Executing HTTP request attempt %d for service '%s' with url '%s'.", attempt, this->getSubject(), request->url.c_str());
+
+	connection->m_error[0] = 0;
+	CURLcode code = curl_easy_perform(curl);
+
+	long status = 0;
+	curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+
+	TransferTiming timing;
+	getTransferTiming(curl, timing);
+
+	if (code == CURLE_OK)
+		m_transferTimings->record(timing);
+
+	curl_easy_setopt(curl, CURLOPT_HTTPHEADER, NULL);
+	curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 1L);
+	curl_slist_free_all(headers);
+
+	if (request->upload) {
+
+		curl_easy_setopt(curl, CURLOPT_READFUNCTION, NULL);
+		curl_easy_setopt(curl, CURLOPT_READDATA, NULL);
+		curl_easy_setopt(curl, CURLOPT_SEEKFUNCTION, NULL);
+		curl_easy_setopt(curl, CURLOPT_SEEKDATA, NULL);
+	}
+
+	std::string error(connection->m_error);
+	request->group->getPool()->returnObject(connection);
+
+	if (request->isCancelled(attempt)) {
+
+		TRACE("HTTP request attempt %d for service '%s' lost to a hedged attempt and was cancelled.", attempt, this->getSubject());
+
+		request->endAttempt(attempt, false);
+		return true;
+	}
+
+	if (request->isCancelled()) {
+
+		this->cancelAttempt(request, attempt);
+		return true;
+	}
+
+	if (transfer.isStopped && code == CURLE_WRITE_ERROR) {
+
+		TRACE( "HTTP response for service '%s' was stopped after %lld bytes as its receivers needed no more data.",
+			this->getSubject(), transfer.bytesReceived );
+
+		code = CURLE_OK;
+	}
+
+	// Server errors are a signal of congestion while client errors are not
+	bool success = (code == CURLE_OK && status < 500);
+
+	if (request->endAttempt(attempt, success)) {
+
+		if (m_hedgingPolicy && transfer.firstByteTime) {
+
+			m_hedgingPolicy->recordLatency(transfer.firstByteTime - transfer.startTime);
+			if (attempt > 0)
+				m_hedgingPolicy->recordHedgeWin();
+		}
+
+		if (m_compression && code == CURLE_OK && !transfer.isStopped)
+			this->recordCompression(timing.downloadSize, transfer.bytesReceived);
+
+		NameValueMap& metaData = response->getMetaData();
+		metaData[HTTP_TIME_QUEUE] = metricValue(transfer.startTime - request->queueTime);
+		metaData[HTTP_TIME_CONNECT] = metricValue(timing.connect);
+
+		if (timing.startTransfer) {
+
+			metaData[HTTP_TIME_TTFB] = metricValue(timing.startTransfer - timing.connect);
+			metaData[HTTP_TIME_TRANSFER] = metricValue(timing.total - timing.startTransfer);
+		}
+
+		if (m_timingMetaData)
+			HttpTransferTimings::addMetaData(timing, metaData);
+
+		setTransferError(response, code, status, error.c_str());
+
+		if (code != CURLE_OK)
+			ERROR( "HTTP request for service '%s' failed with cURL error %d: %s",
+				this->getSubject(), code, response->getErrorDescription().c_str() );
+
+		this->completeResponse(request, transfer, code, status);
+	}
+
+	return success;
+}
+
+void CurlHttpService::cancelAttempt(HttpRequestPtr request, int attempt) {
+
+	TRACE("HTTP request attempt %d for service '%s' was cancelled.", attempt, this->getSubject());
+
+	// The first attempt to end ends the stream so a
+	// hedged attempt still running is aborted as well
+	if (request->endAttempt(attempt, true)) {
+
+		request->response->setError(Message::ERR_CANCELLED, 1, "The request was cancelled.");
+		SEND_DATA(request->response, NULL, 0);
+	}
+}
+
+void CurlHttpService::completeResponse(HttpRequestPtr request, HttpTransfer& transfer, CURLcode code, long status) {
+
+	MessagePtr response = request->response;
+	// The body of a stopped transfer is incomplete so it is not cached
+	bool isCached = (code == CURLE_OK && request->cacheKey.length() > 0 && !transfer.isStopped);
+
+	if (isCached && status == 304 && request->cached) {
+
+		TRACE("Cached response for service '%s' with url '%s' was not modified.", this->getSubject(), request->url.c_str());
+
+		// Cached responses are shared so the
+		// revalidated response replaces it
+		CachedResponsePtr revalidated(new CachedResponse(*request->cached));
+		if (transfer.etag.length())
+			revalidated->etag = transfer.etag;
+		if (transfer.lastModified.length())
+			revalidated->lastModified = transfer.lastModified;
+
+		if (m_responseCache->setExpiry(revalidated, transfer.cacheControl, transfer.expires))
+			m_responseCache->store(request->cacheKey, revalidated);
+		else
+			m_responseCache->remove(request->cacheKey);
+
+		m_responseCache->recordRevalidation(revalidated->body.length());
+		this->sendCachedResponse(request, revalidated, HTTP_CACHE_STATUS_REVALIDATED);
+		return;
+	}
+
+	NameValueMap& metaData = response->getMetaData();
+	bool isModel = (metaData[DATA_IS_DYNA_MODEL] == CSTR_TRUE);
+
+	CachedResponsePtr cached;
+
+	if (isCached && status == 200) {
+
+		metaData[HTTP_CACHE_STATUS] = HTTP_CACHE_STATUS_MISS;
+		m_responseCache->recordMiss();
+
+		cached = CachedResponsePtr(new CachedResponse());
+		cached->etag = transfer.etag;
+		cached->lastModified = transfer.lastModified;
+		cached->contentHash = transfer.contentHash;
+
+		if ( !m_responseCache->setExpiry(cached, transfer.cacheControl, transfer.expires) ||
+			(!isModel && (transfer.bodyOverflow || transfer.body.length() > m_responseCache->getMaxBodySize())) ) {
+
+			m_responseCache->remove(request->cacheKey);
+			cached.reset();
+
+		} else if (isModel)
+			((StreamMessage *) response.get())->setBoundDataCallback(request.get(), cacheBoundData);
+	}
+
+	if (request->isPoll) {
+
+		if (this->postPollResponse(request->message, response, transfer.contentHash)) {
+
+			// The polled body was read whole before it was compared
+			if (transfer.body.length())
+				SEND_COMPLETE_DATA(response, (void *) transfer.body.data(), transfer.body.length());
+
+			SEND_DATA(response, NULL, 0);
+		}
+
+	} else
+		SEND_DATA(response, NULL, 0);
+
+	if (cached) {
+
+		if (!transfer.bodyOverflow && transfer.body.length() <= m_responseCache->getMaxBodySize())
+			cached->body.swap(transfer.body);
+
+		cached->model = request->model;
+		if (cached->model || cached->body.length())
+			m_responseCache->store(request->cacheKey, cached);
+	}
+}
+
+void CurlHttpService::sendCachedResponse(HttpRequestPtr request, CachedResponsePtr cached, const char* status) {
+
+	MessagePtr response = request->response;
+
+	NameValueMap& metaData = response->getMetaData();
+	metaData[HTTP_CACHE_STATUS] = status;
+
+	if (request->isPoll && !this->postPollResponse(request->message, response, cached->contentHash))
+		return;
+
+	// A model is returned as is which avoids parsing it again
+	if (cached->model && metaData[DATA_IS_DYNA_MODEL] == CSTR_TRUE)
+		((StreamMessage *) response.get())->setBoundData(new boost::shared_ptr<binding::DynaModel>(cached->model));
+	else if (cached->body.length())
+		SEND_COMPLETE_DATA(response, (void *) cached->body.data(), cached->body.length());
+
+	SEND_DATA(response, NULL, 0);
+}
+
+void CurlHttpService::endResponse(HttpRequestPtr request) {
+
+	if (!request->isPoll || this->postPollResponse(request->message, request->response, FNV1A_64_INIT))
+		SEND_DATA(request->response, NULL, 0);
+}
+
+void CurlHttpService::rejectRequest(HttpRequestPtr request) {
+
+	request->response->setError(Message::ERR_SERVICE, 503, "Request shed as the service is over its concurrency limit.");
+	this->endResponse(request);
 }
 
 // Configuration callbacks
@@ -197,44 +1359,10 @@ void CurlHttpService::execute(MessagePtr message, std::string& request) {
 ADD_BEGIN_CONFIG_BINDING("messagebus-config/curlhttpservice", CurlHttpService, configureServices);
 void CurlHttpService::configureServices(void* binder, const char* element, std::map<std::string, std::string>& attribs) {
 
-	// cURL handle pool configuration
-	int size = DEFAULT_POOL_SIZE;
-	int max = DEFAULT_POOL_MAX;
-	int timeout = DEFAULT_POOL_TIMEOUT;
-	int evictInterval = DEFAULT_POOL_EVICT_INTERVAL;
-	int lingerTime = DEFAULT_POOL_LINGER_TIME;
-	int evictChecks = DEFAULT_POOL_EVICT_CHECKS;
-
-	// cURL internal cache size (number of connections
-	// cached within each cURL handle defaults to 5)
-	int maxCachedConnections = -1;
-
-	if (attribs.find("poolSize") != attribs.end())
-		size = atoi(attribs["poolSize"].c_str());
-	if (attribs.find("poolMax") != attribs.end())
-		max = atoi(attribs["poolMax"].c_str());
-	if (attribs.find("poolTimeout") != attribs.end())
-		timeout = atoi(attribs["poolTimeout"].c_str());
-	if (attribs.find("poolEvictInterval") != attribs.end())
-		evictInterval = atoi(attribs["poolEvictInterval"].c_str());
-	if (attribs.find("poolLingerTime") != attribs.end())
-		lingerTime = atoi(attribs["poolLingerTime"].c_str());
-	if (attribs.find("poolEvictChecks") != attribs.end())
-		evictChecks = atoi(attribs["poolEvictChecks"].c_str());
-	if (attribs.find("maxCachedConnections") != attribs.end())
-		maxCachedConnections = atoi(attribs["maxCachedConnections"].c_str());
-
-	_pool = boost::shared_ptr<HttpConnectionPool>(new HttpConnectionPool(maxCachedConnections));
-	_pool->setPoolSize(size, max, timeout);
-	_pool->setPoolManagement(evictInterval, lingerTime, evictChecks);
-
-	if (attribs.find("concurrency") != attribs.end())
-		// Concurrency is the number of threads the executor will make available for
-		// asynchronous execution. The executor does not grow the thread count but will
-		// instead queue work items if all threads are busy.
-		_executor = boost::shared_ptr<Executor>(new Executor((size_t) atoi(attribs["concurrency"].c_str())));
-	else
-		_executor = boost::shared_ptr<Executor>(new Executor(size));
+	addGroup(HttpServiceGroupPtr(new HttpServiceGroup(DEFAULT_SERVICE_GROUP, attribs)));
+
+	// Single thread used to time hedged requests
+	_scheduler = boost::shared_ptr<Executor>(new Executor(1));
 
 	if (attribs.find("proxyHost") != attribs.end())
 		_proxyHost = atoi(attribs["poolSize"].c_str());
@@ -242,6 +1370,57 @@ void CurlHttpService::configureServices(void* binder, const char* element, std::
 		_proxyPort = atoi(attribs["proxyPort"].c_str());
 }
 
+ADD_BEGIN_CONFIG_BINDING("messagebus-config/curlhttpservice/group", CurlHttpService, configureGroup);
+void CurlHttpService::configureGroup(void* binder, const char* element, std::map<std::string, std::string>& attribs) {
+
+	std::string name = attribs["name"];
+
+	if (name.length() == 0 || name == DEFAULT_SERVICE_GROUP) {
+
+		ERROR("A cURL HTTP service group must be named and cannot be named '%s'.", DEFAULT_SERVICE_GROUP);
+		return;
+	}
+
+	TRACE("Found cURL HTTP service group configuration '%s'.", name.c_str());
+
+	addGroup(HttpServiceGroupPtr(new HttpServiceGroup(name, attribs)));
+}
+
+ADD_BEGIN_CONFIG_BINDING("messagebus-config/service/httpConfig/bulkhead", CurlHttpService, configureBulkhead);
+void CurlHttpService::configureBulkhead(void* binder, const char* element, std::map<std::string, std::string>& attribs) {
+
+    GET_BINDER(mb::ServiceConfig);
+    Service* service = (Service *) dataBinder->getService();
+
+    if (service->isType("curl")) {
+
+    	CurlHttpService* httpService = (CurlHttpService *) service;
+
+    	// A service joins a shared group by name. If the group
+    	// is not given the service is sized in a group of its own.
+    	httpService->m_group = (attribs.find("group") != attribs.end() ? attribs["group"] : httpService->m_subject);
+
+    	if (attribs.find("group") == attribs.end())
+    		addGroup(HttpServiceGroupPtr(new HttpServiceGroup(httpService->m_group, attribs)));
+    }
+}
+
+ADD_BEGIN_CONFIG_BINDING("messagebus-config/service/httpConfig/prewarm", CurlHttpService, configurePrewarm);
+void CurlHttpService::configurePrewarm(void* binder, const char* element, std::map<std::string, std::string>& attribs) {
+
+    GET_BINDER(mb::ServiceConfig);
+    Service* service = (Service *) dataBinder->getService();
+
+    if (service->isType("curl")) {
+
+    	CurlHttpService* httpService = (CurlHttpService *) service;
+
+    	httpService->m_prewarmConnections = DEFAULT_PREWARM_CONNECTIONS;
+    	if (attribs.find("connections") != attribs.end())
+    		httpService->m_prewarmConnections = atoi(attribs["connections"].c_str());
+    }
+}
+
 ADD_BEGIN_CONFIG_BINDING("messagebus-config/service", CurlHttpService, createService);
 void CurlHttpService::createService(void* binder, const char* element, std::map<std::string, std::string>& attribs) {
 
@@ -23,6 +23,8 @@
 #ifndef CURLHTTPSERVICE_H_
 #define CURLHTTPSERVICE_H_
 
+#include "curl/curl.h"
+
 #include "staticinit.h"
 
 #include "HttpService.h"
@@ -32,6 +34,11 @@ namespace mb {
 	namespace http {
 
 
+class HttpRequest;
+class CachedResponse;
+class HttpServiceGroup;
+struct HttpTransfer;
+
 class CurlHttpService : public HttpService {
 
 STATIC_INIT_DECLARATION(CurlHttpService)
@@ -41,15 +48,53 @@ public:
 	virtual ~CurlHttpService();
 
     Message* createMessage();
-    void execute(MessagePtr message, std::string& request);
+    void execute(MessagePtr message, MessagePtr response, std::string& body);
+
+    /* Pre-warms the configured number of connections when the
+     * service is registered and when it is brought to the foreground.
+     */
+    void start();
+    void resume(std::istream* input = NULL);
+
+    void getMetrics(NameValueMap& metrics);
 
     // XML Configuration bindings
 
     static void configureServices(void* binder, const char* element, std::map<std::string, std::string>& attribs);
+    static void configureGroup(void* binder, const char* element, std::map<std::string, std::string>& attribs);
+    static void configureBulkhead(void* binder, const char* element, std::map<std::string, std::string>& attribs);
+    static void configurePrewarm(void* binder, const char* element, std::map<std::string, std::string>& attribs);
     static void createService(void* binder, const char* element, std::map<std::string, std::string>& attribs);
 
 private:
 
+    boost::shared_ptr<HttpServiceGroup> getGroup();
+
+    void prewarm();
+    void prewarmConnections(boost::shared_ptr<HttpServiceGroup> group);
+
+    bool performRequest(boost::shared_ptr<HttpRequest> request);
+    bool performAttempt(boost::shared_ptr<HttpRequest> request, int attempt);
+    void hedgeRequest(boost::shared_ptr<HttpRequest> request);
+    void cancelAttempt(boost::shared_ptr<HttpRequest> request, int attempt);
+
+    void completeResponse(boost::shared_ptr<HttpRequest> request, HttpTransfer& transfer, CURLcode code, long status);
+    void sendCachedResponse(boost::shared_ptr<HttpRequest> request, boost::shared_ptr<CachedResponse> cached, const char* status);
+    void endResponse(boost::shared_ptr<HttpRequest> request);
+    void rejectRequest(boost::shared_ptr<HttpRequest> request);
+
+    // Name of the group whose executor and cURL handle
+    // pool execute the service's requests
+    std::string m_group;
+
+    // Number of idle connections to open to the service's
+    // url ahead of its first request
+    int m_prewarmConnections;
+
+    boost::mutex m_prewarmLock;
+    long m_prewarmRequests;
+    long m_prewarmed;
+    long m_prewarmFailures;
 };
 
 STATIC_INIT_CALL(CurlHttpService)
@@ -0,0 +1,171 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "HedgingPolicy.h"
+
+#include <algorithm>
+
+#include "log.h"
+
+#include "HttpMetrics.h"
+
+// Minimum number of latency samples before requests are hedged
+#define MIN_LATENCY_SAMPLES  20
+
+
+namespace mb {
+	namespace http {
+
+
+// **** LatencyWindow Implementation ****
+
+LatencyWindow::LatencyWindow(size_t size)
+	: m_samples(size < 1 ? 1 : size) {
+
+	m_next = 0;
+	m_count = 0;
+	m_added = 0;
+}
+
+void LatencyWindow::add(long long sample) {
+
+	m_samples[m_next] = sample;
+	m_next = (m_next + 1) % m_samples.size();
+
+	if (m_count < m_samples.size())
+		m_count++;
+
+	m_added++;
+}
+
+long long LatencyWindow::percentile(double percentile, size_t minSamples) {
+
+	if (m_count < minSamples || m_count == 0)
+		return -1;
+
+	// Re-sort only after a tenth of the window has changed
+	if (m_sorted.size() != m_count || m_added > m_count / 10) {
+
+		m_sorted.assign(m_samples.begin(), m_samples.begin() + m_count);
+		std::sort(m_sorted.begin(), m_sorted.end());
+		m_added = 0;
+	}
+
+	size_t index = (size_t) (percentile / 100.0 * (m_count - 1) + 0.5);
+	return m_sorted[index < m_count ? index : m_count - 1];
+}
+
+
+// **** HedgingPolicy Implementation ****
+
+HedgingPolicy::HedgingPolicy(double percentile, long minDelay, long maxDelay, double budget, int burst, int window)
+	: m_latencies(window) {
+
+	m_percentile = percentile;
+	m_minDelay = minDelay;
+	m_maxDelay = maxDelay;
+	m_budget = budget / 100.0;
+	m_burst = (burst < 1 ? 1 : burst);
+
+	m_tokens = 0;
+
+	m_requests = 0;
+	m_hedges = 0;
+	m_hedgeWins = 0;
+	m_hedgesDenied = 0;
+}
+
+HedgingPolicy::~HedgingPolicy() {
+}
+
+long HedgingPolicy::beginRequest() {
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+
+	m_requests++;
+
+	m_tokens += m_budget;
+	if (m_tokens > m_burst)
+		m_tokens = m_burst;
+
+	long long latency = m_latencies.percentile(m_percentile, MIN_LATENCY_SAMPLES);
+	if (latency < 0)
+		return -1;
+
+	long delay = (long) (latency / 1000);
+	if (delay < m_minDelay)
+		delay = m_minDelay;
+	if (m_maxDelay > 0 && delay > m_maxDelay)
+		delay = m_maxDelay;
+
+	return delay;
+}
+
+bool HedgingPolicy::acquireHedge() {
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+
+	if (m_tokens < 1.0) {
+
+		m_hedgesDenied++;
+		return false;
+	}
+
+	m_tokens -= 1.0;
+	m_hedges++;
+	return true;
+}
+
+void HedgingPolicy::recordLatency(long long micros) {
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+	m_latencies.add(micros);
+}
+
+void HedgingPolicy::recordHedgeWin() {
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+	m_hedgeWins++;
+}
+
+void HedgingPolicy::getMetrics(NameValueMap& metrics) {
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+
+	metrics["hedging.requests"] = metricValue(m_requests);
+	metrics["hedging.hedges"] = metricValue(m_hedges);
+	metrics["hedging.wins"] = metricValue(m_hedgeWins);
+	metrics["hedging.denied"] = metricValue(m_hedgesDenied);
+	metrics["hedging.hedgeRate"] = metricValue(m_requests ? (double) m_hedges / m_requests : 0.0);
+	metrics["hedging.winRate"] = metricValue(m_hedges ? (double) m_hedgeWins / m_hedges : 0.0);
+	metrics["hedging.delayMs"] = metricValue(m_latencies.percentile(m_percentile, MIN_LATENCY_SAMPLES) / 1000);
+}
+
+void HedgingPolicy::log(std::ostream& cout) {
+
+	cout << "\tHedging - p" << m_percentile << " of " << m_latencies.size() << " samples bounded by [" <<
+		m_minDelay << ", " << m_maxDelay << "] ms with a budget of " << m_budget * 100 << "% (burst " << m_burst << ')' << std::endl;
+}
+
+
+	}  // namespace : http
+}  // namespace : mb
@@ -0,0 +1,121 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef HEDGINGPOLICY_H_
+#define HEDGINGPOLICY_H_
+
+#include <vector>
+
+#include "boost/thread.hpp"
+
+#include "Service.h"
+
+
+namespace mb {
+	namespace http {
+
+
+/* Sliding window of the most recent latency
+ * samples from which percentiles are computed.
+ */
+class LatencyWindow {
+
+public:
+	LatencyWindow(size_t size);
+
+	void add(long long sample);
+
+	/* Returns the given percentile of the samples in the window
+	 * or -1 if the window does not have the minimum samples.
+	 */
+	long long percentile(double percentile, size_t minSamples);
+
+	size_t size() {
+		return m_count;
+	}
+
+private:
+
+	std::vector<long long> m_samples;
+	std::vector<long long> m_sorted;
+
+	size_t m_next;
+	size_t m_count;
+	size_t m_added;
+};
+
+
+/* Hedging policy of an idempotent HTTP service. If a request
+ * has not received a response within the configured percentile
+ * of the recent response latency then a duplicate request is
+ * sent. The extra load is capped by a token bucket which is
+ * credited with a percentage of a token for every request and
+ * debited a full token for every hedge.
+ */
+class HedgingPolicy {
+
+public:
+	HedgingPolicy(double percentile, long minDelay, long maxDelay, double budget, int burst, int window);
+	virtual ~HedgingPolicy();
+
+	/* Returns the delay in milli-seconds after which the
+	 * request should be hedged or -1 if the request should
+	 * not be hedged.
+	 */
+	long beginRequest();
+
+	/* Acquires a hedge from the budget */
+	bool acquireHedge();
+
+	/* Records the time to the first response byte of an attempt */
+	void recordLatency(long long micros);
+	/* Records that the hedged attempt won the race */
+	void recordHedgeWin();
+
+	void getMetrics(NameValueMap& metrics);
+	void log(std::ostream& cout);
+
+private:
+
+	boost::mutex m_lock;
+
+	double m_percentile;
+	long m_minDelay;
+	long m_maxDelay;
+	double m_budget;
+	int m_burst;
+
+	LatencyWindow m_latencies;
+	double m_tokens;
+
+	long m_requests;
+	long m_hedges;
+	long m_hedgeWins;
+	long m_hedgesDenied;
+};
+
+
+	}  // namespace : http
+}  // namespace : mb
+
+
+#endif /* HEDGINGPOLICY_H_ */
@@ -0,0 +1,194 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "HttpRecording.h"
+
+#include "log.h"
+
+
+// A recording is saved as a sequence of exchanges each of which
+// is a header line followed by its key, its error description
+// and its chunks. Strings are prefixed by their length so the
+// recorded data is written as received.
+//
+//   exchange <key length> <error> <error code> <description length> <duration> <chunks>\n
+//   <key>\n
+//   <description>\n
+//   chunk <offset> <length>\n
+//   <data>\n
+
+#define RECORDING_EXCHANGE  "exchange"
+#define RECORDING_CHUNK     "chunk"
+
+
+namespace mb {
+	namespace http {
+
+
+// Reads a string of the given length followed by a new line
+bool readString(std::istream& input, size_t length, std::string& value) {
+
+	value.resize(length);
+	if (length && !input.read(&value[0], length))
+		return false;
+
+	return (input.get() == '\n');
+}
+
+HttpRecording::HttpRecording(const std::string& path)
+	: m_path(path) {
+
+	m_size = 0;
+}
+
+HttpRecording::~HttpRecording() {
+}
+
+bool HttpRecording::load() {
+
+	std::ifstream input(m_path.c_str(), std::ios::in | std::ios::binary);
+	if (!input) {
+
+		ERROR("Unable to open HTTP recording '%s'.", m_path.c_str());
+		return false;
+	}
+
+	std::string tag;
+
+	while (input >> tag) {
+
+		RecordedExchangePtr exchange(new RecordedExchange());
+
+		size_t keyLength, descriptionLength, chunks;
+		int error;
+
+		if ( tag != RECORDING_EXCHANGE ||
+			!(input >> keyLength >> error >> exchange->errorCode >> descriptionLength >> exchange->duration >> chunks) ||
+			input.get() != '\n' ||
+			!readString(input, keyLength, exchange->key) ||
+			!readString(input, descriptionLength, exchange->errorDescription) ) {
+
+			ERROR("HTTP recording '%s' is corrupt after %lu exchanges.", m_path.c_str(), (unsigned long) m_size);
+			return false;
+		}
+
+		exchange->error = (Message::Error) error;
+		exchange->chunks.resize(chunks);
+
+		for (size_t i = 0; i < chunks; i++) {
+
+			RecordedChunk& chunk = exchange->chunks[i];
+			size_t length;
+
+			if ( !(input >> tag >> chunk.offset >> length) || tag != RECORDING_CHUNK ||
+				input.get() != '\n' || !readString(input, length, chunk.data) ) {
+
+				ERROR("HTTP recording '%s' is corrupt after %lu exchanges.", m_path.c_str(), (unsigned long) m_size);
+				return false;
+			}
+		}
+
+		boost::lock_guard<boost::mutex> lock(m_lock);
+		this->insert(exchange);
+	}
+
+	TRACE("Loaded %lu exchanges from HTTP recording '%s'.", (unsigned long) m_size, m_path.c_str());
+	return true;
+}
+
+bool HttpRecording::create() {
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+
+	m_file.open(m_path.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+	if (!m_file) {
+
+		ERROR("Unable to create HTTP recording '%s'.", m_path.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+void HttpRecording::add(RecordedExchangePtr exchange) {
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+
+	this->insert(exchange);
+
+	if (!m_file.is_open())
+		return;
+
+	m_file << RECORDING_EXCHANGE << ' ' << exchange->key.length() << ' ' << (int) exchange->error << ' ' <<
+		exchange->errorCode << ' ' << exchange->errorDescription.length() << ' ' << exchange->duration << ' ' <<
+		exchange->chunks.size() << '\n' << exchange->key << '\n' << exchange->errorDescription << '\n';
+
+	for (std::vector<RecordedChunk>::iterator i = exchange->chunks.begin(); i != exchange->chunks.end(); i++) {
+
+		m_file << RECORDING_CHUNK << ' ' << i->offset << ' ' << i->data.length() << '\n';
+		m_file.write(i->data.data(), i->data.length());
+		m_file << '\n';
+	}
+
+	// Each exchange is saved as soon as it is recorded
+	m_file.flush();
+
+	if (!m_file)
+		ERROR("Unable to save exchange to HTTP recording '%s'.", m_path.c_str());
+}
+
+RecordedExchangePtr HttpRecording::find(const std::string& key) {
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+
+	boost::unordered_map<std::string, Responses>::iterator responses = m_exchanges.find(key);
+	if (responses == m_exchanges.end())
+		return RecordedExchangePtr();
+
+	Responses& recorded = responses->second;
+
+	RecordedExchangePtr exchange = recorded.exchanges[recorded.next];
+	recorded.next = (recorded.next + 1) % recorded.exchanges.size();
+
+	return exchange;
+}
+
+size_t HttpRecording::size() {
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+	return m_size;
+}
+
+std::string HttpRecording::createKey(const std::string& subject, const std::string& request) {
+
+	return subject + '\n' + request;
+}
+
+void HttpRecording::insert(RecordedExchangePtr exchange) {
+
+	m_exchanges[exchange->key].exchanges.push_back(exchange);
+	m_size++;
+}
+
+
+	}  // namespace : http
+}  // namespace : mb
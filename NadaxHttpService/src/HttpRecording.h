@@ -0,0 +1,136 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef HTTPRECORDING_H_
+#define HTTPRECORDING_H_
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+#include "boost/thread.hpp"
+#include "boost/shared_ptr.hpp"
+#include "boost/unordered_map.hpp"
+
+#include "Service.h"
+
+
+namespace mb {
+	namespace http {
+
+
+/* A piece of a response as it was received */
+struct RecordedChunk {
+
+	// Time in micro-seconds since the request was sent
+	long long offset;
+	std::string data;
+};
+
+/* A request and its response as received by a live service */
+struct RecordedExchange {
+
+	RecordedExchange() {
+		error = Message::ERR_NONE;
+		errorCode = 0;
+		duration = 0;
+	}
+
+	// Subject of the service and the request it rendered
+	std::string key;
+
+	Message::Error error;
+	int errorCode;
+	std::string errorDescription;
+
+	std::vector<RecordedChunk> chunks;
+
+	// Time in micro-seconds until the response was complete
+	long long duration;
+};
+
+typedef boost::shared_ptr<RecordedExchange> RecordedExchangePtr;
+
+
+/* Exchanges recorded from live services which are saved to
+ * a file as they are added. A request that was recorded more
+ * than once is answered with its recorded responses in turn.
+ */
+class HttpRecording {
+
+public:
+	HttpRecording(const std::string& path);
+	virtual ~HttpRecording();
+
+	const std::string& getPath() {
+		return m_path;
+	}
+
+	/* Loads the exchanges saved to the file. Returns
+	 * false if the file could not be read in full.
+	 */
+	bool load();
+
+	/* Starts a new recording replacing the file's contents */
+	bool create();
+
+	/* Adds the exchange and appends it to the file */
+	void add(RecordedExchangePtr exchange);
+
+	/* Returns the next recorded response to the
+	 * request with the given key or NULL if none
+	 */
+	RecordedExchangePtr find(const std::string& key);
+
+	size_t size();
+
+	static std::string createKey(const std::string& subject, const std::string& request);
+
+private:
+
+	void insert(RecordedExchangePtr exchange);
+
+	std::string m_path;
+	std::ofstream m_file;
+
+	boost::mutex m_lock;
+
+	struct Responses {
+
+		Responses() : next(0) { }
+
+		std::vector<RecordedExchangePtr> exchanges;
+		size_t next;
+	};
+
+	boost::unordered_map<std::string, Responses> m_exchanges;
+	size_t m_size;
+};
+
+typedef boost::shared_ptr<HttpRecording> HttpRecordingPtr;
+
+
+	}  // namespace : http
+}  // namespace : mb
+
+
+#endif /* HTTPRECORDING_H_ */
@@ -0,0 +1,320 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "HttpRequestBody.h"
+
+#include <string.h>
+#include <sys/stat.h>
+#include <algorithm>
+
+#include "log.h"
+#include "clock.h"
+
+
+namespace mb {
+	namespace http {
+
+
+// **** FileRequestBody Implementation ****
+
+FileRequestBody::FileRequestBody(const std::string& path)
+	: m_path(path) {
+
+	struct stat info;
+	m_length = (stat(path.c_str(), &info) == 0 ? (long long) info.st_size : -1);
+
+	m_file = NULL;
+	m_done = false;
+}
+
+FileRequestBody::~FileRequestBody() {
+
+	if (m_file)
+		fclose(m_file);
+}
+
+long long FileRequestBody::getLength() {
+
+	return m_length;
+}
+
+long FileRequestBody::read(char* buffer, size_t size) {
+
+	if (m_done)
+		return 0;
+
+	if (!m_file && !(m_file = fopen(m_path.c_str(), "rb"))) {
+
+		ERROR("Unable to open file '%s' to upload.", m_path.c_str());
+		return -1;
+	}
+
+	size_t len = fread(buffer, 1, size, m_file);
+
+	if (len < size) {
+
+		if (ferror(m_file)) {
+
+			ERROR("Error reading file '%s' to upload.", m_path.c_str());
+			return -1;
+		}
+
+		fclose(m_file);
+		m_file = NULL;
+		m_done = true;
+	}
+
+	return (long) len;
+}
+
+bool FileRequestBody::rewind() {
+
+	if (m_file)
+		fclose(m_file);
+
+	m_file = NULL;
+	m_done = false;
+	return true;
+}
+
+
+// **** BufferRequestBody Implementation ****
+
+BufferRequestBody::BufferRequestBody(boost::shared_ptr<std::string> buffer, const std::string& contentType)
+	: m_buffer(buffer), m_contentType(contentType) {
+
+	m_offset = 0;
+}
+
+BufferRequestBody::BufferRequestBody(const std::string& buffer, const std::string& contentType)
+	: m_buffer(new std::string(buffer)), m_contentType(contentType) {
+
+	m_offset = 0;
+}
+
+long long BufferRequestBody::getLength() {
+
+	return (long long) m_buffer->length();
+}
+
+long BufferRequestBody::read(char* buffer, size_t size) {
+
+	size_t len = std::min(size, m_buffer->length() - m_offset);
+
+	memcpy(buffer, m_buffer->data() + m_offset, len);
+	m_offset += len;
+
+	return (long) len;
+}
+
+bool BufferRequestBody::rewind() {
+
+	m_offset = 0;
+	return true;
+}
+
+
+// **** GeneratorRequestBody Implementation ****
+
+GeneratorRequestBody::GeneratorRequestBody( RequestBodyGenerator generator, void* context,
+	long long length, const std::string& contentType )
+	: m_generator(generator), m_context(context), m_length(length), m_contentType(contentType) {
+
+	m_started = false;
+}
+
+long long GeneratorRequestBody::getLength() {
+
+	return m_length;
+}
+
+long GeneratorRequestBody::read(char* buffer, size_t size) {
+
+	m_started = true;
+	return m_generator(m_context, buffer, size);
+}
+
+bool GeneratorRequestBody::rewind() {
+
+	// Nothing to do if nothing has been generated yet
+	return !m_started;
+}
+
+
+// **** ChainedRequestBody Implementation ****
+
+ChainedRequestBody::ChainedRequestBody() {
+
+	m_current = 0;
+}
+
+void ChainedRequestBody::append(HttpRequestBodyPtr body) {
+
+	m_bodies.push_back(body);
+}
+
+long long ChainedRequestBody::getLength() {
+
+	long long length = 0;
+
+	for (std::vector<HttpRequestBodyPtr>::iterator i = m_bodies.begin(); i != m_bodies.end(); i++) {
+
+		long long bodyLength = (*i)->getLength();
+		if (bodyLength < 0)
+			return -1;
+
+		length += bodyLength;
+	}
+
+	return length;
+}
+
+long ChainedRequestBody::read(char* buffer, size_t size) {
+
+	// Moves on to the next body at the end of
+	// each so only the last read returns 0
+	while (m_current < m_bodies.size()) {
+
+		long len = m_bodies[m_current]->read(buffer, size);
+		if (len != 0)
+			return len;
+
+		m_current++;
+	}
+
+	return 0;
+}
+
+bool ChainedRequestBody::rewind() {
+
+	m_current = 0;
+
+	for (std::vector<HttpRequestBodyPtr>::iterator i = m_bodies.begin(); i != m_bodies.end(); i++) {
+
+		if (!(*i)->rewind())
+			return false;
+	}
+
+	return true;
+}
+
+
+// **** MultipartRequestBody Implementation ****
+
+std::string createBoundary(void* body) {
+
+	char boundary[64];
+	sprintf(boundary, "----NadaxFormBoundary%llx%lx", (unsigned long long) currentTimeMicros(), (unsigned long) body);
+	return boundary;
+}
+
+// Escapes a name or file name within a quoted header parameter
+std::string quoteParameter(const std::string& value) {
+
+	std::string quoted("\"");
+
+	for (std::string::const_iterator c = value.begin(); c != value.end(); c++) {
+
+		if (*c == '"')
+			quoted += "%22";
+		else if (*c == '\r')
+			quoted += "%0D";
+		else if (*c == '\n')
+			quoted += "%0A";
+		else
+			quoted += *c;
+	}
+
+	return quoted + '"';
+}
+
+MultipartRequestBody::MultipartRequestBody()
+	: m_boundary(createBoundary(this)), m_close("--" + m_boundary + "--\r\n") {
+
+	m_closing = false;
+}
+
+void MultipartRequestBody::addField(const std::string& name, const std::string& value) {
+
+	std::string headers("Content-Disposition: form-data; name=" + quoteParameter(name) + "\r\n");
+	this->addPart(headers, HttpRequestBodyPtr(new BufferRequestBody(value)));
+}
+
+void MultipartRequestBody::addFile( const std::string& name, const std::string& fileName,
+	HttpRequestBodyPtr body, const std::string& contentType ) {
+
+	std::string headers(
+		"Content-Disposition: form-data; name=" + quoteParameter(name) + "; filename=" + quoteParameter(fileName) + "\r\n"
+		"Content-Type: " + contentType + "\r\n" );
+
+	this->addPart(headers, body);
+}
+
+void MultipartRequestBody::addFile( const std::string& name, const std::string& fileName,
+	const std::string& path, const std::string& contentType ) {
+
+	this->addFile(name, fileName, HttpRequestBodyPtr(new FileRequestBody(path)), contentType);
+}
+
+void MultipartRequestBody::addPart(const std::string& headers, HttpRequestBodyPtr body) {
+
+	ChainedRequestBody::append(HttpRequestBodyPtr(new BufferRequestBody("--" + m_boundary + "\r\n" + headers + "\r\n")));
+	ChainedRequestBody::append(body);
+	ChainedRequestBody::append(HttpRequestBodyPtr(new BufferRequestBody("\r\n")));
+}
+
+long long MultipartRequestBody::getLength() {
+
+	long long length = ChainedRequestBody::getLength();
+	return (length < 0 ? -1 : length + m_close.getLength());
+}
+
+long MultipartRequestBody::read(char* buffer, size_t size) {
+
+	if (!m_closing) {
+
+		long len = ChainedRequestBody::read(buffer, size);
+		if (len != 0)
+			return len;
+
+		m_closing = true;
+	}
+
+	return m_close.read(buffer, size);
+}
+
+bool MultipartRequestBody::rewind() {
+
+	m_closing = false;
+	m_close.rewind();
+
+	return ChainedRequestBody::rewind();
+}
+
+std::string MultipartRequestBody::getContentType() {
+
+	return "multipart/form-data; boundary=" + m_boundary;
+}
+
+
+	}  // namespace : http
+}  // namespace : mb
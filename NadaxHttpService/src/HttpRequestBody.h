@@ -0,0 +1,215 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef HTTPREQUESTBODY_H_
+#define HTTPREQUESTBODY_H_
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "boost/shared_ptr.hpp"
+
+
+namespace mb {
+	namespace http {
+
+
+/* Body of a request that is streamed to the server as it is
+ * sent instead of being rendered into memory beforehand. The
+ * body is read in pieces into the transfer's own buffer so
+ * the memory used is independent of the size of the body.
+ */
+class HttpRequestBody {
+
+public:
+	virtual ~HttpRequestBody() { };
+
+	/* Returns the size of the body or -1 if it is not known
+	 * in advance, in which case the body is sent chunked.
+	 */
+	virtual long long getLength() = 0;
+
+	/* Reads at most size bytes of the body into the buffer and
+	 * returns the number of bytes read, 0 at the end of the
+	 * body or -1 if the body could not be read.
+	 */
+	virtual long read(char* buffer, size_t size) = 0;
+
+	/* Restarts the body from the beginning so the request can
+	 * be sent again. Returns false if the body cannot be re-read.
+	 */
+	virtual bool rewind() = 0;
+
+	/* Content type of the body if not given by the request headers */
+	virtual std::string getContentType() {
+		return "application/octet-stream";
+	}
+};
+
+typedef boost::shared_ptr<HttpRequestBody> HttpRequestBodyPtr;
+
+
+/* Body read from a file in pieces. The file is opened
+ * when it is first read and closed at its end.
+ */
+class FileRequestBody : public HttpRequestBody {
+
+public:
+	FileRequestBody(const std::string& path);
+	virtual ~FileRequestBody();
+
+	long long getLength();
+	long read(char* buffer, size_t size);
+	bool rewind();
+
+private:
+	std::string m_path;
+	long long m_length;
+
+	FILE* m_file;
+	bool m_done;
+};
+
+
+/* Body sent from a buffer that is shared rather than copied */
+class BufferRequestBody : public HttpRequestBody {
+
+public:
+	BufferRequestBody(boost::shared_ptr<std::string> buffer, const std::string& contentType = "application/octet-stream");
+	BufferRequestBody(const std::string& buffer, const std::string& contentType = "application/octet-stream");
+
+	long long getLength();
+	long read(char* buffer, size_t size);
+	bool rewind();
+
+	std::string getContentType() {
+		return m_contentType;
+	}
+
+private:
+	boost::shared_ptr<std::string> m_buffer;
+	std::string m_contentType;
+
+	size_t m_offset;
+};
+
+
+/* Produces the next piece of a generated body into the buffer
+ * and returns its size, 0 at the end of the body or -1 on error.
+ */
+typedef long (*RequestBodyGenerator)(void* context, char* buffer, size_t size);
+
+/* Body produced by a generator as it is sent. A generated
+ * body cannot be rewound so its request cannot be resent.
+ */
+class GeneratorRequestBody : public HttpRequestBody {
+
+public:
+	GeneratorRequestBody( RequestBodyGenerator generator, void* context,
+		long long length = -1, const std::string& contentType = "application/octet-stream" );
+
+	long long getLength();
+	long read(char* buffer, size_t size);
+	bool rewind();
+
+	std::string getContentType() {
+		return m_contentType;
+	}
+
+private:
+	RequestBodyGenerator m_generator;
+	void* m_context;
+
+	long long m_length;
+	std::string m_contentType;
+
+	bool m_started;
+};
+
+
+/* Body made up of other bodies sent one after the other */
+class ChainedRequestBody : public HttpRequestBody {
+
+public:
+	ChainedRequestBody();
+
+	void append(HttpRequestBodyPtr body);
+
+	long long getLength();
+	long read(char* buffer, size_t size);
+	bool rewind();
+
+protected:
+	std::vector<HttpRequestBodyPtr> m_bodies;
+	size_t m_current;
+};
+
+
+/* Body encoded as multipart/form-data (RFC 7578). Each part's
+ * headers are rendered when the part is added while the part's
+ * content is streamed from its own body as the request is sent.
+ */
+class MultipartRequestBody : public ChainedRequestBody {
+
+public:
+	MultipartRequestBody();
+
+	/* Adds a form field with the given value */
+	void addField(const std::string& name, const std::string& value);
+
+	/* Adds a file whose content is read from the body */
+	void addFile( const std::string& name, const std::string& fileName,
+		HttpRequestBodyPtr body, const std::string& contentType = "application/octet-stream" );
+
+	/* Adds a file whose content is read from the given path */
+	void addFile( const std::string& name, const std::string& fileName,
+		const std::string& path, const std::string& contentType = "application/octet-stream" );
+
+	const std::string& getBoundary() {
+		return m_boundary;
+	}
+
+	long long getLength();
+	long read(char* buffer, size_t size);
+	bool rewind();
+
+	std::string getContentType();
+
+private:
+
+	void addPart(const std::string& headers, HttpRequestBodyPtr body);
+
+	std::string m_boundary;
+
+	// The closing delimiter follows the last part
+	BufferRequestBody m_close;
+	bool m_closing;
+};
+
+
+	}  // namespace : http
+}  // namespace : mb
+
+
+#endif /* HTTPREQUESTBODY_H_ */
@@ -0,0 +1,214 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "HttpResponseCache.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+
+#include "curl/curl.h"
+
+#include "log.h"
+#include "clock.h"
+
+#include "HttpMetrics.h"
+
+
+namespace mb {
+	namespace http {
+
+
+// **** HttpResponseCache Implementation ****
+
+HttpResponseCache::HttpResponseCache(size_t maxEntries, long defaultMaxAge, size_t maxBodySize, bool includePost) {
+
+	m_maxEntries = (maxEntries < 1 ? 1 : maxEntries);
+	m_defaultMaxAge = defaultMaxAge;
+	m_maxBodySize = maxBodySize;
+	m_includePost = includePost;
+
+	m_hits = 0;
+	m_revalidations = 0;
+	m_misses = 0;
+	m_evictions = 0;
+	m_bytesSaved = 0;
+}
+
+HttpResponseCache::~HttpResponseCache() {
+}
+
+CachedResponsePtr HttpResponseCache::lookup(const std::string& key, bool isModel) {
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+
+	boost::unordered_map<std::string, Entry>::iterator entry = m_entries.find(key);
+	if (entry == m_entries.end())
+		return CachedResponsePtr();
+
+	CachedResponsePtr response = entry->second.response;
+
+	// A response that was only kept as a model can
+	// not be returned to a request for the raw data
+	if (!isModel && response->body.length() == 0 && response->model)
+		return CachedResponsePtr();
+
+	m_lru.splice(m_lru.begin(), m_lru, entry->second.position);
+	return response;
+}
+
+bool HttpResponseCache::setExpiry(CachedResponsePtr response, const std::string& cacheControl, const std::string& expires) {
+
+	long long now = currentTimeMillis();
+	long maxAge = -1;
+
+	std::string directives(cacheControl);
+	for (size_t i = 0; i < directives.length(); i++)
+		directives[i] = tolower(directives[i]);
+
+	size_t begin = 0;
+	while (begin < directives.length()) {
+
+		size_t end = directives.find(',', begin);
+		if (end == std::string::npos)
+			end = directives.length();
+
+		size_t first = directives.find_first_not_of(" \t", begin);
+		size_t last = directives.find_last_not_of(" \t", end - 1);
+
+		if (first != std::string::npos && first < end && last >= first) {
+
+			std::string directive = directives.substr(first, last - first + 1);
+
+			if (directive == "no-store")
+				return false;
+			else if (directive == "no-cache")
+				maxAge = 0;
+			else if (directive.compare(0, 8, "max-age=") == 0 && maxAge != 0)
+				maxAge = atol(directive.c_str() + 8);
+		}
+
+		begin = end + 1;
+	}
+
+	if (maxAge >= 0) {
+
+		response->expires = now + (long long) maxAge * 1000;
+
+	} else if (expires.length() > 0) {
+
+		// An invalid date means the response has already expired
+		time_t time = curl_getdate(expires.c_str(), NULL);
+		response->expires = (time > 0 ? (long long) time * 1000 : 0);
+
+	} else
+		response->expires = now + (long long) m_defaultMaxAge * 1000;
+
+	return (response->isFresh(now) || response->hasValidator());
+}
+
+void HttpResponseCache::store(const std::string& key, CachedResponsePtr response) {
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+
+	boost::unordered_map<std::string, Entry>::iterator entry = m_entries.find(key);
+	if (entry != m_entries.end()) {
+
+		entry->second.response = response;
+		m_lru.splice(m_lru.begin(), m_lru, entry->second.position);
+		return;
+	}
+
+	while (m_entries.size() >= m_maxEntries) {
+
+		TRACE("Evicting least recently used cached HTTP response for '%s'.", m_lru.back().c_str());
+
+		m_entries.erase(m_lru.back());
+		m_lru.pop_back();
+		m_evictions++;
+	}
+
+	m_lru.push_front(key);
+
+	Entry& added = m_entries[key];
+	added.response = response;
+	added.position = m_lru.begin();
+}
+
+void HttpResponseCache::remove(const std::string& key) {
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+
+	boost::unordered_map<std::string, Entry>::iterator entry = m_entries.find(key);
+	if (entry != m_entries.end()) {
+
+		m_lru.erase(entry->second.position);
+		m_entries.erase(entry);
+	}
+}
+
+void HttpResponseCache::recordHit(size_t bytes) {
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+	m_hits++;
+	m_bytesSaved += bytes;
+}
+
+void HttpResponseCache::recordRevalidation(size_t bytes) {
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+	m_revalidations++;
+	m_bytesSaved += bytes;
+}
+
+void HttpResponseCache::recordMiss() {
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+	m_misses++;
+}
+
+void HttpResponseCache::getMetrics(NameValueMap& metrics) {
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+
+	long requests = m_hits + m_revalidations + m_misses;
+
+	metrics["cache.entries"] = metricValue(m_entries.size());
+	metrics["cache.hits"] = metricValue(m_hits);
+	metrics["cache.revalidations"] = metricValue(m_revalidations);
+	metrics["cache.misses"] = metricValue(m_misses);
+	metrics["cache.evictions"] = metricValue(m_evictions);
+	metrics["cache.bytesSaved"] = metricValue(m_bytesSaved);
+	metrics["cache.hitRate"] = metricValue(requests ? (double) (m_hits + m_revalidations) / requests : 0.0);
+}
+
+void HttpResponseCache::log(std::ostream& cout) {
+
+	cout << "\tResponse cache - " << std::endl;
+	cout << "\t\tMax entries - " << m_maxEntries << std::endl;
+	cout << "\t\tDefault max age - " << m_defaultMaxAge << "s" << std::endl;
+	cout << "\t\tMax body size - " << m_maxBodySize << std::endl;
+	cout << "\t\tInclude POST - " << (m_includePost ? 'Y' : 'N') << std::endl;
+}
+
+
+	}  // namespace : http
+}  // namespace : mb
@@ -0,0 +1,148 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef HTTPRESPONSECACHE_H_
+#define HTTPRESPONSECACHE_H_
+
+#include <string>
+#include <list>
+
+#include "boost/thread.hpp"
+#include "boost/shared_ptr.hpp"
+#include "boost/unordered_map.hpp"
+
+#include "DynaModel.h"
+#include "Service.h"
+
+
+namespace mb {
+	namespace http {
+
+
+/* A cached HTTP response. The response is kept as the raw
+ * body and/or the DynaModel it was bound to so that a
+ * response that has not been modified can be returned
+ * without being parsed again.
+ */
+class CachedResponse {
+
+public:
+	CachedResponse() {
+		expires = 0;
+		contentHash = 0;
+	}
+
+	bool isFresh(long long now) {
+		return (now < expires);
+	}
+
+	bool hasValidator() {
+		return (etag.length() > 0 || lastModified.length() > 0);
+	}
+
+	std::string etag;
+	std::string lastModified;
+
+	// Time in milli-seconds after which the response is stale
+	long long expires;
+
+	std::string body;
+	boost::shared_ptr<binding::DynaModel> model;
+
+	// Hash of the response body
+	unsigned long long contentHash;
+};
+
+typedef boost::shared_ptr<CachedResponse> CachedResponsePtr;
+
+
+/* LRU cache of the responses of an HTTP service keyed
+ * by the request. Cached responses are served without
+ * a request until they become stale after which they
+ * are revalidated with a conditional request.
+ */
+class HttpResponseCache {
+
+public:
+	HttpResponseCache(size_t maxEntries, long defaultMaxAge, size_t maxBodySize, bool includePost);
+	virtual ~HttpResponseCache();
+
+	bool isIncludePost() {
+		return m_includePost;
+	}
+	size_t getMaxBodySize() {
+		return m_maxBodySize;
+	}
+
+	/* Returns the cached response for the given key which can be
+	 * returned for a request whose response is bound to a DynaModel
+	 * if isModel is true or streamed as is otherwise.
+	 */
+	CachedResponsePtr lookup(const std::string& key, bool isModel);
+
+	/* Sets the expiry time of a response from its Cache-Control and
+	 * Expires headers. Returns false if the response may not be stored
+	 * or would never be usable as it is stale and has no validators.
+	 */
+	bool setExpiry(CachedResponsePtr response, const std::string& cacheControl, const std::string& expires);
+
+	void store(const std::string& key, CachedResponsePtr response);
+	void remove(const std::string& key);
+
+	void recordHit(size_t bytes);
+	void recordRevalidation(size_t bytes);
+	void recordMiss();
+
+	void getMetrics(NameValueMap& metrics);
+	void log(std::ostream& cout);
+
+private:
+
+	struct Entry {
+
+		CachedResponsePtr response;
+		std::list<std::string>::iterator position;
+	};
+
+	boost::mutex m_lock;
+
+	size_t m_maxEntries;
+	long m_defaultMaxAge;
+	size_t m_maxBodySize;
+	bool m_includePost;
+
+	boost::unordered_map<std::string, Entry> m_entries;
+	std::list<std::string> m_lru;
+
+	long m_hits;
+	long m_revalidations;
+	long m_misses;
+	long m_evictions;
+	long long m_bytesSaved;
+};
+
+
+	}  // namespace : http
+}  // namespace : mb
+
+
+#endif /* HTTPRESPONSECACHE_H_ */
@@ -24,10 +24,38 @@
 
 #include "DynaModel.h"
 #include "MessageBusManager.h"
+#include "ConcurrencyLimiter.h"
+#include "HedgingPolicy.h"
+#include "HttpResponseCache.h"
+#include "RequestCoalescer.h"
+#include "RequestBatcher.h"
+#include "HttpTransferTimings.h"
+#include "HttpMetrics.h"
 
 #define TOKEN_BEGIN  "{{"
 #define TOKEN_END    "}}"
 
+#define DEFAULT_CONCURRENCY_LIMIT       10
+#define DEFAULT_CONCURRENCY_MIN_LIMIT   1
+#define DEFAULT_CONCURRENCY_MAX_LIMIT   100
+#define DEFAULT_CONCURRENCY_MAX_QUEUE   100
+#define DEFAULT_CONCURRENCY_QUEUE_WAIT  0
+
+#define DEFAULT_HEDGING_PERCENTILE  95
+#define DEFAULT_HEDGING_MIN_DELAY   10
+#define DEFAULT_HEDGING_MAX_DELAY   0
+#define DEFAULT_HEDGING_BUDGET      5
+#define DEFAULT_HEDGING_BURST       10
+#define DEFAULT_HEDGING_WINDOW      200
+
+#define DEFAULT_CACHE_MAX_ENTRIES    100
+#define DEFAULT_CACHE_MAX_AGE        0
+#define DEFAULT_CACHE_MAX_BODY_SIZE  1048576
+
+#define DEFAULT_BATCH_SEPARATOR  ","
+#define DEFAULT_BATCH_MAX_SIZE   20
+#define DEFAULT_BATCH_MAX_WAIT   10
+
 
 namespace mb {
     namespace http {
@@ -45,6 +73,11 @@ HttpService::HttpService(const std::string& subject, const std::string& url) {
 	m_url = url;
 	m_timeout = 10;
 
+	m_compression = false;
+
+	m_timingMetaData = false;
+	m_transferTimings = boost::shared_ptr<HttpTransferTimings>(new HttpTransferTimings());
+
 	m_method = http::HttpMessage::GET;
 	m_contentType = Message::CNT_UNKNOWN;
 
@@ -52,6 +85,12 @@ HttpService::HttpService(const std::string& subject, const std::string& url) {
 
     m_subscriptionEnabled = false;
     m_subscribeAndSnap =false;
+
+    m_pollResponses = 0;
+    m_pollsSuppressed = 0;
+
+    m_wireBytes = 0;
+    m_decodedBytes = 0;
 }
 
 HttpService::~HttpService() {
@@ -59,7 +98,37 @@ HttpService::~HttpService() {
 
 void HttpService::intialize() {
     
-    std::string tmpl = this->getTemplate();
+    parseTemplate(this->getTemplate(), m_templateTokens);
+    
+    if (m_batchTemplate.length())
+        parseTemplate(m_batchTemplate, m_batchTemplateTokens);
+    else
+        m_batchTemplateTokens = m_templateTokens;
+    
+#ifdef LOG_LEVEL_TRACE
+    std::ostringstream output;
+    
+    bool isVar = false;
+    std::list<std::string>::iterator t;
+    
+    output << std::endl << std::endl << "\tTemplate tokens for service " << this->getSubject() << " : " << std::endl;
+    for (t = m_templateTokens.begin(); t != m_templateTokens.end(); t++) {
+        output << "\t\tTemplate " << (isVar ? "variable" : "characters") << " : " << *t << std::endl;
+        isVar = !isVar;
+    }
+    
+    TRACE(output.str().c_str());
+#endif
+
+	this->start();
+}
+
+void HttpService::destroy() {
+
+	this->stop();
+}
+
+void HttpService::parseTemplate(const std::string& tmpl, std::list<std::string>& tokens) {
     
     size_t len = tmpl.length();
     size_t k, j, i = 0;
@@ -68,44 +137,52 @@ void HttpService::intialize() {
         
         if ((j = tmpl.find(TOKEN_BEGIN, i)) == std::string::npos) {
             
-        	m_templateTokens.push_back(tmpl.substr(i, len));
+            tokens.push_back(tmpl.substr(i, len));
             break;
         }
         if ((k = tmpl.find(TOKEN_END, j + 2)) == std::string::npos) {
             
-        	m_templateTokens.push_back(tmpl.substr(i, len));
+            tokens.push_back(tmpl.substr(i, len));
             break;
         }
         
         // Template characters
-        m_templateTokens.push_back(tmpl.substr(i, j - i));
+        tokens.push_back(tmpl.substr(i, j - i));
         // Template variable name
-        m_templateTokens.push_back(tmpl.substr(j + 2, k - j - 2));
+        tokens.push_back(tmpl.substr(j + 2, k - j - 2));
         
         i = k + 2;
     }
-    
-#ifdef LOG_LEVEL_TRACE
-    std::ostringstream output;
-    
+}
+
+void HttpService::formatRequest(std::list<std::string>& tokens, NameValueMap& variables, std::ostream& output) {
+
+    ServiceConfigManager* scm = ServiceConfigManager::instance();
+
     bool isVar = false;
-    std::list<std::string>::iterator t;
-    
-    output << std::endl << std::endl << "\tTemplate tokens for service " << this->getSubject() << " : " << std::endl;
-    for (t = m_templateTokens.begin(); t != m_templateTokens.end(); t++) {
-        output << "\t\tTemplate " << (isVar ? "variable" : "characters") << " : " << *t << std::endl;
-        isVar = !isVar;
-    }
-    
-    TRACE(output.str().c_str());
-#endif
+    std::list<std::string>::iterator j;
+    for (j = tokens.begin(); j != tokens.end(); j++) {
 
-	this->start();
-}
+        if (isVar) {
 
-void HttpService::destroy() {
+        	if (variables.find(*j) != variables.end()) {
 
-	this->stop();
+        		output << variables[*j];
+
+        	} else {
+
+        		std::string value;
+        		if (scm->lookupTokenValue(*j, value))
+            		output << value;
+        		else
+        			output << TOKEN_BEGIN << *j << TOKEN_END;
+        	}
+
+        } else
+            output << *j;
+
+        isVar = !isVar;
+    }
 }
 
 void HttpService::onMessage(MessagePtr message) {
@@ -217,7 +294,7 @@ void HttpService::onMessage(MessagePtr message) {
 		message.get(),
 		response.get(),
 		Message::MSG_RESP_STREAM,
-		Message::CNT_UNKNOWN,
+		m_contentType,
 		respSubject );
 
 	NameValueMap& metaData = response->getMetaData();
@@ -241,15 +318,17 @@ void HttpService::onMessage(MessagePtr message) {
 		metaData[SUBSCRIPTION_ID] = httpMessage->getId();
 	}
 
-	if (POST_RESPONSE(response, message) > 0) {
+	// The response of an adaptive poll is posted by the implementation
+	// only once it is known whether the polled content has changed.
+	if (message->isAdaptivePoll() || POST_RESPONSE(response, message) > 0) {
 
         std::ostringstream output;
+        NameValueMap variables;
 
         // Build request body
 
 		try {
 
-            NameValueMap variables;
             std::list<Message::NameValue>::iterator i;
 
             std::list<Message::NameValue> params = httpMessage->getParams();
@@ -262,49 +341,205 @@ void HttpService::onMessage(MessagePtr message) {
                 variables[i->name] = i->value;
             }
 
-            ServiceConfigManager* scm = ServiceConfigManager::instance();
+            this->formatRequest(m_templateTokens, variables, output);
 
-            bool isVar = false;
-            std::list<std::string>::iterator j;
-            for (j = m_templateTokens.begin(); j != m_templateTokens.end(); j++) {
+	    } catch (...) {
 
-                if (isVar) {
+	        ERROR( "Error while formating request body for HTTP service with subject '%s'.",
+	            this->getSubject() );
 
-                	if (variables.find(*j) != variables.end()) {
+            response->setError(Message::ERR_CONNECTION_ERROR, 1, "Error formatting request body.");
+            SEND_DATA(response, NULL, 0);
+	    }
 
-                		output << variables[*j];
+		// Requests bound to a model that have a value for the batch
+		// parameter are merged with compatible requests. Requests are
+		// compatible if only the value of the batch parameter differs.
+		// Requests with a streamed body are neither batched nor coalesced
+		bool isStreamed = (httpMessage->getRequestBody().get() != NULL);
 
-                	} else {
+		if ( m_batcher && !message->isAdaptivePoll() && !isStreamed &&
+			metaData[DATA_IS_DYNA_MODEL] == CSTR_TRUE && variables.find(m_batcher->getParam()) != variables.end() ) {
 
-                		std::string value;
-                		if (scm->lookupTokenValue(*j, value))
-                    		output << value;
-                		else
-                			output << TOKEN_BEGIN << *j << TOKEN_END;
-                	}
+			std::ostringstream key;
 
-                } else
-                    output << *j;
+			for (NameValueMap::iterator i = variables.begin(); i != variables.end(); i++) {
+				if (i->first != m_batcher->getParam())
+					key << i->first << '=' << i->second << '\n';
+			}
 
-                isVar = !isVar;
-            }
+			std::list<Message::NameValue>& headers = httpMessage->getHeaders();
+			for (std::list<Message::NameValue>::iterator i = headers.begin(); i != headers.end(); i++)
+				key << '\n' << i->name << ": " << i->value;
 
-	    } catch (...) {
+			m_batcher->add(key.str(), message, response, variables);
+			return;
+		}
 
-	        ERROR( "Error while formating request body for HTTP service with subject '%s'.",
-	            this->getSubject() );
+		std::string result(output.str());
 
-            response->setError(Message::ERR_CONNECTION_ERROR, 1, "Error formatting request body.");
-            SEND_DATA(response, NULL, 0);
-	    }
+		// Polls are not coalesced as each adaptive poll
+		// tracks changes to the content it received
+		if ( m_coalescer && !message->isAdaptivePoll() && !isStreamed &&
+			(m_method != http::HttpMessage::POST || m_coalescer->isIncludePost()) ) {
 
-		std::string result(output.str());
-		this->execute(message, result);
+			std::string key(result);
+
+			std::list<Message::NameValue>& headers = httpMessage->getHeaders();
+			for (std::list<Message::NameValue>::iterator i = headers.begin(); i != headers.end(); i++)
+				key += '\n' + i->name + ": " + i->value;
+
+			if (!m_coalescer->join(key, response)) {
+
+				TRACE("Request for service '%s' was coalesced with an identical request in flight.", this->getSubject());
+				return;
+			}
+		}
+
+		this->execute(message, response, result);
 
 	} else
 		SEND_DATA(response, NULL, 0);
 }
 
+// Context of a batched request passed to its response callback
+struct BatchContext {
+
+	BatchContext(HttpService* service, RequestBatchPtr batch, boost::shared_ptr<binding::DynaModelBinder> binder)
+		: service(service), batch(batch), binder(binder) { }
+
+	HttpService* service;
+	RequestBatchPtr batch;
+	boost::shared_ptr<binding::DynaModelBinder> binder;
+};
+
+void HttpService::executeBatch(RequestBatchPtr batch) {
+
+	MessagePtr message(this->createMessage());
+
+	std::list<Message::NameValue>& headers = ((http::HttpMessage *) batch->message.get())->getHeaders();
+	for (std::list<Message::NameValue>::iterator i = headers.begin(); i != headers.end(); i++)
+		((http::HttpMessage *) message.get())->setHeader(i->name.c_str(), i->value.c_str());
+
+	// The batch is bound with a binder of the service so
+	// its response can be split by the bound items
+	BatchContext* context = new BatchContext(this, batch, this->getDynaModelBinder());
+	message->setDataBinder(context->binder);
+	((P2PMessage *) message.get())->setCallback(context, completeBatch);
+
+	MessagePtr response(new StreamMessage());
+	Service::initMessage(message.get(), response.get(), Message::MSG_RESP_STREAM, m_contentType);
+
+	response->getMetaData()[DATA_IS_DYNA_MODEL] = CSTR_TRUE;
+	Datum<binding::DynaModel> datum(response);
+
+	std::ostringstream output;
+	this->formatRequest(m_batchTemplateTokens, batch->variables, output);
+	std::string request(output.str());
+
+	if (POST_RESPONSE(response, message) > 0) {
+
+		this->execute(message, response, request);
+
+	} else {
+
+		ERROR("Unable to post the response of a batched request for service '%s'.", this->getSubject());
+
+		response->setError(Message::ERR_SERVICE, 500, "Unable to post the response of the batched request.");
+		m_batcher->complete(batch, response);
+
+		this->returnDynaModelBinder(context->binder);
+		delete context;
+	}
+}
+
+void HttpService::completeBatch(void* context, MessagePtr message) {
+
+	BatchContext* batchContext = (BatchContext *) context;
+	HttpService* service = batchContext->service;
+
+	service->m_batcher->complete(batchContext->batch, message);
+	service->returnDynaModelBinder(batchContext->binder);
+
+	delete batchContext;
+}
+
+bool HttpService::postPollResponse(MessagePtr message, MessagePtr response, unsigned long long contentHash) {
+
+	bool changed = true;
+
+	if (response->getError() == Message::ERR_NONE)
+		changed = message->updateContentHash(contentHash);
+
+	{ boost::lock_guard<boost::mutex> lock(m_pollLock);
+
+		m_pollResponses++;
+		if (!changed)
+			m_pollsSuppressed++;
+	}
+
+	if (!changed) {
+
+		TRACE( "Suppressing unchanged poll response for service '%s'. Next poll delay is %ld ms.",
+			this->getSubject(), message->getDelayInterval() );
+
+		return false;
+	}
+
+	return (POST_RESPONSE(response, message) > 0);
+}
+
+void HttpService::recordCompression(long long wireBytes, long long decodedBytes) {
+
+	boost::lock_guard<boost::mutex> lock(m_compressionLock);
+	m_wireBytes += wireBytes;
+	m_decodedBytes += decodedBytes;
+}
+
+void HttpService::getMetrics(NameValueMap& metrics) {
+
+	{ boost::lock_guard<boost::mutex> lock(m_pollLock);
+
+		if (m_pollResponses) {
+
+			metrics["poll.responses"] = metricValue(m_pollResponses);
+			metrics["poll.suppressed"] = metricValue(m_pollsSuppressed);
+		}
+	}
+
+	{ boost::lock_guard<boost::mutex> lock(m_compressionLock);
+
+		if (m_compression) {
+
+			metrics["compression.wireBytes"] = metricValue(m_wireBytes);
+			metrics["compression.decodedBytes"] = metricValue(m_decodedBytes);
+			metrics["compression.ratio"] = metricValue(m_wireBytes ? (double) m_decodedBytes / m_wireBytes : 0.0);
+		}
+	}
+
+	m_transferTimings->getMetrics(metrics);
+
+	UnmarshallerPoolPtr unmarshallers = this->getUnmarshallerPool();
+	long created = unmarshallers->getCreatedCount();
+
+	if (created) {
+
+		metrics["unmarshaller.created"] = metricValue(created);
+		metrics["unmarshaller.pooled"] = metricValue(unmarshallers->getUnallocatedPoolSize());
+	}
+
+	if (m_concurrencyLimiter)
+		m_concurrencyLimiter->getMetrics(metrics);
+	if (m_hedgingPolicy)
+		m_hedgingPolicy->getMetrics(metrics);
+	if (m_responseCache)
+		m_responseCache->getMetrics(metrics);
+	if (m_coalescer)
+		m_coalescer->getMetrics(metrics);
+	if (m_batcher)
+		m_batcher->getMetrics(metrics);
+}
+
 void HttpService::log(std::ostream& cout) {
 
 	Service::log(cout);
@@ -340,6 +575,9 @@ void HttpService::log(std::ostream& cout) {
 	}
 	cout << std::endl;
 
+	cout << "\tHTTP Version - " << (m_httpVersion.length() ? m_httpVersion.c_str() : "default") << std::endl;
+	cout << "\tTiming meta data - " << (m_timingMetaData ? 'Y' : 'N') << std::endl;
+	cout << "\tCompression - " << (m_compression ? (m_acceptEncoding.length() ? m_acceptEncoding.c_str() : "all supported") : "none") << std::endl;
 	cout << "\tSubscription enabled - " << (m_subscriptionEnabled ? 'Y' : 'N') << std::endl;
 	cout << "\tSubscribe and snap - " << (m_subscribeAndSnap ? 'Y' : 'N') << std::endl;
 	cout << "\tSnap override - " << m_streamDoNotSnap << std::endl;
@@ -349,10 +587,39 @@ void HttpService::log(std::ostream& cout) {
 		cout << "\t\t" << i->name << '=' << i->value << std::endl;
 	}
 
+	if (m_concurrencyLimiter)
+		m_concurrencyLimiter->log(cout);
+	if (m_hedgingPolicy)
+		m_hedgingPolicy->log(cout);
+	if (m_responseCache)
+		m_responseCache->log(cout);
+	if (m_coalescer)
+		m_coalescer->log(cout);
+	if (m_batcher)
+		m_batcher->log(cout);
+
+	NameValueMap metrics;
+	this->getMetrics(metrics);
+
+	if (metrics.size()) {
+
+		cout << "\tMetrics - " << std::endl;
+		for (NameValueMap::iterator i = metrics.begin(); i != metrics.end(); i++) {
+			cout << "\t\t" << i->first << '=' << i->second << std::endl;
+		}
+	}
+
 	cout << std::endl;
 	cout << "**** Begin Request Template =>" << std::endl;
 	cout << m_template << std::endl;
 	cout << "<= End Request Template ****" << std::endl << std::endl;
+
+	if (m_batchTemplate.length()) {
+
+		cout << "**** Begin Batch Template =>" << std::endl;
+		cout << m_batchTemplate << std::endl;
+		cout << "<= End Batch Template ****" << std::endl << std::endl;
+	}
 }
 
 // Configuration callbacks
@@ -382,6 +649,187 @@ void HttpService::initService(void* binder, const char* element, std::map<std::s
 				contentType == "text/xml" ? Message::CNT_XML :
 				contentType == "application/json" ? Message::CNT_JSON : Message::CNT_UNKNOWN );
 		}
+		if (attribs.find("compression") != attribsEnd) {
+
+			// Either true, false or the list of encodings to accept
+			std::string compression = attribs["compression"];
+			httpService->m_compression = (compression != CSTR_FALSE);
+			httpService->m_acceptEncoding = (compression == CSTR_TRUE ? "" : compression);
+		}
+		if (attribs.find("httpVersion") != attribsEnd)
+			httpService->m_httpVersion = attribs["httpVersion"];
+		if (attribs.find("timingMetaData") != attribsEnd)
+			httpService->m_timingMetaData = (attribs["timingMetaData"] == CSTR_TRUE);
+		if (attribs.find("spoolThreshold") != attribsEnd)
+			httpService->setSpoolThreshold((size_t) atol(attribs["spoolThreshold"].c_str()));
+    }
+}
+
+ADD_BEGIN_CONFIG_BINDING("messagebus-config/service/httpConfig/concurrencyLimit", HttpService, configureConcurrencyLimit);
+void HttpService::configureConcurrencyLimit(void* binder, const char* element, std::map<std::string, std::string>& attribs) {
+
+    GET_BINDER(mb::ServiceConfig);
+    Service* service = (Service *) dataBinder->getService();
+
+    if (service->isType("http")) {
+
+        HttpService* httpService = (HttpService *) service;
+		std::map<std::string, std::string>::iterator attribsEnd = attribs.end();
+
+		int initialLimit = DEFAULT_CONCURRENCY_LIMIT;
+		int minLimit = DEFAULT_CONCURRENCY_MIN_LIMIT;
+		int maxLimit = DEFAULT_CONCURRENCY_MAX_LIMIT;
+		int maxQueue = DEFAULT_CONCURRENCY_MAX_QUEUE;
+		long maxQueueWait = DEFAULT_CONCURRENCY_QUEUE_WAIT;
+
+		if (attribs.find("initial") != attribsEnd)
+			initialLimit = atoi(attribs["initial"].c_str());
+		if (attribs.find("min") != attribsEnd)
+			minLimit = atoi(attribs["min"].c_str());
+		if (attribs.find("max") != attribsEnd)
+			maxLimit = atoi(attribs["max"].c_str());
+		if (attribs.find("maxQueue") != attribsEnd)
+			maxQueue = atoi(attribs["maxQueue"].c_str());
+		if (attribs.find("maxQueueWait") != attribsEnd)
+			maxQueueWait = atol(attribs["maxQueueWait"].c_str());
+
+		httpService->m_concurrencyLimiter = boost::shared_ptr<ConcurrencyLimiter>(
+			new ConcurrencyLimiter(initialLimit, minLimit, maxLimit, maxQueue, maxQueueWait) );
+
+		if (attribs.find("rttTolerance") != attribsEnd)
+			httpService->m_concurrencyLimiter->setRttTolerance(atof(attribs["rttTolerance"].c_str()));
+		if (attribs.find("backoffRatio") != attribsEnd)
+			httpService->m_concurrencyLimiter->setBackoffRatio(atof(attribs["backoffRatio"].c_str()));
+    }
+}
+
+ADD_BEGIN_CONFIG_BINDING("messagebus-config/service/httpConfig/hedging", HttpService, configureHedging);
+void HttpService::configureHedging(void* binder, const char* element, std::map<std::string, std::string>& attribs) {
+
+    GET_BINDER(mb::ServiceConfig);
+    Service* service = (Service *) dataBinder->getService();
+
+    if (service->isType("http")) {
+
+        HttpService* httpService = (HttpService *) service;
+		std::map<std::string, std::string>::iterator attribsEnd = attribs.end();
+
+		if (httpService->m_method != http::HttpMessage::GET) {
+
+			// Only idempotent requests can be safely duplicated
+			WARN("Hedging is only supported for GET services. Ignoring hedging configuration for service '%s'.", httpService->getSubject());
+			return;
+		}
+
+		double percentile = DEFAULT_HEDGING_PERCENTILE;
+		long minDelay = DEFAULT_HEDGING_MIN_DELAY;
+		long maxDelay = DEFAULT_HEDGING_MAX_DELAY;
+		double budget = DEFAULT_HEDGING_BUDGET;
+		int burst = DEFAULT_HEDGING_BURST;
+		int window = DEFAULT_HEDGING_WINDOW;
+
+		if (attribs.find("percentile") != attribsEnd)
+			percentile = atof(attribs["percentile"].c_str());
+		if (attribs.find("minDelay") != attribsEnd)
+			minDelay = atol(attribs["minDelay"].c_str());
+		if (attribs.find("maxDelay") != attribsEnd)
+			maxDelay = atol(attribs["maxDelay"].c_str());
+		if (attribs.find("budget") != attribsEnd)
+			budget = atof(attribs["budget"].c_str());
+		if (attribs.find("burst") != attribsEnd)
+			burst = atoi(attribs["burst"].c_str());
+		if (attribs.find("window") != attribsEnd)
+			window = atoi(attribs["window"].c_str());
+
+		httpService->m_hedgingPolicy = boost::shared_ptr<HedgingPolicy>(
+			new HedgingPolicy(percentile, minDelay, maxDelay, budget, burst, window) );
+    }
+}
+
+ADD_BEGIN_CONFIG_BINDING("messagebus-config/service/httpConfig/cache", HttpService, configureCache);
+void HttpService::configureCache(void* binder, const char* element, std::map<std::string, std::string>& attribs) {
+
+    GET_BINDER(mb::ServiceConfig);
+    Service* service = (Service *) dataBinder->getService();
+
+    if (service->isType("http")) {
+
+        HttpService* httpService = (HttpService *) service;
+		std::map<std::string, std::string>::iterator attribsEnd = attribs.end();
+
+		int maxEntries = DEFAULT_CACHE_MAX_ENTRIES;
+		long defaultMaxAge = DEFAULT_CACHE_MAX_AGE;
+		long maxBodySize = DEFAULT_CACHE_MAX_BODY_SIZE;
+		bool includePost = false;
+
+		if (attribs.find("maxEntries") != attribsEnd)
+			maxEntries = atoi(attribs["maxEntries"].c_str());
+		if (attribs.find("defaultMaxAge") != attribsEnd)
+			defaultMaxAge = atol(attribs["defaultMaxAge"].c_str());
+		if (attribs.find("maxBodySize") != attribsEnd)
+			maxBodySize = atol(attribs["maxBodySize"].c_str());
+		if (attribs.find("includePost") != attribsEnd)
+			// POST responses are cached only for services
+			// whose POST requests are known to be queries
+			includePost = (attribs["includePost"] == CSTR_TRUE);
+
+		httpService->m_responseCache = boost::shared_ptr<HttpResponseCache>(
+			new HttpResponseCache(maxEntries, defaultMaxAge, maxBodySize, includePost) );
+    }
+}
+
+ADD_BEGIN_CONFIG_BINDING("messagebus-config/service/httpConfig/coalescing", HttpService, configureCoalescing);
+void HttpService::configureCoalescing(void* binder, const char* element, std::map<std::string, std::string>& attribs) {
+
+    GET_BINDER(mb::ServiceConfig);
+    Service* service = (Service *) dataBinder->getService();
+
+    if (service->isType("http")) {
+
+        HttpService* httpService = (HttpService *) service;
+		bool includePost = false;
+
+		if (attribs.find("includePost") != attribs.end())
+			// POST requests are coalesced only for services
+			// whose POST requests are known to be queries
+			includePost = (attribs["includePost"] == CSTR_TRUE);
+
+		httpService->m_coalescer = boost::shared_ptr<RequestCoalescer>(new RequestCoalescer(includePost));
+    }
+}
+
+ADD_BEGIN_CONFIG_BINDING("messagebus-config/service/httpConfig/batching", HttpService, configureBatching);
+void HttpService::configureBatching(void* binder, const char* element, std::map<std::string, std::string>& attribs) {
+
+    GET_BINDER(mb::ServiceConfig);
+    Service* service = (Service *) dataBinder->getService();
+
+    if (service->isType("http")) {
+
+        HttpService* httpService = (HttpService *) service;
+		std::map<std::string, std::string>::iterator attribsEnd = attribs.end();
+
+		std::string param = attribs["param"];
+		std::string keyPath = attribs["keyPath"];
+		std::string separator = DEFAULT_BATCH_SEPARATOR;
+		int maxBatchSize = DEFAULT_BATCH_MAX_SIZE;
+		long maxWait = DEFAULT_BATCH_MAX_WAIT;
+
+		if (param.length() == 0 || keyPath.length() == 0) {
+
+			ERROR("Request batching for service '%s' requires a batch parameter and a key path.", httpService->getSubject());
+			return;
+		}
+
+		if (attribs.find("separator") != attribsEnd)
+			separator = attribs["separator"];
+		if (attribs.find("maxBatchSize") != attribsEnd)
+			maxBatchSize = atoi(attribs["maxBatchSize"].c_str());
+		if (attribs.find("maxWait") != attribsEnd)
+			maxWait = atol(attribs["maxWait"].c_str());
+
+		httpService->m_batcher = boost::shared_ptr<RequestBatcher>( new RequestBatcher(
+			boost::bind(&HttpService::executeBatch, httpService, _1), param, keyPath, separator, maxBatchSize, maxWait ) );
     }
 }
 
@@ -405,6 +853,16 @@ void HttpService::addRequestTemplate(void* binder, const char* element, const ch
     	((HttpService *) service)->m_template = body;
 }
 
+ADD_END_CONFIG_BINDING("messagebus-config/service/batchTemplate", HttpService, addBatchTemplate);
+void HttpService::addBatchTemplate(void* binder, const char* element, const char* body) {
+
+    GET_BINDER(mb::ServiceConfig);
+    Service* service = (Service *) dataBinder->getService();
+
+    if (service->isType("http"))
+    	((HttpService *) service)->m_batchTemplate = body;
+}
+
 
 	}  // namespace : http
 }  // namespace : mb
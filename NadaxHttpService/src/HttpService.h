@@ -27,19 +27,63 @@
 #include <iostream>
 #include <list>
 
+#include "boost/shared_ptr.hpp"
+
 #include "staticinit.h"
 #include "number.h"
 
 #include "ServiceConfigManager.h"
 #include "Service.h"
 
+#include "HttpRequestBody.h"
+
+
+// Response meta data key set to one of the cache status values
+// below when the response of a cached HTTP service is returned
+#define HTTP_CACHE_STATUS              "HTTP_CACHE_STATUS"
+#define HTTP_CACHE_STATUS_HIT          "hit"
+#define HTTP_CACHE_STATUS_REVALIDATED  "revalidated"
+#define HTTP_CACHE_STATUS_MISS         "miss"
+
+// Response meta data keys set to the time in micro-seconds
+// spent in each stage of the request that was responded to
+#define HTTP_TIME_QUEUE     "HTTP_TIME_QUEUE"
+#define HTTP_TIME_CONNECT   "HTTP_TIME_CONNECT"
+#define HTTP_TIME_TTFB      "HTTP_TIME_TTFB"
+#define HTTP_TIME_TRANSFER  "HTTP_TIME_TRANSFER"
+
+// Response meta data keys set to the rest of the transfer's
+// timing breakdown (micro-seconds), its sizes (bytes) and if
+// it reused a connection when the service is configured to
+// add the transfer timings to the response meta data
+#define HTTP_TIME_NAME_LOOKUP   "HTTP_TIME_NAME_LOOKUP"
+#define HTTP_TIME_APP_CONNECT   "HTTP_TIME_APP_CONNECT"
+#define HTTP_TIME_TOTAL         "HTTP_TIME_TOTAL"
+#define HTTP_SIZE_DOWNLOAD      "HTTP_SIZE_DOWNLOAD"
+#define HTTP_SIZE_UPLOAD        "HTTP_SIZE_UPLOAD"
+#define HTTP_SIZE_HEADER        "HTTP_SIZE_HEADER"
+#define HTTP_CONNECTION_REUSED  "HTTP_CONNECTION_REUSED"
+
+// Response meta data key set to the number of requests
+// in the batch a batched request was responded from
+#define HTTP_BATCH_SIZE  "HTTP_BATCH_SIZE"
+
 
 namespace mb {
     namespace http {
 
 
-/* Optional callback to retrieve request body from caller
- * TODO: Refactor to enable file uploads
+class ConcurrencyLimiter;
+class HedgingPolicy;
+class HttpResponseCache;
+class RequestCoalescer;
+class RequestBatcher;
+class HttpTransferTimings;
+struct RequestBatch;
+
+/* Optional callback to retrieve request body from caller. Bodies
+ * that are large or read from files should instead be streamed
+ * with HttpMessage::setRequestBody.
  */
 typedef void (*GetRequestBodyCallback)(MessagePtr message, std::ostream& buffer);
 
@@ -67,6 +111,7 @@ public:
 
 		m_method = message->m_method;
 		m_getBodyCallback = message->m_getBodyCallback;
+		m_requestBody = message->m_requestBody;
 
 		std::list<Message::NameValue>* list;
 
@@ -85,6 +130,17 @@ public:
 		m_getBodyCallback = getBodyCallback;
 	}
 
+	/* Body streamed as the request is sent. A request with a
+	 * streamed body is always posted and the service's request
+	 * template, if any, renders the query string of the url.
+	 */
+	void setRequestBody(HttpRequestBodyPtr requestBody) {
+		m_requestBody = requestBody;
+	}
+	HttpRequestBodyPtr getRequestBody() {
+		return m_requestBody;
+	}
+
 	/* Http Method */
 	HttpMethod getMethod() {
 		return m_method;
@@ -147,6 +203,7 @@ private:
 	std::list<Message::NameValue> m_tmplVars;
 
 	GetRequestBodyCallback m_getBodyCallback;
+	HttpRequestBodyPtr m_requestBody;
 };
 
 /* A HTTP Service class implements an HTTP service endpoint.
@@ -185,28 +242,88 @@ public:
         return m_template.c_str();
     }
     
-    virtual void execute(MessagePtr message, std::string& request) = 0;
+    /* Executes the request. The response of an adaptive poll has not
+     * been posted and must be completed via postPollResponse.
+     */
+    virtual void execute(MessagePtr message, MessagePtr response, std::string& request) = 0;
+
+    virtual void getMetrics(NameValueMap& metrics);
 
     // XML Configuration bindings
 
     static void initService(void* binder, const char* element, std::map<std::string, std::string>& attribs);
+    static void configureConcurrencyLimit(void* binder, const char* element, std::map<std::string, std::string>& attribs);
+    static void configureHedging(void* binder, const char* element, std::map<std::string, std::string>& attribs);
+    static void configureCache(void* binder, const char* element, std::map<std::string, std::string>& attribs);
+    static void configureCoalescing(void* binder, const char* element, std::map<std::string, std::string>& attribs);
+    static void configureBatching(void* binder, const char* element, std::map<std::string, std::string>& attribs);
     static void addHeader(void* binder, const char* element, std::map<std::string, std::string>& attribs);
     static void addRequestTemplate(void* binder, const char* element, const char* body);
+    static void addBatchTemplate(void* binder, const char* element, const char* body);
 
 protected:
 
     void log(std::ostream& cout);
 
+    /* Splits a request template into alternating tokens of
+     * template characters and template variable names.
+     */
+    static void parseTemplate(const std::string& tmpl, std::list<std::string>& tokens);
+
+    /* Renders the request template tokens with the given variables.
+     * Variables that are not given are looked up as config tokens.
+     */
+    void formatRequest(std::list<std::string>& tokens, NameValueMap& variables, std::ostream& output);
+
+    /* Executes a batch of requests merged by the request batcher */
+    void executeBatch(boost::shared_ptr<RequestBatch> batch);
+    static void completeBatch(void* context, MessagePtr message);
+
+    /* Posts the response of an adaptive poll if the hash of its content
+     * differs from that of the previous poll response. Responses with
+     * errors are always posted. Returns true if the response was posted
+     * in which case its data should be streamed to it.
+     */
+    bool postPollResponse(MessagePtr message, MessagePtr response, unsigned long long contentHash);
+
+    /* Records the size of a compressed response as received
+     * and after it was decoded.
+     */
+    void recordCompression(long long wireBytes, long long decodedBytes);
+
     std::string m_subject;
     std::string m_url;
     int m_timeout;
 
+    // Encodings offered in the Accept-Encoding header of
+    // a compressed service. An empty list offers all
+    // encodings supported by the HTTP client.
+    bool m_compression;
+    std::string m_acceptEncoding;
+
+    // HTTP protocol version to use. One of 1.0, 1.1, 2 or
+    // 2-prior-knowledge which uses HTTP/2 without upgrading
+    // from HTTP/1.1 over plain connections. An empty value
+    // lets the HTTP client choose.
+    std::string m_httpVersion;
+
+    // Adds the timing breakdown of each transfer to the
+    // meta data of its response. The timings are always
+    // aggregated in the service's metrics.
+    bool m_timingMetaData;
+    boost::shared_ptr<HttpTransferTimings> m_transferTimings;
+
     HttpMessage::HttpMethod m_method;
     Message::ContentType m_contentType;
 
     std::string m_template;
     std::list<std::string> m_templateTokens;
 
+    // Template of a batched request. The request template
+    // is used to render batches if it is not configured.
+    std::string m_batchTemplate;
+    std::list<std::string> m_batchTemplateTokens;
+
     std::list<Message::NameValue> m_headers;
 
     std::string m_streamSubject;
@@ -216,6 +333,19 @@ protected:
 
     Number<bool> m_subscriptionEnabled;
 
+    boost::shared_ptr<ConcurrencyLimiter> m_concurrencyLimiter;
+    boost::shared_ptr<HedgingPolicy> m_hedgingPolicy;
+    boost::shared_ptr<HttpResponseCache> m_responseCache;
+    boost::shared_ptr<RequestCoalescer> m_coalescer;
+    boost::shared_ptr<RequestBatcher> m_batcher;
+
+    boost::mutex m_pollLock;
+    long m_pollResponses;
+    long m_pollsSuppressed;
+
+    boost::mutex m_compressionLock;
+    long long m_wireBytes;
+    long long m_decodedBytes;
 };
 
 STATIC_INIT_CALL(HttpService)
@@ -0,0 +1,215 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "HttpTransferTimings.h"
+
+#include "HttpService.h"
+#include "HttpMetrics.h"
+
+// Values below this are counted in buckets of their own
+#define LINEAR_BUCKETS     8
+// Buckets each power of two is divided into
+#define SUB_BUCKETS        8
+#define SUB_BUCKET_BITS    3
+// Values above 2^MAX_EXPONENT are counted in the last bucket
+#define MAX_EXPONENT       40
+
+#define NUM_BUCKETS  (LINEAR_BUCKETS + (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKETS)
+
+
+namespace mb {
+	namespace http {
+
+
+const char* _phaseNames[HttpTransferTimings::NUM_PHASES] = {
+	"nameLookup", "connect", "appConnect", "ttfb", "transfer", "total"
+};
+
+
+// **** Histogram Implementation ****
+
+Histogram::Histogram()
+	: m_buckets(NUM_BUCKETS, 0) {
+
+	m_count = 0;
+	m_sum = 0;
+	m_max = 0;
+}
+
+void Histogram::add(long long value) {
+
+	if (value < 0)
+		value = 0;
+
+	m_buckets[bucket(value)]++;
+
+	m_count++;
+	m_sum += value;
+	if (value > m_max)
+		m_max = value;
+}
+
+long long Histogram::percentile(double percentile) {
+
+	if (!m_count)
+		return -1;
+
+	long rank = (long) (percentile / 100.0 * (m_count - 1) + 0.5) + 1;
+	long count = 0;
+
+	for (size_t i = 0; i < m_buckets.size(); i++) {
+
+		count += m_buckets[i];
+		if (count >= rank) {
+
+			long long limit = bucketLimit(i);
+			return (limit < m_max ? limit : m_max);
+		}
+	}
+	return m_max;
+}
+
+void Histogram::getMetrics(NameValueMap& metrics, const std::string& prefix) {
+
+	metrics[prefix + ".count"] = metricValue(m_count);
+
+	if (m_count) {
+
+		metrics[prefix + ".mean"] = metricValue((long long) this->getMean());
+		metrics[prefix + ".p50"] = metricValue(this->percentile(50));
+		metrics[prefix + ".p90"] = metricValue(this->percentile(90));
+		metrics[prefix + ".p99"] = metricValue(this->percentile(99));
+		metrics[prefix + ".max"] = metricValue(m_max);
+	}
+}
+
+size_t Histogram::bucket(long long value) {
+
+	if (value < LINEAR_BUCKETS)
+		return (size_t) value;
+
+	int exponent = 0;
+	for (long long v = value; v > 1; v >>= 1)
+		exponent++;
+
+	if (exponent > MAX_EXPONENT)
+		return NUM_BUCKETS - 1;
+
+	// The bits below the leading bit select the sub-bucket
+	size_t subBucket = (size_t) ((value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+	return LINEAR_BUCKETS + (exponent - SUB_BUCKET_BITS) * SUB_BUCKETS + subBucket;
+}
+
+long long Histogram::bucketLimit(size_t bucket) {
+
+	if (bucket < LINEAR_BUCKETS)
+		return (long long) bucket;
+
+	int exponent = (int) ((bucket - LINEAR_BUCKETS) / SUB_BUCKETS) + SUB_BUCKET_BITS;
+	long long subBucket = (long long) ((bucket - LINEAR_BUCKETS) % SUB_BUCKETS);
+	long long width = 1LL << (exponent - SUB_BUCKET_BITS);
+
+	return (SUB_BUCKETS + subBucket + 1) * width - 1;
+}
+
+
+// **** HttpTransferTimings Implementation ****
+
+HttpTransferTimings::HttpTransferTimings() {
+
+	m_transfers = 0;
+	m_reused = 0;
+
+	m_downloadBytes = 0;
+	m_uploadBytes = 0;
+	m_headerBytes = 0;
+}
+
+HttpTransferTimings::~HttpTransferTimings() {
+}
+
+void HttpTransferTimings::record(const TransferTiming& timing) {
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+
+	m_transfers++;
+
+	if (timing.isReused) {
+
+		m_reused++;
+
+	} else {
+
+		m_phases[NAME_LOOKUP].add(timing.nameLookup);
+		m_phases[CONNECT].add(timing.connect - timing.nameLookup);
+
+		if (timing.appConnect)
+			m_phases[APP_CONNECT].add(timing.appConnect - timing.connect);
+	}
+
+	if (timing.startTransfer) {
+
+		m_phases[TTFB].add(timing.startTransfer - (timing.appConnect ? timing.appConnect : timing.connect));
+		m_phases[TRANSFER].add(timing.total - timing.startTransfer);
+	}
+
+	m_phases[TOTAL].add(timing.total);
+
+	m_downloadSizes.add(timing.downloadSize);
+
+	m_downloadBytes += timing.downloadSize;
+	m_uploadBytes += timing.uploadSize;
+	m_headerBytes += timing.headerSize;
+}
+
+void HttpTransferTimings::addMetaData(const TransferTiming& timing, NameValueMap& metaData) {
+
+	metaData[HTTP_TIME_NAME_LOOKUP] = metricValue(timing.nameLookup);
+	metaData[HTTP_TIME_APP_CONNECT] = metricValue(timing.appConnect ? timing.appConnect - timing.connect : 0);
+	metaData[HTTP_TIME_TOTAL] = metricValue(timing.total);
+	metaData[HTTP_SIZE_DOWNLOAD] = metricValue(timing.downloadSize);
+	metaData[HTTP_SIZE_UPLOAD] = metricValue(timing.uploadSize);
+	metaData[HTTP_SIZE_HEADER] = metricValue(timing.headerSize);
+	metaData[HTTP_CONNECTION_REUSED] = (timing.isReused ? CSTR_TRUE : CSTR_FALSE);
+}
+
+void HttpTransferTimings::getMetrics(NameValueMap& metrics) {
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+
+	metrics["transfer.count"] = metricValue(m_transfers);
+	metrics["transfer.reused"] = metricValue(m_reused);
+	metrics["transfer.downloadBytes"] = metricValue(m_downloadBytes);
+	metrics["transfer.uploadBytes"] = metricValue(m_uploadBytes);
+	metrics["transfer.headerBytes"] = metricValue(m_headerBytes);
+
+	m_downloadSizes.getMetrics(metrics, "transfer.downloadSize");
+
+	// Times are in micro-seconds
+	for (int i = 0; i < NUM_PHASES; i++)
+		m_phases[i].getMetrics(metrics, std::string("timing.") + _phaseNames[i]);
+}
+
+
+	}  // namespace : http
+}  // namespace : mb
@@ -0,0 +1,164 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef HTTPTRANSFERTIMINGS_H_
+#define HTTPTRANSFERTIMINGS_H_
+
+#include <string>
+#include <vector>
+
+#include "boost/thread.hpp"
+
+#include "Service.h"
+
+
+namespace mb {
+	namespace http {
+
+
+/* Log-linear histogram of non-negative values. Each power
+ * of two is divided into eight buckets so percentiles are
+ * reported within 12.5% of the values that were added.
+ */
+class Histogram {
+
+public:
+	Histogram();
+
+	void add(long long value);
+
+	/* Returns the upper bound of the bucket holding the
+	 * given percentile or -1 if no values were added.
+	 */
+	long long percentile(double percentile);
+
+	long getCount() {
+		return m_count;
+	}
+	long long getMax() {
+		return m_max;
+	}
+	double getMean() {
+		return (m_count ? (double) m_sum / m_count : 0.0);
+	}
+
+	/* Adds the count, mean, p50, p90, p99 and max
+	 * with the given prefix to the metrics map.
+	 */
+	void getMetrics(NameValueMap& metrics, const std::string& prefix);
+
+private:
+
+	static size_t bucket(long long value);
+	static long long bucketLimit(size_t bucket);
+
+	std::vector<long> m_buckets;
+
+	long m_count;
+	long long m_sum;
+	long long m_max;
+};
+
+
+/* Timing breakdown of a single HTTP transfer. The times are
+ * in micro-seconds from the start of the transfer until the
+ * end of each stage as reported by the HTTP client.
+ */
+struct TransferTiming {
+
+	TransferTiming() {
+		nameLookup = connect = appConnect = startTransfer = total = 0;
+		downloadSize = uploadSize = headerSize = 0;
+		isReused = false;
+	}
+
+	long long nameLookup;
+	long long connect;
+	// Zero unless a TLS handshake was made
+	long long appConnect;
+	// Zero if no response was received
+	long long startTransfer;
+	long long total;
+
+	long long downloadSize;
+	long long uploadSize;
+	long long headerSize;
+
+	// True if the transfer reused an open connection
+	bool isReused;
+};
+
+
+/* Histograms of the time each HTTP transfer of a service
+ * spent resolving the host, connecting, negotiating TLS,
+ * waiting for the server and receiving the response. The
+ * connection phases are recorded only for transfers that
+ * opened a new connection so reused connections do not
+ * hide the cost of opening one.
+ */
+class HttpTransferTimings {
+
+public:
+	enum Phase {
+		NAME_LOOKUP,  // Resolving the host name
+		CONNECT,      // TCP connect after the name was resolved
+		APP_CONNECT,  // TLS handshake after the TCP connect
+		TTFB,         // Connected until the first response byte
+		TRANSFER,     // First until the last response byte
+		TOTAL,
+
+		NUM_PHASES
+	};
+
+public:
+	HttpTransferTimings();
+	virtual ~HttpTransferTimings();
+
+	void record(const TransferTiming& timing);
+
+	/* Adds the breakdown of a transfer to a response's meta data */
+	static void addMetaData(const TransferTiming& timing, NameValueMap& metaData);
+
+	void getMetrics(NameValueMap& metrics);
+
+private:
+
+	boost::mutex m_lock;
+
+	Histogram m_phases[NUM_PHASES];
+	Histogram m_downloadSizes;
+
+	long m_transfers;
+	long m_reused;
+
+	long long m_downloadBytes;
+	long long m_uploadBytes;
+	long long m_headerBytes;
+};
+
+
+	}  // namespace : http
+}  // namespace : mb
+
+
+#endif /* HTTPTRANSFERTIMINGS_H_ */
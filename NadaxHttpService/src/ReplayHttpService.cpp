@@ -0,0 +1,421 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "ReplayHttpService.h"
+
+#include <stdlib.h>
+
+#include "log.h"
+#include "clock.h"
+#include "hash.h"
+
+#include "HttpMetrics.h"
+#include "MessageBusManager.h"
+
+
+#define DEFAULT_REPLAY_SPEED        1.0
+#define DEFAULT_REPLAY_CONCURRENCY  4
+
+
+namespace mb {
+	namespace http {
+
+
+// Recordings are shared by all services that use the same file
+// so services can record to and replay from a single recording
+std::map<std::string, HttpRecordingPtr> _recordings;
+boost::mutex _recordingsLock;
+
+HttpRecordingPtr getRecording(const std::string& path, ReplayHttpService::Mode mode) {
+
+	boost::lock_guard<boost::mutex> lock(_recordingsLock);
+
+	std::map<std::string, HttpRecordingPtr>::iterator recording = _recordings.find(path);
+	if (recording != _recordings.end())
+		return recording->second;
+
+	HttpRecordingPtr created(new HttpRecording(path));
+
+	if (mode == ReplayHttpService::RECORD ? !created->create() : !created->load())
+		return HttpRecordingPtr();
+
+	_recordings[path] = created;
+	return created;
+}
+
+
+// State of a response being replayed or recorded
+struct ReplayHttpService::Playback {
+
+	Playback(ReplayHttpService* service, MessagePtr message, MessagePtr response)
+		: service(service), message(message), response(response) {
+
+		isPoll = message->isAdaptivePoll();
+		contentHash = FNV1A_64_INIT;
+
+		startTime = currentTimeMicros();
+	}
+
+	ReplayHttpService* service;
+
+	MessagePtr message;
+	MessagePtr response;
+
+	RecordedExchangePtr exchange;
+
+	// The response of an adaptive poll is buffered
+	// and posted only if its content has changed
+	bool isPoll;
+	std::string body;
+	unsigned long long contentHash;
+
+	long long startTime;
+
+	// Request forwarded to the live service when recording
+	MessagePtr live;
+};
+
+
+STATIC_INIT_NULL_IMPL(ReplayHttpService)
+
+ReplayHttpService::ReplayHttpService(const std::string& subject, const std::string& url)
+	: HttpService(subject, url) {
+
+	Service::setType("replay");
+
+	m_mode = REPLAY;
+	m_recordedSubject = subject;
+	m_speed = DEFAULT_REPLAY_SPEED;
+
+	m_replayed = 0;
+	m_missing = 0;
+	m_recorded = 0;
+}
+
+ReplayHttpService::~ReplayHttpService() {
+}
+
+mb::Message* ReplayHttpService::createMessage() {
+
+	return HttpService::createMessage();
+}
+
+void ReplayHttpService::execute(MessagePtr message, MessagePtr response, std::string& body) {
+
+	boost::shared_ptr<Playback> playback(new Playback(this, message, response));
+
+	if (!m_recording || !m_executor) {
+
+		ERROR("No recording has been configured for replay service '%s'.", this->getSubject());
+
+		response->setError(Message::ERR_SERVICE, 1, "No recording has been configured.");
+		this->complete(playback);
+		return;
+	}
+
+	std::string key = HttpRecording::createKey(m_recordedSubject, body);
+
+	if (m_mode == RECORD) {
+
+		playback->exchange = RecordedExchangePtr(new RecordedExchange());
+		playback->exchange->key = key;
+
+		this->record(playback);
+		return;
+	}
+
+	playback->exchange = m_recording->find(key);
+
+	if (!playback->exchange) {
+
+		WARN("No recorded response to the request for service '%s': %s", this->getSubject(), body.c_str());
+
+		{ boost::lock_guard<boost::mutex> lock(m_lock);
+			m_missing++;
+		}
+
+		response->setError(Message::ERR_SERVICE, 404, "No recorded response to the request.");
+		this->complete(playback);
+		return;
+	}
+
+	{ boost::lock_guard<boost::mutex> lock(m_lock);
+		m_replayed++;
+	}
+
+	m_executor->submit(boost::bind(&ReplayHttpService::play, this, playback, 0));
+}
+
+void ReplayHttpService::play(boost::shared_ptr<Playback> playback, size_t chunk) {
+
+	RecordedExchange* exchange = playback->exchange.get();
+	size_t chunks = exchange->chunks.size();
+
+	// Each chunk and the end of the response is sent at its
+	// recorded offset from the start of the replay. The chunk
+	// after the last is the end of the response.
+	for (; chunk <= chunks && !playback->message->isCancelled(); chunk++) {
+
+		if (m_speed > 0) {
+
+			long long offset = (chunk < chunks ? exchange->chunks[chunk].offset : exchange->duration);
+			long delay = (long) ((playback->startTime + (long long) (offset / m_speed) - currentTimeMicros()) / 1000);
+
+			if (delay > 0) {
+
+				m_executor->schedule(boost::bind(&ReplayHttpService::play, this, playback, chunk), delay);
+				return;
+			}
+		}
+
+		if (chunk < chunks)
+			this->send(playback, exchange->chunks[chunk].data.data(), exchange->chunks[chunk].data.length());
+	}
+
+	if (exchange->error != Message::ERR_NONE)
+		playback->response->setError(exchange->error, exchange->errorCode, exchange->errorDescription.c_str());
+
+	this->complete(playback);
+}
+
+void ReplayHttpService::send(boost::shared_ptr<Playback> playback, const char* data, size_t size) {
+
+	if (playback->isPoll) {
+
+		playback->body.append(data, size);
+		playback->contentHash = fnv1a64(data, size, playback->contentHash);
+
+	} else
+		SEND_DATA(playback->response, (void *) data, size);
+}
+
+void ReplayHttpService::complete(boost::shared_ptr<Playback> playback) {
+
+	MessagePtr response = playback->response;
+
+	if (playback->message->isCancelled() && response->getError() == Message::ERR_NONE)
+		response->setError(Message::ERR_CANCELLED, 1, "The message was cancelled.");
+
+	if (playback->isPoll) {
+
+		if (this->postPollResponse(playback->message, response, playback->contentHash)) {
+
+			if (playback->body.length())
+				SEND_COMPLETE_DATA(response, (void *) playback->body.data(), playback->body.length());
+
+			SEND_DATA(response, NULL, 0);
+		}
+
+	} else
+		SEND_DATA(response, NULL, 0);
+}
+
+void ReplayHttpService::record(boost::shared_ptr<Playback> playback) {
+
+	MessageBusManager* manager = MessageBusManager::instance();
+
+	MessagePtr live = manager->createMessage(m_liveSubject.c_str());
+	HttpMessage* liveRequest = dynamic_cast<HttpMessage *>(live.get());
+
+	if (!liveRequest) {
+
+		ERROR("Live HTTP service '%s' recorded by service '%s' is not registered.", m_liveSubject.c_str(), this->getSubject());
+
+		playback->response->setError(Message::ERR_SERVICE, 1, "The live service is not registered.");
+		this->complete(playback);
+		return;
+	}
+
+	// The live service renders the same request from
+	// the request's headers, params and variables
+	HttpMessage* request = (HttpMessage *) playback->message.get();
+	std::list<Message::NameValue>::iterator i;
+
+	for (i = request->getHeaders().begin(); i != request->getHeaders().end(); i++)
+		liveRequest->setHeader(i->name.c_str(), i->value.c_str());
+	for (i = request->getParams().begin(); i != request->getParams().end(); i++)
+		liveRequest->setParam(i->name.c_str(), i->value.c_str());
+	for (i = request->getTmplVars().begin(); i != request->getTmplVars().end(); i++)
+		liveRequest->setTmplVar(i->name.c_str(), i->value.c_str());
+
+	liveRequest->setRequestBody(request->getRequestBody());
+
+	playback->live = live;
+
+	// The context is released with the live response
+	boost::shared_ptr<Playback>* context = new boost::shared_ptr<Playback>(playback);
+	liveRequest->setCallback(context, handleLiveResponse);
+
+	if (!manager->postMessage(live)) {
+
+		ERROR("Unable to post request to live HTTP service '%s'.", m_liveSubject.c_str());
+
+		delete context;
+		playback->live.reset();
+
+		playback->response->setError(Message::ERR_SERVICE, 1, "Unable to post request to the live service.");
+		this->complete(playback);
+	}
+}
+
+void ReplayHttpService::handleLiveResponse(void* context, MessagePtr message) {
+
+	boost::shared_ptr<Playback>* playback = (boost::shared_ptr<Playback> *) context;
+
+	if (message->getType() == Message::MSG_RESP_STREAM)
+		((StreamMessage *) message.get())->setCallback(context, readLiveResponse);
+	else
+		(*playback)->service->completeLiveResponse(playback, message);
+}
+
+bool ReplayHttpService::readLiveResponse(void* context, MessagePtr message, void* buffer, size_t size) {
+
+	boost::shared_ptr<Playback>* playback = (boost::shared_ptr<Playback> *) context;
+
+	if (!buffer) {
+
+		(*playback)->service->completeLiveResponse(playback, message);
+		return true;
+	}
+
+	if ((*playback)->message->isCancelled()) {
+
+		(*playback)->live->cancel();
+		return false;
+	}
+
+	RecordedChunk chunk;
+	chunk.offset = currentTimeMicros() - (*playback)->startTime;
+	chunk.data.assign((const char *) buffer, size);
+
+	(*playback)->exchange->chunks.push_back(chunk);
+	(*playback)->service->send(*playback, (const char *) buffer, size);
+
+	return true;
+}
+
+void ReplayHttpService::completeLiveResponse(boost::shared_ptr<Playback>* context, MessagePtr message) {
+
+	boost::shared_ptr<Playback> playback = *context;
+	delete context;
+
+	playback->live.reset();
+
+	RecordedExchangePtr exchange = playback->exchange;
+
+	exchange->error = message->getError();
+	exchange->errorCode = message->getErrorCode();
+	exchange->errorDescription = message->getErrorDescription();
+	exchange->duration = currentTimeMicros() - playback->startTime;
+
+	if (exchange->error != Message::ERR_NONE)
+		playback->response->setError(exchange->error, exchange->errorCode, exchange->errorDescription.c_str());
+
+	// A response cut short by a cancel is not recorded
+	if (!playback->message->isCancelled()) {
+
+		m_recording->add(exchange);
+
+		boost::lock_guard<boost::mutex> lock(m_lock);
+		m_recorded++;
+	}
+
+	this->complete(playback);
+}
+
+void ReplayHttpService::getMetrics(NameValueMap& metrics) {
+
+	HttpService::getMetrics(metrics);
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+
+	metrics["replay.mode"] = (m_mode == RECORD ? "record" : "replay");
+	metrics["replay.replayed"] = metricValue(m_replayed);
+	metrics["replay.missing"] = metricValue(m_missing);
+	metrics["replay.recorded"] = metricValue(m_recorded);
+}
+
+
+// Configuration callbacks
+
+ADD_BEGIN_CONFIG_BINDING("messagebus-config/service/httpConfig/replay", ReplayHttpService, configureReplay);
+void ReplayHttpService::configureReplay(void* binder, const char* element, std::map<std::string, std::string>& attribs) {
+
+    GET_BINDER(mb::ServiceConfig);
+    Service* service = (Service *) dataBinder->getService();
+
+    if (service->isType("replay")) {
+
+    	ReplayHttpService* replayService = (ReplayHttpService *) service;
+		std::map<std::string, std::string>::iterator attribsEnd = attribs.end();
+
+		if (attribs.find("file") == attribsEnd) {
+
+			ERROR("A recording file must be given for replay service '%s'.", replayService->getSubject());
+			return;
+		}
+
+		if (attribs.find("mode") != attribsEnd && attribs["mode"] == "record") {
+
+			if (attribs.find("service") == attribsEnd) {
+
+				ERROR("The live service to record must be given for replay service '%s'.", replayService->getSubject());
+				return;
+			}
+
+			replayService->m_mode = RECORD;
+			replayService->m_liveSubject = attribs["service"];
+		}
+
+		if (attribs.find("recordedSubject") != attribsEnd)
+			replayService->m_recordedSubject = attribs["recordedSubject"];
+		if (attribs.find("speed") != attribsEnd)
+			replayService->m_speed = atof(attribs["speed"].c_str());
+
+		int concurrency = DEFAULT_REPLAY_CONCURRENCY;
+		if (attribs.find("concurrency") != attribsEnd)
+			concurrency = atoi(attribs["concurrency"].c_str());
+
+		replayService->m_recording = getRecording(attribs["file"], replayService->m_mode);
+		replayService->m_executor = boost::shared_ptr<Executor>(new Executor((size_t) concurrency));
+    }
+}
+
+ADD_BEGIN_CONFIG_BINDING("messagebus-config/service", ReplayHttpService, createService);
+void ReplayHttpService::createService(void* binder, const char* element, std::map<std::string, std::string>& attribs) {
+
+    GET_BINDER(mb::ServiceConfig);
+
+    std::string serviceName = attribs["name"];
+    std::string serviceUrl = attribs["url"];
+    std::string serviceType = attribs["type"];
+
+    if (serviceType == "replayhttp") {
+
+    	TRACE("Found replay HTTP service configuration '%s'.", serviceName.c_str());
+    	dataBinder->addService(new ReplayHttpService(serviceName, serviceUrl));
+    }
+}
+
+
+    }  // namespace : http
+}  // namespace : mb
@@ -0,0 +1,113 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef REPLAYHTTPSERVICE_H_
+#define REPLAYHTTPSERVICE_H_
+
+#include "boost/shared_ptr.hpp"
+
+#include "staticinit.h"
+#include "executor.h"
+
+#include "HttpService.h"
+#include "HttpRecording.h"
+
+
+namespace mb {
+	namespace http {
+
+
+/* An HTTP service that answers requests with responses recorded
+ * from a live service so the full pipeline can be benchmarked or
+ * tested offline. Recorded responses are keyed by the subject and
+ * the rendered request and are streamed with their original chunk
+ * boundaries and timing, optionally at an accelerated speed.
+ *
+ * In record mode the service forwards each request to the live
+ * service it wraps and records the response as it streams back.
+ */
+class ReplayHttpService : public HttpService {
+
+STATIC_INIT_DECLARATION(ReplayHttpService)
+
+public:
+	enum Mode {
+		REPLAY,
+		RECORD
+	};
+
+public:
+	ReplayHttpService(const std::string& subject, const std::string& url);
+	virtual ~ReplayHttpService();
+
+    Message* createMessage();
+    void execute(MessagePtr message, MessagePtr response, std::string& body);
+
+    void getMetrics(NameValueMap& metrics);
+
+    // XML Configuration bindings
+
+    static void configureReplay(void* binder, const char* element, std::map<std::string, std::string>& attribs);
+    static void createService(void* binder, const char* element, std::map<std::string, std::string>& attribs);
+
+private:
+
+    struct Playback;
+
+    void play(boost::shared_ptr<Playback> playback, size_t chunk);
+    void send(boost::shared_ptr<Playback> playback, const char* data, size_t size);
+    void complete(boost::shared_ptr<Playback> playback);
+
+    void record(boost::shared_ptr<Playback> playback);
+    static void handleLiveResponse(void* context, MessagePtr message);
+    static bool readLiveResponse(void* context, MessagePtr message, void* buffer, size_t size);
+    void completeLiveResponse(boost::shared_ptr<Playback>* context, MessagePtr message);
+
+    Mode m_mode;
+
+    // Subject of the live service wrapped in record mode
+    std::string m_liveSubject;
+    // Subject the responses were recorded for which
+    // defaults to the subject of the service
+    std::string m_recordedSubject;
+
+    HttpRecordingPtr m_recording;
+
+    // Factor by which replayed responses are sped up.
+    // Responses are replayed without delays if 0.
+    double m_speed;
+
+    boost::shared_ptr<Executor> m_executor;
+
+    boost::mutex m_lock;
+    long m_replayed;
+    long m_missing;
+    long m_recorded;
+};
+
+STATIC_INIT_CALL(ReplayHttpService)
+
+	}  // namespace : http
+}  // namespace : mb
+
+
+#endif /* REPLAYHTTPSERVICE_H_ */
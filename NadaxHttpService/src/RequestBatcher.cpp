@@ -0,0 +1,316 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "RequestBatcher.h"
+
+#include <sstream>
+#include <algorithm>
+
+#include "log.h"
+#include "clock.h"
+
+#include "HttpService.h"
+#include "HttpMetrics.h"
+
+
+namespace mb {
+	namespace http {
+
+
+// **** RequestBatcher Implementation ****
+
+RequestBatcher::RequestBatcher( BatchHandler handler,
+	const std::string& param,
+	const std::string& keyPath,
+	const std::string& separator,
+	int maxBatchSize,
+	long maxWait )
+
+	: m_handler(handler), m_param(param), m_keyPath(keyPath), m_separator(separator) {
+
+	m_maxBatchSize = maxBatchSize;
+	m_maxWait = maxWait;
+
+	m_stopped = false;
+
+	m_requests = 0;
+	m_batches = 0;
+	m_missing = 0;
+
+	m_timer = boost::thread(&RequestBatcher::run, this);
+}
+
+RequestBatcher::~RequestBatcher() {
+
+	boost::unordered_map<std::string, RequestBatchPtr> pending;
+
+	{ boost::lock_guard<boost::mutex> lock(m_lock);
+
+		m_stopped = true;
+		m_changed.notify_all();
+
+		pending.swap(m_pending);
+	}
+
+	m_timer.join();
+
+	// Requests still waiting for their batch are failed
+	for (boost::unordered_map<std::string, RequestBatchPtr>::iterator i = pending.begin(); i != pending.end(); i++) {
+
+		std::list<std::pair<std::string, MessagePtr> >& responses = i->second->responses;
+
+		for (std::list<std::pair<std::string, MessagePtr> >::iterator j = responses.begin(); j != responses.end(); j++) {
+
+			j->second->setError(Message::ERR_SERVICE, 503, "The request batcher was stopped.");
+			SEND_DATA(j->second, NULL, 0);
+		}
+	}
+}
+
+void RequestBatcher::add(const std::string& compatibilityKey, MessagePtr message, MessagePtr response, NameValueMap& variables) {
+
+	std::string key = variables[m_param];
+	RequestBatchPtr full;
+
+	{ boost::lock_guard<boost::mutex> lock(m_lock);
+
+		m_requests++;
+
+		RequestBatchPtr batch;
+
+		boost::unordered_map<std::string, RequestBatchPtr>::iterator element = m_pending.find(compatibilityKey);
+		if (element == m_pending.end()) {
+
+			batch = RequestBatchPtr(new RequestBatch());
+			batch->compatibilityKey = compatibilityKey;
+			batch->message = message;
+			batch->variables = variables;
+			batch->deadline = currentTimeMillis() + m_maxWait;
+
+			m_pending[compatibilityKey] = batch;
+			m_changed.notify_all();
+
+		} else
+			batch = element->second;
+
+		// Requests for the same key share the key's item
+		if (std::find(batch->keys.begin(), batch->keys.end(), key) == batch->keys.end())
+			batch->keys.push_back(key);
+
+		batch->responses.push_back(std::pair<std::string, MessagePtr>(key, response));
+
+		if ((int) batch->keys.size() >= m_maxBatchSize) {
+
+			m_pending.erase(compatibilityKey);
+			full = batch;
+		}
+	}
+
+	if (full)
+		this->execute(full);
+}
+
+void RequestBatcher::run() {
+
+	boost::unique_lock<boost::mutex> lock(m_lock);
+
+	while (!m_stopped) {
+
+		if (m_pending.empty()) {
+
+			m_changed.wait(lock);
+			continue;
+		}
+
+		long long now = currentTimeMillis();
+		long long deadline = 0;
+
+		std::list<RequestBatchPtr> expired;
+
+		boost::unordered_map<std::string, RequestBatchPtr>::iterator i = m_pending.begin();
+		while (i != m_pending.end()) {
+
+			if (i->second->deadline <= now) {
+
+				expired.push_back(i->second);
+				i = m_pending.erase(i);
+
+			} else {
+
+				if (!deadline || i->second->deadline < deadline)
+					deadline = i->second->deadline;
+				i++;
+			}
+		}
+
+		if (expired.size()) {
+
+			lock.unlock();
+
+			for (std::list<RequestBatchPtr>::iterator j = expired.begin(); j != expired.end(); j++)
+				this->execute(*j);
+
+			lock.lock();
+
+		} else
+			m_changed.timed_wait(lock, boost::posix_time::milliseconds(deadline - now));
+	}
+}
+
+void RequestBatcher::execute(RequestBatchPtr batch) {
+
+	std::ostringstream keys;
+
+	for (std::vector<std::string>::iterator i = batch->keys.begin(); i != batch->keys.end(); i++) {
+
+		if (i != batch->keys.begin())
+			keys << m_separator;
+		keys << *i;
+	}
+
+	batch->variables[m_param] = keys.str();
+
+	{ boost::lock_guard<boost::mutex> lock(m_lock);
+		m_batches++;
+	}
+
+	TRACE("Executing batch of %d requests for %d keys.", batch->responses.size(), batch->keys.size());
+
+	m_handler(batch);
+}
+
+void RequestBatcher::complete(RequestBatchPtr batch, MessagePtr response) {
+
+	binding::DynaModelNode root;
+	if (response->getContentType() == Message::CNT_MODEL && response->getData())
+		root = *((binding::DynaModelNode *) response->getData());
+
+	std::string batchSize = metricValue(batch->responses.size());
+	long missing = 0;
+
+	std::list<std::pair<std::string, MessagePtr> >::iterator i;
+
+	for (i = batch->responses.begin(); i != batch->responses.end(); i++) {
+
+		MessagePtr itemResponse = i->second;
+		itemResponse->getMetaData()[HTTP_BATCH_SIZE] = batchSize;
+
+		if (response->getError()) {
+
+			itemResponse->setError(response->getError(), response->getErrorCode(), response->getErrorDescription().c_str());
+
+		} else if (!root) {
+
+			itemResponse->setError(Message::ERR_SERVICE, 500, "The response of the batched request could not be bound.");
+
+		} else {
+
+			binding::DynaModelNode item = findItem(root, m_keyPath, i->first);
+
+			if (item)
+				((StreamMessage *) itemResponse.get())->setBoundData(new binding::DynaModelNode(item));
+			else {
+
+				itemResponse->setError(Message::ERR_SERVICE, 404, "The response of the batched request has no item for the key.");
+				missing++;
+			}
+		}
+
+		SEND_DATA(itemResponse, NULL, 0);
+	}
+
+	if (missing) {
+
+		boost::lock_guard<boost::mutex> lock(m_lock);
+		m_missing += missing;
+	}
+}
+
+binding::DynaModelNode RequestBatcher::findItem(binding::DynaModelNode root, const std::string& keyPath, const std::string& key) {
+
+	std::vector<std::string> path;
+	size_t begin = 0, end;
+
+	while ((end = keyPath.find('/', begin)) != std::string::npos) {
+
+		path.push_back(keyPath.substr(begin, end - begin));
+		begin = end + 1;
+	}
+	path.push_back(keyPath.substr(begin));
+
+	binding::DynaModelNode node = root;
+	size_t i = 0;
+
+	while (node && i < path.size()) {
+
+		if (node->getType() == binding::DynaModel::LIST) {
+
+			// The rest of the path leads to the key of each item
+			for (int j = 0; j < node->size(); j++) {
+
+				binding::DynaModelNode item = node->get((unsigned int) j);
+				binding::DynaModelNode value = item;
+
+				for (size_t k = i; value && k < path.size(); k++)
+					value = value->get(path[k].c_str());
+
+				if (value && value->value() && key == value->value())
+					return item;
+			}
+
+			return binding::DynaModelNode();
+		}
+
+		node = node->get(path[i++].c_str());
+	}
+
+	// The path leads to a map of items keyed by their keys
+	if (node && node->getType() == binding::DynaModel::MAP)
+		return node->get(key.c_str());
+
+	return binding::DynaModelNode();
+}
+
+void RequestBatcher::getMetrics(NameValueMap& metrics) {
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+
+	metrics["batch.requests"] = metricValue(m_requests);
+	metrics["batch.batches"] = metricValue(m_batches);
+	metrics["batch.meanSize"] = metricValue(m_batches ? (double) m_requests / m_batches : 0.0);
+	metrics["batch.missing"] = metricValue(m_missing);
+	metrics["batch.pending"] = metricValue(m_pending.size());
+}
+
+void RequestBatcher::log(std::ostream& cout) {
+
+	cout << "\tRequest batching - " << std::endl;
+	cout << "\t\tParameter - " << m_param << std::endl;
+	cout << "\t\tKey path - " << m_keyPath << std::endl;
+	cout << "\t\tSeparator - " << m_separator << std::endl;
+	cout << "\t\tMax batch size - " << m_maxBatchSize << std::endl;
+	cout << "\t\tMax wait - " << m_maxWait << std::endl;
+}
+
+
+	}  // namespace : http
+}  // namespace : mb
@@ -0,0 +1,147 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef REQUESTBATCHER_H_
+#define REQUESTBATCHER_H_
+
+#include <string>
+#include <list>
+#include <vector>
+
+#include "boost/thread.hpp"
+#include "boost/function.hpp"
+#include "boost/shared_ptr.hpp"
+#include "boost/unordered_map.hpp"
+
+#include "DynaModel.h"
+#include "Service.h"
+
+
+namespace mb {
+	namespace http {
+
+
+/* Requests merged into one upstream request */
+struct RequestBatch {
+
+	// Requests with the same compatibility key differ only
+	// in the value of the batch parameter
+	std::string compatibilityKey;
+
+	// Message and template variables of the first request.
+	// The batch parameter is set to the requests' keys when
+	// the batch is executed.
+	MessagePtr message;
+	NameValueMap variables;
+
+	std::vector<std::string> keys;
+	std::list<std::pair<std::string, MessagePtr> > responses;
+
+	long long deadline;
+};
+
+typedef boost::shared_ptr<RequestBatch> RequestBatchPtr;
+
+
+/* Batches requests to a service whose backend accepts many
+ * keys in one request. Compatible requests received within
+ * the maximum wait of the first are merged into one batch,
+ * which is executed once it is full or the wait has elapsed.
+ * The batch's keys are joined with the separator into the
+ * value of the batch parameter. The bound response of the
+ * batch is split back to each request by the key path. The
+ * path leads either to a list whose items hold their key at
+ * the rest of the path or to a map of items keyed by their
+ * keys. Only requests whose responses are bound to a
+ * DynaModel can be batched.
+ */
+class RequestBatcher {
+
+public:
+	/* Executes a batch, which must then be completed with
+	 * the response of the batched request via complete().
+	 */
+	typedef boost::function<void (RequestBatchPtr batch)> BatchHandler;
+
+	RequestBatcher( BatchHandler handler,
+		const std::string& param,
+		const std::string& keyPath,
+		const std::string& separator,
+		int maxBatchSize,
+		long maxWait );
+
+	virtual ~RequestBatcher();
+
+	const std::string& getParam() {
+		return m_param;
+	}
+
+	/* Adds a request to the pending batch with the given
+	 * compatibility key. The request's key is the value
+	 * of the batch parameter in its template variables.
+	 */
+	void add(const std::string& compatibilityKey, MessagePtr message, MessagePtr response, NameValueMap& variables);
+
+	/* Completes the responses of the batch with the items of the
+	 * bound response. The response's error fails every request.
+	 */
+	void complete(RequestBatchPtr batch, MessagePtr response);
+
+	/* Returns the item with the given key in a bound batch response */
+	static binding::DynaModelNode findItem(binding::DynaModelNode root, const std::string& keyPath, const std::string& key);
+
+	void getMetrics(NameValueMap& metrics);
+	void log(std::ostream& cout);
+
+private:
+
+	void run();
+	void execute(RequestBatchPtr batch);
+
+	BatchHandler m_handler;
+
+	std::string m_param;
+	std::string m_keyPath;
+	std::string m_separator;
+
+	int m_maxBatchSize;
+	long m_maxWait;
+
+	boost::mutex m_lock;
+	boost::condition_variable m_changed;
+
+	bool m_stopped;
+	boost::thread m_timer;
+
+	boost::unordered_map<std::string, RequestBatchPtr> m_pending;
+
+	long m_requests;
+	long m_batches;
+	long m_missing;
+};
+
+
+	}  // namespace : http
+}  // namespace : mb
+
+
+#endif /* REQUESTBATCHER_H_ */
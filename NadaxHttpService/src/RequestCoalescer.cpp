@@ -0,0 +1,208 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include "RequestCoalescer.h"
+
+#include "log.h"
+
+#include "HttpMetrics.h"
+
+
+namespace mb {
+	namespace http {
+
+
+// **** RequestCoalescer Implementation ****
+
+RequestCoalescer::RequestCoalescer(bool includePost) {
+
+	m_includePost = includePost;
+
+	m_requests = 0;
+	m_coalesced = 0;
+}
+
+RequestCoalescer::~RequestCoalescer() {
+}
+
+bool RequestCoalescer::join(const std::string& key, MessagePtr response) {
+
+	bool isModel = (response->getMetaData()[DATA_IS_DYNA_MODEL] == CSTR_TRUE);
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+
+	m_requests++;
+
+	boost::unordered_map<std::string, InFlightPtr>::iterator element = m_inFlight.find(key);
+	if (element != m_inFlight.end()) {
+
+		InFlightPtr flight = element->second;
+
+		if (isModel && flight->isModel) {
+
+			flight->modelFollowers.push_back(response);
+			m_coalesced++;
+			return false;
+
+		} else if (!flight->isStreaming) {
+
+			flight->streamFollowers.push_back(response);
+			m_coalesced++;
+			return false;
+		}
+
+		// The response has started streaming so the
+		// request is executed without leading
+		return true;
+	}
+
+	InFlightPtr flight(new InFlight(key, isModel));
+	m_inFlight[key] = flight;
+	m_leaders[response.get()] = flight;
+
+	// The response has already been posted so these callbacks
+	// are called after those binding the response's data
+	StreamMessage* streamMessage = (StreamMessage *) response.get();
+	streamMessage->setBoundDataCallback(this, shareBoundData);
+	streamMessage->setCallback(this, forwardData);
+
+	return true;
+}
+
+bool RequestCoalescer::forwardData(void* context, MessagePtr message, void* buffer, size_t size) {
+
+	RequestCoalescer* coalescer = (RequestCoalescer *) context;
+
+	InFlightPtr flight = coalescer->findLeader(message.get(), size == 0);
+	if (!flight)
+		return true;
+
+	if (!size) {
+
+		coalescer->complete(flight, message);
+		return true;
+	}
+
+	std::list<MessagePtr> followers;
+
+	{ boost::lock_guard<boost::mutex> lock(coalescer->m_lock);
+
+		flight->isStreaming = true;
+		followers = flight->streamFollowers;
+	}
+
+	// A body sent whole by the leader is sent whole to the followers
+	bool isComplete = ((StreamMessage *) message.get())->isCompleteData();
+
+	for (std::list<MessagePtr>::iterator i = followers.begin(); i != followers.end(); i++) {
+
+		if (isComplete)
+			SEND_COMPLETE_DATA((*i), buffer, size);
+		else
+			SEND_DATA((*i), buffer, size);
+	}
+
+	return true;
+}
+
+void RequestCoalescer::shareBoundData(void* context, MessagePtr message, void* data) {
+
+	RequestCoalescer* coalescer = (RequestCoalescer *) context;
+
+	InFlightPtr flight = coalescer->findLeader(message.get(), false);
+	if (flight)
+		flight->model = *((boost::shared_ptr<binding::DynaModel> *) data);
+}
+
+RequestCoalescer::InFlightPtr RequestCoalescer::findLeader(Message* response, bool remove) {
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+
+	boost::unordered_map<Message*, InFlightPtr>::iterator element = m_leaders.find(response);
+	if (element == m_leaders.end())
+		return InFlightPtr();
+
+	InFlightPtr flight = element->second;
+
+	if (remove) {
+
+		// Requests received from now on are executed
+		m_leaders.erase(element);
+		m_inFlight.erase(flight->key);
+	}
+	return flight;
+}
+
+void RequestCoalescer::complete(InFlightPtr flight, MessagePtr leader) {
+
+	std::list<MessagePtr>::iterator i;
+
+	for (i = flight->streamFollowers.begin(); i != flight->streamFollowers.end(); i++) {
+
+		MessagePtr response = *i;
+
+		if (leader->getError())
+			response->setError(leader->getError(), leader->getErrorCode(), leader->getErrorDescription().c_str());
+
+		SEND_DATA(response, NULL, 0);
+	}
+
+	if (flight->modelFollowers.size()) {
+
+		TRACE( "Sharing bound response of coalesced request with %d waiting requests.",
+			flight->modelFollowers.size() );
+	}
+
+	for (i = flight->modelFollowers.begin(); i != flight->modelFollowers.end(); i++) {
+
+		MessagePtr response = *i;
+
+		if (leader->getError())
+			response->setError(leader->getError(), leader->getErrorCode(), leader->getErrorDescription().c_str());
+		else if (!flight->model)
+			response->setError(Message::ERR_SERVICE, 500, "The response of the coalesced request could not be bound.");
+		else
+			((StreamMessage *) response.get())->setBoundData(new boost::shared_ptr<binding::DynaModel>(flight->model));
+
+		SEND_DATA(response, NULL, 0);
+	}
+}
+
+void RequestCoalescer::getMetrics(NameValueMap& metrics) {
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+
+	metrics["coalesce.requests"] = metricValue(m_requests);
+	metrics["coalesce.coalesced"] = metricValue(m_coalesced);
+	metrics["coalesce.inFlight"] = metricValue(m_inFlight.size());
+}
+
+void RequestCoalescer::log(std::ostream& cout) {
+
+	cout << "\tRequest coalescing - " << std::endl;
+	cout << "\t\tInclude POST - " << (m_includePost ? 'Y' : 'N') << std::endl;
+}
+
+
+	}  // namespace : http
+}  // namespace : mb
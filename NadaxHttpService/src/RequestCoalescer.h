@@ -0,0 +1,117 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef REQUESTCOALESCER_H_
+#define REQUESTCOALESCER_H_
+
+#include <string>
+#include <list>
+
+#include "boost/thread.hpp"
+#include "boost/shared_ptr.hpp"
+#include "boost/unordered_map.hpp"
+
+#include "DynaModel.h"
+#include "Service.h"
+
+
+namespace mb {
+	namespace http {
+
+
+/* Single-flight coalescing of identical requests to an HTTP
+ * service. The first request with a given key leads and is
+ * executed. Requests with the same key received while it is
+ * in flight attach to it and are completed with its response
+ * instead of being executed. A follower whose response is
+ * bound to a DynaModel is handed the model the leader's
+ * response was bound to, so the response is parsed only
+ * once. Other followers receive the leader's data as it is
+ * streamed and may therefore only attach before the first
+ * byte of the leader's response has arrived. Cancelling the
+ * leader's request also fails the requests attached to it.
+ */
+class RequestCoalescer {
+
+public:
+	RequestCoalescer(bool includePost);
+	virtual ~RequestCoalescer();
+
+	bool isIncludePost() {
+		return m_includePost;
+	}
+
+	/* Joins the response of a request to the in-flight request
+	 * with the same key. Returns true if the request should be
+	 * executed, in which case it leads if no request with the
+	 * key was in flight. Returns false if the response was
+	 * attached to the in-flight request.
+	 */
+	bool join(const std::string& key, MessagePtr response);
+
+	void getMetrics(NameValueMap& metrics);
+	void log(std::ostream& cout);
+
+private:
+
+	struct InFlight {
+
+		InFlight(const std::string& key, bool isModel)
+			: key(key), isModel(isModel), isStreaming(false) { }
+
+		std::string key;
+		bool isModel;
+		bool isStreaming;
+
+		std::list<MessagePtr> modelFollowers;
+		std::list<MessagePtr> streamFollowers;
+
+		boost::shared_ptr<binding::DynaModel> model;
+	};
+
+	typedef boost::shared_ptr<InFlight> InFlightPtr;
+
+	static bool forwardData(void* context, MessagePtr message, void* buffer, size_t size);
+	static void shareBoundData(void* context, MessagePtr message, void* data);
+
+	InFlightPtr findLeader(Message* response, bool remove);
+	void complete(InFlightPtr flight, MessagePtr leader);
+
+	boost::mutex m_lock;
+
+	bool m_includePost;
+
+	boost::unordered_map<std::string, InFlightPtr> m_inFlight;
+	// In-flight requests keyed by the response of their leader
+	boost::unordered_map<Message*, InFlightPtr> m_leaders;
+
+	long m_requests;
+	long m_coalesced;
+};
+
+
+	}  // namespace : http
+}  // namespace : mb
+
+
+#endif /* REQUESTCOALESCER_H_ */
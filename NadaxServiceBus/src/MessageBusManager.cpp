@@ -30,9 +30,9 @@
 #include "boost/date_time/posix_time/posix_time_types.hpp"
 
 #include "number.h"
+#include "clock.h"
 #include "DataBinder.h"
 #include "Unmarshaller.h"
-#include "XmlStreamParser.h"
 
 #define PROVIDER_FOR_SUBJECT_EXISTS  "A provider for the subject '%s' already exists."
 #define SERVICE_FOR_SUBJECT_EXISTS   "A service for the subject '%s' already exists."
@@ -54,9 +54,12 @@ namespace mb {
 struct Response {
     
     Response() {
-        unmarshaller = NULL;
         isFirst = true;
+        isDocument = false;
+        isFailed = false;
         isNotified = false;
+        bindTime = 0;
+        spoolThreshold = 0;
     }
     
     void wait() {
@@ -74,17 +77,53 @@ struct Response {
     MessagePtr message;
     
     binding::DataBinderPtr dataBinder;
-    binding::Unmarshaller* unmarshaller;
+    
+    // Parser taken from the pool of the service
+    // for the content type of the response
+    UnmarshallerPoolPtr unmarshallerPool;
+    UnmarshallerPtr unmarshaller;
+    Message::ContentType unmarshallerType;
     
     std::list<Listener*> listeners;
     
     bool isFirst;
     bool isNotified;
     
+    // The data is available whole and parsed as
+    // a document rather than a stream of chunks
+    bool isDocument;
+    
+    // The error response was delivered and the rest
+    // of the stream is dropped until its end
+    bool isFailed;
+    
+    // Time spent parsing the data stream
+    long long bindTime;
+    
+    // Size above which streamed data is spooled to a file
+    size_t spoolThreshold;
+    
     boost::mutex doneM;
     boost::condition_variable doneC;
 };
 
+// Returns the parser of a response to its pool which
+// resets it along with the binder of the response
+static void releaseUnmarshaller(Response* response) {
+    
+    try {
+        
+        response->unmarshallerPool->returnUnmarshaller(
+            response->unmarshallerType, response->unmarshaller, response->isDocument );
+        
+    } catch (CException* e) {
+        
+        ERROR("Exception caught while returning a response unmarshaller to its pool: %s", e->getMessage());
+    }
+    
+    response->unmarshaller.reset();
+}
+
 
 // **** Message Bus Message Queue ****
 
@@ -107,6 +146,7 @@ public:
     MessageQueue() {
         
         m_stop = false;
+        m_messageAvailable = false;
     }
     
     static void addActivityCallback(ActivityCallback callback, Message::MessageType msgType) {
@@ -320,6 +360,8 @@ public:
                                                     
                                                 case P2PMessage::CANCEL:
                                                     TRACE("    * Subscription message '%s' with id '%s' has been cancelled.", subject.c_str(), id.c_str());
+                                                    // Aborts any poll of the subscription still in flight
+                                                    subMessage->cancel();
                                                     messages.erase(qm);
                                                     break;
                                                     
@@ -371,16 +413,22 @@ private:
     
     bool waitForMessage(long millis) {
         boost::unique_lock<boost::mutex> lock(m_messageAvailable_M);
-        if (millis) {
-            const boost::system_time timeout = boost::get_system_time() + boost::posix_time::milliseconds(millis);
-            return m_messageAvailable_C.timed_wait(lock, timeout);
-        } else {
-            m_messageAvailable_C.wait(lock);
-            return false;
+        // Messages notified before the wait began
+        // are picked up without waiting
+        bool available = m_messageAvailable;
+        if (!available) {
+            if (millis) {
+                const boost::system_time timeout = boost::get_system_time() + boost::posix_time::milliseconds(millis);
+                available = m_messageAvailable_C.timed_wait(lock, timeout);
+            } else
+                m_messageAvailable_C.wait(lock);
         }
+        m_messageAvailable = false;
+        return available;
     }
     void notifyMessageAvailable() {
         boost::lock_guard<boost::mutex> lock(m_messageAvailable_M);
+        m_messageAvailable = true;
         m_messageAvailable_C.notify_all();
     }
     
@@ -421,6 +469,7 @@ private:
     boost::shared_mutex m_processing1;
     boost::mutex m_messageAvailable_M;
     boost::condition_variable m_messageAvailable_C;
+    bool m_messageAvailable;
     
     std::list<QueuedMessage> m_waitq;
     boost::shared_mutex m_processing2;
@@ -462,6 +511,8 @@ MessageBusManager::MessageBusManager() {
     
     m_messageQueue = boost::shared_ptr<MessageQueue>(new MessageQueue());
     m_queueWorker = boost::shared_ptr<boost::thread>(new boost::thread(&MessageQueue::process, m_messageQueue.get()));
+    
+    m_unmarshallerPool = UnmarshallerPoolPtr(new UnmarshallerPool());
 }
 
 MessageBusManager::~MessageBusManager() {
@@ -537,7 +588,7 @@ MessagePtr MessageBusManager::sendMessage(MessagePtr message) {
         
         TRACE("Begin sending sync P2P message type '%d' for subject '%s'.", message->getType(), subject);
         
-        Listener* serviceListener;
+        Service* serviceListener;
         
         { boost::shared_lock<boost::shared_mutex> lock(m_servicesLock);
             
@@ -548,6 +599,7 @@ MessagePtr MessageBusManager::sendMessage(MessagePtr message) {
         if (serviceListener) {
             
             response.dataBinder = message->getDataBinder();
+            response.spoolThreshold = serviceListener->getSpoolThreshold();
             
             ((P2PMessage *) message.get())->setCallback(&response, handleP2PReply);
             serviceListener->onMessage(message);
@@ -622,15 +674,25 @@ int MessageBusManager::postMessage(MessagePtr message, Listener* callback) {
             
             TRACE("Will be binding message data for subject '%s'.", subject);
             
+            { boost::shared_lock<boost::shared_mutex> lock(m_servicesLock);
+                
+                boost::unordered_map<std::string, Service*>::iterator element = m_services.find(subject);
+                response->unmarshallerPool = ( element != m_services.end() ?
+                    element->second->getUnmarshallerPool() : m_unmarshallerPool );
+            }
+            
             if (message->getType() == Message::MSG_RESP_STRING) {
                 
                 TRACE("Message data for subject '%s' is string.", subject);
                 
+                // The copy of the data is parsed in place
                 std::string msg = (const char *) message->getData();
                 int size = msg.length();
                 
+                response->isDocument = true;
+                
                 if (size)
-                    unmarshalMessage(response, message, (void *) msg.c_str(), size);
+                    unmarshalMessage(response, message, (void *) &msg[0], size);
                 
                 unmarshalMessage(response, message, NULL, 0);
                 
@@ -660,7 +722,10 @@ void MessageBusManager::handleP2PReply(void* context, mb::MessagePtr message) {
         TRACE( "Setting call back function to read message stream for P2P response message with subject '%s'.",
               message->getSubject().c_str() );
         
-        response->message = MessagePtr(new StringMessage(message.get()));
+        StringMessage* stringMessage = new StringMessage(message.get());
+        stringMessage->setSpoolThreshold(response->spoolThreshold);
+        
+        response->message = MessagePtr(stringMessage);
         ((StreamMessage *) message.get())->setCallback(context, readMessageStream);
         
     } else {
@@ -677,9 +742,16 @@ bool MessageBusManager::readMessageStream(void* context, mb::MessagePtr message,
     TRACE( "Reading streamed %d bytes of message data for P2P response message with subject '%s'.",
           size, response->message->getSubject().c_str() );
     
-    if (!size)
+    if (!size) {
+        
+        // Errors are set on the stream after it was posted
+        if (message->getError() != Message::ERR_NONE)
+            response->message->setError( message->getError(),
+                message->getErrorCode(), message->getErrorDescription().c_str() );
+        
         response->notify();
-    else
+        
+    } else
         ((StringMessage *) response->message.get())->append((char *) buffer, size);
     
     return true;
@@ -708,24 +780,84 @@ bool MessageBusManager::unmarshalMessage(void* context, mb::MessagePtr message,
     
     Response* response = (Response *) context;
     
+    if (response->isFailed) {
+        
+        if (!size)
+            delete response;
+        
+        return false;
+    }
+    
     try {
         
         if (!size) {
             
-            if (response->unmarshaller) {
+            StreamMessage* streamMessage = ( message->getType() == Message::MSG_RESP_STREAM ?
+                (StreamMessage *) message.get() : NULL );
+            
+            if (response->unmarshaller && message->isCancelled()) {
+                
+                // The partially bound data of a cancelled
+                // message is discarded and the binder released
+                releaseUnmarshaller(response);
+                
+                TRACE( "Discarding data bound for cancelled response message with subject '%s'.",
+                      message->getSubject().c_str() );
+                
+                response->message = MessagePtr(new Message(message.get()));
+                if (response->message->getError() == Message::ERR_NONE)
+                    response->message->setError(Message::ERR_CANCELLED, 1, "The message was cancelled.");
+                
+            } else if (response->unmarshaller) {
+                
+                long long start = currentTimeMicros();
                 
-                response->unmarshaller->parse("", 0);
+                // A document was parsed with its data
+                if (!response->isDocument)
+                    response->unmarshaller->parse("", 0);
+                
+                long long end = currentTimeMicros();
+                response->bindTime += end - start;
                 
                 response->message = MessagePtr(new DataMessage(message.get()));
                 response->message->setData(response->unmarshaller->getResult());
                 response->message->m_cntType = Message::CNT_MODEL;
                 
-                response->dataBinder->reset();
-                delete response->unmarshaller;
+                std::ostringstream bindTime, boundTime;
+                bindTime << response->bindTime;
+                boundTime << end;
+                
+                response->message->m_msgMetaData[BIND_TIME] = bindTime.str();
+                response->message->m_msgMetaData[BOUND_TIME] = boundTime.str();
+                
+                releaseUnmarshaller(response);
                 
                 TRACE( "Returning unmarshalled message data for P2P response message with subject '%s'.",
                       response->message->getSubject().c_str() );
                 
+                if (streamMessage)
+                    streamMessage->notifyBoundData(message, response->message->getData());
+                
+            } else if (streamMessage && streamMessage->getError() == Message::ERR_NONE) {
+                
+                void* boundData = streamMessage->detachBoundData();
+                
+                if (boundData) {
+                    
+                    // Data was bound from an earlier stream so
+                    // return it without binding the stream
+                    response->message = MessagePtr(new DataMessage(message.get()));
+                    response->message->setData(boundData);
+                    response->message->m_cntType = Message::CNT_MODEL;
+                    
+                    TRACE( "Returning previously bound message data for P2P response message with subject '%s'.",
+                          response->message->getSubject().c_str() );
+                    
+                    streamMessage->notifyBoundData(message, boundData);
+                    
+                } else
+                    response->message = MessagePtr(new Message(message.get()));
+                
             } else
                 response->message = MessagePtr(new Message(message.get()));
             
@@ -736,6 +868,10 @@ bool MessageBusManager::unmarshalMessage(void* context, mb::MessagePtr message,
             
             return true;
             
+        } else if (message->isCancelled()) {
+            
+            return false;
+            
         } else {
             
             Message::ContentType cntType = message->getContentType();
@@ -747,27 +883,17 @@ bool MessageBusManager::unmarshalMessage(void* context, mb::MessagePtr message,
                 if (!dataBinder->lock())
                     THROW(MessageBusException, EXCEP_MSSG(RESPONSE_BINDER_IS_LOCKED)); 
                 
-                switch (cntType) {
-
-					//case Message::ContentType::JSON:
-					//
-					//	response->unmarshaller = new parser::JsonBinder(dataBinder);
-					//	response->unmarshaller->initialize();
-					//  TRACE("Unmarshalling json data stream for response message with subject '%s'.", response->message->getSubject());
-					//	break;
-                        
-                    case Message::CNT_XML:
-                    default:
-                        
-                        // Assume XML as default content type
-                        response->unmarshaller = new parser::XmlBinder(dataBinder);
-                        response->unmarshaller->initialize();
-                        
-                        TRACE( "Unmarshalling xml data stream for response message with subject '%s'.",
-                              message->getSubject().c_str() );
-
-                        break;
-                }
+                if ( message->getType() == Message::MSG_RESP_STREAM &&
+                    ((StreamMessage *) message.get())->isCompleteData() )
+                    response->isDocument = true;
+                
+                // The pool parses content types without a factory as
+                // XML and data that is available whole as a document
+                response->unmarshaller = response->unmarshallerPool->getUnmarshaller(cntType, dataBinder, response->isDocument);
+                response->unmarshallerType = cntType;
+                
+                TRACE( "Unmarshalling data stream of content type '%d' for response message with subject '%s'.",
+                      cntType, message->getSubject().c_str() );
                 
                 response->isFirst = false;
             }
@@ -777,7 +903,27 @@ bool MessageBusManager::unmarshalMessage(void* context, mb::MessagePtr message,
                 TRACE( "Unmarshalling streamed %d bytes of message data for P2P response message with subject '%s'.",
                       size, message->getSubject().c_str() );
                 
-                response->unmarshaller->parse((char *) buffer, size);
+                long long start = currentTimeMicros();
+                
+                // String data is copied for the response so the
+                // unmarshaller may parse the document in place
+                if (!response->isDocument)
+                    response->unmarshaller->parse((char *) buffer, size);
+                else if (message->getType() == Message::MSG_RESP_STRING)
+                    response->unmarshaller->parseDocument((char *) buffer, size);
+                else
+                    response->unmarshaller->parse((char *) buffer, size, true);
+                
+                response->bindTime += currentTimeMicros() - start;
+                
+                // No more data is needed once the binding is complete
+                if (response->unmarshaller->isComplete()) {
+                    
+                    TRACE( "Binding of response message with subject '%s' completed before the end of the stream.",
+                          message->getSubject().c_str() );
+                    
+                    return false;
+                }
             }
         }
         
@@ -792,12 +938,16 @@ bool MessageBusManager::unmarshalMessage(void* context, mb::MessagePtr message,
         response->message->m_msgType = Message::MSG_RESP;
         response->message->setError(Message::ERR_SERVICE, 500, e->getMessage());
         
-        handleMulticastReply(&(response->listeners), response->message);
-        
         if (response->unmarshaller)
-            delete response->unmarshaller;
+            releaseUnmarshaller(response);
         
-        delete response;
+        handleMulticastReply(&(response->listeners), response->message);
+        
+        // The end of the stream is still to be received
+        if (size)
+            response->isFailed = true;
+        else
+            delete response;
     }
     
     return false;
@@ -868,6 +1018,18 @@ void MessageBusManager::unregisterService(Service* service) {
     service->destroy();
 }
 
+bool MessageBusManager::getServiceMetrics(const char* subject, NameValueMap& metrics) {
+    
+    boost::shared_lock<boost::shared_mutex> lock(m_servicesLock);
+    
+    boost::unordered_map<std::string, Service*>::iterator element = m_services.find(subject);
+    if (element == m_services.end())
+        return false;
+    
+    element->second->getMetrics(metrics);
+    return true;
+}
+
 void MessageBusManager::registerListener(const char* subject, Listener* listener) {
     
     boost::unique_lock<boost::shared_mutex> lock(m_listenersLock);
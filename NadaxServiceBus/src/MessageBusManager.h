@@ -113,6 +113,8 @@ public:
 
 	void registerService(Service* service);
 	void unregisterService(Service* service);
+
+	bool getServiceMetrics(const char* subject, NameValueMap& metrics);
     
     static void addSubjectRegisteredCallback(SubjectRegisteredCallback callback);
     static void addSubjectUnregisteredCallback(SubjectUnregisteredCallback callback);
@@ -163,6 +165,9 @@ private:
 
 	boost::shared_ptr<MessageQueue> m_messageQueue;
 	boost::shared_ptr<boost::thread> m_queueWorker;
+
+	// Parsers of messages bound for subjects without a service
+	UnmarshallerPoolPtr m_unmarshallerPool;
     
     static std::list<SubjectRegisteredCallback> _subjectRegisteredCallbacks;
     static std::list<SubjectUnregisteredCallback> _subjectUnregisteredCallbacks;
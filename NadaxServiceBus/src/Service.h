@@ -34,11 +34,14 @@
 #include "boost/unordered_map.hpp"
 #include "boost/unordered_set.hpp"
 #include "boost/pool/object_pool.hpp"
+#include "boost/thread/mutex.hpp"
 
 #include "log.h"
 #include "uuid.h"
+#include "spoolfile.h"
 
 #include "DynaModel.h"
+#include "UnmarshallerPool.h"
 
 #ifndef CSTR_TRUE
 #define CSTR_TRUE   "true"
@@ -52,6 +55,11 @@
 #define STREAMING_UPDATE    "IS_STREAMING"
 #define REQUEST_ID          "REQUEST_ID"
 
+// Meta data of a bound response set to the time in micro-seconds
+// spent binding it and the time at which the binding completed
+#define BIND_TIME   "BIND_TIME"
+#define BOUND_TIME  "BOUND_TIME"
+
 #define DO_NOT_SNAP  "DO_NOT_SNAP"
 
 #define SUBSCRIPTION_RESULT_CODE    "subResult"
@@ -72,6 +80,9 @@
 #define SEND_DATA(message, buffer, size) \
     ((StreamMessage *) message.get())->sendData(message, buffer, size)
 
+#define SEND_COMPLETE_DATA(message, buffer, size) \
+    ((StreamMessage *) message.get())->sendCompleteData(message, buffer, size)
+
 
 namespace mb {
 
@@ -101,6 +112,14 @@ public:
  */
 typedef bool (*DataCallback)(void* context, MessagePtr message, void* buffer, size_t size);
 
+/* Callback through which the message bus returns the
+ * result of binding the data streamed by a message. The
+ * data is a pointer to the binder's result shared pointer
+ * (i.e. boost::shared_ptr<T>*) which remains owned by the
+ * message bus.
+ */
+typedef void (*BoundDataCallback)(void* context, MessagePtr message, void* data);
+
 /* Response callback which clients can use to receive
  * a one time response for a specific message posted
  * by that client.
@@ -115,6 +134,32 @@ typedef void (*MessageCleanupCallback)(Message* message);
  */
 typedef boost::unordered_map<std::string, std::string> NameValueMap;
 
+/* Cancellation flag shared by a request and the
+ * messages created in response to it. Services and
+ * the message bus check it to abandon work whose
+ * result is no longer wanted.
+ */
+class CancellationToken {
+
+public:
+	CancellationToken() : m_cancelled(false) { }
+
+	void cancel() {
+		boost::lock_guard<boost::mutex> lock(m_lock);
+		m_cancelled = true;
+	}
+	bool isCancelled() {
+		boost::lock_guard<boost::mutex> lock(m_lock);
+		return m_cancelled;
+	}
+
+private:
+	boost::mutex m_lock;
+	bool m_cancelled;
+};
+
+typedef boost::shared_ptr<CancellationToken> CancellationTokenPtr;
+
 /* Base message structure. The Message Bus will create
  * a particular instance of a Message given a subject
  * name of the intended recipient of that message.
@@ -155,7 +200,8 @@ public:
 		ERR_CONNECTION_ERROR,    // Service connect error
 		ERR_CONNECTION_BREAK,    // Service connection break
 		ERR_CONNECTION_TIMEOUT,  // Service connection initiation timeout
-		ERR_EXECUTION_TIMEOUT    // Service execution timeout
+		ERR_EXECUTION_TIMEOUT,   // Service execution timeout
+		ERR_CANCELLED            // Message was cancelled
 	};
 
 	struct NameValue {
@@ -184,6 +230,12 @@ public:
         
         m_postCount = 0;
 
+		m_minDelay = 0;
+		m_maxDelay = 0;
+		m_backoff = 1.0;
+		m_contentHash = 0;
+		m_hasContentHash = false;
+
 		m_msgType = MSG_UNKNOWN;
 		m_cntType = CNT_UNKNOWN;
 
@@ -192,6 +244,8 @@ public:
         
         m_hasBinder = 0;
         
+        m_cancellationToken = CancellationTokenPtr(new CancellationToken());
+        
         m_cleanupCallback = NULL;
 
 		TRACE("Constructing Message: %p[%s]", this, m_id.c_str());
@@ -205,6 +259,12 @@ public:
 		m_posttime = message->m_posttime;
         
         m_postCount = 0;
+
+		m_minDelay = message->m_minDelay;
+		m_maxDelay = message->m_maxDelay;
+		m_backoff = message->m_backoff;
+		m_contentHash = 0;
+		m_hasContentHash = false;
         
 		m_msgType = message->m_msgType;
 		m_cntType = message->m_cntType;
@@ -216,6 +276,8 @@ public:
 		m_dataBinder = message->m_dataBinder;
         m_hasBinder = 0;
 
+		m_cancellationToken = message->m_cancellationToken;
+
 		m_subject = message->m_subject;
 
 		m_msgMetaData.insert(message->m_msgMetaData.begin(), message->m_msgMetaData.end());
@@ -290,6 +352,46 @@ public:
         if (!nowait)
             schedulePost();
 	}
+	/* Adaptive polling starts polling at the min delay and
+	 * backs the delay off towards the max delay while the
+	 * content of the poll responses does not change. When
+	 * the content changes the delay snaps back to the min.
+	 */
+	void setAdaptiveDelay(long minDelay, long maxDelay, double backoff = 2.0, bool nowait = false) {
+
+		m_minDelay = minDelay;
+		m_maxDelay = (maxDelay < minDelay ? minDelay : maxDelay);
+		m_backoff = (backoff < 1.0 ? 1.0 : backoff);
+
+		setDelay(minDelay, true, nowait);
+	}
+	bool isAdaptivePoll() {
+		return (m_maxDelay > 0);
+	}
+	/* Records the content hash of the latest poll response and
+	 * adapts the poll delay. Returns true if the content changed.
+	 * As the poll is rescheduled when it is sent, the new delay
+	 * takes effect from the poll after the next one.
+	 */
+	bool updateContentHash(unsigned long long hash) {
+
+		bool changed = (!m_hasContentHash || hash != m_contentHash);
+
+		m_contentHash = hash;
+		m_hasContentHash = true;
+
+		if (changed) {
+
+			m_delay = m_minDelay;
+
+		} else {
+
+			long long delay = (long long) ((m_delay > 0 ? m_delay : 1) * m_backoff);
+			m_delay = (delay > m_maxDelay ? m_maxDelay : delay < m_minDelay ? m_minDelay : delay);
+		}
+		return changed;
+	}
+
 	void schedulePost() {
 
 		struct timeval time;
@@ -363,6 +465,18 @@ public:
         return m_hasBinder;
     }
 
+	/* Cancels the message and the messages sharing its
+	 * token, i.e. a request and its responses. In-flight
+	 * work for the request is aborted and any data still
+	 * streamed for it is dropped.
+	 */
+	void cancel() {
+		m_cancellationToken->cancel();
+	}
+	bool isCancelled() {
+		return m_cancellationToken->isCancelled();
+	}
+
     /* Message cleanup callback */
     void setCleanupCallback(MessageCleanupCallback callback) {
         m_cleanupCallback = callback;
@@ -377,6 +491,12 @@ protected:
     
     long m_postCount;
 
+	long long m_minDelay;
+	long long m_maxDelay;
+	double m_backoff;
+	unsigned long long m_contentHash;
+	bool m_hasContentHash;
+
 	MessageType m_msgType;
 	ContentType m_cntType;
 
@@ -390,6 +510,8 @@ protected:
 	binding::DataBinderPtr m_dataBinder;
     short m_hasBinder;
 
+	CancellationTokenPtr m_cancellationToken;
+
 	NameValueMap m_msgMetaData;
     MessagePtr m_attachment;
     
@@ -471,34 +593,107 @@ private:
 
 /* In a string message the string data
  * member contains the message contents.
+ *
+ * If a spool threshold is set, contents that grow beyond it
+ * are moved to a temporary file and the rest of the contents
+ * are appended to the file. The data of a spooled message is
+ * a read-only memory mapping of the file, which can also be
+ * read as a stream via its descriptor.
  */
 class StringMessage : public Message {
 
 public:
 	StringMessage() : Message() {
+		m_spoolThreshold = 0;
 	}
 	StringMessage(Message* message) : Message(message) {
+		m_spoolThreshold = 0;
 	}
 	StringMessage(StringMessage* message) : Message(message) {
-		m_data << message->m_data.str();
+		m_spoolThreshold = message->m_spoolThreshold;
+		m_spool = message->m_spool;
+		if (!m_spool)
+			m_data << message->m_data.str();
 	};
 	virtual ~StringMessage() {
 	}
 
 	void* getData() {
-		return (void *) m_data.str().c_str();
+		if (m_spool)
+			return (void *) m_spool->map();
+		// The contents are copied out of the stream as
+		// its str() returns a temporary
+		m_contents = m_data.str();
+		return (void *) m_contents.c_str();
 	}
 	void setData(void* data) {
+		m_spool.reset();
 		m_data.clear();
 		m_data.str((const char *) data);
 	}
 
 	void append(char* buffer, size_t size) {
+
+		if (m_spool) {
+
+			if (!m_spool->write(buffer, size))
+				this->setError(ERR_SERVICE, errno, "Unable to write message data to spool file.");
+			return;
+		}
+
 		m_data.write(buffer, size);
+
+		if (m_spoolThreshold && (size_t) m_data.tellp() > m_spoolThreshold)
+			this->spool();
+	}
+
+	/* Size in bytes above which the contents are spooled
+	 * to a temporary file or 0 to never spool contents */
+	void setSpoolThreshold(size_t spoolThreshold) {
+		m_spoolThreshold = spoolThreshold;
+	}
+
+	bool isSpooled() {
+		return (m_spool.get() != NULL);
+	}
+	size_t getSize() {
+		return (m_spool ? m_spool->getSize() : (size_t) m_data.tellp());
+	}
+	/* Descriptor of the spool file or -1 if the contents are not
+	 * spooled. The descriptor is valid as long as the message and
+	 * should be read with pread or after seeking to the beginning. */
+	int getSpoolFile() {
+		return (m_spool ? m_spool->getFile() : -1);
 	}
 
 private:
+
+	void spool() {
+
+		boost::shared_ptr<SpoolFile> spool(new SpoolFile());
+
+		if (!spool->create()) {
+
+			// The contents remain in memory if they cannot be spooled
+			ERROR("Unable to create spool file for message data: %s", strerror(errno));
+			m_spoolThreshold = 0;
+			return;
+		}
+
+		std::string data = m_data.str();
+		m_data.str("");
+
+		if (!spool->write(data.c_str(), data.length()))
+			this->setError(ERR_SERVICE, errno, "Unable to write message data to spool file.");
+
+		m_spool = spool;
+	}
+
 	std::ostringstream m_data;
+	std::string m_contents;
+
+	size_t m_spoolThreshold;
+	boost::shared_ptr<SpoolFile> m_spool;
 };
 
 /* A Stream message is a message that will be
@@ -509,12 +704,20 @@ class StreamMessage : public Message {
 
 public:
 	StreamMessage() : Message() {
+		m_boundData = NULL;
+		m_isCompleteData = false;
 	};
 	StreamMessage(Message* message) : Message(message) {
+		m_boundData = NULL;
+		m_isCompleteData = false;
 	}
 	StreamMessage(StreamMessage* message) : Message(message) {
 		std::list<DataCallbackHandle>* callbacks = &message->m_callbacks;
 		m_callbacks.insert(m_callbacks.end(), callbacks->begin(), callbacks->end());
+		std::list<BoundDataCallbackHandle>* boundCallbacks = &message->m_boundCallbacks;
+		m_boundCallbacks.insert(m_boundCallbacks.end(), boundCallbacks->begin(), boundCallbacks->end());
+		m_boundData = NULL;
+		m_isCompleteData = false;
 	};
 	virtual ~StreamMessage() {
 	}
@@ -523,32 +726,108 @@ public:
 		m_callbacks.push_back(DataCallbackHandle(context, callback));
 	}
 
+	/* Callback to receive the result of binding the streamed
+	 * data or the bound data the message was completed with */
+	void setBoundDataCallback(void* context, BoundDataCallback callback) {
+		m_boundCallbacks.push_back(BoundDataCallbackHandle(context, callback));
+	}
+	void notifyBoundData(MessagePtr message, void* data) {
+
+		for (std::list<BoundDataCallbackHandle>::iterator i = m_boundCallbacks.begin(); i != m_boundCallbacks.end(); i++)
+			i->callback(i->context, message, data);
+	}
+
+	/* Data that was bound from an earlier stream (i.e. a cached
+	 * response) which is returned as the bound result instead of
+	 * binding any streamed data. The data must be a new instance of
+	 * the binder's result shared pointer (i.e. boost::shared_ptr<T>*)
+	 * and ownership passes to the data message that is delivered.
+	 */
+	void setBoundData(void* data) {
+		m_boundData = data;
+	}
+	void* detachBoundData() {
+		void* data = m_boundData;
+		m_boundData = NULL;
+		return data;
+	}
+
+	/* Sends data to the receivers of the stream. A receiver that
+	 * returns false is sent no more data other than the end of the
+	 * stream. Returns false once no receiver wants more data. */
 	bool sendData(MessagePtr messsage, void* buffer, size_t size) {
 
-		bool result = true;
+		// Data of a cancelled message is dropped but the end
+		// of the stream is still sent so that receivers can
+		// release what they hold for the message
+		if (size && this->isCancelled())
+			return false;
+
+		bool result = m_callbacks.empty();
 
 		for (std::list<DataCallbackHandle>::iterator i = m_callbacks.begin(); i != m_callbacks.end(); i++) {
 
+			if (size && i->isDone)
+				continue;
+
 			DataCallbackHandle handle = *i;
-			bool callbackResult = handle.callback(handle.context, messsage, buffer, size);
-            result = result && callbackResult;
+
+			if (handle.callback(handle.context, messsage, buffer, size))
+				result = true;
+			else
+				i->isDone = true;
 		}
 
 		return result;
 	}
 
+	/* Sends the whole of the stream's data as a single chunk
+	 * which receivers can parse as a complete document rather
+	 * than incrementally. Only the end of the stream may follow.
+	 */
+	bool sendCompleteData(MessagePtr message, void* buffer, size_t size) {
+
+		m_isCompleteData = true;
+		bool result = this->sendData(message, buffer, size);
+		m_isCompleteData = false;
+
+		return result;
+	}
+
+	/* Whether the data being sent is the whole of the stream */
+	bool isCompleteData() {
+		return m_isCompleteData;
+	}
+
 private:
 
 	struct DataCallbackHandle {
 
 		DataCallbackHandle(void* context, DataCallback callback)
-			: context(context), callback(callback) { }
+			: context(context), callback(callback), isDone(false) { }
 
 		void* context;
 		DataCallback callback;
+
+		// The receiver wants no more data
+		bool isDone;
+	};
+
+	struct BoundDataCallbackHandle {
+
+		BoundDataCallbackHandle(void* context, BoundDataCallback callback)
+			: context(context), callback(callback) { }
+
+		void* context;
+		BoundDataCallback callback;
 	};
 
 	std::list<DataCallbackHandle> m_callbacks;
+	std::list<BoundDataCallbackHandle> m_boundCallbacks;
+
+	void* m_boundData;
+
+	bool m_isCompleteData;
 };
 
 /* A p2p message is a single delivery message
@@ -719,6 +998,9 @@ private:
 class Service : public Provider, public Listener {
 
 public:
+	Service() : m_unmarshallerPool(new UnmarshallerPool()) {
+		m_spoolThreshold = 0;
+	}
 	virtual ~Service() { }
 
 	/* Checks if this service is associated with the
@@ -786,6 +1068,38 @@ public:
 		m_binderPool.returnObject(binder);
 	}
 
+	/* Sets the factory of the unmarshallers that parse response
+	 * data of the given content type for binding. The service's
+	 * pools parse XML and JSON with the data binding parsers.
+	 */
+	void setUnmarshallerFactory(Message::ContentType cntType, UnmarshallerFactory factory) {
+		m_unmarshallerPool->setFactory(cntType, factory);
+	}
+
+	/* Pool of the parsers that bind the service's responses.
+	 */
+	UnmarshallerPoolPtr getUnmarshallerPool() {
+		return m_unmarshallerPool;
+	}
+
+	/* Size in bytes above which the contents of a response
+	 * to a synchronous request are spooled to a temporary
+	 * file instead of being held in memory. If 0 responses
+	 * are never spooled.
+	 */
+	size_t getSpoolThreshold() {
+		return m_spoolThreshold;
+	}
+	void setSpoolThreshold(size_t spoolThreshold) {
+		m_spoolThreshold = spoolThreshold;
+	}
+
+	/* Adds runtime metrics of the service as name value
+	 * pairs to the given map. Services that do not keep
+	 * any metrics leave the map unchanged.
+	 */
+	virtual void getMetrics(NameValueMap& metrics) { }
+
 	/* Logs state of the service.
 	 */
 	friend std::ostream &operator<< (std::ostream& cout, const Service& service) {
@@ -814,6 +1128,7 @@ protected:
 		response->m_msgType = msgType;
 		response->m_cntType = cntType;
 		response->m_dataBinder = request->m_dataBinder;
+		response->m_cancellationToken = request->m_cancellationToken;
 	}
 
 	void setType(const char* type) {
@@ -834,6 +1149,10 @@ private:
 	boost::unordered_set<std::string> m_types;
 
 	binding::DynaModelBinderPool m_binderPool;
+
+	UnmarshallerPoolPtr m_unmarshallerPool;
+
+	size_t m_spoolThreshold;
 };
 
 
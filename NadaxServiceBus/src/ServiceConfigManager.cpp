@@ -89,6 +89,7 @@ public:
         GET_BINDER(ServiceConfigBinder);
 
         dataBinder->m_bindingConfig = boost::shared_ptr<DynaModelBindingConfig>(new DynaModelBindingConfig());
+        dataBinder->m_bindingConfig->beginBindingsConfigElement(attribs);
     }
 
     static void beginBindConfig(void* binder, const char* element, std::map<std::string, std::string>& attribs) {
@@ -0,0 +1,180 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "UnmarshallerPool.h"
+
+#include "log.h"
+#include "Service.h"
+#include "XmlStreamParser.h"
+#include "XmlInSituParser.h"
+#include "JsonStreamParser.h"
+
+
+namespace mb {
+
+
+binding::Unmarshaller* createXmlUnmarshaller() {
+	return new parser::XmlBinder();
+}
+
+binding::Unmarshaller* createJsonUnmarshaller() {
+	return new parser::JsonBinder();
+}
+
+binding::Unmarshaller* createXmlDocumentUnmarshaller() {
+	return new parser::XmlDocumentBinder();
+}
+
+
+UnmarshallerPool::UnmarshallerPool() {
+
+	m_pools[Message::CNT_XML] = FactoryPoolPtr(new FactoryPool(createXmlUnmarshaller));
+	m_pools[Message::CNT_JSON] = FactoryPoolPtr(new FactoryPool(createJsonUnmarshaller));
+
+	m_documentPools[Message::CNT_XML] = FactoryPoolPtr(new FactoryPool(createXmlDocumentUnmarshaller));
+}
+
+UnmarshallerPool::~UnmarshallerPool() {
+}
+
+void UnmarshallerPool::setFactory(int contentType, UnmarshallerFactory factory) {
+
+	boost::lock_guard<boost::mutex> lock(m_poolsLock);
+	m_pools[contentType] = FactoryPoolPtr(new FactoryPool(factory));
+	m_documentPools.erase(contentType);
+}
+
+void UnmarshallerPool::setDocumentFactory(int contentType, UnmarshallerFactory factory) {
+
+	boost::lock_guard<boost::mutex> lock(m_poolsLock);
+	m_documentPools[contentType] = FactoryPoolPtr(new FactoryPool(factory));
+}
+
+UnmarshallerPtr UnmarshallerPool::getUnmarshaller(int contentType, binding::DataBinderPtr binder, bool isDocument) {
+
+	UnmarshallerPtr unmarshaller = this->getPool(contentType, isDocument)->getObject();
+	unmarshaller->setDataBinder(binder);
+
+	return unmarshaller;
+}
+
+void UnmarshallerPool::returnUnmarshaller(int contentType, UnmarshallerPtr unmarshaller, bool isDocument) {
+
+	this->getPool(contentType, isDocument)->returnObject(unmarshaller);
+}
+
+int UnmarshallerPool::getAllocatedSize() {
+
+	boost::lock_guard<boost::mutex> lock(m_poolsLock);
+
+	int size = 0;
+	for (FactoryPoolMap::iterator i = m_pools.begin(); i != m_pools.end(); i++)
+		size += i->second->getAllocatedSize();
+	for (FactoryPoolMap::iterator i = m_documentPools.begin(); i != m_documentPools.end(); i++)
+		size += i->second->getAllocatedSize();
+
+	return size;
+}
+
+int UnmarshallerPool::getUnallocatedPoolSize() {
+
+	boost::lock_guard<boost::mutex> lock(m_poolsLock);
+
+	int size = 0;
+	for (FactoryPoolMap::iterator i = m_pools.begin(); i != m_pools.end(); i++)
+		size += i->second->getUnallocatedPoolSize();
+	for (FactoryPoolMap::iterator i = m_documentPools.begin(); i != m_documentPools.end(); i++)
+		size += i->second->getUnallocatedPoolSize();
+
+	return size;
+}
+
+long UnmarshallerPool::getCreatedCount() {
+
+	boost::lock_guard<boost::mutex> lock(m_poolsLock);
+
+	long count = 0;
+	for (FactoryPoolMap::iterator i = m_pools.begin(); i != m_pools.end(); i++)
+		count += i->second->getCreatedCount();
+	for (FactoryPoolMap::iterator i = m_documentPools.begin(); i != m_documentPools.end(); i++)
+		count += i->second->getCreatedCount();
+
+	return count;
+}
+
+UnmarshallerPool::FactoryPoolPtr UnmarshallerPool::getPool(int contentType, bool isDocument) {
+
+	boost::lock_guard<boost::mutex> lock(m_poolsLock);
+
+	FactoryPoolMap::iterator pool = m_pools.find(contentType);
+
+	if (isDocument) {
+
+		FactoryPoolMap::iterator documentPool = m_documentPools.find(contentType);
+
+		// Content types parsed as XML by default
+		// also parse their whole responses as XML
+		if (documentPool == m_documentPools.end() && pool == m_pools.end())
+			documentPool = m_documentPools.find(Message::CNT_XML);
+
+		if (documentPool != m_documentPools.end())
+			return documentPool->second;
+	}
+
+	// Assume XML as default content type
+	if (pool == m_pools.end())
+		pool = m_pools.find(Message::CNT_XML);
+
+	return pool->second;
+}
+
+binding::Unmarshaller* UnmarshallerPool::FactoryPool::create() {
+
+	binding::Unmarshaller* unmarshaller = m_factory();
+
+	try {
+		unmarshaller->initialize();
+
+	} catch (...) {
+
+		delete unmarshaller;
+		throw;
+	}
+
+	{ boost::lock_guard<boost::mutex> lock(m_createdLock);
+		++m_created;
+	}
+
+	TRACE("Created a pooled unmarshaller at %p.", unmarshaller);
+	return unmarshaller;
+}
+
+void UnmarshallerPool::FactoryPool::passivate(binding::Unmarshaller* unmarshaller) {
+
+	// The parser is reset for reuse and the
+	// binder of the last response released
+	unmarshaller->reset();
+	unmarshaller->setDataBinder(binding::DataBinderPtr());
+}
+
+
+}  // namespace : mb
@@ -0,0 +1,133 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef UNMARSHALLERPOOL_H_
+#define UNMARSHALLERPOOL_H_
+
+#include "boost/shared_ptr.hpp"
+#include "boost/unordered_map.hpp"
+#include "boost/thread/mutex.hpp"
+
+#include "objectpool.h"
+#include "Unmarshaller.h"
+
+
+namespace mb {
+
+
+/* Creates an unmarshaller for a content type. The unmarshaller
+ * is initialized by the pool and given a binder when it is taken
+ * from the pool.
+ */
+typedef binding::Unmarshaller* (*UnmarshallerFactory)();
+
+typedef boost::shared_ptr<binding::Unmarshaller> UnmarshallerPtr;
+
+
+/* Pools of initialized unmarshallers of a service keyed by the
+ * content type they parse. Parsers returned to the pool are reset
+ * and reused for the next response of the same content type rather
+ * than being created for each response. Content types without a
+ * factory are parsed as XML.
+ *
+ * Responses that are available whole are parsed by the document
+ * unmarshallers of their content type, which parse XML in place.
+ * Content types without a document factory parse whole responses
+ * with the unmarshallers of their factory.
+ */
+class UnmarshallerPool {
+
+public:
+	UnmarshallerPool();
+	virtual ~UnmarshallerPool();
+
+	/* Sets the factory that creates the unmarshallers of the given
+	 * content type. Unmarshallers pooled for the content type by a
+	 * prior factory are discarded along with its document factory
+	 * so the given factory also parses whole responses.
+	 */
+	void setFactory(int contentType, UnmarshallerFactory factory);
+
+	/* Sets the factory that creates the unmarshallers of whole
+	 * responses of the given content type.
+	 */
+	void setDocumentFactory(int contentType, UnmarshallerFactory factory);
+
+	/* Takes an unmarshaller for the content type from the pool and
+	 * sets it to bind with the given binder. If isDocument is true
+	 * the unmarshaller is one for responses that are parsed whole.
+	 */
+	UnmarshallerPtr getUnmarshaller(int contentType, binding::DataBinderPtr binder, bool isDocument = false);
+
+	/* Resets the unmarshaller along with its binder
+	 * and returns it to the pool it was taken from.
+	 */
+	void returnUnmarshaller(int contentType, UnmarshallerPtr unmarshaller, bool isDocument = false);
+
+	/* Number of pooled unmarshallers that are in use and that are
+	 * available across all content types */
+	int getAllocatedSize();
+	int getUnallocatedPoolSize();
+
+	/* Number of unmarshallers created across all content types */
+	long getCreatedCount();
+
+private:
+
+	class FactoryPool : public ObjectPool<binding::Unmarshaller> {
+
+	public:
+		FactoryPool(UnmarshallerFactory factory) : m_factory(factory), m_created(0) { }
+
+		long getCreatedCount() {
+			boost::lock_guard<boost::mutex> lock(m_createdLock);
+			return m_created;
+		}
+
+	protected:
+		virtual binding::Unmarshaller* create();
+		virtual void passivate(binding::Unmarshaller* unmarshaller);
+
+	private:
+		UnmarshallerFactory m_factory;
+
+		boost::mutex m_createdLock;
+		long m_created;
+	};
+
+	typedef boost::shared_ptr<FactoryPool> FactoryPoolPtr;
+
+	typedef boost::unordered_map<int, FactoryPoolPtr> FactoryPoolMap;
+
+	FactoryPoolPtr getPool(int contentType, bool isDocument);
+
+	boost::mutex m_poolsLock;
+	FactoryPoolMap m_pools;
+	FactoryPoolMap m_documentPools;
+};
+
+typedef boost::shared_ptr<UnmarshallerPool> UnmarshallerPoolPtr;
+
+
+}  // namespace : mb
+
+#endif /* UNMARSHALLERPOOL_H_ */
@@ -30,6 +30,8 @@
 #include "boost/asio.hpp"
 #include "boost/bind.hpp"
 #include "boost/thread.hpp"
+#include "boost/shared_ptr.hpp"
+#include "boost/function.hpp"
 
 class Executor {
 public:
@@ -53,6 +55,25 @@ public:
 		m_service.post(task);
 	}
 
+	// Submits the task for execution after the given delay
+	template<typename F> void schedule(F task, long millis) {
+
+		boost::shared_ptr<boost::asio::deadline_timer> timer(
+			new boost::asio::deadline_timer(m_service, boost::posix_time::milliseconds(millis)) );
+
+		boost::function<void ()> scheduled(task);
+		timer->async_wait(boost::bind(&Executor::onTimer, timer, scheduled, boost::asio::placeholders::error));
+	}
+
+private:
+
+	static void onTimer( boost::shared_ptr<boost::asio::deadline_timer> timer,
+		boost::function<void ()> task, const boost::system::error_code& error ) {
+
+		if (!error)
+			task();
+	}
+
 protected:
 	boost::thread_group m_pool;
 	boost::asio::io_service m_service;
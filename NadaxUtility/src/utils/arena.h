@@ -0,0 +1,197 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// arena.h : Bump allocator for memory that is released all at once.
+//
+
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+
+// Memory is handed out from large chunks by advancing an offset and
+// is never freed individually. Resetting the arena rewinds it to its
+// first chunk while keeping the chunks, so once an arena has grown to
+// the size needed for a unit of work, such as parsing a document, it
+// serves every later unit without touching the heap. An arena is not
+// thread safe and is meant to be owned by a single parse.
+class MemoryArena
+{
+public:
+	// Alignment of every allocation
+	static const size_t ALIGNMENT = 16;
+
+	MemoryArena(size_t chunkSize = 16384);
+	virtual ~MemoryArena();
+
+	void* allocate(size_t size);
+
+	// Copies the string into the arena
+	char* copy(const char* str, size_t len);
+	char* copy(const char* str) {
+		return copy(str, strlen(str));
+	}
+
+	// Releases everything allocated since the last reset
+	void reset();
+
+	// Number of allocations served since the arena was created
+	long getAllocationCount() {
+		return m_allocations;
+	}
+
+	// Number of chunks allocated from the heap
+	long getChunkCount() {
+		return (long) m_chunks.size();
+	}
+
+	// Bytes allocated since the last reset
+	size_t getAllocatedSize() {
+		return m_allocated;
+	}
+
+	// Bytes held from the heap in all chunks
+	size_t getCapacity() {
+		return m_capacity;
+	}
+
+private:
+
+	MemoryArena(const MemoryArena&);
+	MemoryArena& operator=(const MemoryArena&);
+
+	struct Chunk {
+		char* data;
+		size_t size;
+	};
+
+	void* allocateChunk(size_t size);
+
+	size_t m_chunkSize;
+
+	std::vector<Chunk> m_chunks;
+
+	size_t m_chunk;
+	char* m_next;
+	char* m_end;
+
+	long m_allocations;
+	size_t m_allocated;
+	size_t m_capacity;
+};
+
+
+// **** Implementation ***
+
+inline MemoryArena::MemoryArena(size_t chunkSize)
+{
+	m_chunkSize = chunkSize;
+
+	m_chunk = 0;
+	m_next = NULL;
+	m_end = NULL;
+
+	m_allocations = 0;
+	m_allocated = 0;
+	m_capacity = 0;
+}
+
+inline MemoryArena::~MemoryArena()
+{
+	for (size_t i = 0; i < m_chunks.size(); i++)
+		free(m_chunks[i].data);
+}
+
+inline void* MemoryArena::allocate(size_t size)
+{
+	size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+	++m_allocations;
+	m_allocated += size;
+
+	if (m_next && (size_t) (m_end - m_next) >= size)
+	{
+		void* data = m_next;
+		m_next += size;
+		return data;
+	}
+
+	return allocateChunk(size);
+}
+
+inline char* MemoryArena::copy(const char* str, size_t len)
+{
+	char* data = (char *) allocate(len + 1);
+
+	memcpy(data, str, len);
+	data[len] = 0;
+
+	return data;
+}
+
+inline void MemoryArena::reset()
+{
+	m_chunk = 0;
+	m_allocated = 0;
+
+	if (m_chunks.size())
+	{
+		m_next = m_chunks[0].data;
+		m_end = m_next + m_chunks[0].size;
+	}
+}
+
+inline void* MemoryArena::allocateChunk(size_t size)
+{
+	// Chunks kept from before the last reset are reused
+	// in order while they are large enough for the request
+	size_t next = (m_next ? m_chunk + 1 : 0);
+
+	while (next < m_chunks.size() && m_chunks[next].size < size)
+		++next;
+
+	if (next == m_chunks.size())
+	{
+		Chunk chunk;
+		chunk.size = (size > m_chunkSize ? size : m_chunkSize);
+
+		// malloc aligns to at least 16 bytes on the supported platforms
+		if (!(chunk.data = (char *) malloc(chunk.size)))
+			return NULL;
+
+		m_chunks.push_back(chunk);
+		m_capacity += chunk.size;
+	}
+
+	m_chunk = next;
+	m_next = m_chunks[next].data + size;
+	m_end = m_chunks[next].data + m_chunks[next].size;
+
+	return m_chunks[next].data;
+}
+
+
+#endif /* ARENA_H_ */
@@ -0,0 +1,50 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// clock.h : Wall clock helpers used for measuring elapsed times.
+//
+
+#ifndef CLOCK_H_
+#define CLOCK_H_
+
+#include <sys/time.h>
+
+
+// Returns the current time in micro-seconds
+inline long long currentTimeMicros() {
+
+	struct timeval time;
+	gettimeofday(&time, NULL);
+
+	long long tv_sec = time.tv_sec;
+	long long tv_usec = time.tv_usec;
+
+	return tv_sec * 1000000 + tv_usec;
+}
+
+// Returns the current time in milli-seconds
+inline long long currentTimeMillis() {
+
+	return currentTimeMicros() / 1000;
+}
+
+#endif /* CLOCK_H_ */
@@ -0,0 +1,49 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// hash.h : Non-cryptographic hash used to detect content changes.
+//
+
+#ifndef HASH_H_
+#define HASH_H_
+
+#include <stddef.h>
+
+#define FNV1A_64_INIT   0xcbf29ce484222325ULL
+#define FNV1A_64_PRIME  0x100000001b3ULL
+
+
+// Returns the 64 bit FNV-1a hash of the given data. A hash
+// can be computed incrementally by passing the hash of the
+// preceding data as the initial value.
+inline unsigned long long fnv1a64(const void* data, size_t size, unsigned long long hash = FNV1A_64_INIT) {
+
+	const unsigned char* bytes = (const unsigned char *) data;
+
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= FNV1A_64_PRIME;
+	}
+	return hash;
+}
+
+#endif /* HASH_H_ */
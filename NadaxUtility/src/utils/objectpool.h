@@ -123,6 +123,9 @@ public:
 		m_max = -1;
 		m_allocated = 0;
 
+		m_waits = 0;
+		m_exhausted = 0;
+
 		m_timeout = -1;
 		m_lingerTime = -1;
 		m_evictChecks = -1;
@@ -152,6 +155,18 @@ public:
 		return m_pool.size();
 	}
 
+	/// Returns the number of requests for an object that found all objects allocated.
+	long getWaitCount() {
+		boost::lock_guard<boost::mutex> lock(m_poolM);
+		return m_waits;
+	}
+
+	/// Returns the number of requests for an object that failed as all objects remained allocated.
+	long getExhaustedCount() {
+		boost::lock_guard<boost::mutex> lock(m_poolM);
+		return m_exhausted;
+	}
+
 	/**
 	 * @brief Sets the pool size.
 	 *
@@ -259,10 +274,14 @@ public:
 
 			if (m_max > 0) {
 
+				if (m_allocated == m_max)
+					++m_waits;
+
 				while (m_allocated == m_max) {
 
 					if (m_timeout == 0) {
 
+						++m_exhausted;
 						throw _pool_error()
 							<< pool_error_msg("All pooled objects have been allocated.")
 							<< boost::errinfo_errno(ERROR_ALL_OBJECTS_ALLOCATED);
@@ -273,6 +292,7 @@ public:
 
 						if (!m_poolC.timed_wait(lock, timeout)) {
 
+							++m_exhausted;
 							throw _pool_error()
 								<< pool_error_msg("Timed out waiting for pooled object.")
 								<< boost::errinfo_errno(ERROR_TIMED_OUT_WAITING_FOR_OBJECT);
@@ -492,6 +512,9 @@ private:
 	int m_max;
 	int m_allocated;
 
+	long m_waits;
+	long m_exhausted;
+
 	long m_timeout;
 	long m_lingerTime;
 
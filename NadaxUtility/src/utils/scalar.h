@@ -0,0 +1,332 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// scalar.h : Locale independent parsers of numbers, booleans and
+//            ISO 8601 timestamps.
+//
+
+#ifndef SCALAR_H_
+#define SCALAR_H_
+
+#include <string.h>
+#include <limits.h>
+
+#include <string>
+#include <sstream>
+#include <locale>
+
+
+// Each parser accepts the whole of the given text, which may be
+// surrounded by white space, and returns false without changing
+// the value if it is not well formed or out of range. The decimal
+// point is always '.' whatever the locale of the process.
+
+inline bool parseInt64(const char* text, long long& value);
+inline bool parseDouble(const char* text, double& value);
+
+// Accepts true, false, 1 and 0
+inline bool parseBool(const char* text, bool& value);
+
+// Accepts a date given as YYYY-MM-DD optionally followed by 'T' or a
+// space and a time given as hh:mm[:ss[.fff]] and a time zone given
+// as Z or +/-hh[:mm]. Times without a zone are taken to be in UTC.
+// The value is in milli-seconds since the epoch.
+inline bool parseTimestamp(const char* text, long long& value);
+
+
+// **** Implementation ***
+
+inline const char* skipScalarSpace(const char* text)
+{
+	while (*text == ' ' || *text == '\t' || *text == '\n' || *text == '\r')
+		text++;
+
+	return text;
+}
+
+inline bool isScalarEnd(const char* text)
+{
+	return *skipScalarSpace(text) == 0;
+}
+
+inline bool parseInt64(const char* text, long long& value)
+{
+	const char* p = skipScalarSpace(text);
+
+	bool negative = (*p == '-');
+	if (*p == '-' || *p == '+')
+		p++;
+
+	if (*p < '0' || *p > '9')
+		return false;
+
+	// The magnitude of LLONG_MIN is one more than LLONG_MAX
+	unsigned long long limit = (negative ? (unsigned long long) LLONG_MAX + 1 : (unsigned long long) LLONG_MAX);
+	unsigned long long magnitude = 0;
+
+	for (; *p >= '0' && *p <= '9'; p++)
+	{
+		unsigned int digit = *p - '0';
+
+		if (magnitude > (limit - digit) / 10)
+			return false;
+
+		magnitude = magnitude * 10 + digit;
+	}
+
+	if (!isScalarEnd(p))
+		return false;
+
+	value = (negative ? (long long) (0 - magnitude) : (long long) magnitude);
+	return true;
+}
+
+inline bool parseDouble(const char* text, double& value)
+{
+	// Powers of ten that are exactly representable as doubles
+	static const double powers[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	const char* start = skipScalarSpace(text);
+	const char* p = start;
+
+	bool negative = (*p == '-');
+	if (*p == '-' || *p == '+')
+		p++;
+
+	unsigned long long mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+	bool hasDigits = false;
+
+	for (; *p >= '0' && *p <= '9'; p++, hasDigits = true)
+	{
+		if (digits < 19)
+		{
+			mantissa = mantissa * 10 + (*p - '0');
+			if (mantissa)
+				digits++;
+		}
+		else
+			exponent++;
+	}
+
+	if (*p == '.')
+	{
+		for (p++; *p >= '0' && *p <= '9'; p++, hasDigits = true)
+		{
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + (*p - '0');
+				if (mantissa)
+					digits++;
+				exponent--;
+			}
+		}
+	}
+
+	if (!hasDigits)
+		return false;
+
+	if (*p == 'e' || *p == 'E')
+	{
+		p++;
+
+		bool negativeExponent = (*p == '-');
+		if (*p == '-' || *p == '+')
+			p++;
+
+		if (*p < '0' || *p > '9')
+			return false;
+
+		int e = 0;
+		for (; *p >= '0' && *p <= '9'; p++)
+			if (e < 100000)
+				e = e * 10 + (*p - '0');
+
+		exponent += (negativeExponent ? -e : e);
+	}
+
+	const char* end = p;
+	if (!isScalarEnd(end))
+		return false;
+
+	if (mantissa == 0)
+	{
+		value = (negative ? -0.0 : 0.0);
+		return true;
+	}
+
+	// A mantissa and power of ten that are both exact give
+	// a correctly rounded result with a single operation
+	if (mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22)
+	{
+		double result = (double) mantissa;
+		result = (exponent < 0 ? result / powers[-exponent] : result * powers[exponent]);
+
+		value = (negative ? -result : result);
+		return true;
+	}
+
+	// Long mantissas and large exponents are left to the
+	// standard library reading in the classic locale
+	std::istringstream input(std::string(start, end - start));
+	input.imbue(std::locale::classic());
+
+	double result;
+	input >> result;
+
+	if (input.fail())
+		return false;
+
+	value = result;
+	return true;
+}
+
+inline bool parseBool(const char* text, bool& value)
+{
+	const char* p = skipScalarSpace(text);
+
+	if (!strncmp(p, "true", 4) && isScalarEnd(p + 4))
+		value = true;
+	else if (!strncmp(p, "false", 5) && isScalarEnd(p + 5))
+		value = false;
+	else if ((*p == '1' || *p == '0') && isScalarEnd(p + 1))
+		value = (*p == '1');
+	else
+		return false;
+
+	return true;
+}
+
+// Reads exactly the given number of digits
+inline bool parseScalarDigits(const char*& p, int count, int& value)
+{
+	value = 0;
+
+	for (int i = 0; i < count; i++, p++)
+	{
+		if (*p < '0' || *p > '9')
+			return false;
+
+		value = value * 10 + (*p - '0');
+	}
+
+	return true;
+}
+
+inline bool parseTimestamp(const char* text, long long& value)
+{
+	static const int monthDays[] = { 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+	const char* p = skipScalarSpace(text);
+
+	int year, month, day;
+	int hour = 0, minute = 0, second = 0, millis = 0;
+	int offset = 0;
+
+	if ( !parseScalarDigits(p, 4, year) || *p++ != '-' ||
+		!parseScalarDigits(p, 2, month) || *p++ != '-' ||
+		!parseScalarDigits(p, 2, day) )
+		return false;
+
+	if (month < 1 || month > 12 || day < 1 || day > monthDays[month - 1])
+		return false;
+
+	bool leapYear = ((year % 4 == 0 && year % 100 != 0) || year % 400 == 0);
+	if (month == 2 && day == 29 && !leapYear)
+		return false;
+
+	if ((*p == 'T' || *p == ' ') && p[1] >= '0' && p[1] <= '9')
+	{
+		p++;
+
+		if (!parseScalarDigits(p, 2, hour) || *p++ != ':' || !parseScalarDigits(p, 2, minute))
+			return false;
+
+		if (*p == ':')
+		{
+			p++;
+
+			if (!parseScalarDigits(p, 2, second))
+				return false;
+
+			if (*p == '.' || *p == ',')
+			{
+				int scale = 100;
+
+				if (*++p < '0' || *p > '9')
+					return false;
+
+				for (; *p >= '0' && *p <= '9'; p++, scale /= 10)
+					millis += (*p - '0') * scale;
+			}
+		}
+
+		if (hour > 23 || minute > 59 || second > 60)
+			return false;
+
+		if (*p == 'Z')
+		{
+			p++;
+		}
+		else if (*p == '+' || *p == '-')
+		{
+			int sign = (*p++ == '-' ? -1 : 1);
+			int offsetHours, offsetMinutes = 0;
+
+			if (!parseScalarDigits(p, 2, offsetHours))
+				return false;
+
+			if (*p == ':')
+				p++;
+			if (*p >= '0' && *p <= '9' && !parseScalarDigits(p, 2, offsetMinutes))
+				return false;
+
+			if (offsetHours > 23 || offsetMinutes > 59)
+				return false;
+
+			offset = sign * (offsetHours * 60 + offsetMinutes);
+		}
+	}
+
+	if (!isScalarEnd(p))
+		return false;
+
+	// Days since the epoch of the proleptic Gregorian calendar
+	int y = (month <= 2 ? year - 1 : year);
+	int era = (y >= 0 ? y : y - 399) / 400;
+	int yearOfEra = y - era * 400;
+	int dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+	int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+	long long days = (long long) era * 146097 + dayOfEra - 719468;
+
+	long long seconds = days * 86400 + hour * 3600 + minute * 60 + second - offset * 60;
+
+	value = seconds * 1000 + millis;
+	return true;
+}
+
+
+#endif /* SCALAR_H_ */
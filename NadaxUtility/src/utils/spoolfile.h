@@ -0,0 +1,180 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// spoolfile.h : Temporary file data is spooled to and read back memory mapped.
+//
+
+#ifndef SPOOLFILE_H_
+#define SPOOLFILE_H_
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/mman.h>
+
+#include <string>
+
+
+// Data is appended to an unnamed temporary file and once complete
+// is read back through a read-only memory mapping, so data of any
+// size can be held without growing the heap. The file is unlinked
+// as soon as it is created and so is removed with its last handle.
+class SpoolFile
+{
+public:
+	SpoolFile();
+	virtual ~SpoolFile();
+
+	// Creates the file in the given directory or, if NULL,
+	// in the directory given by TMPDIR or /tmp
+	bool create(const char* directory = NULL);
+
+	bool write(const void* data, size_t size);
+
+	// Maps the data written so far. The mapping is terminated
+	// by a null character which is not included in the size.
+	const char* map();
+
+	size_t getSize();
+
+	// Descriptor of the file for reading it as a stream. Its
+	// offset is at the end of the data so it should be read
+	// with pread or after seeking to the beginning.
+	int getFile();
+
+private:
+
+	int m_fd;
+	size_t m_size;
+
+	void* m_map;
+	size_t m_mapSize;
+	size_t m_mappedSize;
+};
+
+
+// **** Implementation ***
+
+inline SpoolFile::SpoolFile()
+{
+	m_fd = -1;
+	m_size = 0;
+
+	m_map = NULL;
+	m_mapSize = 0;
+	m_mappedSize = 0;
+}
+
+inline SpoolFile::~SpoolFile()
+{
+	if (m_map)
+		munmap(m_map, m_mapSize);
+	if (m_fd != -1)
+		close(m_fd);
+}
+
+inline bool SpoolFile::create(const char* directory)
+{
+	if (!directory)
+		directory = getenv("TMPDIR");
+
+	std::string path(directory && *directory ? directory : "/tmp");
+	path += "/spool.XXXXXX";
+
+	m_fd = mkstemp(&path[0]);
+	if (m_fd == -1)
+		return false;
+
+	unlink(path.c_str());
+	return true;
+}
+
+inline bool SpoolFile::write(const void* data, size_t size)
+{
+	const char* bytes = (const char *) data;
+
+	while (size)
+	{
+		ssize_t written = ::write(m_fd, bytes, size);
+		if (written == -1)
+		{
+			if (errno == EINTR)
+				continue;
+
+			return false;
+		}
+
+		bytes += written;
+		size -= written;
+		m_size += written;
+	}
+
+	return true;
+}
+
+inline const char* SpoolFile::map()
+{
+	if (m_map && m_mappedSize == m_size)
+		return (const char *) m_map;
+
+	if (m_map)
+	{
+		munmap(m_map, m_mapSize);
+		m_map = NULL;
+	}
+
+	// The data is mapped over a zeroed anonymous mapping that
+	// extends at least one byte past its end which terminates
+	// it without writing to the file
+	size_t page = (size_t) sysconf(_SC_PAGESIZE);
+	size_t mapSize = (m_size / page + 1) * page;
+
+	void* map = mmap(NULL, mapSize, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (map == MAP_FAILED)
+		return NULL;
+
+	if (m_size && mmap(map, m_size, PROT_READ, MAP_SHARED | MAP_FIXED, m_fd, 0) == MAP_FAILED)
+	{
+		munmap(map, mapSize);
+		return NULL;
+	}
+
+	m_map = map;
+	m_mapSize = mapSize;
+	m_mappedSize = m_size;
+
+	return (const char *) m_map;
+}
+
+inline size_t SpoolFile::getSize()
+{
+	return m_size;
+}
+
+inline int SpoolFile::getFile()
+{
+	return m_fd;
+}
+
+#endif /* SPOOLFILE_H_ */
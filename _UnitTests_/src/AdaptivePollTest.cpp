@@ -0,0 +1,63 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <iostream>
+
+#include <boost/test/unit_test.hpp>
+
+#include "hash.h"
+#include "Service.h"
+
+BOOST_AUTO_TEST_CASE( adaptive_poll_test ) {
+
+	std::cout << std::endl << "Begin adaptive poll tests..." << std::endl;
+
+	// Known FNV-1a 64 bit hash values
+	BOOST_REQUIRE_MESSAGE(fnv1a64("", 0) == 0xcbf29ce484222325ULL, "FNV-1a hash of empty data is not consistent.");
+	BOOST_REQUIRE_MESSAGE(fnv1a64("a", 1) == 0xaf63dc4c8601ec8cULL, "FNV-1a hash is not consistent.");
+	BOOST_REQUIRE_MESSAGE(fnv1a64("bar", 3, fnv1a64("foo", 3)) == fnv1a64("foobar", 6), "Incremental FNV-1a hash is not consistent.");
+
+	mb::P2PMessage message;
+	BOOST_REQUIRE_MESSAGE(!message.isAdaptivePoll(), "Message is an adaptive poll before a delay is set.");
+
+	message.setDelay(100);
+	BOOST_REQUIRE_MESSAGE(!message.isAdaptivePoll(), "Fixed delay message is an adaptive poll.");
+
+	message.setAdaptiveDelay(100, 1000, 2.0);
+	BOOST_REQUIRE_MESSAGE(message.isAdaptivePoll(), "Message is not an adaptive poll.");
+	BOOST_REQUIRE_MESSAGE(message.getDelayInterval() == 100, "Adaptive poll does not start at the min delay.");
+
+	BOOST_REQUIRE_MESSAGE(message.updateContentHash(1), "First poll response was not a change.");
+	BOOST_REQUIRE_MESSAGE(message.getDelayInterval() == 100, "Poll delay changed on first response.");
+
+	long delays[] = { 200, 400, 800, 1000, 1000 };
+	for (int i = 0; i < 5; i++) {
+
+		BOOST_REQUIRE_MESSAGE(!message.updateContentHash(1), "Unchanged poll response was a change.");
+		BOOST_REQUIRE_MESSAGE(message.getDelayInterval() == delays[i], "Poll delay did not back off.");
+	}
+
+	BOOST_REQUIRE_MESSAGE(message.updateContentHash(2), "Changed poll response was not a change.");
+	BOOST_REQUIRE_MESSAGE(message.getDelayInterval() == 100, "Poll delay did not reset to the min on change.");
+
+	std::cout << std::endl << "End adaptive poll tests..." << std::endl;
+}
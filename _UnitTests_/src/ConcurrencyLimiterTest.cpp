@@ -0,0 +1,119 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <iostream>
+
+#include <boost/test/unit_test.hpp>
+
+#include "log.h"
+
+#include "ConcurrencyLimiter.h"
+
+boost::mutex _countersLock;
+
+int _running = 0;
+int _maxRunning = 0;
+int _finished = 0;
+int _rejected = 0;
+
+int counter(int* value) {
+
+	boost::lock_guard<boost::mutex> lock(_countersLock);
+	return *value;
+}
+
+bool limitedTask(long millis, bool result) {
+
+	{ boost::lock_guard<boost::mutex> lock(_countersLock);
+
+		if (++_running > _maxRunning)
+			_maxRunning = _running;
+	}
+
+	boost::this_thread::sleep(boost::posix_time::milliseconds(millis));
+
+	{ boost::lock_guard<boost::mutex> lock(_countersLock);
+
+		_running--;
+		_finished++;
+	}
+	return result;
+}
+
+void rejectedTask() {
+
+	boost::lock_guard<boost::mutex> lock(_countersLock);
+	_rejected++;
+}
+
+BOOST_AUTO_TEST_CASE( concurrency_limiter_test ) {
+
+	std::cout << std::endl << "Begin concurrency limiter tests..." << std::endl;
+
+	boost::shared_ptr<Executor> executor(new Executor(8));
+	mb::NameValueMap metrics;
+
+	// Limit of 2 with room for 3 queued requests should execute
+	// 5 of the 8 submitted requests and shed the remaining 3
+
+	mb::http::ConcurrencyLimiter limiter(2, 1, 4, 3, 0);
+
+	for (int i = 0; i < 8; i++)
+		limiter.submit(executor, boost::bind(limitedTask, 200, true), rejectedTask);
+
+	while (counter(&_finished) + counter(&_rejected) < 8)
+		boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+
+	limiter.getMetrics(metrics);
+	std::cout << "Max concurrent requests = " << _maxRunning <<
+		", shed = " << metrics["concurrency.shed"] << std::endl;
+
+	BOOST_REQUIRE_MESSAGE(_maxRunning < 4, "Concurrent requests exceeded the concurrency limit.");
+	BOOST_REQUIRE_MESSAGE(_finished == 5, "Queued requests were not executed.");
+	BOOST_REQUIRE_MESSAGE(_rejected == 3, "Requests exceeding the queue size were not shed.");
+	BOOST_REQUIRE_MESSAGE(metrics["concurrency.shed"] == "3", "Shed count metric is not consistent.");
+	BOOST_REQUIRE_MESSAGE(metrics["concurrency.inFlight"] == "0", "In flight count metric is not consistent.");
+
+	// Failed requests should back off the limit to the minimum
+
+	mb::http::ConcurrencyLimiter backoff(4, 1, 4, 10, 0);
+	backoff.setBackoffRatio(0.5);
+
+	for (int i = 0; i < 3; i++) {
+
+		int finished = counter(&_finished);
+		backoff.submit(executor, boost::bind(limitedTask, 10, false), rejectedTask);
+
+		while (counter(&_finished) == finished)
+			boost::this_thread::sleep(boost::posix_time::milliseconds(20));
+		boost::this_thread::sleep(boost::posix_time::milliseconds(20));
+	}
+
+	metrics.clear();
+	backoff.getMetrics(metrics);
+	std::cout << "Concurrency limit after failures = " << metrics["concurrency.limit"] << std::endl;
+
+	BOOST_REQUIRE_MESSAGE(metrics["concurrency.limit"] == "1", "Concurrency limit did not back off on failures.");
+	BOOST_REQUIRE_MESSAGE(metrics["concurrency.failed"] == "3", "Failed count metric is not consistent.");
+
+	std::cout << std::endl << "End concurrency limiter tests..." << std::endl;
+}
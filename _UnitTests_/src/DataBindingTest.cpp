@@ -176,6 +176,89 @@ BOOST_AUTO_TEST_CASE( xml_data_binder ) {
 	fclose(file);
 }
 
+class AttributeTestBinder : public DataBinder {
+
+public:
+	AttributeTestBinder() {
+		DataBinder::addBeginRule("items/item", beginItemView);
+		DataBinder::addBeginRule("items/item", beginItemMap);
+		DataBinder::addEndRule("items/item/@id", endItemId);
+		DataBinder::addEndRule("items/item", endItem);
+	}
+
+	static void beginItemView(void* binder, const char *element, const Attributes& attribs) {
+
+		GET_BINDER(AttributeTestBinder);
+
+		dataBinder->viewValue = attribs.get("id", "");
+		dataBinder->viewSize = attribs.size();
+
+		BOOST_CHECK_MESSAGE(!attribs.has("missing"), "An attribute that was not given was found.");
+		BOOST_CHECK_MESSAGE(strcmp(attribs.get("missing", "none"), "none") == 0, "The default of a missing attribute was not returned.");
+	}
+
+	static void beginItemMap(void* binder, const char *element, std::map<std::string, std::string>& attribs) {
+
+		GET_BINDER(AttributeTestBinder);
+		dataBinder->mapValue = attribs["id"];
+	}
+
+	static void endItemId(void* binder, const char *element, const char *body) {
+
+		GET_BINDER(AttributeTestBinder);
+		dataBinder->ids.push_back(body);
+	}
+
+	static void endItem(void* binder, const char *element, const char *body) {
+
+		GET_BINDER(AttributeTestBinder);
+		dataBinder->bodies.push_back(body);
+	}
+
+	std::string viewValue;
+	int viewSize;
+
+	std::string mapValue;
+
+	std::vector<std::string> ids;
+	std::vector<std::string> bodies;
+};
+
+BOOST_AUTO_TEST_CASE( xml_data_binder_attributes ) {
+
+	AttributeTestBinder dataBinder;
+
+	const char* noAttribs[] = { NULL };
+	const char* itemAttribs[] = { "type", "a", "id", "1", NULL };
+	const char* otherAttribs[] = { "id", "2", NULL };
+
+	dataBinder.startElement("items", noAttribs);
+
+	dataBinder.startElement("item", itemAttribs);
+	BOOST_CHECK_MESSAGE(dataBinder.viewValue == "1" && dataBinder.viewSize == 2, "The attribute view did not give the attributes.");
+	BOOST_CHECK_MESSAGE(dataBinder.mapValue == "1", "The attribute map was not built for a map rule.");
+	dataBinder.characters(" \n\t body one \r\n", 15);
+	dataBinder.endElement("item");
+
+	// Attributes and bodies of elements without rules are not bound
+	dataBinder.startElement("other", otherAttribs);
+	dataBinder.characters("ignored", 7);
+	dataBinder.endElement("other");
+
+	dataBinder.startElement("ns:item", otherAttribs);
+	dataBinder.characters("two", 3);
+	dataBinder.endElement("ns:item");
+
+	dataBinder.endElement("items");
+
+	BOOST_REQUIRE_MESSAGE(dataBinder.ids.size() == 2, "Attribute rules did not fire for each item.");
+	BOOST_CHECK(dataBinder.ids[0] == "1" && dataBinder.ids[1] == "2");
+
+	BOOST_REQUIRE_MESSAGE(dataBinder.bodies.size() == 2, "End rules did not fire for each item.");
+	BOOST_CHECK_MESSAGE(dataBinder.bodies[0] == "body one", "The body was not trimmed.");
+	BOOST_CHECK_MESSAGE(dataBinder.bodies[1] == "two", "The body of the previous element was not cleared.");
+}
+
 BOOST_AUTO_TEST_CASE( xml_generic_data_binding ) {
 
 	// Test Dyna Model Creation and Accessing
@@ -0,0 +1,266 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <string.h>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+#include <boost/test/unit_test.hpp>
+
+#include "clock.h"
+
+#include "DynaModel.h"
+#include "XmlStreamParser.h"
+
+#define COLUMN_TEST_ITEMS   20000
+#define COLUMN_TEST_SCANS   10
+
+using namespace binding;
+using namespace parser;
+
+
+bool sameModel(DynaModelNode model, DynaModelNode other);
+DynaModelNode bindDynaModel(XmlBinder& xmlBinder, DynaModelBinder& dynaBinder, const std::string& document, size_t chunkSize);
+
+
+const char* _columnTestXml =
+	"<items>"
+	"<item id=\"a\"><name>Apple</name><qty>7</qty><price>1.25</price><status>active</status></item>"
+	"<item id=\"b\"><name>Banana</name><qty>12</qty><price>0.5</price><status>inactive</status></item>"
+	"<item id=\"c\"><name>Cherry</name><qty>-3</qty><price>4</price></item>"
+	"<item id=\"d\"><name>Date</name><qty>0</qty><price>2.75</price><status>active</status></item>"
+	"</items>";
+
+void addColumnBindings(DynaModelBinder& dynaBinder) {
+
+	dynaBinder.addBinding("items/item", DynaModel::LIST, "items");
+	dynaBinder.addBinding("items/item/@id", "id", true);
+	dynaBinder.addBinding("items/item/name", "name");
+	dynaBinder.addBinding("items/item/qty", "qty", DynaModel::VAL_INT64);
+	dynaBinder.addBinding("items/item/price", "price", DynaModel::VAL_DOUBLE);
+	dynaBinder.addBinding("items/item/status", "status");
+}
+
+DynaModelNode bindColumnModel(const std::string& xml, bool compact, bool columnar) {
+
+	DynaModelBinder dynaBinder;
+	dynaBinder.setCompact(compact);
+	dynaBinder.setColumnar(columnar);
+	addColumnBindings(dynaBinder);
+
+	XmlBinder xmlBinder(&dynaBinder);
+	xmlBinder.initialize();
+
+	return bindDynaModel(xmlBinder, dynaBinder, xml, 64);
+}
+
+BOOST_AUTO_TEST_CASE( dynamodel_column_test ) {
+
+	std::cout << std::endl << "Begin dyna model column tests..." << std::endl;
+
+	std::string xml = _columnTestXml;
+
+	DynaModelNode model = bindColumnModel(xml, true, true);
+	DynaModelNode rowModel = bindColumnModel(xml, true, false);
+	DynaModelNode heapModel = bindColumnModel(xml, false, true);
+
+	// Rows in columns are read like any other map
+	BOOST_CHECK_MESSAGE(sameModel(model, heapModel), "The columnar model was not bound like the heap model: \n" << model);
+	BOOST_CHECK(sameModel(model, rowModel));
+
+	std::ostringstream json, rowJson;
+	json << model;
+	rowJson << rowModel;
+	BOOST_CHECK_MESSAGE(json.str() == rowJson.str(), json.str());
+
+	DynaModelNode items = model->get("items");
+	BOOST_REQUIRE(items.get() && items->size() == 4);
+
+	DynaModelNode b = items->get((unsigned int) 1);
+	BOOST_CHECK(items->get("b").get() == b.get());
+	BOOST_CHECK_EQUAL(b->size(), 5);
+	BOOST_CHECK_EQUAL(b->get("name")->value(), "Banana");
+	BOOST_CHECK_EQUAL(b->get(2)->intValue(), 12);
+	BOOST_CHECK_EQUAL(b->keys().front(), "id");
+	BOOST_CHECK(b->containsKey("status") && !items->get("c")->containsKey("status"));
+	BOOST_CHECK_EQUAL(items->get("c")->size(), 4);
+	BOOST_CHECK(b->getDocument() == model->getDocument());
+
+	// Columns are only kept for lists of compact models
+	DynaModelColumn column;
+	BOOST_CHECK(!heapModel->get("items")->getColumn("qty", column));
+	BOOST_CHECK(!rowModel->get("items")->getColumn("qty", column));
+	BOOST_CHECK(!items->getColumn("weight", column));
+
+	BOOST_REQUIRE(items->getColumn("qty", column));
+	BOOST_CHECK(column.getType() == DynaModel::VAL_INT64);
+	BOOST_REQUIRE_EQUAL(column.size(), 4);
+
+	long long qty = 0;
+	for (DynaModelColumn::Iterator cell = column.begin(); cell != column.end(); ++cell)
+		qty += cell.intValue();
+
+	BOOST_CHECK_EQUAL(qty, 16);
+	BOOST_CHECK_EQUAL(column.integers()[2], -3);
+	BOOST_CHECK_EQUAL(column.value(2), "-3");
+
+	BOOST_REQUIRE(items->getColumn("price", column));
+	BOOST_CHECK(column.getType() == DynaModel::VAL_DOUBLE);
+	BOOST_CHECK_EQUAL(column.reals()[3], 2.75);
+	BOOST_CHECK_EQUAL(column.doubleValue(0), 1.25);
+
+	// Repeated strings are kept once in the dictionary of a column
+	BOOST_REQUIRE(items->getColumn("status", column));
+	BOOST_CHECK(column.getType() == DynaModel::VAL_STRING);
+	BOOST_CHECK_EQUAL(column.dictionarySize(), 3);
+	BOOST_CHECK(!column.hasValue(2) && column.value(2) == NULL);
+	BOOST_CHECK_EQUAL(column.value(3), "active");
+	BOOST_CHECK(column.codes()[0] == column.codes()[3]);
+	BOOST_CHECK(items->get("a")->get("status").get() == items->get("d")->get("status").get());
+
+	// Columns keep the document of the list
+	items.reset();
+	model.reset();
+	BOOST_CHECK_EQUAL(column.value(1), "inactive");
+
+	// Rows that do not match the columns of the first row
+	// are kept as maps and the list is no longer columnar
+	std::string mixedXml =
+		"<items>"
+		"<item id=\"a\"><name>Apple</name><qty>7</qty></item>"
+		"<item id=\"b\"><name>Banana</name><qty>many</qty></item>"
+		"<item id=\"c\"><qty>2</qty><name>Cherry</name></item>"
+		"</items>";
+
+	model = bindColumnModel(mixedXml, true, true);
+	items = model->get("items");
+
+	BOOST_CHECK(sameModel(model, bindColumnModel(mixedXml, false, false)));
+	BOOST_CHECK(!items->getColumn("name", column));
+	BOOST_CHECK_EQUAL(items->get("b")->get("qty")->value(), "many");
+	BOOST_CHECK_EQUAL(items->get((unsigned int) 2)->get("name")->value(), "Cherry");
+
+	// Rows changed after they were bound are moved out of the columns
+	model = bindColumnModel(xml, true, true);
+	items = model->get("items");
+
+	DynaModelNode d = items->get("d");
+	BOOST_REQUIRE(items->getColumn("name", column));
+
+	d->setValue("name", "Durian");
+	BOOST_CHECK(!items->getColumn("name", column));
+	BOOST_CHECK_EQUAL(d->get("name")->value(), "Durian");
+	BOOST_CHECK_EQUAL(d->get("qty")->intValue(1), 0);
+	BOOST_CHECK_EQUAL(items->get("a")->get("name")->value(), "Apple");
+
+	// Lists that are changed directly are no longer columnar
+	model = bindColumnModel(xml, true, true);
+	items = model->get("items");
+
+	items->addValue("extra");
+	BOOST_CHECK(!items->getColumn("name", column));
+	BOOST_CHECK_EQUAL(items->size(), 5);
+
+	// Rows of lists created through the API
+	DynaModelNode list = DynaModel::createCompact()->createColumnarList();
+	for (int i = 0; i < 3; i++) {
+
+		std::ostringstream value;
+		value << i;
+
+		DynaModelNode row = list->createNode();
+		row->setValue("n", value.str().c_str());
+		list->add(row);
+	}
+
+	BOOST_REQUIRE(list->getColumn("n", column));
+	BOOST_CHECK_EQUAL(column.value(2), "2");
+	BOOST_CHECK_EQUAL(list->get(1)->get("n")->value(), "1");
+
+	std::cout << std::endl << "End dyna model column tests..." << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE( dynamodel_column_benchmark ) {
+
+	std::cout << std::endl << "Begin dyna model column benchmark..." << std::endl;
+
+	std::ostringstream xml;
+	xml << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<items>\n";
+
+	for (int i = 0; i < COLUMN_TEST_ITEMS; i++)
+		xml << "<item id=\"item-" << i << "\"><name>Item " << i % 100 << "</name><qty>" << i % 50 << "</qty><price>" <<
+			i % 1000 << ".25</price><status>" << (i % 3 ? "active" : "inactive") << "</status></item>\n";
+
+	xml << "</items>\n";
+
+	std::string document = xml.str();
+
+	long long expected = 0;
+	for (int i = 0; i < COLUMN_TEST_ITEMS; i++)
+		expected += i % 50;
+
+	size_t capacity[2];
+	long long scanTime[2];
+
+	for (int columnar = 0; columnar < 2; columnar++) {
+
+		DynaModelNode model = bindColumnModel(document, true, columnar != 0);
+		DynaModelNode items = model->get("items");
+		BOOST_REQUIRE_EQUAL(items->size(), COLUMN_TEST_ITEMS);
+
+		capacity[columnar] = model->getDocumentCapacity();
+
+		long long startTime = currentTimeMillis();
+
+		for (int scan = 0; scan < COLUMN_TEST_SCANS; scan++) {
+
+			long long qty = 0;
+			DynaModelColumn column;
+
+			if (items->getColumn("qty", column)) {
+
+				for (DynaModelColumn::Iterator cell = column.begin(); cell != column.end(); ++cell)
+					qty += cell.intValue();
+
+			} else {
+
+				for (int i = 0; i < COLUMN_TEST_ITEMS; i++)
+					qty += items->get(i)->get("qty")->intValue();
+			}
+
+			BOOST_REQUIRE_EQUAL(qty, expected);
+		}
+
+		scanTime[columnar] = currentTimeMillis() - startTime;
+	}
+
+	std::cout << "Bound " << COLUMN_TEST_ITEMS << " items to rows in " << capacity[0] / 1024 << " KB scanned " <<
+		COLUMN_TEST_SCANS << " times in " << scanTime[0] << " ms" << std::endl;
+	std::cout << "Bound " << COLUMN_TEST_ITEMS << " items to columns in " << capacity[1] / 1024 << " KB scanned " <<
+		COLUMN_TEST_SCANS << " times in " << scanTime[1] << " ms" << std::endl;
+
+	BOOST_CHECK_MESSAGE(capacity[1] < capacity[0], "Columns did not hold less memory than rows.");
+	BOOST_CHECK_MESSAGE(scanTime[1] <= scanTime[0], "Columns were not scanned faster than rows.");
+
+	std::cout << std::endl << "End dyna model column benchmark..." << std::endl;
+}
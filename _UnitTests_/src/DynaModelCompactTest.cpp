@@ -0,0 +1,380 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <new>
+
+#include <boost/test/unit_test.hpp>
+
+#include "clock.h"
+#include "exception.h"
+
+#include "DynaModel.h"
+#include "XmlStreamParser.h"
+
+#define GENERIC_BINDING_TEST  "./data/generic_binding_test.xml"
+
+#define COMPACT_TEST_KEYS       100
+#define COMPACT_TEST_ITEMS      20000
+#define COMPACT_TEST_DOCUMENTS  5
+#define COMPACT_TEST_CHUNK      16384
+
+using namespace binding;
+using namespace parser;
+
+
+std::string readFile(const char* path);
+void addGenericBindings(DynaModelBinder& dynaBinder);
+
+
+// Bytes allocated with new and not yet deleted, which
+// are counted to compare the memory held by models
+static long _allocatedBytes = 0;
+
+#define BLOCK_HEADER  16
+
+void* operator new(size_t size) {
+
+	char* block = (char *) malloc(size + BLOCK_HEADER);
+	if (!block)
+		throw std::bad_alloc();
+
+	*((size_t *) block) = size;
+	__sync_fetch_and_add(&_allocatedBytes, (long) size);
+
+	return block + BLOCK_HEADER;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) throw() {
+
+	try {
+		return operator new(size);
+	} catch (...) {
+		return NULL;
+	}
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& nothrow) throw() {
+	return operator new(size, nothrow);
+}
+
+void operator delete(void* data) throw() {
+
+	if (data) {
+
+		char* block = (char *) data - BLOCK_HEADER;
+		__sync_fetch_and_sub(&_allocatedBytes, (long) *((size_t *) block));
+
+		free(block);
+	}
+}
+
+// Called with the size by code compiled for C++14
+void operator delete(void* data, size_t size) throw() {
+	operator delete(data);
+}
+
+void operator delete[](void* data, size_t size) throw() {
+	operator delete(data);
+}
+
+void operator delete(void* data, const std::nothrow_t&) throw() {
+	operator delete(data);
+}
+
+void operator delete[](void* data) throw() {
+	operator delete(data);
+}
+
+void operator delete[](void* data, const std::nothrow_t&) throw() {
+	operator delete(data);
+}
+
+
+bool sameModel(DynaModelNode model, DynaModelNode other) {
+
+	if (!model.get() || !other.get())
+		return model.get() == other.get();
+
+	if (model->getType() != other->getType() || model->size() != other->size())
+		return false;
+
+	if (model->getType() == DynaModel::VALUE)
+		return strcmp(model->value(), other->value()) == 0;
+
+	std::list<std::string> keys = model->keys();
+	if (keys.size() != other->keys().size())
+		return false;
+
+	for (std::list<std::string>::iterator key = keys.begin(); key != keys.end(); key++)
+		if (!sameModel(model->get(key->c_str()), other->get(key->c_str())))
+			return false;
+
+	for (int i = 0; i < model->size(); i++)
+		if (!sameModel(model->get(i), other->get(i)))
+			return false;
+
+	return true;
+}
+
+void buildTestModel(DynaModelNode node) {
+
+	DynaModelNode test1 = node->add("test1");
+	DynaModelNode test2 = node->add("test2", DynaModel::LIST);
+
+	DynaModelNode test11A = test1->add("test11", DynaModel::LIST);
+	DynaModelNode test11Ai = test11A->add();
+	test11Ai->setValue("aa1", "111");
+	test11Ai->setValue("bb1", "122");
+	test11Ai->setValue("cc1", "133");
+	test11Ai = test11A->add();
+	test11Ai->setValue("aa2", "211");
+	test11Ai->setValue("bb2", "222");
+	test11Ai->setValue("cc2", "233");
+
+	test2->addValue("test2_0");
+	test2->addValue("test2_1");
+	test2->addValue("test2_2");
+	test2->addValue("test2_3");
+}
+
+DynaModelNode bindDynaModel(XmlBinder& xmlBinder, DynaModelBinder& dynaBinder, const std::string& document, size_t chunkSize) {
+
+	for (size_t i = 0; i < document.length(); i += chunkSize)
+		xmlBinder.parse(document.c_str() + i, (int) std::min(chunkSize, document.length() - i), false);
+	xmlBinder.parse("", 0, true);
+
+	DynaModelNode root = dynaBinder.getRootPtr();
+
+	xmlBinder.reset();
+	return root;
+}
+
+void addItemBindings(DynaModelBinder& dynaBinder) {
+
+	dynaBinder.addBinding("items/item", DynaModel::LIST, "items");
+	dynaBinder.addBinding("items/item/@id", "id", true);
+	dynaBinder.addBinding("items/item/name", "name");
+	dynaBinder.addBinding("items/item/value", "value");
+	dynaBinder.addBinding("items/item/status", "status");
+}
+
+BOOST_AUTO_TEST_CASE( dynamodel_compact_test ) {
+
+	std::cout << std::endl << "Begin compact dyna model tests..." << std::endl;
+
+	// The API works the same on compact and heap models
+	DynaModelNode node = DynaModel::createCompact();
+	DynaModelNode heapNode = DynaModel::create();
+	buildTestModel(node);
+	buildTestModel(heapNode);
+
+	BOOST_CHECK(sameModel(node, heapNode));
+	BOOST_CHECK(node->getDocument() != NULL);
+	BOOST_CHECK(heapNode->getDocument() == NULL);
+	BOOST_CHECK(node->getDocumentCapacity() > 0);
+
+	std::ostringstream json;
+	json << node;
+	BOOST_CHECK_MESSAGE(json.str() ==
+		"{\"test1\":{\"test11\":[{\"aa1\":\"111\",\"bb1\":\"122\",\"cc1\":\"133\"},{\"aa2\":\"211\",\"bb2\":\"222\",\"cc2\":\"233\"}]},"
+		"\"test2\":[\"test2_0\",\"test2_1\",\"test2_2\",\"test2_3\"]}", json.str());
+
+	// Keys are kept in the order they were added
+	std::list<std::string> keys = node->keys();
+	BOOST_REQUIRE_EQUAL(keys.size(), 2);
+	BOOST_CHECK_EQUAL(keys.front(), "test1");
+	BOOST_CHECK(node->containsKey("test2"));
+	BOOST_CHECK(!node->containsKey("test3"));
+	BOOST_CHECK(node->get("aa1").get() == NULL);
+
+	// Values are replaced in place and replaced by nodes
+	DynaModelNode item = node->get("test1")->get("test11")->get((unsigned int) 0);
+	BOOST_REQUIRE(item.get());
+	item->setValue("bb1", "changed");
+	BOOST_CHECK_EQUAL(item->size(), 3);
+	BOOST_CHECK_EQUAL(item->get(1)->value(), "changed");
+
+	DynaModelNode replaced = item->add("aa1", DynaModel::LIST);
+	BOOST_CHECK(replaced->getType() == DynaModel::LIST);
+	BOOST_CHECK(item->get("aa1").get() == replaced.get());
+	BOOST_CHECK(item->add("aa1").get() == replaced.get());
+
+	// Nodes added with an existing key are moved to the end
+	DynaModelNode moved = node->createNode(DynaModel::MAP);
+	node->add(moved, "test1");
+	BOOST_CHECK_EQUAL(node->size(), 2);
+	BOOST_CHECK(node->get(1).get() == moved.get());
+	BOOST_CHECK(node->get("test1").get() == moved.get());
+	BOOST_CHECK(moved->getDocument() == node->getDocument());
+
+	// Maps with many keys are indexed
+	DynaModelNode large = node->add("large");
+
+	for (int i = 0; i < COMPACT_TEST_KEYS; i++) {
+
+		std::ostringstream key, value;
+		key << "key" << i;
+		value << i;
+		large->setValue(key.str().c_str(), value.str().c_str());
+	}
+
+	large->add(DynaModel::createCompact(), "key5");
+
+	BOOST_REQUIRE_EQUAL(large->size(), COMPACT_TEST_KEYS);
+	BOOST_CHECK(large->get("key5")->getType() == DynaModel::MAP);
+
+	for (int i = 0; i < COMPACT_TEST_KEYS; i++) {
+
+		std::ostringstream key, value;
+		key << "key" << i;
+		value << i;
+
+		BOOST_REQUIRE(large->containsKey(key.str().c_str()));
+		if (i != 5)
+			BOOST_REQUIRE_EQUAL(large->get(key.str().c_str())->value(), value.str());
+	}
+
+	BOOST_CHECK(!large->containsKey("key100"));
+
+	// Nodes of other documents and heap nodes are kept alive
+	{
+		DynaModelNode heap = DynaModel::create();
+		heap->setValue("h", "1");
+		node->add(heap, "heap");
+		BOOST_CHECK(node->get("heap").get() == heap.get());
+
+		DynaModelNode other = DynaModel::createCompact();
+		other->setValue("o", "2");
+		node->add(other, "other");
+	}
+
+	BOOST_CHECK_EQUAL(node->get("heap")->get("h")->value(), "1");
+	BOOST_CHECK_EQUAL(node->get("other")->get("o")->value(), "2");
+
+	// Nodes keep their document when the root is released
+	DynaModelNode test2 = node->get("test2");
+	node.reset();
+	BOOST_CHECK_EQUAL(test2->get(3)->value(), "test2_3");
+
+	// Maps and lists are used as with heap models
+	BOOST_CHECK_THROW(test2->setValue("a", "b"), CException*);
+	BOOST_CHECK_THROW(test2->add("a"), CException*);
+	BOOST_CHECK_THROW(item->add(), CException*);
+	BOOST_CHECK_THROW(item->addValue("a"), CException*);
+
+	// Bound models are compact by default
+	std::string document = readFile(GENERIC_BINDING_TEST);
+
+	DynaModelBinder compactBinder;
+	addGenericBindings(compactBinder);
+	XmlBinder compactXmlBinder(&compactBinder);
+	compactXmlBinder.initialize();
+
+	DynaModelBinder heapBinder;
+	heapBinder.setCompact(false);
+	addGenericBindings(heapBinder);
+	XmlBinder heapXmlBinder(&heapBinder);
+	heapXmlBinder.initialize();
+
+	DynaModelNode compactModel = bindDynaModel(compactXmlBinder, compactBinder, document, 64);
+	DynaModelNode heapModel = bindDynaModel(heapXmlBinder, heapBinder, document, 64);
+
+	BOOST_CHECK(compactModel->getDocument() != NULL);
+	BOOST_CHECK(heapModel->getDocument() == NULL);
+	BOOST_CHECK(compactModel->get("summary")->size() > 0);
+	BOOST_CHECK_MESSAGE(sameModel(compactModel, heapModel), "The compact model was not bound like the heap model: \n" << compactModel);
+
+	std::cout << std::endl << "End compact dyna model tests..." << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE( dynamodel_compact_benchmark ) {
+
+	std::cout << std::endl << "Begin compact dyna model benchmark..." << std::endl;
+
+	std::ostringstream xml;
+	xml << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<items>\n";
+
+	for (int i = 0; i < COMPACT_TEST_ITEMS; i++)
+		xml << "<item id=\"item-" << i << "\"><name>Item " << i << " with a longer description</name><value>" <<
+			i * 10 << "</value><status>" << (i % 3 ? "active" : "inactive") << "</status></item>\n";
+
+	xml << "</items>\n";
+
+	std::string document = xml.str();
+	DynaModelNode models[2];
+	long modelBytes[2];
+
+	for (int compact = 0; compact < 2; compact++) {
+
+		DynaModelBinder dynaBinder;
+		dynaBinder.setCompact(compact != 0);
+		addItemBindings(dynaBinder);
+
+		XmlBinder xmlBinder(&dynaBinder);
+		xmlBinder.initialize();
+
+		// The first document grows the buffers of the binder
+		bindDynaModel(xmlBinder, dynaBinder, document, COMPACT_TEST_CHUNK);
+
+		long allocatedBytes = _allocatedBytes;
+		models[compact] = bindDynaModel(xmlBinder, dynaBinder, document, COMPACT_TEST_CHUNK);
+		modelBytes[compact] = _allocatedBytes - allocatedBytes + (long) models[compact]->getDocumentCapacity();
+
+		long long start = currentTimeMicros();
+
+		for (int i = 0; i < COMPACT_TEST_DOCUMENTS; i++)
+			BOOST_REQUIRE_EQUAL(bindDynaModel(xmlBinder, dynaBinder, document, COMPACT_TEST_CHUNK)->get("items")->size(), COMPACT_TEST_ITEMS);
+
+		long long bindTime = (currentTimeMicros() - start) / COMPACT_TEST_DOCUMENTS;
+
+		DynaModelNode items = models[compact]->get("items");
+		long total = 0;
+
+		start = currentTimeMicros();
+
+		for (int i = 0; i < COMPACT_TEST_ITEMS; i++)
+			total += atol(items->get(i)->get("value")->value());
+
+		long long accessTime = currentTimeMicros() - start;
+
+		BOOST_CHECK_EQUAL(total, 10L * COMPACT_TEST_ITEMS * (COMPACT_TEST_ITEMS - 1) / 2);
+		BOOST_CHECK(items->get("item-7")->get("status")->value() == std::string("active"));
+
+		std::cout << "\t" << (compact ? "compact: " : "heap:    ") << std::fixed << std::setprecision(1) <<
+			modelBytes[compact] / 1024.0 << " KB held, " << bindTime / 1000.0 << " ms to bind and " <<
+			accessTime / 1000.0 << " ms to read " << COMPACT_TEST_ITEMS << " items" << std::endl;
+	}
+
+	BOOST_CHECK(sameModel(models[0], models[1]));
+	BOOST_CHECK_MESSAGE(modelBytes[1] < modelBytes[0], "The compact model does not hold less memory than the heap model.");
+
+	std::cout << std::endl << "End compact dyna model benchmark..." << std::endl;
+}
@@ -0,0 +1,76 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <iostream>
+
+#include <boost/test/unit_test.hpp>
+
+#include "HedgingPolicy.h"
+
+BOOST_AUTO_TEST_CASE( hedging_policy_test ) {
+
+	std::cout << std::endl << "Begin hedging policy tests..." << std::endl;
+
+	mb::http::LatencyWindow window(10);
+
+	BOOST_REQUIRE_MESSAGE(window.percentile(90, 1) == -1, "Empty latency window returned a percentile.");
+
+	for (int i = 1; i <= 20; i++)
+		window.add(i * 1000);
+
+	// Only the last 10 samples (11..20 ms) should be in the window
+	BOOST_REQUIRE_MESSAGE(window.size() == 10, "Latency window did not slide.");
+	BOOST_REQUIRE_MESSAGE(window.percentile(0, 1) == 11000, "Latency window minimum is not consistent.");
+	BOOST_REQUIRE_MESSAGE(window.percentile(100, 1) == 20000, "Latency window maximum is not consistent.");
+	BOOST_REQUIRE_MESSAGE(window.percentile(50, 1) == 16000, "Latency window median is not consistent.");
+
+	// Budget of 50% allows one hedge for every two requests
+
+	mb::http::HedgingPolicy policy(90, 5, 100, 50, 1, 100);
+
+	BOOST_REQUIRE_MESSAGE(policy.beginRequest() == -1, "Request hedged without enough latency samples.");
+
+	for (int i = 1; i <= 100; i++)
+		policy.recordLatency(i * 1000);
+
+	long delay = policy.beginRequest();
+	std::cout << "Hedge delay for p90 = " << delay << " ms" << std::endl;
+	BOOST_REQUIRE_MESSAGE(delay == 90, "Hedge delay does not match p90 latency.");
+
+	BOOST_REQUIRE_MESSAGE(policy.acquireHedge(), "Hedge denied with budget available.");
+	BOOST_REQUIRE_MESSAGE(!policy.acquireHedge(), "Hedge allowed beyond budget.");
+
+	policy.beginRequest();
+	policy.beginRequest();
+	BOOST_REQUIRE_MESSAGE(policy.acquireHedge(), "Budget was not replenished by requests.");
+	policy.recordHedgeWin();
+
+	mb::NameValueMap metrics;
+	policy.getMetrics(metrics);
+
+	std::cout << "Hedge rate = " << metrics["hedging.hedgeRate"] << ", win rate = " << metrics["hedging.winRate"] << std::endl;
+	BOOST_REQUIRE_MESSAGE(metrics["hedging.hedges"] == "2", "Hedge count metric is not consistent.");
+	BOOST_REQUIRE_MESSAGE(metrics["hedging.wins"] == "1", "Hedge win count metric is not consistent.");
+	BOOST_REQUIRE_MESSAGE(metrics["hedging.denied"] == "1", "Denied hedge count metric is not consistent.");
+
+	std::cout << std::endl << "End hedging policy tests..." << std::endl;
+}
@@ -0,0 +1,178 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <iostream>
+#include <stdlib.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include "clock.h"
+
+#include "MessageBusManager.h"
+#include "ServiceConfigManager.h"
+#include "CurlHttpService.h"
+
+#include "LoopbackHttpServer.h"
+
+#define HTTP_BULKHEAD_TEST  "./data/http_bulkhead_test.xml"
+
+// Requests flooding the slow service
+#define SLOW_REQUESTS  6
+// Latency of the slow service
+#define SLOW_LATENCY   500
+
+
+struct BulkheadTestResponses {
+
+	BulkheadTestResponses() : responses(0), errors(0) { }
+
+	static void handleResponse(void* context, mb::MessagePtr message) {
+
+		if (message->getType() == mb::Message::MSG_RESP_STREAM)
+			((mb::StreamMessage *) message.get())->setCallback(context, readResponse);
+		else
+			((BulkheadTestResponses *) context)->complete(message);
+	}
+
+	static bool readResponse(void* context, mb::MessagePtr message, void* buffer, size_t size) {
+
+		if (!buffer)
+			((BulkheadTestResponses *) context)->complete(message);
+
+		return true;
+	}
+
+	void complete(mb::MessagePtr message) {
+
+		boost::lock_guard<boost::mutex> lock(this->lock);
+		responses++;
+		if (message->getError())
+			errors++;
+		done.notify_all();
+	}
+
+	bool wait(int count, long millis) {
+
+		boost::unique_lock<boost::mutex> lock(this->lock);
+		const boost::system_time timeout = boost::get_system_time() + boost::posix_time::milliseconds(millis);
+
+		while (responses < count)
+			if (!done.timed_wait(lock, timeout))
+				return (responses >= count);
+
+		return true;
+	}
+
+	boost::mutex lock;
+	boost::condition_variable done;
+
+	int responses;
+	int errors;
+};
+
+void postBulkheadRequest(const char* subject, BulkheadTestResponses* responses) {
+
+	mb::MessagePtr message = mb::MessageBusManager::instance()->createMessage(subject);
+	((mb::P2PMessage *) message.get())->setCallback(responses, BulkheadTestResponses::handleResponse);
+
+	BOOST_REQUIRE(mb::MessageBusManager::instance()->postMessage(message));
+}
+
+BOOST_AUTO_TEST_CASE( http_bulkhead_test ) {
+
+	std::cout << std::endl << "Begin HTTP bulkhead tests..." << std::endl;
+
+	LoopbackHttpServer::Config slowConfig;
+	slowConfig.latencyMean = SLOW_LATENCY;
+
+	LoopbackHttpServer::Config fastConfig;
+
+	LoopbackHttpServer slowServer(slowConfig);
+	LoopbackHttpServer fastServer(fastConfig);
+	slowServer.start();
+	fastServer.start();
+
+	mb::MessageBusManager::initialize();
+	mb::ServiceConfigManager::initialize();
+
+	mb::ServiceConfigManager* configManager = mb::ServiceConfigManager::instance();
+	configManager->addToken("LOOPBACK_SLOW_URL", slowServer.getUrl().c_str());
+	configManager->addToken("LOOPBACK_FAST_URL", fastServer.getUrl().c_str());
+	configManager->loadConfigFile(HTTP_BULKHEAD_TEST);
+
+	mb::MessageBusManager* manager = mb::MessageBusManager::instance();
+
+	// Flood the slow service so its group's threads and handles are exhausted
+	BulkheadTestResponses slowResponses;
+	for (int i = 0; i < SLOW_REQUESTS; i++)
+		postBulkheadRequest("bulkheadSlow", &slowResponses);
+
+	boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+
+	// Services in other groups are not held up by the slow service
+	BulkheadTestResponses fastResponses;
+	long long startTime = currentTimeMillis();
+
+	postBulkheadRequest("bulkheadFast", &fastResponses);
+	postBulkheadRequest("bulkheadShared", &fastResponses);
+
+	BOOST_REQUIRE_MESSAGE(fastResponses.wait(2, SLOW_LATENCY * 4), "No responses were received from the fast services.");
+	long long fastTime = currentTimeMillis() - startTime;
+
+	std::cout << "Fast services responded in " << fastTime << " ms while the slow service was flooded." << std::endl;
+
+	BOOST_CHECK_MESSAGE(fastTime < SLOW_LATENCY / 2, "The fast services were held up by the slow service's group.");
+	BOOST_CHECK_MESSAGE(fastResponses.errors == 0, "The fast services responded with errors.");
+
+	BOOST_REQUIRE_MESSAGE(slowResponses.wait(SLOW_REQUESTS, SLOW_LATENCY * SLOW_REQUESTS * 2), "Not all requests to the slow service were responded to.");
+
+	mb::NameValueMap slowMetrics;
+	manager->getServiceMetrics("bulkheadSlow", slowMetrics);
+
+	std::cout << "Slow group: " << slowMetrics["group.name"] << ", pool waits " << slowMetrics["group.pool.waits"] <<
+		", pool exhausted " << slowMetrics["group.pool.exhausted"] << ", max queue time " << slowMetrics["group.queue.max"] << " us" << std::endl;
+
+	// Only one handle for two threads so requests wait for
+	// a handle and some give up after the pool timeout
+	BOOST_CHECK_MESSAGE(slowMetrics["group.name"] == "bulkheadSlow", "The slow service was not given its own group.");
+	BOOST_CHECK_MESSAGE(atol(slowMetrics["group.pool.waits"].c_str()) > 0, "Pool contention was not reported.");
+	BOOST_CHECK_MESSAGE(atol(slowMetrics["group.pool.exhausted"].c_str()) == slowResponses.errors, "Pool exhaustion does not match the failed requests.");
+	BOOST_CHECK_MESSAGE(slowResponses.errors > 0, "The slow service's pool was not exhausted.");
+
+	mb::NameValueMap fastMetrics;
+	manager->getServiceMetrics("bulkheadFast", fastMetrics);
+
+	BOOST_CHECK_MESSAGE(fastMetrics["group.name"] == "default", "The fast service is not in the default group.");
+	BOOST_CHECK_MESSAGE(fastMetrics["group.pool.waits"] == "0", "Contention was reported for the default group.");
+
+	mb::NameValueMap sharedMetrics;
+	manager->getServiceMetrics("bulkheadShared", sharedMetrics);
+
+	BOOST_CHECK_MESSAGE(sharedMetrics["group.name"] == "sharedGroup", "The shared service is not in its named group.");
+	BOOST_CHECK_MESSAGE(sharedMetrics["group.requests"] == "1", "Requests of the shared group are not consistent.");
+
+	slowServer.stop();
+	fastServer.stop();
+
+	std::cout << std::endl << "End HTTP bulkhead tests..." << std::endl;
+}
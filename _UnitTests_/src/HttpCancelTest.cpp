@@ -0,0 +1,176 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <iostream>
+
+#include <boost/test/unit_test.hpp>
+
+#include "clock.h"
+
+#include "DataBinder.h"
+#include "MessageBusManager.h"
+#include "ServiceConfigManager.h"
+#include "CurlHttpService.h"
+
+#include "LoopbackHttpServer.h"
+
+#define HTTP_CANCEL_TEST  "./data/http_cancel_test.xml"
+
+// Time within which a cancelled transfer should be aborted
+#define CANCEL_TIMEOUT  1000
+
+
+// Binds the items of the response so a cancel
+// has to release a binder that is in use
+class CancelTestBinder : public binding::TypedDataBinder<long> {
+
+public:
+	CancelTestBinder() {
+		DataBinder::addEndRule("items/item", endItem);
+	}
+
+	void beginBinding() {
+		this->setRoot(new long(0));
+	}
+
+	static void endItem(void* binder, const char* element, const char* body) {
+
+		GET_BINDER(CancelTestBinder);
+		GET_BINDING_ROOT(count, long);
+
+		(*count)++;
+	}
+};
+
+struct CancelTestResponse {
+
+	CancelTestResponse() : received(false) { }
+
+	static void handleResponse(void* context, mb::MessagePtr message) {
+
+		CancelTestResponse* result = (CancelTestResponse *) context;
+
+		boost::lock_guard<boost::mutex> lock(result->lock);
+		result->response = message;
+		result->received = true;
+		result->done.notify_all();
+	}
+
+	bool wait(long millis) {
+
+		boost::unique_lock<boost::mutex> lock(this->lock);
+		const boost::system_time timeout = boost::get_system_time() + boost::posix_time::milliseconds(millis);
+
+		while (!received)
+			if (!done.timed_wait(lock, timeout))
+				return received;
+
+		return true;
+	}
+
+	boost::mutex lock;
+	boost::condition_variable done;
+
+	mb::MessagePtr response;
+	bool received;
+};
+
+void checkCancelled(CancelTestResponse& result, binding::DataBinderPtr binder) {
+
+	long long cancelTime = currentTimeMillis();
+
+	BOOST_REQUIRE_MESSAGE(result.wait(CANCEL_TIMEOUT * 5), "No response was received for the cancelled request.");
+	BOOST_CHECK_MESSAGE(currentTimeMillis() - cancelTime < CANCEL_TIMEOUT, "The cancelled transfer was not aborted in time.");
+	BOOST_CHECK_MESSAGE(result.response->getError() == mb::Message::ERR_CANCELLED, "The response was not marked as cancelled.");
+
+	// The binder should have been released for the next request
+	BOOST_CHECK_MESSAGE(binder->lock(), "The binder of the cancelled request was not released.");
+	binder->reset();
+}
+
+BOOST_AUTO_TEST_CASE( http_cancel_test ) {
+
+	std::cout << std::endl << "Begin HTTP cancel tests..." << std::endl;
+
+	// A response that streams slowly in small chunks
+	LoopbackHttpServer::Config config;
+	config.payloadSize = 65536;
+	config.chunkSize = 1024;
+	config.chunkDelay = 20;
+	config.latencyMean = 100;
+
+	LoopbackHttpServer server(config);
+	server.start();
+
+	mb::MessageBusManager::initialize();
+	mb::ServiceConfigManager::initialize();
+
+	mb::ServiceConfigManager* configManager = mb::ServiceConfigManager::instance();
+	configManager->addToken("LOOPBACK_SLOW_URL", server.getUrl().c_str());
+	configManager->loadConfigFile(HTTP_CANCEL_TEST);
+
+	mb::MessageBusManager* manager = mb::MessageBusManager::instance();
+	binding::DataBinderPtr binder(new CancelTestBinder());
+
+	// Caller gives up while the response is streaming
+	{
+		CancelTestResponse result;
+
+		mb::MessagePtr message = manager->createMessage("cancelTestXml");
+		((mb::P2PMessage *) message.get())->setCallback(&result, CancelTestResponse::handleResponse);
+		message->setDataBinder(binder);
+
+		BOOST_REQUIRE(manager->postMessage(message));
+
+		boost::this_thread::sleep(boost::posix_time::milliseconds(400));
+		BOOST_REQUIRE_MESSAGE(!result.received, "The response was received before it could be cancelled.");
+
+		message->cancel();
+		checkCancelled(result, binder);
+	}
+
+	// Subscription cancelled with a control action while it is polling
+	{
+		CancelTestResponse result;
+
+		mb::MessagePtr message = manager->createMessage("cancelTestXml");
+		((mb::P2PMessage *) message.get())->setCallback(&result, CancelTestResponse::handleResponse);
+		message->setDataBinder(binder);
+		message->setDelay(60000, true, true);
+
+		BOOST_REQUIRE(manager->postMessage(message));
+
+		boost::this_thread::sleep(boost::posix_time::milliseconds(400));
+		BOOST_REQUIRE_MESSAGE(!result.received, "The poll response was received before it could be cancelled.");
+
+		mb::MessagePtr cancel = manager->createMessage("cancelTestXml");
+		((mb::P2PMessage *) cancel.get())->setControlAction(mb::P2PMessage::CANCEL, message->getId().c_str());
+
+		BOOST_REQUIRE(manager->postMessage(cancel));
+		checkCancelled(result, binder);
+	}
+
+	server.stop();
+
+	std::cout << std::endl << "End HTTP cancel tests..." << std::endl;
+}
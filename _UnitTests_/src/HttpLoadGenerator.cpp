@@ -0,0 +1,273 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "HttpLoadGenerator.h"
+
+#include <stdlib.h>
+#include <algorithm>
+#include <iomanip>
+
+#include "clock.h"
+
+#include "DataBinder.h"
+#include "MessageBusManager.h"
+#include "HttpService.h"
+
+
+const char* _stageNames[HttpLoadGenerator::NUM_STAGES] = {
+	"queue", "connect", "ttfb", "transfer", "bind", "deliver", "total"
+};
+
+const char* _stageTimes[HttpLoadGenerator::NUM_STAGES] = {
+	HTTP_TIME_QUEUE, HTTP_TIME_CONNECT, HTTP_TIME_TTFB, HTTP_TIME_TRANSFER, BIND_TIME, NULL, NULL
+};
+
+
+// Binds an XML payload of items to the number of items
+class ItemCountBinder : public binding::TypedDataBinder<long> {
+
+public:
+	ItemCountBinder() {
+		DataBinder::addEndRule("items/item", endItem);
+	}
+
+	void beginBinding() {
+		this->setRoot(new long(0));
+	}
+
+	static void endItem(void* binder, const char* element, const char* body) {
+
+		GET_BINDER(ItemCountBinder);
+		GET_BINDING_ROOT(count, long);
+
+		(*count)++;
+	}
+};
+
+
+struct HttpLoadGenerator::Request {
+
+	Request(HttpLoadGenerator* generator) : generator(generator) {
+		postTime = currentTimeMicros();
+	}
+
+	HttpLoadGenerator* generator;
+	long long postTime;
+
+	// The request is the listener of its response
+	// so it is kept until the response is received
+	mb::MessagePtr message;
+};
+
+
+HttpLoadGenerator::HttpLoadGenerator(const char* subject, bool bind)
+	: m_subject(subject), m_bind(bind) {
+
+	m_inFlight = 0;
+
+	m_responses = 0;
+	m_errors = 0;
+	m_items = 0;
+
+	m_startTime = 0;
+	m_endTime = 0;
+}
+
+HttpLoadGenerator::~HttpLoadGenerator() {
+}
+
+void HttpLoadGenerator::run(int requests, int concurrency) {
+
+	mb::MessageBusManager* manager = mb::MessageBusManager::instance();
+
+	{ boost::lock_guard<boost::mutex> lock(m_lock);
+
+		m_responses = 0;
+		m_errors = 0;
+		m_items = 0;
+
+		for (int i = 0; i < NUM_STAGES; i++)
+			m_times[i].clear();
+
+		m_startTime = currentTimeMicros();
+	}
+
+	for (int i = 0; i < requests; i++) {
+
+		{ boost::unique_lock<boost::mutex> lock(m_lock);
+
+			while (m_inFlight >= concurrency)
+				m_completed.wait(lock);
+
+			m_inFlight++;
+		}
+
+		mb::MessagePtr message = manager->createMessage(m_subject.c_str());
+
+		Request* request = new Request(this);
+		request->message = message;
+		((mb::P2PMessage *) message.get())->setCallback(request, handleResponse);
+
+		if (m_bind)
+			message->setDataBinder(binding::DataBinderPtr(new ItemCountBinder()));
+
+		if (!manager->postMessage(message)) {
+
+			ERROR("Load generator was unable to post a message to service '%s'.", m_subject.c_str());
+
+			delete request;
+
+			boost::lock_guard<boost::mutex> lock(m_lock);
+			m_inFlight--;
+			m_errors++;
+		}
+	}
+
+	boost::unique_lock<boost::mutex> lock(m_lock);
+
+	while (m_inFlight > 0)
+		m_completed.wait(lock);
+
+	m_endTime = currentTimeMicros();
+}
+
+void HttpLoadGenerator::handleResponse(void* context, mb::MessagePtr message) {
+
+	Request* request = (Request *) context;
+
+	if (message->getType() == mb::Message::MSG_RESP_STREAM)
+		((mb::StreamMessage *) message.get())->setCallback(context, readResponse);
+	else
+		request->generator->completeResponse(request, message);
+}
+
+bool HttpLoadGenerator::readResponse(void* context, mb::MessagePtr message, void* buffer, size_t size) {
+
+	Request* request = (Request *) context;
+
+	if (!buffer)
+		request->generator->completeResponse(request, message);
+
+	return true;
+}
+
+void HttpLoadGenerator::completeResponse(Request* request, mb::MessagePtr message) {
+
+	long long receiveTime = currentTimeMicros();
+	long items = 0;
+
+	if (message->getContentType() == mb::Message::CNT_MODEL && message->getData()) {
+
+		mb::Datum<long> count(message);
+		items = *count;
+	}
+
+	mb::NameValueMap& metaData = message->getMetaData();
+	mb::NameValueMap::iterator value;
+
+	{ boost::lock_guard<boost::mutex> lock(m_lock);
+
+		for (int i = 0; i < NUM_STAGES; i++) {
+
+			if (_stageTimes[i] && (value = metaData.find(_stageTimes[i])) != metaData.end())
+				m_times[i].push_back(atoll(value->second.c_str()));
+		}
+
+		if ((value = metaData.find(BOUND_TIME)) != metaData.end())
+			m_times[DELIVER].push_back(receiveTime - atoll(value->second.c_str()));
+
+		m_times[TOTAL].push_back(receiveTime - request->postTime);
+
+		m_responses++;
+		if (message->getError())
+			m_errors++;
+		m_items += items;
+
+		m_inFlight--;
+		m_completed.notify_all();
+	}
+
+	delete request;
+}
+
+long HttpLoadGenerator::getResponseCount() {
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+	return m_responses;
+}
+
+long HttpLoadGenerator::getErrorCount() {
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+	return m_errors;
+}
+
+long HttpLoadGenerator::getItemCount() {
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+	return m_items;
+}
+
+double HttpLoadGenerator::getThroughput() {
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+	return (m_endTime > m_startTime ? m_responses * 1000000.0 / (m_endTime - m_startTime) : 0.0);
+}
+
+long long HttpLoadGenerator::getPercentile(Stage stage, double percentile) {
+
+	std::vector<long long> times;
+
+	{ boost::lock_guard<boost::mutex> lock(m_lock);
+		times = m_times[stage];
+	}
+
+	if (times.empty())
+		return -1;
+
+	size_t i = (size_t) (percentile / 100.0 * (times.size() - 1) + 0.5);
+	std::nth_element(times.begin(), times.begin() + i, times.end());
+
+	return times[i];
+}
+
+void HttpLoadGenerator::report(std::ostream& output) {
+
+	output << "Load test of service '" << m_subject << "': " << this->getResponseCount() << " responses, " <<
+		this->getErrorCount() << " errors, " << std::fixed << std::setprecision(1) << this->getThroughput() << " responses/s" << std::endl;
+
+	output << "\t" << std::setw(10) << std::left << "stage" << std::right <<
+		std::setw(10) << "p50 ms" << std::setw(10) << "p90 ms" << std::setw(10) << "p99 ms" << std::setw(10) << "max ms" << std::endl;
+
+	for (int i = 0; i < NUM_STAGES; i++) {
+
+		Stage stage = (Stage) i;
+		if (this->getPercentile(stage, 100) < 0)
+			continue;
+
+		output << "\t" << std::setw(10) << std::left << _stageNames[i] << std::right << std::setprecision(3) <<
+			std::setw(10) << this->getPercentile(stage, 50) / 1000.0 <<
+			std::setw(10) << this->getPercentile(stage, 90) / 1000.0 <<
+			std::setw(10) << this->getPercentile(stage, 99) / 1000.0 <<
+			std::setw(10) << this->getPercentile(stage, 100) / 1000.0 << std::endl;
+	}
+}
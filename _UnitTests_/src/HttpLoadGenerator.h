@@ -0,0 +1,112 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef HTTPLOADGENERATOR_H_
+#define HTTPLOADGENERATOR_H_
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include "boost/thread.hpp"
+
+#include "Service.h"
+
+
+/* Drives an HTTP service through the message bus with a fixed
+ * number of requests in flight and records the time spent in
+ * each stage of every request. The HTTP stages are taken from
+ * the timings the service adds to the response meta data and
+ * the bind and deliver stages from the binding meta data.
+ */
+class HttpLoadGenerator {
+
+public:
+	enum Stage {
+		QUEUE,     // Waiting for an executor thread
+		CONNECT,   // Connecting or reusing a connection
+		TTFB,      // Connected until the first response byte
+		TRANSFER,  // First until the last response byte
+		BIND,      // Binding the response
+		DELIVER,   // Bound until received by the caller
+		TOTAL,     // Posted until received by the caller
+
+		NUM_STAGES
+	};
+
+public:
+	/* If bind is true each response is bound to a count of its
+	 * items which requires the service to respond with XML.
+	 */
+	HttpLoadGenerator(const char* subject, bool bind);
+	virtual ~HttpLoadGenerator();
+
+	/* Posts the given number of requests keeping at most the given
+	 * number in flight and returns once all have been responded to.
+	 */
+	void run(int requests, int concurrency);
+
+	long getResponseCount();
+	long getErrorCount();
+	long getItemCount();
+
+	/* Responses per second over the last run */
+	double getThroughput();
+
+	/* Returns the time in micro-seconds within which the given
+	 * percentage of requests completed the stage or -1 if no
+	 * times were recorded for the stage.
+	 */
+	long long getPercentile(Stage stage, double percentile);
+
+	void report(std::ostream& output);
+
+private:
+
+	struct Request;
+
+	static void handleResponse(void* context, mb::MessagePtr message);
+	static bool readResponse(void* context, mb::MessagePtr message, void* buffer, size_t size);
+
+	void completeResponse(Request* request, mb::MessagePtr message);
+
+	std::string m_subject;
+	bool m_bind;
+
+	boost::mutex m_lock;
+	boost::condition_variable m_completed;
+
+	int m_inFlight;
+
+	long m_responses;
+	long m_errors;
+	long m_items;
+
+	long long m_startTime;
+	long long m_endTime;
+
+	std::vector<long long> m_times[NUM_STAGES];
+};
+
+
+#endif /* HTTPLOADGENERATOR_H_ */
@@ -0,0 +1,114 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <iostream>
+#include <stdlib.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include "MessageBusManager.h"
+#include "ServiceConfigManager.h"
+#include "CurlHttpService.h"
+
+#include "LoopbackHttpServer.h"
+#include "HttpLoadGenerator.h"
+
+#define HTTP_LOAD_TEST  "./data/http_load_test.xml"
+
+#define LOAD_TEST_REQUESTS     200
+#define LOAD_TEST_CONCURRENCY  8
+
+
+void runLoadTest(LoopbackHttpServer& server, const char* subject, bool bind) {
+
+	long requests = server.getRequestCount();
+	long errors = server.getErrorCount();
+
+	HttpLoadGenerator generator(subject, bind);
+	generator.run(LOAD_TEST_REQUESTS, LOAD_TEST_CONCURRENCY);
+	generator.report(std::cout);
+
+	BOOST_REQUIRE_MESSAGE(generator.getResponseCount() == LOAD_TEST_REQUESTS, "Not all requests were responded to.");
+	BOOST_REQUIRE_MESSAGE(server.getRequestCount() - requests == LOAD_TEST_REQUESTS, "Server did not receive all requests.");
+	BOOST_REQUIRE_MESSAGE(generator.getErrorCount() == server.getErrorCount() - errors, "Error responses do not match the errors served.");
+	BOOST_REQUIRE_MESSAGE(generator.getPercentile(HttpLoadGenerator::TRANSFER, 50) >= 0, "Transfer times were not recorded.");
+
+	mb::NameValueMap metrics;
+	mb::MessageBusManager::instance()->getServiceMetrics(subject, metrics);
+
+	std::cout << "\ttransfer timings: total p50 " << metrics["timing.total.p50"] << " us, ttfb p50 " <<
+		metrics["timing.ttfb.p50"] << " us, " << metrics["transfer.reused"] << " of " << metrics["transfer.count"] << " reused connections" << std::endl;
+
+	BOOST_REQUIRE_MESSAGE(atol(metrics["timing.total.count"].c_str()) > 0, "Transfer timings were not aggregated.");
+
+	if (bind) {
+
+		BOOST_REQUIRE_MESSAGE(generator.getPercentile(HttpLoadGenerator::BIND, 50) >= 0, "Bind times were not recorded.");
+		BOOST_REQUIRE_MESSAGE(generator.getPercentile(HttpLoadGenerator::DELIVER, 50) >= 0, "Deliver times were not recorded.");
+		BOOST_REQUIRE_MESSAGE(generator.getItemCount() > 0, "Responses were not bound.");
+	}
+}
+
+BOOST_AUTO_TEST_CASE( http_load_test ) {
+
+	std::cout << std::endl << "Begin HTTP load tests..." << std::endl;
+
+	LoopbackHttpServer::Config xmlConfig;
+	xmlConfig.payloadSize = 65536;
+	xmlConfig.chunkSize = 4096;
+	xmlConfig.latency = LoopbackHttpServer::EXPONENTIAL;
+	xmlConfig.latencyMean = 5;
+	xmlConfig.latencyMax = 50;
+	xmlConfig.errorRate = 0.02;
+
+	LoopbackHttpServer::Config jsonConfig;
+	jsonConfig.contentType = mb::Message::CNT_JSON;
+	jsonConfig.payloadSize = 8192;
+	jsonConfig.latency = LoopbackHttpServer::UNIFORM;
+	jsonConfig.latencyMean = 5;
+
+	LoopbackHttpServer xmlServer(xmlConfig);
+	LoopbackHttpServer jsonServer(jsonConfig);
+	xmlServer.start();
+	jsonServer.start();
+
+	mb::MessageBusManager::initialize();
+	mb::ServiceConfigManager::initialize();
+
+	mb::ServiceConfigManager* manager = mb::ServiceConfigManager::instance();
+
+	manager->addToken("LOOPBACK_XML_URL", xmlServer.getUrl().c_str());
+	manager->addToken("LOOPBACK_JSON_URL", jsonServer.getUrl().c_str());
+	manager->loadConfigFile(HTTP_LOAD_TEST);
+
+	// HTTP/1.1 with chunked responses bound as they stream
+	runLoadTest(xmlServer, "loadTestXml", true);
+	// HTTP/2 over a plain connection
+	runLoadTest(xmlServer, "loadTestXmlH2", true);
+	// Unbound POST requests
+	runLoadTest(jsonServer, "loadTestJson", false);
+
+	xmlServer.stop();
+	jsonServer.stop();
+
+	std::cout << std::endl << "End HTTP load tests..." << std::endl;
+}
@@ -0,0 +1,165 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <iostream>
+#include <stdlib.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include "clock.h"
+
+#include "Manager.h"
+#include "MessageBusManager.h"
+#include "ServiceConfigManager.h"
+#include "CurlHttpService.h"
+
+#include "LoopbackHttpServer.h"
+
+#define HTTP_PREWARM_TEST  "./data/http_prewarm_test.xml"
+
+#define PREWARM_CONNECTIONS  3
+#define PREWARM_TIMEOUT      5000
+
+
+struct PrewarmTestResponse {
+
+	PrewarmTestResponse() : received(false) { }
+
+	static void handleResponse(void* context, mb::MessagePtr message) {
+
+		PrewarmTestResponse* result = (PrewarmTestResponse *) context;
+
+		if (message->getType() == mb::Message::MSG_RESP_STREAM)
+			((mb::StreamMessage *) message.get())->setCallback(context, readResponse);
+		else
+			result->complete(message);
+	}
+
+	static bool readResponse(void* context, mb::MessagePtr message, void* buffer, size_t size) {
+
+		if (!buffer)
+			((PrewarmTestResponse *) context)->complete(message);
+
+		return true;
+	}
+
+	void complete(mb::MessagePtr message) {
+
+		boost::lock_guard<boost::mutex> lock(this->lock);
+		response = message;
+		received = true;
+		done.notify_all();
+	}
+
+	bool wait(long millis) {
+
+		boost::unique_lock<boost::mutex> lock(this->lock);
+		const boost::system_time timeout = boost::get_system_time() + boost::posix_time::milliseconds(millis);
+
+		while (!received)
+			if (!done.timed_wait(lock, timeout))
+				return received;
+
+		return true;
+	}
+
+	boost::mutex lock;
+	boost::condition_variable done;
+
+	mb::MessagePtr response;
+	bool received;
+};
+
+// Waits for the given number of pre-warm requests to complete
+bool waitForPrewarm(const char* subject, long count) {
+
+	long long timeout = currentTimeMillis() + PREWARM_TIMEOUT;
+
+	while (currentTimeMillis() < timeout) {
+
+		mb::NameValueMap metrics;
+		mb::MessageBusManager::instance()->getServiceMetrics(subject, metrics);
+
+		if (atol(metrics["prewarm.requests"].c_str()) + atol(metrics["prewarm.failures"].c_str()) >= count)
+			return (atol(metrics["prewarm.failures"].c_str()) == 0);
+
+		boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+	}
+
+	return false;
+}
+
+BOOST_AUTO_TEST_CASE( http_prewarm_test ) {
+
+	std::cout << std::endl << "Begin HTTP pre-warm tests..." << std::endl;
+
+	LoopbackHttpServer::Config config;
+	config.payloadSize = 4096;
+
+	LoopbackHttpServer server(config);
+	server.start();
+
+	mb::MessageBusManager::initialize();
+	mb::ServiceConfigManager::initialize();
+
+	mb::ServiceConfigManager* configManager = mb::ServiceConfigManager::instance();
+	configManager->addToken("LOOPBACK_URL", server.getUrl().c_str());
+	configManager->loadConfigFile(HTTP_PREWARM_TEST);
+
+	// Connections are opened when the service is registered
+	BOOST_REQUIRE_MESSAGE(waitForPrewarm("prewarmTestXml", PREWARM_CONNECTIONS), "Connections were not pre-warmed.");
+	BOOST_CHECK_MESSAGE(server.getConnectionCount() == PREWARM_CONNECTIONS, "The server did not accept the pre-warmed connections.");
+	BOOST_CHECK_MESSAGE(server.getRequestCount() == 0, "Pre-warming should not send requests for the payload.");
+
+	mb::MessageBusManager* manager = mb::MessageBusManager::instance();
+
+	// Requests reuse the pre-warmed connections
+	for (int i = 0; i < PREWARM_CONNECTIONS; i++) {
+
+		PrewarmTestResponse result;
+
+		mb::MessagePtr message = manager->createMessage("prewarmTestXml");
+		((mb::P2PMessage *) message.get())->setCallback(&result, PrewarmTestResponse::handleResponse);
+
+		BOOST_REQUIRE(manager->postMessage(message));
+		BOOST_REQUIRE_MESSAGE(result.wait(PREWARM_TIMEOUT), "No response was received.");
+
+		BOOST_CHECK_MESSAGE(!result.response->getError(), "The request to the pre-warmed service failed.");
+		BOOST_CHECK_MESSAGE( result.response->getMetaData()[HTTP_CONNECTION_REUSED] == CSTR_TRUE,
+			"The request did not reuse a pre-warmed connection." );
+	}
+
+	BOOST_CHECK_MESSAGE(server.getConnectionCount() == PREWARM_CONNECTIONS, "Requests opened new connections.");
+	BOOST_CHECK_MESSAGE(server.getRequestCount() == PREWARM_CONNECTIONS, "The server did not receive all requests.");
+
+	// Idle connections are checked again when brought to the
+	// foreground and as they are still open none are added
+	mb::Manager::bringToForeground();
+
+	BOOST_REQUIRE_MESSAGE(waitForPrewarm("prewarmTestXml", PREWARM_CONNECTIONS * 2), "Connections were not pre-warmed on resume.");
+	BOOST_CHECK_MESSAGE(server.getConnectionCount() == PREWARM_CONNECTIONS, "Open connections were not reused on resume.");
+
+	server.stop();
+
+	std::cout << std::endl << "End HTTP pre-warm tests..." << std::endl;
+}
@@ -0,0 +1,161 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <iostream>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include "clock.h"
+
+#include "MessageBusManager.h"
+#include "ServiceConfigManager.h"
+#include "ReplayHttpService.h"
+
+#include "LoopbackHttpServer.h"
+
+#define HTTP_REPLAY_TEST      "./data/http_replay_test.xml"
+#define HTTP_REPLAY_PLAYBACK  "./data/http_replay_playback.xml"
+
+
+mb::MessagePtr sendReplayRequest(const char* subject, const char* id, long long* time = NULL) {
+
+	mb::MessageBusManager* manager = mb::MessageBusManager::instance();
+
+	mb::MessagePtr message = manager->createMessage(subject);
+	((mb::http::HttpMessage *) message.get())->setTmplVar("id", id);
+
+	long long startTime = currentTimeMillis();
+	mb::MessagePtr response = manager->sendMessage(message);
+
+	if (time)
+		*time = currentTimeMillis() - startTime;
+
+	return response;
+}
+
+BOOST_AUTO_TEST_CASE( http_replay_test ) {
+
+	std::cout << std::endl << "Begin HTTP replay tests..." << std::endl;
+
+	// A response that streams slowly so its timing can be replayed
+	LoopbackHttpServer::Config config;
+	config.payloadSize = 32768;
+	config.chunkSize = 4096;
+	config.chunkDelay = 25;
+
+	LoopbackHttpServer server(config);
+	server.start();
+
+	char path[] = "/tmp/nadax_replay_XXXXXX";
+	int fd = mkstemp(path);
+	BOOST_REQUIRE(fd != -1);
+	close(fd);
+
+	mb::MessageBusManager::initialize();
+	mb::ServiceConfigManager::initialize();
+
+	mb::ServiceConfigManager* configManager = mb::ServiceConfigManager::instance();
+	configManager->addToken("LOOPBACK_URL", server.getUrl().c_str());
+	configManager->addToken("REPLAY_FILE", path);
+	configManager->loadConfigFile(HTTP_REPLAY_TEST);
+
+	const std::string& payload = server.getPayload();
+	long long recordTime;
+
+	// Responses are passed through from the live service as they are recorded
+	{
+		mb::MessagePtr response = sendReplayRequest("replayRecord", "1", &recordTime);
+		BOOST_REQUIRE(response);
+		BOOST_REQUIRE_MESSAGE(!response->getError(), "The recorded request failed: " << response->getErrorDescription());
+		BOOST_CHECK(((mb::StringMessage *) response.get())->getSize() == payload.length());
+		BOOST_CHECK(std::string((const char *) response->getData()) == payload);
+
+		response = sendReplayRequest("replayRecord", "2");
+		BOOST_REQUIRE(response);
+		BOOST_REQUIRE(!response->getError());
+
+		BOOST_CHECK(server.getRequestCount() == 2);
+	}
+
+	// The recording is saved as the exchanges are added
+	{
+		mb::http::HttpRecording recording(path);
+		BOOST_REQUIRE_MESSAGE(recording.load(), "The recording could not be loaded.");
+		BOOST_CHECK(recording.size() == 2);
+
+		mb::http::RecordedExchangePtr exchange = recording.find(
+			mb::http::HttpRecording::createKey("replayRecord", "{\"id\":\"1\"}") );
+		BOOST_REQUIRE_MESSAGE(exchange, "The recorded exchange was not found.");
+		BOOST_CHECK(exchange->chunks.size() > 1);
+		BOOST_CHECK(exchange->duration > 0);
+
+		std::string body;
+		for (size_t i = 0; i < exchange->chunks.size(); i++)
+			body += exchange->chunks[i].data;
+
+		BOOST_CHECK_MESSAGE(body == payload, "The recorded chunks do not match the payload.");
+	}
+
+	configManager->loadConfigFile(HTTP_REPLAY_PLAYBACK);
+	long requests = server.getRequestCount();
+
+	// Replayed at the recorded speed and without delays
+	{
+		long long realtime, fast;
+
+		mb::MessagePtr response = sendReplayRequest("replayRealtime", "1", &realtime);
+		BOOST_REQUIRE(response);
+		BOOST_REQUIRE_MESSAGE(!response->getError(), "The replayed request failed: " << response->getErrorDescription());
+		BOOST_CHECK(std::string((const char *) response->getData()) == payload);
+
+		response = sendReplayRequest("replayFast", "1", &fast);
+		BOOST_REQUIRE(response);
+		BOOST_REQUIRE(!response->getError());
+		BOOST_CHECK(std::string((const char *) response->getData()) == payload);
+
+		std::cout << "\trecorded " << recordTime << " ms, replayed " << realtime << " ms, fast " << fast << " ms" << std::endl;
+
+		BOOST_CHECK_MESSAGE(realtime * 2 > recordTime, "The response was not replayed at the recorded speed.");
+		BOOST_CHECK_MESSAGE(fast * 2 < realtime, "The response was not replayed without delays.");
+		BOOST_CHECK_MESSAGE(server.getRequestCount() == requests, "Replayed requests were sent to the server.");
+	}
+
+	// Requests that were not recorded fail
+	{
+		mb::MessagePtr response = sendReplayRequest("replayFast", "3");
+		BOOST_REQUIRE(response);
+		BOOST_CHECK(response->getError() == mb::Message::ERR_SERVICE);
+		BOOST_CHECK(response->getErrorCode() == 404);
+
+		mb::NameValueMap metrics;
+		mb::MessageBusManager::instance()->getServiceMetrics("replayFast", metrics);
+		BOOST_CHECK(metrics["replay.replayed"] == "1");
+		BOOST_CHECK(metrics["replay.missing"] == "1");
+	}
+
+	unlink(path);
+	server.stop();
+
+	std::cout << std::endl << "End HTTP replay tests..." << std::endl;
+}
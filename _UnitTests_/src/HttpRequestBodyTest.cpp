@@ -0,0 +1,261 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include "MessageBusManager.h"
+#include "ServiceConfigManager.h"
+#include "CurlHttpService.h"
+#include "HttpRequestBody.h"
+
+#include "LoopbackHttpServer.h"
+
+#define HTTP_UPLOAD_TEST  "./data/http_upload_test.xml"
+
+#define UPLOAD_FILE_SIZE       (4 * 1024 * 1024 + 123)
+#define UPLOAD_GENERATED_SIZE  (1024 * 1024)
+#define UPLOAD_TIMEOUT         30000
+
+
+// Reads the whole body in pieces of the given size
+std::string readBody(mb::http::HttpRequestBody& body, size_t size) {
+
+	std::string content;
+	char buffer[4096];
+
+	long len;
+	while ((len = body.read(buffer, std::min(size, sizeof(buffer)))) > 0)
+		content.append(buffer, len);
+
+	BOOST_REQUIRE_MESSAGE(len == 0, "The request body could not be read.");
+	return content;
+}
+
+struct GeneratedBody {
+
+	GeneratedBody(long long size) : size(size), generated(0) { }
+
+	static long generate(void* context, char* buffer, size_t size) {
+
+		GeneratedBody* body = (GeneratedBody *) context;
+
+		size_t len = (size_t) std::min((long long) size, body->size - body->generated);
+		memset(buffer, 'x', len);
+		body->generated += len;
+
+		return (long) len;
+	}
+
+	long long size;
+	long long generated;
+};
+
+struct UploadTestResponse {
+
+	UploadTestResponse() : received(false) { }
+
+	static void handleResponse(void* context, mb::MessagePtr message) {
+
+		if (message->getType() == mb::Message::MSG_RESP_STREAM)
+			((mb::StreamMessage *) message.get())->setCallback(context, readResponse);
+		else
+			((UploadTestResponse *) context)->complete(message);
+	}
+
+	static bool readResponse(void* context, mb::MessagePtr message, void* buffer, size_t size) {
+
+		if (!buffer)
+			((UploadTestResponse *) context)->complete(message);
+
+		return true;
+	}
+
+	void complete(mb::MessagePtr message) {
+
+		boost::lock_guard<boost::mutex> lock(this->lock);
+		response = message;
+		received = true;
+		done.notify_all();
+	}
+
+	bool wait(long millis) {
+
+		boost::unique_lock<boost::mutex> lock(this->lock);
+		const boost::system_time timeout = boost::get_system_time() + boost::posix_time::milliseconds(millis);
+
+		while (!received)
+			if (!done.timed_wait(lock, timeout))
+				return received;
+
+		return true;
+	}
+
+	boost::mutex lock;
+	boost::condition_variable done;
+
+	mb::MessagePtr response;
+	bool received;
+};
+
+// Uploads the body and returns the number of bytes the server received
+long long upload(LoopbackHttpServer& server, mb::http::HttpRequestBodyPtr body) {
+
+	mb::MessageBusManager* manager = mb::MessageBusManager::instance();
+	long long received = server.getBytesReceived();
+
+	UploadTestResponse result;
+
+	mb::MessagePtr message = manager->createMessage("uploadTest");
+	((mb::P2PMessage *) message.get())->setCallback(&result, UploadTestResponse::handleResponse);
+	((mb::http::HttpMessage *) message.get())->setRequestBody(body);
+
+	BOOST_REQUIRE(manager->postMessage(message));
+	BOOST_REQUIRE_MESSAGE(result.wait(UPLOAD_TIMEOUT), "No response was received for the upload.");
+	BOOST_REQUIRE_MESSAGE(!result.response->getError(), "The upload failed: " << result.response->getErrorDescription());
+
+	return server.getBytesReceived() - received;
+}
+
+BOOST_AUTO_TEST_CASE( http_request_body_test ) {
+
+	std::cout << std::endl << "Begin HTTP request body tests..." << std::endl;
+
+	char path[] = "/tmp/nadax_upload_XXXXXX";
+	int fd = mkstemp(path);
+	BOOST_REQUIRE(fd >= 0);
+
+	std::string content;
+	for (int i = 0; content.length() < UPLOAD_FILE_SIZE; i++)
+		content += (char) ('a' + i % 26);
+	content.resize(UPLOAD_FILE_SIZE);
+
+	FILE* file = fdopen(fd, "wb");
+	fwrite(content.data(), 1, content.length(), file);
+	fclose(file);
+
+	// File bodies are read in pieces and can be resent
+	{
+		mb::http::FileRequestBody body(path);
+		BOOST_CHECK(body.getLength() == UPLOAD_FILE_SIZE);
+		BOOST_CHECK_MESSAGE(readBody(body, 1000) == content, "The file body was not read in full.");
+
+		BOOST_REQUIRE(body.rewind());
+		BOOST_CHECK_MESSAGE(readBody(body, 4096) == content, "The rewound file body was not read in full.");
+
+		mb::http::FileRequestBody missing("/tmp/nadax_upload_missing");
+		char buffer[16];
+		BOOST_CHECK(missing.getLength() == -1);
+		BOOST_CHECK(missing.read(buffer, sizeof(buffer)) == -1);
+	}
+
+	// Chained bodies are read one after the other
+	{
+		mb::http::ChainedRequestBody body;
+		body.append(mb::http::HttpRequestBodyPtr(new mb::http::BufferRequestBody("Hello ")));
+		body.append(mb::http::HttpRequestBodyPtr(new mb::http::BufferRequestBody("")));
+		body.append(mb::http::HttpRequestBodyPtr(new mb::http::BufferRequestBody("World")));
+
+		BOOST_CHECK(body.getLength() == 11);
+		BOOST_CHECK(readBody(body, 3) == "Hello World");
+		BOOST_REQUIRE(body.rewind());
+		BOOST_CHECK(readBody(body, 100) == "Hello World");
+	}
+
+	// Generated bodies cannot be resent once read
+	{
+		GeneratedBody generated(10000);
+		mb::http::GeneratorRequestBody body(GeneratedBody::generate, &generated);
+
+		BOOST_CHECK(body.getLength() == -1);
+		BOOST_CHECK(body.rewind());
+		BOOST_CHECK(readBody(body, 1024).length() == 10000);
+		BOOST_CHECK(!body.rewind());
+	}
+
+	// Multipart bodies are encoded as form data
+	{
+		mb::http::MultipartRequestBody body;
+		body.addField("description", "A \"quoted\" value");
+		body.addFile("upload", "data.txt", mb::http::HttpRequestBodyPtr(new mb::http::BufferRequestBody("file data")), "text/plain");
+
+		std::string boundary = body.getBoundary();
+		std::string expected =
+			"--" + boundary + "\r\n"
+			"Content-Disposition: form-data; name=\"description\"\r\n"
+			"\r\n"
+			"A \"quoted\" value\r\n"
+			"--" + boundary + "\r\n"
+			"Content-Disposition: form-data; name=\"upload\"; filename=\"data.txt\"\r\n"
+			"Content-Type: text/plain\r\n"
+			"\r\n"
+			"file data\r\n"
+			"--" + boundary + "--\r\n";
+
+		BOOST_CHECK(body.getContentType() == "multipart/form-data; boundary=" + boundary);
+		BOOST_CHECK(body.getLength() == (long long) expected.length());
+		BOOST_CHECK_MESSAGE(readBody(body, 7) == expected, "The multipart body was not encoded as expected.");
+		BOOST_REQUIRE(body.rewind());
+		BOOST_CHECK(readBody(body, 4096) == expected);
+	}
+
+	LoopbackHttpServer::Config config;
+	config.payloadSize = 1024;
+
+	LoopbackHttpServer server(config);
+	server.start();
+
+	mb::MessageBusManager::initialize();
+	mb::ServiceConfigManager::initialize();
+
+	mb::ServiceConfigManager* configManager = mb::ServiceConfigManager::instance();
+	configManager->addToken("LOOPBACK_URL", server.getUrl().c_str());
+	configManager->loadConfigFile(HTTP_UPLOAD_TEST);
+
+	// A file uploaded as form data with a known length
+	{
+		boost::shared_ptr<mb::http::MultipartRequestBody> body(new mb::http::MultipartRequestBody());
+		body->addField("name", "upload test");
+		body->addFile("file", "upload.bin", path);
+
+		long long length = body->getLength();
+		BOOST_CHECK_MESSAGE(upload(server, body) == length, "The server did not receive the whole multipart body.");
+	}
+
+	// A generated body of unknown length is sent chunked
+	{
+		GeneratedBody generated(UPLOAD_GENERATED_SIZE);
+		mb::http::HttpRequestBodyPtr body(new mb::http::GeneratorRequestBody(GeneratedBody::generate, &generated));
+
+		BOOST_CHECK_MESSAGE(upload(server, body) == UPLOAD_GENERATED_SIZE, "The server did not receive the whole generated body.");
+	}
+
+	server.stop();
+	unlink(path);
+
+	std::cout << std::endl << "End HTTP request body tests..." << std::endl;
+}
@@ -0,0 +1,94 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <iostream>
+
+#include <boost/test/unit_test.hpp>
+
+#include "clock.h"
+
+#include "HttpResponseCache.h"
+
+BOOST_AUTO_TEST_CASE( http_response_cache_test ) {
+
+	std::cout << std::endl << "Begin HTTP response cache tests..." << std::endl;
+
+	mb::http::HttpResponseCache cache(2, 0, 1024, false);
+	mb::http::CachedResponsePtr response;
+
+	// Freshness
+
+	response = mb::http::CachedResponsePtr(new mb::http::CachedResponse());
+	BOOST_REQUIRE_MESSAGE(cache.setExpiry(response, "public, max-age=60", ""), "Response with max-age not storable.");
+	BOOST_REQUIRE_MESSAGE(response->isFresh(currentTimeMillis()), "Response with max-age is not fresh.");
+
+	response = mb::http::CachedResponsePtr(new mb::http::CachedResponse());
+	BOOST_REQUIRE_MESSAGE(!cache.setExpiry(response, "no-store", ""), "Response with no-store is storable.");
+	BOOST_REQUIRE_MESSAGE(!cache.setExpiry(response, "no-cache", ""), "Stale response without validators is storable.");
+
+	response->etag = "\"v1\"";
+	BOOST_REQUIRE_MESSAGE(cache.setExpiry(response, "No-Cache, max-age=60", ""), "Stale response with validator not storable.");
+	BOOST_REQUIRE_MESSAGE(!response->isFresh(currentTimeMillis()), "Response with no-cache is fresh.");
+
+	BOOST_REQUIRE_MESSAGE(cache.setExpiry(response, "", "Thu, 01 Jan 2099 00:00:00 GMT"), "Response with expires not storable.");
+	BOOST_REQUIRE_MESSAGE(response->isFresh(currentTimeMillis()), "Response with future expires is not fresh.");
+	cache.setExpiry(response, "", "invalid date");
+	BOOST_REQUIRE_MESSAGE(!response->isFresh(currentTimeMillis()), "Response with an invalid expires is fresh.");
+
+	// LRU eviction and lookup
+
+	mb::http::CachedResponsePtr a(new mb::http::CachedResponse());
+	a->body = "a";
+	mb::http::CachedResponsePtr b(new mb::http::CachedResponse());
+	b->body = "b";
+	mb::http::CachedResponsePtr c(new mb::http::CachedResponse());
+	c->model = binding::DynaModel::create();
+
+	cache.store("a", a);
+	cache.store("b", b);
+	BOOST_REQUIRE_MESSAGE(cache.lookup("a", false) == a, "Cached response not found.");
+
+	// "b" is now the least recently used
+	cache.store("c", c);
+	BOOST_REQUIRE_MESSAGE(!cache.lookup("b", false), "Least recently used response not evicted.");
+	BOOST_REQUIRE_MESSAGE(cache.lookup("a", false) == a, "Recently used response was evicted.");
+
+	BOOST_REQUIRE_MESSAGE(!cache.lookup("c", false), "Model only response returned as raw data.");
+	BOOST_REQUIRE_MESSAGE(cache.lookup("c", true) == c, "Model only response not returned as a model.");
+
+	cache.remove("a");
+	BOOST_REQUIRE_MESSAGE(!cache.lookup("a", true), "Removed response was found.");
+
+	cache.recordHit(10);
+	cache.recordRevalidation(10);
+	cache.recordMiss();
+
+	mb::NameValueMap metrics;
+	cache.getMetrics(metrics);
+
+	std::cout << "Cache hit rate = " << metrics["cache.hitRate"] << std::endl;
+	BOOST_REQUIRE_MESSAGE(metrics["cache.entries"] == "1", "Cache entries metric is not consistent.");
+	BOOST_REQUIRE_MESSAGE(metrics["cache.evictions"] == "1", "Cache eviction metric is not consistent.");
+	BOOST_REQUIRE_MESSAGE(metrics["cache.bytesSaved"] == "20", "Cache bytes saved metric is not consistent.");
+
+	std::cout << std::endl << "End HTTP response cache tests..." << std::endl;
+}
@@ -0,0 +1,116 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <iostream>
+#include <string.h>
+#include <unistd.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include "MessageBusManager.h"
+#include "ServiceConfigManager.h"
+#include "CurlHttpService.h"
+
+#include "LoopbackHttpServer.h"
+
+#define HTTP_SPOOL_TEST  "./data/http_spool_test.xml"
+
+#define SPOOL_PAYLOAD_SIZE  (2 * 1024 * 1024)
+
+
+BOOST_AUTO_TEST_CASE( http_spool_test ) {
+
+	std::cout << std::endl << "Begin HTTP spool tests..." << std::endl;
+
+	// Spool files are mapped over a terminating page
+	{
+		SpoolFile spool;
+		BOOST_REQUIRE(spool.create());
+
+		std::string page((size_t) sysconf(_SC_PAGESIZE), 'x');
+		BOOST_REQUIRE(spool.write(page.c_str(), page.length()));
+
+		const char* data = spool.map();
+		BOOST_REQUIRE(data);
+		BOOST_CHECK(spool.getSize() == page.length());
+		BOOST_CHECK(strlen(data) == page.length());
+
+		BOOST_REQUIRE(spool.write("y", 1));
+		data = spool.map();
+		BOOST_REQUIRE(data);
+		BOOST_CHECK(strlen(data) == page.length() + 1 && data[page.length()] == 'y');
+	}
+
+	LoopbackHttpServer::Config config;
+	config.payloadSize = SPOOL_PAYLOAD_SIZE;
+	config.chunkSize = 16384;
+
+	LoopbackHttpServer server(config);
+	server.start();
+
+	mb::MessageBusManager::initialize();
+	mb::ServiceConfigManager::initialize();
+
+	mb::ServiceConfigManager* configManager = mb::ServiceConfigManager::instance();
+	configManager->addToken("LOOPBACK_URL", server.getUrl().c_str());
+	configManager->loadConfigFile(HTTP_SPOOL_TEST);
+
+	mb::MessageBusManager* manager = mb::MessageBusManager::instance();
+	const std::string& payload = server.getPayload();
+
+	// A response larger than the threshold is spooled to a file
+	{
+		mb::MessagePtr response = manager->sendMessage(manager->createMessage("spoolTestXml"));
+		BOOST_REQUIRE(response);
+		BOOST_REQUIRE_MESSAGE(!response->getError(), "The spooled request failed: " << response->getErrorDescription());
+
+		mb::StringMessage* message = (mb::StringMessage *) response.get();
+		BOOST_REQUIRE_MESSAGE(message->isSpooled(), "The response was not spooled.");
+		BOOST_CHECK(message->getSize() == payload.length());
+
+		const char* data = (const char *) message->getData();
+		BOOST_REQUIRE(data);
+		BOOST_CHECK_MESSAGE(memcmp(data, payload.c_str(), payload.length()) == 0, "The mapped response does not match the payload.");
+		BOOST_CHECK_MESSAGE(data[payload.length()] == 0, "The mapped response is not terminated.");
+
+		char head[64];
+		BOOST_REQUIRE(pread(message->getSpoolFile(), head, sizeof(head), 0) == sizeof(head));
+		BOOST_CHECK_MESSAGE(memcmp(head, payload.c_str(), sizeof(head)) == 0, "The spool file does not match the payload.");
+	}
+
+	// Without a threshold the response is held in memory
+	{
+		mb::MessagePtr response = manager->sendMessage(manager->createMessage("spoolTestXmlInMemory"));
+		BOOST_REQUIRE(response);
+		BOOST_REQUIRE(!response->getError());
+
+		mb::StringMessage* message = (mb::StringMessage *) response.get();
+		BOOST_CHECK(!message->isSpooled());
+		BOOST_CHECK(message->getSpoolFile() == -1);
+		BOOST_CHECK(message->getSize() == payload.length());
+	}
+
+	server.stop();
+
+	std::cout << std::endl << "End HTTP spool tests..." << std::endl;
+}
@@ -0,0 +1,105 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <iostream>
+#include <stdlib.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include "HttpService.h"
+#include "HttpTransferTimings.h"
+
+BOOST_AUTO_TEST_CASE( http_transfer_timings_test ) {
+
+	std::cout << std::endl << "Begin HTTP transfer timings tests..." << std::endl;
+
+	mb::http::Histogram histogram;
+
+	BOOST_REQUIRE_MESSAGE(histogram.percentile(50) == -1, "Empty histogram returned a percentile.");
+
+	for (int i = 0; i < 8; i++)
+		histogram.add(i);
+
+	// Small values are counted exactly
+	BOOST_REQUIRE_MESSAGE(histogram.percentile(0) == 0, "Histogram minimum is not exact.");
+	BOOST_REQUIRE_MESSAGE(histogram.percentile(100) == 7, "Histogram maximum is not exact.");
+
+	mb::http::Histogram latencies;
+
+	for (int i = 1; i <= 10000; i++)
+		latencies.add(i * 100);
+
+	long long p50 = latencies.percentile(50);
+	long long p99 = latencies.percentile(99);
+	std::cout << "Histogram p50 = " << p50 << ", p99 = " << p99 << std::endl;
+
+	BOOST_REQUIRE_MESSAGE(p50 >= 500000 && p50 <= 500000 * 1.125, "Histogram median is not within the bucket precision.");
+	BOOST_REQUIRE_MESSAGE(p99 >= 990000 && p99 <= 1000000, "Histogram p99 is not within the bucket precision.");
+	BOOST_REQUIRE_MESSAGE(latencies.getMax() == 1000000, "Histogram maximum is not consistent.");
+	BOOST_REQUIRE_MESSAGE(latencies.getMean() == 500050, "Histogram mean is not consistent.");
+
+	// One transfer that opened a TLS connection and one that reused it
+
+	mb::http::TransferTiming opened;
+	opened.nameLookup = 2000;
+	opened.connect = 5000;
+	opened.appConnect = 15000;
+	opened.startTransfer = 40000;
+	opened.total = 50000;
+	opened.downloadSize = 4096;
+	opened.headerSize = 200;
+
+	mb::http::TransferTiming reused;
+	reused.startTransfer = 20000;
+	reused.total = 22000;
+	reused.downloadSize = 1024;
+	reused.uploadSize = 100;
+	reused.isReused = true;
+
+	mb::http::HttpTransferTimings timings;
+	timings.record(opened);
+	timings.record(reused);
+
+	mb::NameValueMap metrics;
+	timings.getMetrics(metrics);
+
+	BOOST_REQUIRE_MESSAGE(metrics["transfer.count"] == "2", "Transfer count metric is not consistent.");
+	BOOST_REQUIRE_MESSAGE(metrics["transfer.reused"] == "1", "Reused connection count metric is not consistent.");
+	BOOST_REQUIRE_MESSAGE(metrics["transfer.downloadBytes"] == "5120", "Download size metric is not consistent.");
+	BOOST_REQUIRE_MESSAGE(metrics["transfer.uploadBytes"] == "100", "Upload size metric is not consistent.");
+
+	// Connection phases are only recorded for the new connection
+	BOOST_REQUIRE_MESSAGE(metrics["timing.nameLookup.count"] == "1", "Name lookup recorded for a reused connection.");
+	BOOST_REQUIRE_MESSAGE(metrics["timing.connect.max"] == "3000", "Connect time is not consistent.");
+	BOOST_REQUIRE_MESSAGE(metrics["timing.appConnect.max"] == "10000", "TLS handshake time is not consistent.");
+	BOOST_REQUIRE_MESSAGE(metrics["timing.ttfb.count"] == "2", "Time to first byte count is not consistent.");
+	BOOST_REQUIRE_MESSAGE(metrics["timing.ttfb.max"] == "25000", "Time to first byte is not consistent.");
+	BOOST_REQUIRE_MESSAGE(metrics["timing.total.max"] == "50000", "Total time is not consistent.");
+
+	mb::NameValueMap metaData;
+	mb::http::HttpTransferTimings::addMetaData(opened, metaData);
+
+	BOOST_REQUIRE_MESSAGE(metaData[HTTP_TIME_APP_CONNECT] == "10000", "TLS handshake meta data is not consistent.");
+	BOOST_REQUIRE_MESSAGE(metaData[HTTP_CONNECTION_REUSED] == CSTR_FALSE, "Connection reuse meta data is not consistent.");
+
+	std::cout << std::endl << "End HTTP transfer timings tests..." << std::endl;
+}
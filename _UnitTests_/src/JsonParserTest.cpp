@@ -0,0 +1,296 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <stdio.h>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+#include <boost/test/unit_test.hpp>
+
+#include "clock.h"
+
+#include "DynaModel.h"
+#include "XmlStreamParser.h"
+#include "JsonStreamParser.h"
+
+#define BUFFER_SIZE  1024
+
+#define GENERIC_BINDING_TEST_XML   "./data/generic_binding_test.xml"
+#define GENERIC_BINDING_TEST_JSON  "./data/generic_binding_test.json"
+
+#define BENCHMARK_ITEMS       20000
+#define BENCHMARK_RUNS        5
+#define BENCHMARK_CHUNK_SIZE  16384
+
+using namespace binding;
+using namespace parser;
+
+
+// Records the parsing events as an XML like string
+class JsonEventRecorder : public JsonStreamParser {
+
+public:
+
+	bool parse(const char* data, int size, bool isFinal) {
+		return parseExternalBuffer(data, size, isFinal);
+	}
+
+	void reset() {
+		resetParser();
+		events.str("");
+	}
+
+	std::string error() {
+
+		std::ostringstream oss;
+		oss << getCurrentLineNumber() << ':' << getCurrentColumnNumber() << ' ' << getError();
+		return oss.str();
+	}
+
+	void startElement(const char* name, const char** attribs) {
+
+		events << '<' << name;
+		for (int i = 0; attribs[i]; i += 2)
+			events << ' ' << attribs[i] << "=\"" << attribs[i + 1] << '"';
+		events << '>';
+	}
+	void endElement(const char* name) {
+		events << "</" << name << '>';
+	}
+	void characters(const char* text, int len) {
+		events.write(text, len);
+	}
+
+	std::ostringstream events;
+};
+
+// Counts the bound items and their value
+class ItemBenchmarkBinder : public TypedDataBinder<long> {
+
+public:
+	ItemBenchmarkBinder() {
+		DataBinder::addEndRule("items/item/@id", endId);
+		DataBinder::addEndRule("items/item/value", endValue);
+	}
+
+	void beginBinding() {
+		this->setRoot(new long(0));
+		items = 0;
+	}
+
+	static void endId(void* binder, const char* element, const char* body) {
+		((ItemBenchmarkBinder *) binder)->items++;
+	}
+
+	static void endValue(void* binder, const char* element, const char* body) {
+
+		GET_BINDER(ItemBenchmarkBinder);
+		GET_BINDING_ROOT(total, long);
+
+		*total += atol(body);
+	}
+
+	long items;
+};
+
+std::string readFile(const char* path) {
+
+	FILE* file = fopen(path, "r");
+	BOOST_REQUIRE_MESSAGE(file != NULL, "Error opening test file " << path);
+
+	std::string contents;
+	char buffer[4096];
+	size_t len;
+
+	while ((len = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		contents.append(buffer, len);
+
+	fclose(file);
+	return contents;
+}
+
+void addGenericBindings(DynaModelBinder& dynaBinder) {
+
+	dynaBinder.addBinding("*/overview/intro", DynaModel::VALUE, "i");
+	dynaBinder.addBinding("*/overview/terms/line", DynaModel::LIST, "t");
+	dynaBinder.addBinding("*/overview/legal", DynaModel::MAP, "l" );
+	dynaBinder.addBinding("*/overview/legal/header", "h" );
+	dynaBinder.addBinding("*/overview/legal/body", "b");
+	dynaBinder.addBinding("*/overview/legal/footer", "f" );
+
+	dynaBinder.addBinding("*/summary/sumitem", DynaModel::LIST, "summary");
+	dynaBinder.addBinding("*/summary/sumitem/@id", "k", true);
+	dynaBinder.addBinding("*/summary/sumitem/name", "n");
+	dynaBinder.addBinding("*/summary/sumitem/desc", "d");
+	dynaBinder.addBinding("*/summary/sumitem/value", "v");
+
+	dynaBinder.addBinding("*/detail1/detailitem", DynaModel::MAP, "di1", "summary");
+	dynaBinder.addBinding("*/detail1/detailitem/@id", "k", true);
+	dynaBinder.addBinding("*/detail1/detailitem/value1", "v1");
+	dynaBinder.addBinding("*/detail1/detailitem/value2", "v2");
+	dynaBinder.addBinding("*/detail1/detailitem/y/z", DynaModel::LIST, "y");
+
+	dynaBinder.addBinding("*/detail2/y", DynaModel::MAP, "di2", "summary");
+	dynaBinder.addBinding("*/detail2/y/id", "k", true);
+	dynaBinder.addBinding("*/detail2/y/x", "v1");
+}
+
+std::string bindGeneric(Unmarshaller& unmarshaller, DynaModelBinder& dynaBinder, const std::string& document, size_t chunkSize) {
+
+	for (size_t i = 0; i < document.length(); i += chunkSize)
+		unmarshaller.parse(document.c_str() + i, (int) std::min(chunkSize, document.length() - i), false);
+	unmarshaller.parse("", 0, true);
+
+	std::ostringstream output;
+	output << dynaBinder.getRootPtr();
+
+	unmarshaller.reset();
+	return output.str();
+}
+
+double benchmark(Unmarshaller& unmarshaller, ItemBenchmarkBinder& binder, const std::string& document) {
+
+	long long startTime = currentTimeMicros();
+
+	for (int run = 0; run < BENCHMARK_RUNS; run++) {
+
+		for (size_t i = 0; i < document.length(); i += BENCHMARK_CHUNK_SIZE)
+			unmarshaller.parse(document.c_str() + i, (int) std::min((size_t) BENCHMARK_CHUNK_SIZE, document.length() - i), false);
+		unmarshaller.parse("", 0, true);
+
+		BOOST_REQUIRE(binder.items == BENCHMARK_ITEMS);
+		BOOST_REQUIRE(*((long *) binder.getRoot()) == 10L * BENCHMARK_ITEMS * (BENCHMARK_ITEMS - 1) / 2);
+
+		unmarshaller.reset();
+	}
+
+	long long elapsed = currentTimeMicros() - startTime;
+	return (elapsed > 0 ? document.length() * (double) BENCHMARK_RUNS / elapsed : 0.0);
+}
+
+BOOST_AUTO_TEST_CASE( json_stream_parser ) {
+
+	std::cout << std::endl << "Begin JSON stream parser tests..." << std::endl;
+
+	JsonEventRecorder recorder;
+
+	// Events are the same wherever the document is split
+	{
+		const char* document =
+			" {\"a\": {\"@id\": 7, \"@ref\": \"x\\\"y\", \"b\": [1, -2.5e+3, true, null, \"\\u00e9\\ud83d\\ude00\\n\"],"
+			" \"c\": {}, \"d\": [[\"e\"], []], \"f\": {\"@g\": [\"h\"]}}} ";
+		const char* events =
+			"<a id=\"7\" ref=\"x\"y\"><b>1</b><b>-2.5e+3</b><b>true</b><b></b><b>\xc3\xa9\xf0\x9f\x98\x80\n</b>"
+			"<c></c><d><d>e</d></d><d></d><f><@g>h</@g></f></a>";
+
+		int length = (int) strlen(document);
+
+		for (int split = 0; split <= length; split++) {
+
+			recorder.reset();
+			BOOST_REQUIRE_MESSAGE(recorder.parse(document, split, false), recorder.error());
+			BOOST_REQUIRE_MESSAGE(recorder.parse(document + split, length - split, true), recorder.error());
+			BOOST_REQUIRE_MESSAGE(recorder.events.str() == events, "Split at " << split << ": " << recorder.events.str());
+		}
+	}
+
+	// Top-level values are named with the root name
+	{
+		recorder.reset();
+		recorder.setRootName("row");
+		const char* values = "[{\"x\":1},{\"x\":2}]\n42";
+		BOOST_REQUIRE(recorder.parse(values, (int) strlen(values), true));
+		BOOST_CHECK_MESSAGE(recorder.events.str() == "<row><x>1</x></row><row><x>2</x></row><row>42</row>", recorder.events.str());
+	}
+
+	// Invalid documents are rejected with their position
+	{
+		const char* invalid[] = {
+			"{\"a\":1,}", "[1 2]", "{\"a\" 1}", "{a:1}", "[01]", "[1.]", "[tru]", "[\"\\x\"]", "[\"\t\"]", "{\"a\":[1}", "[1", ""
+		};
+
+		for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+
+			recorder.reset();
+			BOOST_CHECK_MESSAGE(!recorder.parse(invalid[i], (int) strlen(invalid[i]), true), "Invalid document was parsed: " << invalid[i]);
+		}
+
+		recorder.reset();
+		const char* misplaced = "{\n  \"a\": [1,\n  2 3]}";
+		BOOST_REQUIRE(!recorder.parse(misplaced, (int) strlen(misplaced), true));
+		BOOST_CHECK_MESSAGE(recorder.error() == "3:4 Expected a comma or the end of an object or array", recorder.error());
+	}
+
+	// Binding rules apply to the JSON and XML forms of a document alike
+	{
+		DynaModelBinder xmlDynaBinder;
+		addGenericBindings(xmlDynaBinder);
+		XmlBinder xmlBinder(&xmlDynaBinder);
+		xmlBinder.initialize();
+
+		DynaModelBinder jsonDynaBinder;
+		addGenericBindings(jsonDynaBinder);
+		JsonBinder jsonBinder(&jsonDynaBinder);
+		jsonBinder.initialize();
+
+		std::string xmlModel = bindGeneric(xmlBinder, xmlDynaBinder, readFile(GENERIC_BINDING_TEST_XML), BUFFER_SIZE);
+		std::string jsonDocument = readFile(GENERIC_BINDING_TEST_JSON);
+
+		BOOST_CHECK_MESSAGE(bindGeneric(jsonBinder, jsonDynaBinder, jsonDocument, BUFFER_SIZE) == xmlModel,
+			"The JSON document was not bound like the XML document: \n" << xmlModel);
+		BOOST_CHECK(bindGeneric(jsonBinder, jsonDynaBinder, jsonDocument, 7) == xmlModel);
+	}
+
+	// Throughput of binding equivalent JSON and XML documents
+	{
+		std::ostringstream xml, json;
+		xml << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<items>\n";
+		json << "{\"items\":{\"item\":[\n";
+
+		for (int i = 0; i < BENCHMARK_ITEMS; i++) {
+
+			xml << "<item id=\"" << i << "\"><name>Item " << i << " with a longer description</name><value>" << i * 10 << "</value></item>\n";
+			json << (i ? ",\n" : "") << "{\"@id\":" << i << ",\"name\":\"Item " << i << " with a longer description\",\"value\":" << i * 10 << '}';
+		}
+
+		xml << "</items>\n";
+		json << "\n]}}\n";
+
+		ItemBenchmarkBinder xmlItemBinder;
+		XmlBinder xmlBinder(&xmlItemBinder);
+		xmlBinder.initialize();
+
+		ItemBenchmarkBinder jsonItemBinder;
+		JsonBinder jsonBinder(&jsonItemBinder);
+		jsonBinder.initialize();
+
+		double xmlRate = benchmark(xmlBinder, xmlItemBinder, xml.str());
+		double jsonRate = benchmark(jsonBinder, jsonItemBinder, json.str());
+
+		std::cout << std::fixed << std::setprecision(1) <<
+			"\tbinding " << BENCHMARK_ITEMS << " items: xml " << xml.str().length() / 1024 << " KB at " << xmlRate << " MB/s, json " <<
+			json.str().length() / 1024 << " KB at " << jsonRate << " MB/s" << std::endl;
+	}
+
+	std::cout << std::endl << "End JSON stream parser tests..." << std::endl;
+}
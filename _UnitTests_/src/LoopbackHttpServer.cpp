@@ -0,0 +1,796 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "LoopbackHttpServer.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+
+#include <sstream>
+#include <map>
+#include <algorithm>
+
+#include "boost/bind.hpp"
+#include "boost/random/uniform_01.hpp"
+#include "boost/random/exponential_distribution.hpp"
+
+#include "log.h"
+
+#define HTTP2_PREFACE      "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"
+#define HTTP2_PREFACE_LEN  24
+
+#define HTTP2_DATA           0x0
+#define HTTP2_HEADERS        0x1
+#define HTTP2_RST_STREAM     0x3
+#define HTTP2_SETTINGS       0x4
+#define HTTP2_PING           0x6
+#define HTTP2_GOAWAY         0x7
+#define HTTP2_WINDOW_UPDATE  0x8
+#define HTTP2_CONTINUATION   0x9
+
+#define HTTP2_FLAG_ACK          0x1
+#define HTTP2_FLAG_END_STREAM   0x1
+#define HTTP2_FLAG_END_HEADERS  0x4
+
+#define HTTP2_SETTINGS_INITIAL_WINDOW_SIZE  0x4
+#define HTTP2_SETTINGS_MAX_FRAME_SIZE       0x5
+
+#define HTTP2_DEFAULT_WINDOW      65535
+#define HTTP2_DEFAULT_FRAME_SIZE  16384
+
+#define ERROR_BODY_XML   "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<error>Internal Server Error</error>\n"
+#define ERROR_BODY_JSON  "{\"error\":\"Internal Server Error\"}"
+
+
+using boost::asio::ip::tcp;
+
+
+// Buffered reads and writes on an accepted socket
+class LoopbackHttpServer::Connection {
+
+public:
+	Connection(boost::shared_ptr<tcp::socket> socket) : socket(socket) {
+	}
+
+	// Reads until at least the given number of bytes are buffered
+	bool fill(size_t len) {
+
+		char data[8192];
+		boost::system::error_code error;
+
+		while (buffer.length() < len) {
+
+			size_t size = socket->read_some(boost::asio::buffer(data, sizeof(data)), error);
+			if (error)
+				return false;
+
+			buffer.append(data, size);
+		}
+		return true;
+	}
+
+	// Reads until the delimiter is buffered and returns
+	// the number of bytes up to and including it
+	size_t fillUntil(const char* delimiter) {
+
+		size_t pos;
+		while ((pos = buffer.find(delimiter)) == std::string::npos) {
+
+			if (!fill(buffer.length() + 1))
+				return std::string::npos;
+		}
+		return pos + strlen(delimiter);
+	}
+
+	// Reads and discards the given number of bytes
+	bool discard(size_t len) {
+
+		while (len) {
+
+			if (buffer.empty() && !fill(1))
+				return false;
+
+			size_t size = std::min(len, buffer.length());
+			buffer.erase(0, size);
+			len -= size;
+		}
+		return true;
+	}
+
+	std::string consume(size_t len) {
+
+		std::string data = buffer.substr(0, len);
+		buffer.erase(0, len);
+		return data;
+	}
+
+	bool write(const std::string& data) {
+
+		boost::system::error_code error;
+		boost::asio::write(*socket, boost::asio::buffer(data), error);
+		return !error;
+	}
+
+	boost::shared_ptr<tcp::socket> socket;
+	std::string buffer;
+};
+
+
+// HTTP/2 connection state of the peer
+struct LoopbackHttpServer::Http2Session {
+
+	Http2Session() {
+		initialWindow = HTTP2_DEFAULT_WINDOW;
+		maxFrameSize = HTTP2_DEFAULT_FRAME_SIZE;
+		window = HTTP2_DEFAULT_WINDOW;
+		closed = false;
+	}
+
+	long initialWindow;
+	size_t maxFrameSize;
+
+	// Flow control windows for the data sent to the peer
+	long window;
+	std::map<unsigned int, long> streamWindows;
+
+	// Streams whose requests have been received in full
+	std::list<unsigned int> ready;
+
+	bool closed;
+};
+
+std::string http2Frame(unsigned char type, unsigned char flags, unsigned int streamId, const std::string& payload) {
+
+	std::string frame;
+	size_t len = payload.length();
+
+	frame += (char) ((len >> 16) & 0xff);
+	frame += (char) ((len >> 8) & 0xff);
+	frame += (char) (len & 0xff);
+	frame += (char) type;
+	frame += (char) flags;
+	frame += (char) ((streamId >> 24) & 0x7f);
+	frame += (char) ((streamId >> 16) & 0xff);
+	frame += (char) ((streamId >> 8) & 0xff);
+	frame += (char) (streamId & 0xff);
+	frame += payload;
+
+	return frame;
+}
+
+unsigned int http2Int(const std::string& data, size_t pos) {
+
+	return ( ((unsigned int) (unsigned char) data[pos] << 24) |
+		((unsigned int) (unsigned char) data[pos + 1] << 16) |
+		((unsigned int) (unsigned char) data[pos + 2] << 8) |
+		(unsigned int) (unsigned char) data[pos + 3] );
+}
+
+// Encodes a header as an HPACK literal without indexing
+// whose name is the given entry of the static table
+void hpackLiteral(std::string& block, unsigned int nameIndex, const std::string& value) {
+
+	// 4-bit prefix integer
+	if (nameIndex < 15)
+		block += (char) nameIndex;
+	else {
+		block += (char) 0x0f;
+		block += (char) (nameIndex - 15);
+	}
+
+	// 7-bit prefix string length without Huffman encoding
+	size_t len = value.length();
+	if (len < 127)
+		block += (char) len;
+	else {
+		block += (char) 0x7f;
+		for (len -= 127; len >= 128; len >>= 7)
+			block += (char) ((len & 0x7f) | 0x80);
+		block += (char) len;
+	}
+	block += value;
+}
+
+// Streams whose requests are complete are added to the ready list
+bool LoopbackHttpServer::readHttp2Frame(Connection& connection, Http2Session& session) {
+
+	if (!connection.fill(9))
+		return false;
+
+	std::string header = connection.consume(9);
+
+	size_t len = ( ((size_t) (unsigned char) header[0] << 16) |
+		((size_t) (unsigned char) header[1] << 8) | (size_t) (unsigned char) header[2] );
+	unsigned char type = (unsigned char) header[3];
+	unsigned char flags = (unsigned char) header[4];
+	unsigned int streamId = http2Int(header, 5) & 0x7fffffff;
+
+	if (!connection.fill(len))
+		return false;
+
+	std::string payload = connection.consume(len);
+
+	switch (type) {
+
+		case HTTP2_SETTINGS:
+
+			if (!(flags & HTTP2_FLAG_ACK)) {
+
+				for (size_t i = 0; i + 6 <= payload.length(); i += 6) {
+
+					unsigned int id = ((unsigned int) (unsigned char) payload[i] << 8) | (unsigned char) payload[i + 1];
+					long value = (long) http2Int(payload, i + 2);
+
+					if (id == HTTP2_SETTINGS_INITIAL_WINDOW_SIZE) {
+
+						// Changes to the initial window apply to all open streams
+						std::map<unsigned int, long>::iterator j;
+						for (j = session.streamWindows.begin(); j != session.streamWindows.end(); j++)
+							j->second += value - session.initialWindow;
+
+						session.initialWindow = value;
+
+					} else if (id == HTTP2_SETTINGS_MAX_FRAME_SIZE)
+						session.maxFrameSize = (size_t) value;
+				}
+
+				if (!connection.write(http2Frame(HTTP2_SETTINGS, HTTP2_FLAG_ACK, 0, "")))
+					return false;
+			}
+			break;
+
+		case HTTP2_WINDOW_UPDATE:
+
+			if (payload.length() >= 4) {
+
+				long increment = (long) (http2Int(payload, 0) & 0x7fffffff);
+				if (streamId)
+					session.streamWindows[streamId] += increment;
+				else
+					session.window += increment;
+			}
+			break;
+
+		case HTTP2_PING:
+
+			if (!(flags & HTTP2_FLAG_ACK) && !connection.write(http2Frame(HTTP2_PING, HTTP2_FLAG_ACK, 0, payload)))
+				return false;
+			break;
+
+		case HTTP2_HEADERS:
+
+			// The request headers are not needed so the header block
+			// and any continuation frames that follow it are skipped
+			session.streamWindows[streamId] = session.initialWindow;
+
+			while (!(flags & HTTP2_FLAG_END_HEADERS)) {
+
+				if (!connection.fill(9))
+					return false;
+
+				std::string continuation = connection.consume(9);
+				size_t continuationLen = ( ((size_t) (unsigned char) continuation[0] << 16) |
+					((size_t) (unsigned char) continuation[1] << 8) | (size_t) (unsigned char) continuation[2] );
+
+				if ((unsigned char) continuation[3] != HTTP2_CONTINUATION || !connection.fill(continuationLen))
+					return false;
+
+				flags |= ((unsigned char) continuation[4] & HTTP2_FLAG_END_HEADERS);
+				connection.consume(continuationLen);
+			}
+
+			if (flags & HTTP2_FLAG_END_STREAM)
+				session.ready.push_back(streamId);
+			break;
+
+		case HTTP2_DATA:
+
+			if (len) {
+
+				// Return the request body's flow control credit
+				std::string increment;
+				increment += (char) ((len >> 24) & 0x7f);
+				increment += (char) ((len >> 16) & 0xff);
+				increment += (char) ((len >> 8) & 0xff);
+				increment += (char) (len & 0xff);
+
+				if (!connection.write(http2Frame(HTTP2_WINDOW_UPDATE, 0, 0, increment)))
+					return false;
+			}
+
+			if (flags & HTTP2_FLAG_END_STREAM)
+				session.ready.push_back(streamId);
+			break;
+
+		case HTTP2_RST_STREAM:
+
+			session.streamWindows.erase(streamId);
+			break;
+
+		case HTTP2_GOAWAY:
+
+			session.closed = true;
+			break;
+
+		default:
+			break;
+	}
+
+	return true;
+}
+
+
+// **** LoopbackHttpServer Implementation ****
+
+LoopbackHttpServer::LoopbackHttpServer(const Config& config)
+	: m_config(config), m_acceptor(m_service) {
+
+	m_stopped = true;
+
+	m_connections = 0;
+	m_bytesReceived = 0;
+	m_requests = 0;
+	m_errors = 0;
+
+	std::ostringstream payload;
+	char item[256];
+	int i = 0;
+
+	if (config.contentType == mb::Message::CNT_JSON) {
+
+		payload << "{\"items\":[";
+		while ((size_t) payload.tellp() + 3 < config.payloadSize || i == 0) {
+
+			sprintf(item, "%s{\"id\":%d,\"name\":\"Item %d\",\"value\":%d}", (i ? "," : ""), i, i, i * 10);
+			payload << item;
+			i++;
+		}
+		payload << "]}";
+
+	} else {
+
+		payload << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<items>\n";
+		while ((size_t) payload.tellp() + 9 < config.payloadSize || i == 0) {
+
+			sprintf(item, "<item id=\"%d\"><name>Item %d</name><value>%d</value></item>\n", i, i, i * 10);
+			payload << item;
+			i++;
+		}
+		payload << "</items>\n";
+	}
+
+	m_payload = payload.str();
+}
+
+LoopbackHttpServer::~LoopbackHttpServer() {
+
+	this->stop();
+}
+
+void LoopbackHttpServer::start() {
+
+	tcp::endpoint endpoint(boost::asio::ip::address_v4::loopback(), 0);
+
+	m_acceptor.open(endpoint.protocol());
+	m_acceptor.set_option(tcp::acceptor::reuse_address(true));
+	m_acceptor.bind(endpoint);
+	m_acceptor.listen();
+
+	m_stopped = false;
+	m_acceptThread = boost::shared_ptr<boost::thread>(new boost::thread(&LoopbackHttpServer::accept, this));
+
+	TRACE("Loopback HTTP server listening on port %d.", (int) this->getPort());
+}
+
+void LoopbackHttpServer::stop() {
+
+	{ boost::lock_guard<boost::mutex> lock(m_lock);
+
+		if (m_stopped)
+			return;
+
+		m_stopped = true;
+	}
+
+	boost::system::error_code error;
+
+	// Wake up the blocking accept so it sees the server has stopped
+	tcp::socket wakeup(m_service);
+	wakeup.connect(m_acceptor.local_endpoint(), error);
+
+	m_acceptThread->join();
+	wakeup.close(error);
+	m_acceptor.close(error);
+
+	{ boost::lock_guard<boost::mutex> lock(m_lock);
+
+		std::list< boost::shared_ptr<tcp::socket> >::iterator i;
+		for (i = m_sockets.begin(); i != m_sockets.end(); i++)
+			(*i)->shutdown(tcp::socket::shutdown_both, error);
+	}
+
+	m_connectionThreads.join_all();
+}
+
+unsigned short LoopbackHttpServer::getPort() {
+
+	return m_acceptor.local_endpoint().port();
+}
+
+std::string LoopbackHttpServer::getUrl() {
+
+	std::ostringstream url;
+	url << "http://127.0.0.1:" << this->getPort() << '/';
+	return url.str();
+}
+
+long LoopbackHttpServer::getConnectionCount() {
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+	return m_connections;
+}
+
+long long LoopbackHttpServer::getBytesReceived() {
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+	return m_bytesReceived;
+}
+
+long LoopbackHttpServer::getRequestCount() {
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+	return m_requests;
+}
+
+long LoopbackHttpServer::getErrorCount() {
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+	return m_errors;
+}
+
+void LoopbackHttpServer::accept() {
+
+	while (true) {
+
+		boost::shared_ptr<tcp::socket> socket(new tcp::socket(m_service));
+		boost::system::error_code error;
+
+		m_acceptor.accept(*socket, error);
+		if (error)
+			break;
+
+		{ boost::lock_guard<boost::mutex> lock(m_lock);
+
+			if (m_stopped)
+				break;
+
+			m_sockets.push_back(socket);
+			m_connections++;
+		}
+
+		socket->set_option(tcp::no_delay(true), error);
+		m_connectionThreads.create_thread(boost::bind(&LoopbackHttpServer::serve, this, socket));
+	}
+}
+
+void LoopbackHttpServer::serve(boost::shared_ptr<tcp::socket> socket) {
+
+	Connection connection(socket);
+
+	// An HTTP/1.x request line can never begin with "PRI "
+	if (connection.fill(4)) {
+
+		if (connection.buffer.compare(0, 4, HTTP2_PREFACE, 4) == 0) {
+
+			if (connection.fill(HTTP2_PREFACE_LEN) && connection.consume(HTTP2_PREFACE_LEN) == HTTP2_PREFACE)
+				this->serveHttp2(connection);
+
+		} else
+			this->serveHttp1(connection);
+	}
+
+	boost::system::error_code error;
+	socket->close(error);
+
+	boost::lock_guard<boost::mutex> lock(m_lock);
+	m_sockets.remove(socket);
+}
+
+void LoopbackHttpServer::serveHttp1(Connection& connection) {
+
+	while (true) {
+
+		size_t len = connection.fillUntil("\r\n\r\n");
+		if (len == std::string::npos)
+			return;
+
+		std::istringstream head(connection.consume(len));
+		std::string line;
+
+		std::getline(head, line);
+		bool keepAlive = (line.find("HTTP/1.0") == std::string::npos);
+		bool isHead = (line.compare(0, 5, "HEAD ") == 0);
+		bool isChunked = false;
+		bool expectContinue = false;
+		size_t contentLength = 0;
+
+		while (std::getline(head, line) && line != "\r") {
+
+			size_t colon = line.find(':');
+			if (colon == std::string::npos)
+				continue;
+
+			std::string name = line.substr(0, colon);
+			std::string value = line.substr(colon + 1);
+
+			if (strcasecmp(name.c_str(), "Content-Length") == 0)
+				contentLength = (size_t) atol(value.c_str());
+			else if (strcasecmp(name.c_str(), "Connection") == 0)
+				keepAlive = (value.find("close") == std::string::npos && value.find("Close") == std::string::npos);
+			else if (strcasecmp(name.c_str(), "Transfer-Encoding") == 0)
+				isChunked = (value.find("chunked") != std::string::npos);
+			else if (strcasecmp(name.c_str(), "Expect") == 0)
+				expectContinue = (value.find("100-continue") != std::string::npos);
+		}
+
+		if (expectContinue && !connection.write("HTTP/1.1 100 Continue\r\n\r\n"))
+			return;
+
+		// The request body is discarded as it is read
+		size_t bodyLength = 0;
+
+		if (isChunked) {
+
+			while (true) {
+
+				size_t len = connection.fillUntil("\r\n");
+				if (len == std::string::npos)
+					return;
+
+				size_t chunkSize = (size_t) strtoul(connection.consume(len).c_str(), NULL, 16);
+				if (chunkSize == 0)
+					break;
+
+				if (!connection.discard(chunkSize + 2))
+					return;
+				bodyLength += chunkSize;
+			}
+
+			// Trailers end with an empty line
+			while (true) {
+
+				size_t len = connection.fillUntil("\r\n");
+				if (len == std::string::npos)
+					return;
+				if (connection.consume(len) == "\r\n")
+					break;
+			}
+
+		} else {
+
+			if (!connection.discard(contentLength))
+				return;
+			bodyLength = contentLength;
+		}
+
+		{ boost::lock_guard<boost::mutex> lock(m_lock);
+			m_bytesReceived += bodyLength;
+		}
+
+		// A HEAD request is answered at once with the
+		// headers only and is not counted as a request
+		if (isHead) {
+
+			std::ostringstream response;
+			response << "HTTP/1.1 200 OK\r\n";
+			response << "Content-Type: " << this->getContentType() << "\r\n";
+			response << "Content-Length: " << m_payload.length() << "\r\n\r\n";
+
+			if (!connection.write(response.str()) || !keepAlive)
+				return;
+
+			continue;
+		}
+
+		int status = this->nextResponse();
+
+		std::ostringstream response;
+		response << "HTTP/1.1 " << (status == 200 ? "200 OK" : "500 Internal Server Error") << "\r\n";
+		response << "Content-Type: " << this->getContentType() << "\r\n";
+		if (!keepAlive)
+			response << "Connection: close\r\n";
+
+		if (status != 200) {
+
+			std::string body = (m_config.contentType == mb::Message::CNT_JSON ? ERROR_BODY_JSON : ERROR_BODY_XML);
+			response << "Content-Length: " << body.length() << "\r\n\r\n" << body;
+
+			if (!connection.write(response.str()))
+				return;
+
+		} else if (m_config.chunkSize) {
+
+			response << "Transfer-Encoding: chunked\r\n\r\n";
+			if (!connection.write(response.str()))
+				return;
+
+			// Each chunk is written on its own so the
+			// client receives the payload in pieces
+			for (size_t i = 0; i < m_payload.length(); i += m_config.chunkSize) {
+
+				std::string data = m_payload.substr(i, m_config.chunkSize);
+
+				if (i && m_config.chunkDelay)
+					boost::this_thread::sleep(boost::posix_time::milliseconds(m_config.chunkDelay));
+
+				char size[20];
+				sprintf(size, "%lx\r\n", (unsigned long) data.length());
+
+				if (!connection.write(size + data + "\r\n"))
+					return;
+			}
+
+			if (!connection.write("0\r\n\r\n"))
+				return;
+
+		} else {
+
+			response << "Content-Length: " << m_payload.length() << "\r\n\r\n" << m_payload;
+			if (!connection.write(response.str()))
+				return;
+		}
+
+		if (!keepAlive)
+			return;
+	}
+}
+
+void LoopbackHttpServer::serveHttp2(Connection& connection) {
+
+	Http2Session session;
+
+	if (!connection.write(http2Frame(HTTP2_SETTINGS, 0, 0, "")))
+		return;
+
+	while (!session.closed) {
+
+		if (session.ready.empty()) {
+
+			if (!this->readHttp2Frame(connection, session))
+				return;
+			continue;
+		}
+
+		unsigned int streamId = session.ready.front();
+		session.ready.pop_front();
+
+		int status = this->nextResponse();
+
+		std::string body = ( status == 200 ? m_payload :
+			m_config.contentType == mb::Message::CNT_JSON ? ERROR_BODY_JSON : ERROR_BODY_XML );
+
+		std::ostringstream contentLength;
+		contentLength << body.length();
+
+		// Indexed :status 200 or :status 500 followed
+		// by the content-type and content-length
+		std::string block;
+		block += (char) (status == 200 ? 0x88 : 0x8e);
+		hpackLiteral(block, 31, this->getContentType());
+		hpackLiteral(block, 28, contentLength.str());
+
+		if (!connection.write(http2Frame(HTTP2_HEADERS, HTTP2_FLAG_END_HEADERS, streamId, block)))
+			return;
+
+		size_t frameSize = ( m_config.chunkSize && m_config.chunkSize < session.maxFrameSize ?
+			m_config.chunkSize : session.maxFrameSize );
+
+		size_t i = 0;
+		while (i < body.length()) {
+
+			long window = session.streamWindows[streamId];
+			if (session.window < window)
+				window = session.window;
+
+			if (window <= 0) {
+
+				// Wait for the client to open the flow control window
+				if (!this->readHttp2Frame(connection, session) || session.closed)
+					return;
+				continue;
+			}
+
+			size_t len = body.length() - i;
+			if (len > frameSize)
+				len = frameSize;
+			if (len > (size_t) window)
+				len = (size_t) window;
+
+			bool last = (i + len == body.length());
+
+			if (i && m_config.chunkDelay)
+				boost::this_thread::sleep(boost::posix_time::milliseconds(m_config.chunkDelay));
+
+			if (!connection.write(http2Frame(HTTP2_DATA, (last ? HTTP2_FLAG_END_STREAM : 0), streamId, body.substr(i, len))))
+				return;
+
+			session.window -= len;
+			session.streamWindows[streamId] -= len;
+			i += len;
+		}
+
+		session.streamWindows.erase(streamId);
+	}
+}
+
+int LoopbackHttpServer::nextResponse() {
+
+	long latency = 0;
+	bool isError;
+
+	{ boost::lock_guard<boost::mutex> lock(m_lock);
+
+		boost::uniform_01<double> uniform;
+
+		switch (m_config.latency) {
+
+			case UNIFORM:
+				latency = (long) (uniform(m_random) * 2 * m_config.latencyMean);
+				break;
+
+			case EXPONENTIAL:
+
+				if (m_config.latencyMean > 0) {
+
+					boost::exponential_distribution<double> exponential(1.0 / m_config.latencyMean);
+					latency = (long) exponential(m_random);
+				}
+				break;
+
+			case FIXED:
+			default:
+				latency = m_config.latencyMean;
+				break;
+		}
+
+		if (m_config.latencyMax > 0 && latency > m_config.latencyMax)
+			latency = m_config.latencyMax;
+
+		isError = (m_config.errorRate > 0.0 && uniform(m_random) < m_config.errorRate);
+
+		m_requests++;
+		if (isError)
+			m_errors++;
+	}
+
+	if (latency > 0)
+		boost::this_thread::sleep(boost::posix_time::milliseconds(latency));
+
+	return (isError ? 500 : 200);
+}
+
+const char* LoopbackHttpServer::getContentType() {
+
+	return (m_config.contentType == mb::Message::CNT_JSON ? "application/json" : "text/xml");
+}
@@ -0,0 +1,153 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#ifndef LOOPBACKHTTPSERVER_H_
+#define LOOPBACKHTTPSERVER_H_
+
+#include <string>
+#include <list>
+
+#include "boost/asio.hpp"
+#include "boost/thread.hpp"
+#include "boost/shared_ptr.hpp"
+#include "boost/random/mersenne_twister.hpp"
+
+#include "Service.h"
+
+
+/* Self-contained HTTP server bound to the loopback interface
+ * which serves a canned XML or JSON payload for every request.
+ * Connections starting with the HTTP/2 connection preface are
+ * served over HTTP/2 (h2c with prior knowledge), all others
+ * over HTTP/1.1 with keep-alive. The payload size, chunking,
+ * latency distribution and error rate are configurable.
+ */
+class LoopbackHttpServer {
+
+public:
+	enum LatencyDistribution {
+		FIXED,        // Always the mean latency
+		UNIFORM,      // Uniform between 0 and twice the mean
+		EXPONENTIAL   // Exponential with the mean capped at the max
+	};
+
+	struct Config {
+
+		Config() {
+			contentType = mb::Message::CNT_XML;
+			payloadSize = 16384;
+			chunkSize = 0;
+			chunkDelay = 0;
+			latency = FIXED;
+			latencyMean = 0;
+			latencyMax = 0;
+			errorRate = 0.0;
+		}
+
+		mb::Message::ContentType contentType;
+		size_t payloadSize;
+
+		// Size of the chunks the payload is written in. The payload
+		// is sent with chunked transfer encoding over HTTP/1.1 and
+		// as DATA frames of this size over HTTP/2. If 0 the payload
+		// is written at once with a Content-Length.
+		size_t chunkSize;
+		// Delay in milli-seconds before each chunk after the first
+		long chunkDelay;
+
+		// Response latency in milli-seconds
+		LatencyDistribution latency;
+		long latencyMean;
+		long latencyMax;
+
+		// Fraction of requests that fail with a 500 response
+		double errorRate;
+	};
+
+public:
+	LoopbackHttpServer(const Config& config);
+	virtual ~LoopbackHttpServer();
+
+	/* Starts listening on an ephemeral loopback port */
+	void start();
+	void stop();
+
+	unsigned short getPort();
+	std::string getUrl();
+
+	const std::string& getPayload() {
+		return m_payload;
+	}
+
+	/* Number of connections accepted since the server started */
+	long getConnectionCount();
+
+	/* Size of the request bodies received over HTTP/1.1 */
+	long long getBytesReceived();
+
+	long getRequestCount();
+	long getErrorCount();
+
+private:
+
+	class Connection;
+	struct Http2Session;
+
+	void accept();
+	void serve(boost::shared_ptr<boost::asio::ip::tcp::socket> socket);
+
+	void serveHttp1(Connection& connection);
+	void serveHttp2(Connection& connection);
+
+	// Reads the next HTTP/2 frame and handles connection level frames
+	bool readHttp2Frame(Connection& connection, Http2Session& session);
+
+	// Returns the status of the next response after
+	// waiting for the response latency
+	int nextResponse();
+
+	const char* getContentType();
+
+	Config m_config;
+	std::string m_payload;
+
+	boost::asio::io_service m_service;
+	boost::asio::ip::tcp::acceptor m_acceptor;
+
+	boost::shared_ptr<boost::thread> m_acceptThread;
+	boost::thread_group m_connectionThreads;
+
+	boost::mutex m_lock;
+	std::list< boost::shared_ptr<boost::asio::ip::tcp::socket> > m_sockets;
+	bool m_stopped;
+
+	boost::mt19937 m_random;
+
+	long m_connections;
+	long long m_bytesReceived;
+	long m_requests;
+	long m_errors;
+};
+
+
+#endif /* LOOPBACKHTTPSERVER_H_ */
@@ -0,0 +1,131 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <iostream>
+#include <sstream>
+#include <set>
+#include <algorithm>
+
+#include <boost/test/unit_test.hpp>
+
+#include "Path.h"
+#include "PathAutomaton.h"
+#include "DynaModel.h"
+
+using namespace binding;
+
+
+const char* _patterns[] = {
+	"a/b", "*/b", "?/b", "*/a/?/c", "a", "*", "/a/b", "a/?", "*/?/b/c", "x/*", "*/a/@id", "b/b/b/b"
+};
+
+const char* _elements[] = { "a", "b", "c", "x" };
+
+// Checks the patterns matched by the automaton for every path of
+// up to the given depth against the patterns matched by Path
+void checkPaths(PathAutomaton& automaton, Path& path, int state, int depth) {
+
+	std::set<int> matches(automaton.getMatches(state).begin(), automaton.getMatches(state).end());
+
+	for (int i = 0; i < (int) (sizeof(_patterns) / sizeof(_patterns[0])); i++) {
+
+		Path pattern(_patterns[i]);
+		bool isMatch = (path == pattern);
+
+		BOOST_CHECK_MESSAGE(isMatch == (matches.find(i) != matches.end()),
+			"Pattern '" << _patterns[i] << "' " << (isMatch ? "should" : "should not") << " match path '" << path.str() << "'");
+	}
+
+	if (!depth)
+		return;
+
+	for (int i = 0; i < (int) (sizeof(_elements) / sizeof(_elements[0])); i++) {
+
+		path.push(_elements[i]);
+		checkPaths(automaton, path, automaton.next(state, _elements[i]), depth - 1);
+		path.pop();
+	}
+}
+
+BOOST_AUTO_TEST_CASE( path_automaton_test ) {
+
+	std::cout << std::endl << "Begin path automaton tests..." << std::endl;
+
+	PathAutomaton automaton;
+	for (int i = 0; i < (int) (sizeof(_patterns) / sizeof(_patterns[0])); i++)
+		BOOST_REQUIRE(automaton.add(_patterns[i]) == i);
+
+	automaton.compile();
+	std::cout << "\t" << sizeof(_patterns) / sizeof(_patterns[0]) << " patterns compiled to " << automaton.getNumStates() << " states" << std::endl;
+
+	// Matches are the same as those of Path
+	{
+		Path path;
+		int start = automaton.getStart();
+
+		for (int i = 0; i < (int) (sizeof(_elements) / sizeof(_elements[0])); i++) {
+
+			path.push(_elements[i]);
+			checkPaths(automaton, path, automaton.next(start, _elements[i]), 4);
+			path.pop();
+		}
+	}
+
+	// Attributes and names not in any pattern
+	{
+		int state = automaton.next(automaton.next(automaton.getStart(), "q"), "a");
+
+		std::vector<int> matches = automaton.getMatches(automaton.nextAttribute(state, "id"));
+		BOOST_CHECK(std::find(matches.begin(), matches.end(), 10) != matches.end());
+
+		matches = automaton.getMatches(automaton.nextAttribute(state, "ref"));
+		BOOST_CHECK(std::find(matches.begin(), matches.end(), 10) == matches.end());
+
+		BOOST_CHECK(automaton.next(state, "unknown") == automaton.next(state, "other"));
+	}
+
+	// Binders created from the same config share the compiled rules
+	{
+		DynaModelBindingConfig config;
+
+		std::map<std::string, std::string> attribs;
+		attribs["path"] = "*/items/item";
+		attribs["type"] = "list";
+		attribs["key"] = "items";
+		config.beginBindingConfigElement(attribs);
+
+		attribs.clear();
+		attribs["path"] = "name";
+		attribs["key"] = "name";
+		config.beginBindingConfigElement(attribs);
+		config.endBindingConfigElement();
+		config.endBindingConfigElement();
+
+		DynaModelBinder binder1(&config);
+		DynaModelBinder binder2(&config);
+
+		BOOST_REQUIRE(binder1.getRules());
+		BOOST_CHECK_MESSAGE(binder1.getRules() == binder2.getRules(), "The compiled rules are not shared.");
+	}
+
+	std::cout << std::endl << "End path automaton tests..." << std::endl;
+}
@@ -0,0 +1,191 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "Service.h"
+#include "HttpService.h"
+#include "RequestBatcher.h"
+
+struct BatchedResponse {
+
+	BatchedResponse() {
+		done = false;
+	}
+
+	static bool onData(void* context, mb::MessagePtr message, void* buffer, size_t size) {
+
+		if (!size)
+			((BatchedResponse *) context)->done = true;
+		return true;
+	}
+
+	binding::DynaModelNode item(mb::MessagePtr response) {
+
+		binding::DynaModelNode* data = (binding::DynaModelNode *) ((mb::StreamMessage *) response.get())->detachBoundData();
+		if (!data)
+			return binding::DynaModelNode();
+
+		binding::DynaModelNode node = *data;
+		delete data;
+		return node;
+	}
+
+	bool done;
+};
+
+struct ExecutedBatches {
+
+	void execute(mb::http::RequestBatchPtr batch) {
+
+		boost::lock_guard<boost::mutex> lock(this->lock);
+		batches.push_back(batch);
+		executed.notify_all();
+	}
+
+	bool wait(size_t count, long millis) {
+
+		boost::unique_lock<boost::mutex> lock(this->lock);
+		const boost::system_time timeout = boost::get_system_time() + boost::posix_time::milliseconds(millis);
+
+		while (batches.size() < count)
+			if (!executed.timed_wait(lock, timeout))
+				return (batches.size() >= count);
+
+		return true;
+	}
+
+	boost::mutex lock;
+	boost::condition_variable executed;
+
+	std::vector<mb::http::RequestBatchPtr> batches;
+};
+
+mb::MessagePtr createBatchedResponse(BatchedResponse* context) {
+
+	mb::MessagePtr response(new mb::StreamMessage());
+	((mb::StreamMessage *) response.get())->setCallback(context, BatchedResponse::onData);
+	return response;
+}
+
+void addBatchedRequest(mb::http::RequestBatcher& batcher, const char* compatibilityKey, const char* id, mb::MessagePtr response) {
+
+	mb::NameValueMap variables;
+	variables["id"] = id;
+	variables["region"] = "emea";
+
+	batcher.add(compatibilityKey, mb::MessagePtr(new mb::http::HttpMessage(mb::http::HttpMessage::GET)), response, variables);
+}
+
+BOOST_AUTO_TEST_CASE( request_batcher_test ) {
+
+	std::cout << std::endl << "Begin request batcher tests..." << std::endl;
+
+	ExecutedBatches executed;
+	mb::http::RequestBatcher batcher(boost::bind(&ExecutedBatches::execute, &executed, _1), "id", "items/id", ",", 3, 50);
+
+	BatchedResponse a1, b, a2, c, x;
+
+	mb::MessagePtr a1Response = createBatchedResponse(&a1);
+	mb::MessagePtr bResponse = createBatchedResponse(&b);
+	mb::MessagePtr a2Response = createBatchedResponse(&a2);
+	mb::MessagePtr cResponse = createBatchedResponse(&c);
+	mb::MessagePtr xResponse = createBatchedResponse(&x);
+
+	// A batch is executed as soon as it is full
+
+	addBatchedRequest(batcher, "emea", "a", a1Response);
+	addBatchedRequest(batcher, "emea", "b", bResponse);
+	addBatchedRequest(batcher, "emea", "a", a2Response);
+	BOOST_REQUIRE_MESSAGE(executed.batches.size() == 0, "Batch was executed before it was full.");
+
+	addBatchedRequest(batcher, "emea", "c", cResponse);
+	BOOST_REQUIRE_MESSAGE(executed.batches.size() == 1, "Full batch was not executed.");
+
+	mb::http::RequestBatchPtr batch = executed.batches[0];
+	BOOST_REQUIRE_MESSAGE(batch->variables["id"] == "a,b,c", "Batch keys were not joined into the batch parameter.");
+	BOOST_REQUIRE_MESSAGE(batch->variables["region"] == "emea", "Batch did not keep the other template variables.");
+	BOOST_REQUIRE_MESSAGE(batch->responses.size() == 4, "Batch does not hold all of its requests.");
+
+	// An incompatible request is executed in its own batch after the maximum wait
+
+	addBatchedRequest(batcher, "apac", "x", xResponse);
+	BOOST_REQUIRE_MESSAGE(executed.wait(2, 1000), "Batch was not executed after the maximum wait.");
+	BOOST_REQUIRE_MESSAGE(executed.batches[1]->variables["id"] == "x", "Incompatible request was batched.");
+
+	// The bound response is split by the key path
+
+	binding::DynaModelNode root = binding::DynaModel::create();
+	binding::DynaModelNode items = root->add("items", binding::DynaModel::LIST);
+
+	binding::DynaModelNode itemA = items->add();
+	itemA->setValue("id", "a");
+	itemA->setValue("value", "1");
+
+	binding::DynaModelNode itemB = items->add();
+	itemB->setValue("id", "b");
+	itemB->setValue("value", "2");
+
+	mb::MessagePtr result(new mb::DataMessage());
+	result->setData(&root);
+
+	batcher.complete(batch, result);
+
+	BOOST_REQUIRE_MESSAGE(a1.done && a2.done && b.done && c.done, "Batched requests were not completed.");
+
+	BOOST_REQUIRE_MESSAGE(a1.item(a1Response) == itemA, "Batched request did not receive its item.");
+	BOOST_REQUIRE_MESSAGE(a2.item(a2Response) == itemA, "Requests for the same key did not share the item.");
+	BOOST_REQUIRE_MESSAGE(b.item(bResponse) == itemB, "Batched request did not receive its item.");
+	BOOST_REQUIRE_MESSAGE(bResponse->getMetaData()[HTTP_BATCH_SIZE] == "4", "Batch size meta data is not consistent.");
+
+	BOOST_REQUIRE_MESSAGE(cResponse->getErrorCode() == 404, "Request without an item in the batch response did not fail.");
+
+	// An error fails every request of the batch
+
+	mb::MessagePtr error(new mb::DataMessage());
+	error->setError(mb::Message::ERR_SERVICE, 503, "Service unavailable.");
+
+	batcher.complete(executed.batches[1], error);
+
+	BOOST_REQUIRE_MESSAGE(x.done && xResponse->getErrorCode() == 503, "Batched request did not receive the batch error.");
+
+	// Items of a map are found by their keys
+
+	binding::DynaModelNode keyed = binding::DynaModel::create();
+	binding::DynaModelNode quote = keyed->add("quotes")->add("IBM");
+
+	BOOST_REQUIRE_MESSAGE(mb::http::RequestBatcher::findItem(keyed, "quotes", "IBM") == quote, "Item was not found by its key.");
+	BOOST_REQUIRE_MESSAGE(!mb::http::RequestBatcher::findItem(keyed, "quotes", "MSFT"), "Item was found for a missing key.");
+
+	mb::NameValueMap metrics;
+	batcher.getMetrics(metrics);
+
+	BOOST_REQUIRE_MESSAGE(metrics["batch.requests"] == "5", "Batched requests metric is not consistent.");
+	BOOST_REQUIRE_MESSAGE(metrics["batch.batches"] == "2", "Batches metric is not consistent.");
+	BOOST_REQUIRE_MESSAGE(metrics["batch.missing"] == "1", "Missing items metric is not consistent.");
+
+	std::cout << std::endl << "End request batcher tests..." << std::endl;
+}
@@ -0,0 +1,122 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+
+#include <iostream>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+#include "Service.h"
+#include "RequestCoalescer.h"
+
+struct CoalescedResponse {
+
+	CoalescedResponse() {
+		done = false;
+	}
+
+	static bool onData(void* context, mb::MessagePtr message, void* buffer, size_t size) {
+
+		CoalescedResponse* response = (CoalescedResponse *) context;
+		if (size)
+			response->data.append((const char *) buffer, size);
+		else
+			response->done = true;
+		return true;
+	}
+
+	std::string data;
+	bool done;
+};
+
+mb::MessagePtr createCoalescedResponse(CoalescedResponse* context, bool isModel) {
+
+	mb::MessagePtr response(new mb::StreamMessage());
+	response->getMetaData()[DATA_IS_DYNA_MODEL] = (isModel ? CSTR_TRUE : CSTR_FALSE);
+	((mb::StreamMessage *) response.get())->setCallback(context, CoalescedResponse::onData);
+	return response;
+}
+
+BOOST_AUTO_TEST_CASE( request_coalescer_test ) {
+
+	std::cout << std::endl << "Begin request coalescer tests..." << std::endl;
+
+	mb::http::RequestCoalescer coalescer(false);
+
+	// Streamed responses
+
+	CoalescedResponse leader, follower, late;
+
+	mb::MessagePtr leaderResponse = createCoalescedResponse(&leader, false);
+	mb::MessagePtr followerResponse = createCoalescedResponse(&follower, false);
+	mb::MessagePtr lateResponse = createCoalescedResponse(&late, false);
+
+	BOOST_REQUIRE_MESSAGE(coalescer.join("a", leaderResponse), "First request did not lead.");
+	BOOST_REQUIRE_MESSAGE(!coalescer.join("a", followerResponse), "Identical request was not coalesced.");
+
+	((mb::StreamMessage *) leaderResponse.get())->sendData(leaderResponse, (void *) "abc", 3);
+	BOOST_REQUIRE_MESSAGE(coalescer.join("a", lateResponse), "Request was coalesced after the response started streaming.");
+
+	((mb::StreamMessage *) leaderResponse.get())->sendData(leaderResponse, (void *) "def", 3);
+	leaderResponse->setError(mb::Message::ERR_SERVICE, 404, "Not found.");
+	((mb::StreamMessage *) leaderResponse.get())->sendData(leaderResponse, NULL, 0);
+
+	BOOST_REQUIRE_MESSAGE(follower.done && follower.data == "abcdef", "Coalesced request did not receive the streamed response.");
+	BOOST_REQUIRE_MESSAGE(followerResponse->getErrorCode() == 404, "Coalesced request did not receive the response error.");
+	BOOST_REQUIRE_MESSAGE(!late.done, "Request executed on its own was completed by the leader.");
+
+	BOOST_REQUIRE_MESSAGE(coalescer.join("a", lateResponse), "Request did not lead after the previous request completed.");
+	((mb::StreamMessage *) lateResponse.get())->sendData(lateResponse, NULL, 0);
+
+	// Bound responses
+
+	CoalescedResponse modelLeader, modelFollower;
+
+	mb::MessagePtr modelLeaderResponse = createCoalescedResponse(&modelLeader, true);
+	mb::MessagePtr modelFollowerResponse = createCoalescedResponse(&modelFollower, true);
+
+	BOOST_REQUIRE_MESSAGE(coalescer.join("b", modelLeaderResponse), "First bound request did not lead.");
+	((mb::StreamMessage *) modelLeaderResponse.get())->sendData(modelLeaderResponse, (void *) "<a/>", 4);
+	BOOST_REQUIRE_MESSAGE(!coalescer.join("b", modelFollowerResponse), "Bound request was not coalesced after the response started streaming.");
+
+	boost::shared_ptr<binding::DynaModel> model = binding::DynaModel::create();
+	((mb::StreamMessage *) modelLeaderResponse.get())->notifyBoundData(modelLeaderResponse, &model);
+	((mb::StreamMessage *) modelLeaderResponse.get())->sendData(modelLeaderResponse, NULL, 0);
+
+	BOOST_REQUIRE_MESSAGE(modelFollower.done && modelFollower.data.length() == 0, "Coalesced bound request was streamed the response.");
+
+	boost::shared_ptr<binding::DynaModel>* shared =
+		(boost::shared_ptr<binding::DynaModel> *) ((mb::StreamMessage *) modelFollowerResponse.get())->detachBoundData();
+
+	BOOST_REQUIRE_MESSAGE(shared && *shared == model, "Coalesced bound request did not share the bound response.");
+	delete shared;
+
+	mb::NameValueMap metrics;
+	coalescer.getMetrics(metrics);
+
+	BOOST_REQUIRE_MESSAGE(metrics["coalesce.requests"] == "6", "Coalesced requests metric is not consistent.");
+	BOOST_REQUIRE_MESSAGE(metrics["coalesce.coalesced"] == "2", "Coalesced metric is not consistent.");
+	BOOST_REQUIRE_MESSAGE(metrics["coalesce.inFlight"] == "0", "In-flight metric is not consistent.");
+
+	std::cout << std::endl << "End request coalescer tests..." << std::endl;
+}
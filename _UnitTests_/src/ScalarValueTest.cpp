@@ -0,0 +1,234 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <locale.h>
+#include <string.h>
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+
+#include <boost/test/unit_test.hpp>
+
+#include "scalar.h"
+
+#include "DynaModel.h"
+#include "XmlStreamParser.h"
+
+using namespace binding;
+using namespace parser;
+
+
+const char* _typedValueTestXml =
+	"<items>"
+	"<item id=\"a\"><price>12.50</price><qty>7</qty><active>true</active><updated>2024-02-29T12:34:56.789Z</updated><size>12x34</size></item>"
+	"<item id=\"b\"><price>9.75</price><qty>-3</qty><active>0</active><updated>2024-02-29T12:34:56+02:00</updated><size>5x6</size></item>"
+	"<item id=\"c\"><price>100</price><qty>many</qty><active>false</active><updated>2021-03-04</updated><size>1x2</size></item>"
+	"</items>";
+
+void addTypedBinding(DynaModelBindingConfig& config, const char* path, const char* key, const char* type, bool isIdx = false) {
+
+	std::map<std::string, std::string> attribs;
+	attribs["path"] = path;
+	attribs["key"] = key;
+	attribs["type"] = type;
+	attribs["index"] = (isIdx ? "true" : "false");
+
+	config.beginBindingConfigElement(attribs);
+	config.endBindingConfigElement();
+}
+
+void createTypedBindingConfig(DynaModelBindingConfig& config) {
+
+	std::map<std::string, std::string> attribs;
+
+	attribs["path"] = "items/item";
+	attribs["key"] = "items";
+	attribs["type"] = "list";
+	config.beginBindingConfigElement(attribs);
+	config.endBindingConfigElement();
+
+	addTypedBinding(config, "items/item/@id", "id", "value", true);
+	addTypedBinding(config, "items/item/price", "price", "double");
+	addTypedBinding(config, "items/item/qty", "qty", "int64");
+	addTypedBinding(config, "items/item/active", "active", "bool");
+	addTypedBinding(config, "items/item/updated", "updated", "timestamp");
+
+	// The parts of a value parsed by rules can be typed too
+	attribs.clear();
+	attribs["path"] = "items/item/size";
+	config.beginBindingConfigElement(attribs);
+
+	attribs.clear();
+	attribs["key"] = "width";
+	attribs["delim"] = "x";
+	attribs["type"] = "int64";
+	config.beginParseRule(attribs);
+
+	attribs["key"] = "height";
+	config.beginParseRule(attribs);
+
+	config.endBindingConfigElement();
+}
+
+bool comparePrice(DynaModelNode item, DynaModelNode other) {
+	return item->get("price")->compare(*other->get("price")) < 0;
+}
+
+BOOST_AUTO_TEST_CASE( scalar_parser_test ) {
+
+	std::cout << std::endl << "Begin scalar parser tests..." << std::endl;
+
+	long long i = 0;
+	BOOST_CHECK(parseInt64(" 42 ", i) && i == 42);
+	BOOST_CHECK(parseInt64("+7", i) && i == 7);
+	BOOST_CHECK(parseInt64("9223372036854775807", i) && i == 9223372036854775807LL);
+	BOOST_CHECK(parseInt64("-9223372036854775808", i) && i == -9223372036854775807LL - 1);
+	BOOST_CHECK(!parseInt64("9223372036854775808", i));
+	BOOST_CHECK(!parseInt64("1.0", i));
+	BOOST_CHECK(!parseInt64("4 2", i));
+	BOOST_CHECK(!parseInt64("-", i));
+	BOOST_CHECK(!parseInt64("", i));
+	BOOST_CHECK_EQUAL(i, -9223372036854775807LL - 1);
+
+	double d = 0;
+	BOOST_CHECK(parseDouble("0.1", d) && d == 0.1);
+	BOOST_CHECK(parseDouble("-2.5e+3", d) && d == -2500.0);
+	BOOST_CHECK(parseDouble("1e-5", d) && d == 1e-5);
+	BOOST_CHECK(parseDouble(".5", d) && d == 0.5);
+	BOOST_CHECK(parseDouble("3.", d) && d == 3.0);
+	BOOST_CHECK(parseDouble("0.000000000000000000000000000001", d) && d == 1e-30);
+	BOOST_CHECK(parseDouble("123456789012345678901234", d) && d == 1.2345678901234569e+23);
+	BOOST_CHECK(parseDouble("1.7976931348623157e308", d) && d == 1.7976931348623157e308);
+	BOOST_CHECK(!parseDouble("1e400", d));
+	BOOST_CHECK(!parseDouble("1e", d));
+	BOOST_CHECK(!parseDouble(".", d));
+	BOOST_CHECK(!parseDouble("1,5", d));
+	BOOST_CHECK(!parseDouble("nan", d));
+
+	// The decimal point does not depend on the locale
+	std::string locale = setlocale(LC_NUMERIC, NULL);
+	if (setlocale(LC_NUMERIC, "de_DE.UTF-8") || setlocale(LC_NUMERIC, "fr_FR.UTF-8")) {
+
+		BOOST_CHECK(parseDouble("0.5", d) && d == 0.5);
+		BOOST_CHECK(parseDouble("12345678901234567890.5", d) && d == 12345678901234567890.5);
+		setlocale(LC_NUMERIC, locale.c_str());
+	}
+
+	bool b = false;
+	BOOST_CHECK(parseBool("true", b) && b);
+	BOOST_CHECK(parseBool(" 0 ", b) && !b);
+	BOOST_CHECK(parseBool("1", b) && b);
+	BOOST_CHECK(parseBool("false", b) && !b);
+	BOOST_CHECK(!parseBool("yes", b));
+	BOOST_CHECK(!parseBool("truex", b));
+
+	long long t = 0;
+	BOOST_CHECK(parseTimestamp("1970-01-01", t) && t == 0);
+	BOOST_CHECK(parseTimestamp("1969-12-31T23:59:59Z", t) && t == -1000);
+	BOOST_CHECK(parseTimestamp("2024-02-29T12:34:56.789Z", t) && t == 1709210096789LL);
+	BOOST_CHECK(parseTimestamp("2024-02-29 12:34:56.789", t) && t == 1709210096789LL);
+	BOOST_CHECK(parseTimestamp("2024-02-29T12:34:56+02:00", t) && t == 1709202896000LL);
+	BOOST_CHECK(parseTimestamp("2024-02-29T12:34:56+0200", t) && t == 1709202896000LL);
+	BOOST_CHECK(parseTimestamp("2024-02-29T14:34-02", t) && t == 1709224440000LL);
+	BOOST_CHECK(!parseTimestamp("2023-02-29", t));
+	BOOST_CHECK(!parseTimestamp("2024-13-01", t));
+	BOOST_CHECK(!parseTimestamp("2024-01-01T24:00", t));
+	BOOST_CHECK(!parseTimestamp("2024-01-01T12", t));
+	BOOST_CHECK(!parseTimestamp("20240101", t));
+
+	std::cout << std::endl << "End scalar parser tests..." << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE( dynamodel_typed_value_test ) {
+
+	std::cout << std::endl << "Begin typed dyna model value tests..." << std::endl;
+
+	DynaModelBindingConfig config;
+	createTypedBindingConfig(config);
+
+	std::string xml = _typedValueTestXml;
+
+	for (int compact = 0; compact < 2; compact++) {
+
+		DynaModelBinder dynaBinder(&config);
+		dynaBinder.setCompact(compact != 0);
+
+		XmlBinder xmlBinder(&dynaBinder);
+		xmlBinder.initialize();
+		xmlBinder.parse(xml.c_str(), (int) xml.length(), true);
+
+		DynaModelNode items = dynaBinder.getRootPtr()->get("items");
+		BOOST_REQUIRE(items.get() && items->size() == 3);
+
+		DynaModelNode a = items->get("a");
+		DynaModelNode b = items->get("b");
+		DynaModelNode c = items->get("c");
+
+		// Typed values keep the text they were bound from
+		BOOST_CHECK(a->get("price")->valueType() == DynaModel::VAL_DOUBLE);
+		BOOST_CHECK_EQUAL(a->get("price")->value(), "12.50");
+		BOOST_CHECK_EQUAL(a->get("price")->doubleValue(), 12.5);
+		BOOST_CHECK_EQUAL(a->get("qty")->intValue(), 7);
+		BOOST_CHECK_EQUAL(b->get("qty")->intValue(), -3);
+		BOOST_CHECK(a->get("active")->boolValue() && !b->get("active")->boolValue());
+		BOOST_CHECK_EQUAL(a->get("updated")->timestampValue(), 1709210096789LL);
+		BOOST_CHECK_EQUAL(b->get("updated")->timestampValue(), 1709202896000LL);
+		BOOST_CHECK_EQUAL(c->get("updated")->timestampValue(), 1614816000000LL);
+		BOOST_CHECK(a->get("id")->valueType() == DynaModel::VAL_STRING);
+
+		// Values that cannot be parsed are bound as strings
+		BOOST_CHECK(c->get("qty")->valueType() == DynaModel::VAL_STRING);
+		BOOST_CHECK_EQUAL(c->get("qty")->value(), "many");
+		BOOST_CHECK_EQUAL(c->get("qty")->intValue(-1), -1);
+
+		// String values are parsed by the typed accessors
+		BOOST_CHECK_EQUAL(a->get("id")->intValue(5), 5);
+
+		BOOST_CHECK(a->get("width")->valueType() == DynaModel::VAL_INT64);
+		BOOST_CHECK_EQUAL(a->get("width")->intValue() * a->get("height")->intValue(), 12 * 34);
+
+		// Typed values compare as numbers rather than as text
+		BOOST_CHECK_EQUAL(c->get("price")->compare(*a->get("price")), 1);
+		BOOST_CHECK_EQUAL(a->get("price")->compare(*a->get("price")), 0);
+		BOOST_CHECK_EQUAL(b->get("qty")->compare(*a->get("price")), -1);
+		BOOST_CHECK_EQUAL(a->get("id")->compare(*b->get("id")), -1);
+
+		std::vector<DynaModelNode> sorted;
+		for (int i = 0; i < items->size(); i++)
+			sorted.push_back(items->get(i));
+
+		std::sort(sorted.begin(), sorted.end(), comparePrice);
+		BOOST_CHECK(sorted[0] == b && sorted[1] == a && sorted[2] == c);
+
+		// Keys of compact models are written in order
+		if (compact) {
+
+			std::ostringstream json;
+			json << a;
+			BOOST_CHECK_MESSAGE(json.str() ==
+				"{\"id\":\"a\",\"price\":12.5,\"qty\":7,\"active\":true,\"updated\":\"2024-02-29T12:34:56.789Z\",\"width\":12,\"height\":34}",
+				json.str());
+		}
+	}
+
+	std::cout << std::endl << "End typed dyna model value tests..." << std::endl;
+}
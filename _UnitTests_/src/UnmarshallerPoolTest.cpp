@@ -0,0 +1,211 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <iostream>
+#include <stdlib.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include "DataBinder.h"
+#include "XmlStreamParser.h"
+#include "MessageBusManager.h"
+#include "ServiceConfigManager.h"
+#include "UnmarshallerPool.h"
+
+#include "LoopbackHttpServer.h"
+#include "HttpLoadGenerator.h"
+
+#define HTTP_LOAD_TEST  "./data/http_load_test.xml"
+
+#define POOL_TEST_REQUESTS     40
+#define POOL_TEST_CONCURRENCY  4
+
+
+// Binds the items of an XML or JSON payload to their count
+class PoolTestBinder : public binding::TypedDataBinder<long> {
+
+public:
+	PoolTestBinder() {
+		DataBinder::addEndRule("items/item", endItem);
+	}
+
+	void beginBinding() {
+		this->setRoot(new long(0));
+	}
+
+	static void endItem(void* binder, const char* element, const char* body) {
+
+		GET_BINDER(PoolTestBinder);
+		GET_BINDING_ROOT(count, long);
+
+		(*count)++;
+	}
+};
+
+// XML parser created by a custom factory
+class PoolTestXmlBinder : public parser::XmlBinder {
+
+public:
+	PoolTestXmlBinder() {
+		_created++;
+	}
+
+	static binding::Unmarshaller* create() {
+		return new PoolTestXmlBinder();
+	}
+
+	static int _created;
+};
+
+int PoolTestXmlBinder::_created = 0;
+
+
+long bindItems(mb::UnmarshallerPool& pool, int cntType, binding::DataBinderPtr binder, const char* data, binding::Unmarshaller** parser = NULL) {
+
+	BOOST_REQUIRE(binder->lock());
+
+	mb::UnmarshallerPtr unmarshaller = pool.getUnmarshaller(cntType, binder);
+	if (parser)
+		*parser = unmarshaller.get();
+
+	unmarshaller->parse(data, strlen(data));
+	unmarshaller->parse("", 0);
+
+	boost::shared_ptr<long>* count = (boost::shared_ptr<long> *) unmarshaller->getResult();
+	long items = **count;
+	delete count;
+
+	pool.returnUnmarshaller(cntType, unmarshaller);
+	return items;
+}
+
+BOOST_AUTO_TEST_CASE( unmarshaller_pool_test ) {
+
+	std::cout << std::endl << "Begin unmarshaller pool tests..." << std::endl;
+
+	const char* xml = "<items><item>1</item><item>2</item><item>3</item></items>";
+	const char* json = "{\"items\":{\"item\":[1,2,3,4]}}";
+
+	mb::UnmarshallerPool pool;
+	binding::DataBinderPtr binder(new PoolTestBinder());
+
+	binding::Unmarshaller* first;
+	binding::Unmarshaller* parser;
+
+	// Parsers are reset and reused across documents
+	BOOST_CHECK_EQUAL(bindItems(pool, mb::Message::CNT_XML, binder, xml, &first), 3);
+	BOOST_CHECK_EQUAL(bindItems(pool, mb::Message::CNT_XML, binder, xml, &parser), 3);
+	BOOST_CHECK_MESSAGE(parser == first, "The returned xml parser was not reused.");
+	BOOST_CHECK_EQUAL(pool.getCreatedCount(), 1);
+	BOOST_CHECK_EQUAL(pool.getAllocatedSize(), 0);
+	BOOST_CHECK_EQUAL(pool.getUnallocatedPoolSize(), 1);
+
+	// Each content type has its own pool
+	BOOST_CHECK_EQUAL(bindItems(pool, mb::Message::CNT_JSON, binder, json, &parser), 4);
+	BOOST_CHECK_MESSAGE(parser != first, "A json document was parsed by the xml parser.");
+	BOOST_CHECK_EQUAL(pool.getCreatedCount(), 2);
+
+	// Content types without a factory are parsed as XML
+	BOOST_CHECK_EQUAL(bindItems(pool, mb::Message::CNT_UNKNOWN, binder, xml, &parser), 3);
+	BOOST_CHECK_MESSAGE(parser == first, "The default content type did not use the xml pool.");
+
+	// Parsers in use are not shared
+	{
+		mb::UnmarshallerPtr inUse = pool.getUnmarshaller(mb::Message::CNT_XML, binding::DataBinderPtr(new PoolTestBinder()));
+
+		BOOST_CHECK_EQUAL(bindItems(pool, mb::Message::CNT_XML, binder, xml, &parser), 3);
+		BOOST_CHECK_MESSAGE(parser != inUse.get(), "A parser in use was taken from the pool.");
+		BOOST_CHECK_EQUAL(pool.getAllocatedSize(), 1);
+
+		pool.returnUnmarshaller(mb::Message::CNT_XML, inUse);
+		BOOST_CHECK_EQUAL(pool.getUnallocatedPoolSize(), 3);
+	}
+
+	// A parser that failed mid-document is usable once returned
+	{
+		BOOST_REQUIRE(binder->lock());
+		mb::UnmarshallerPtr unmarshaller = pool.getUnmarshaller(mb::Message::CNT_XML, binder);
+
+		BOOST_CHECK_THROW(unmarshaller->parse("<items><item></items>", 21), CException*);
+		pool.returnUnmarshaller(mb::Message::CNT_XML, unmarshaller);
+
+		for (int i = 0; i < 3; i++)
+			BOOST_CHECK_EQUAL(bindItems(pool, mb::Message::CNT_XML, binder, xml), 3);
+	}
+
+	// Factories plug content type specific parsers into the pool
+	pool.setFactory(mb::Message::CNT_XML, PoolTestXmlBinder::create);
+
+	for (int i = 0; i < 5; i++) {
+
+		BOOST_CHECK_EQUAL(bindItems(pool, mb::Message::CNT_XML, binder, xml, &parser), 3);
+		BOOST_CHECK_MESSAGE(dynamic_cast<PoolTestXmlBinder *>(parser), "The parser was not created by the factory.");
+	}
+
+	BOOST_CHECK_EQUAL(PoolTestXmlBinder::_created, 1);
+
+	std::cout << std::endl << "End unmarshaller pool tests..." << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE( http_unmarshaller_pool_test ) {
+
+	std::cout << std::endl << "Begin HTTP unmarshaller pool tests..." << std::endl;
+
+	LoopbackHttpServer::Config config;
+	config.payloadSize = 16384;
+	config.chunkSize = 2048;
+
+	LoopbackHttpServer server(config);
+	server.start();
+
+	mb::MessageBusManager::initialize();
+	mb::ServiceConfigManager::initialize();
+
+	mb::ServiceConfigManager* manager = mb::ServiceConfigManager::instance();
+	manager->addToken("LOOPBACK_XML_URL", server.getUrl().c_str());
+	manager->addToken("LOOPBACK_JSON_URL", server.getUrl().c_str());
+	manager->loadConfigFile(HTTP_LOAD_TEST);
+
+	// The service may have bound responses of earlier tests
+	mb::NameValueMap metrics;
+	mb::MessageBusManager::instance()->getServiceMetrics("loadTestXml", metrics);
+	long created = atol(metrics["unmarshaller.created"].c_str());
+
+	HttpLoadGenerator generator("loadTestXml", true);
+	generator.run(POOL_TEST_REQUESTS, POOL_TEST_CONCURRENCY);
+
+	BOOST_REQUIRE_EQUAL(generator.getResponseCount(), POOL_TEST_REQUESTS);
+	BOOST_REQUIRE_MESSAGE(generator.getItemCount() > 0, "Responses were not bound.");
+
+	mb::MessageBusManager::instance()->getServiceMetrics("loadTestXml", metrics);
+	created = atol(metrics["unmarshaller.created"].c_str()) - created;
+
+	std::cout << "\t" << created << " parsers created for " << POOL_TEST_REQUESTS << " responses" << std::endl;
+
+	// At most one parser is needed for each response bound concurrently
+	BOOST_CHECK_MESSAGE(created <= POOL_TEST_CONCURRENCY, "Parsers were not reused across responses.");
+	BOOST_CHECK_EQUAL(metrics["unmarshaller.pooled"], metrics["unmarshaller.created"]);
+
+	server.stop();
+
+	std::cout << std::endl << "End HTTP unmarshaller pool tests..." << std::endl;
+}
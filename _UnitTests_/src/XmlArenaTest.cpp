@@ -0,0 +1,232 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+#include <boost/test/unit_test.hpp>
+
+#include "clock.h"
+#include "arena.h"
+#include "exception.h"
+
+#include "DataBinder.h"
+#include "XmlStreamParser.h"
+
+#define ARENA_TEST_ITEMS      2000
+#define ARENA_TEST_DOCUMENTS  50
+#define ARENA_TEST_CHUNK      4096
+
+
+// Binds the items of a document to the sum of their values
+class ArenaTestBinder : public binding::TypedDataBinder<long> {
+
+public:
+	ArenaTestBinder() {
+		DataBinder::addBeginRule("items/item", beginItem);
+		DataBinder::addEndRule("items/item/value", endValue);
+	}
+
+	void beginBinding() {
+		this->setRoot(new long(0));
+	}
+
+	static void beginItem(void* binder, const char* element, const binding::Attributes& attribs) {
+
+		GET_BINDER(ArenaTestBinder);
+
+		// The id is kept in the arena until the document ends
+		dataBinder->lastId = dataBinder->getArena().copy(attribs.get("id", ""));
+	}
+
+	static void endValue(void* binder, const char* element, const char* body) {
+
+		GET_BINDER(ArenaTestBinder);
+		GET_BINDING_ROOT(sum, long);
+
+		if (*dataBinder->lastId)
+			*sum += atol(body);
+	}
+
+	const char* lastId;
+};
+
+std::string createArenaTestDocument(int items) {
+
+	std::ostringstream xml;
+	xml << "<?xml version=\"1.0\" encoding=\"UTF-8\"?><items>";
+
+	for (int i = 0; i < items; i++)
+		xml << "<item id=\"item-" << i << "\" type=\"test\"><name>Item number " << i <<
+			"</name><value>" << (i % 10) << "</value><!-- comment --><empty/></item>";
+
+	xml << "</items>";
+	return xml.str();
+}
+
+long bindArenaTestDocument(parser::XmlBinder& xmlBinder, const std::string& xml, int chunkSize) {
+
+	const char* data = xml.data();
+	int size = (int) xml.length();
+
+	for (int i = 0; i < size; i += chunkSize)
+		xmlBinder.parse(data + i, (size - i < chunkSize ? size - i : chunkSize), false);
+
+	xmlBinder.parse("", 0, true);
+
+	boost::shared_ptr<long>* sum = (boost::shared_ptr<long> *) xmlBinder.getResult();
+	long result = **sum;
+	delete sum;
+
+	xmlBinder.reset();
+	return result;
+}
+
+BOOST_AUTO_TEST_CASE( memory_arena_test ) {
+
+	std::cout << std::endl << "Begin memory arena tests..." << std::endl;
+
+	MemoryArena arena(256);
+
+	char* a = (char *) arena.allocate(10);
+	char* b = (char *) arena.allocate(1);
+	BOOST_CHECK_EQUAL((size_t) a % MemoryArena::ALIGNMENT, 0);
+	BOOST_CHECK_EQUAL((size_t) b % MemoryArena::ALIGNMENT, 0);
+	BOOST_CHECK_EQUAL(b - a, 16);
+
+	// Requests larger than a chunk get a chunk of their own
+	char* large = (char *) arena.allocate(1000);
+	memset(large, 'x', 1000);
+	BOOST_CHECK_EQUAL(arena.getChunkCount(), 2);
+
+	// Allocations continue in a new chunk after a large one
+	BOOST_CHECK_EQUAL(std::string(arena.copy("arena")), "arena");
+	BOOST_CHECK_EQUAL(arena.getAllocationCount(), 4);
+	BOOST_CHECK_EQUAL(arena.getChunkCount(), 3);
+
+	// Chunks are kept and reused in order after a reset
+	arena.reset();
+	BOOST_CHECK_EQUAL(arena.getAllocatedSize(), 0);
+	BOOST_CHECK(arena.allocate(10) == a);
+	BOOST_CHECK(arena.allocate(1000) == large);
+	BOOST_CHECK(arena.allocate(10) != NULL);
+	BOOST_CHECK_EQUAL(arena.getChunkCount(), 3);
+	BOOST_CHECK_EQUAL(arena.getCapacity(), (size_t) 256 + 1008 + 256);
+
+	std::cout << std::endl << "End memory arena tests..." << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE( xml_parser_arena_test ) {
+
+	std::cout << std::endl << "Begin xml parser arena tests..." << std::endl;
+
+	std::string xml = createArenaTestDocument(100);
+
+	binding::DataBinderPtr binder(new ArenaTestBinder());
+	parser::XmlBinder xmlBinder(binder);
+	xmlBinder.initialize();
+
+	parser::XmlParserArena* arena = xmlBinder.getArena();
+	BOOST_REQUIRE_MESSAGE(arena, "The parser does not allocate from an arena.");
+
+	long expected = bindArenaTestDocument(xmlBinder, xml, 64);
+	BOOST_CHECK_EQUAL(expected, 450);
+
+	// Once grown the arena serves every document without the heap
+	long heapAllocations = arena->getHeapAllocationCount();
+
+	for (int i = 0; i < 10; i++)
+		BOOST_CHECK_EQUAL(bindArenaTestDocument(xmlBinder, xml, 64 + i * 100), expected);
+
+	BOOST_CHECK_EQUAL(arena->getHeapAllocationCount(), heapAllocations);
+	BOOST_CHECK_EQUAL(binder->getArena().getChunkCount(), 1);
+
+	// Tokens split across chunks are buffered in blocks too
+	// large for the arena which are allocated from the heap
+	std::string large = "<items><item id=\"" + std::string(100000, 'x') + "\"><value>7</value></item></items>";
+	BOOST_CHECK_EQUAL(bindArenaTestDocument(xmlBinder, large, 4096), 7);
+	BOOST_CHECK_EQUAL(bindArenaTestDocument(xmlBinder, xml, 64), expected);
+
+	// Parsing errors leave the arena usable for the next document
+	binder->lock();
+	BOOST_CHECK_THROW(xmlBinder.parse("<items><item></items>", 21, false), CException*);
+	xmlBinder.reset();
+
+	BOOST_CHECK_EQUAL(bindArenaTestDocument(xmlBinder, xml, 64), expected);
+
+	std::cout << std::endl << "End xml parser arena tests..." << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE( xml_arena_benchmark ) {
+
+	std::cout << std::endl << "Begin xml arena benchmark..." << std::endl;
+
+	std::string xml = createArenaTestDocument(ARENA_TEST_ITEMS);
+	double megabytes = xml.length() * (double) ARENA_TEST_DOCUMENTS / (1024 * 1024);
+
+	long result[2];
+	long long elapsed[2];
+
+	for (int useArena = 0; useArena < 2; useArena++) {
+
+		binding::DataBinderPtr binder(new ArenaTestBinder());
+		parser::XmlBinder xmlBinder(binder);
+		xmlBinder.setUseArena(useArena != 0);
+		xmlBinder.initialize();
+
+		result[useArena] = bindArenaTestDocument(xmlBinder, xml, ARENA_TEST_CHUNK);
+
+		parser::XmlParserArena* arena = xmlBinder.getArena();
+		long allocations = (arena ? arena->getAllocationCount() : 0);
+		long heapAllocations = (arena ? arena->getHeapAllocationCount() : 0);
+
+		long long start = currentTimeMicros();
+
+		for (int i = 0; i < ARENA_TEST_DOCUMENTS; i++)
+			BOOST_REQUIRE_EQUAL(bindArenaTestDocument(xmlBinder, xml, ARENA_TEST_CHUNK), result[useArena]);
+
+		elapsed[useArena] = currentTimeMicros() - start;
+
+		std::cout << "\t" << (useArena ? "arena: " : "heap:  ") << std::fixed << std::setprecision(1) <<
+			megabytes * 1000000.0 / elapsed[useArena] << " MB/s";
+
+		if (arena) {
+
+			allocations = arena->getAllocationCount() - allocations;
+			heapAllocations = arena->getHeapAllocationCount() - heapAllocations;
+
+			std::cout << ", " << (double) allocations / ARENA_TEST_DOCUMENTS << " expat allocations and " <<
+				(double) heapAllocations / ARENA_TEST_DOCUMENTS << " heap allocations per document, " <<
+				arena->getHeapAllocationCount() << " chunks held";
+
+			BOOST_CHECK_MESSAGE(allocations > 0, "Expat did not allocate from the arena.");
+			BOOST_CHECK_MESSAGE(heapAllocations == 0, "Documents were parsed with heap allocations.");
+		}
+
+		std::cout << std::endl;
+	}
+
+	BOOST_CHECK_EQUAL(result[0], result[1]);
+
+	std::cout << std::endl << "End xml arena benchmark..." << std::endl;
+}
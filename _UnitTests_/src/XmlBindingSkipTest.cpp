@@ -0,0 +1,355 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <string.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "clock.h"
+
+#include "XmlStreamParser.h"
+#include "DynaModel.h"
+#include "MessageBusManager.h"
+#include "ServiceConfigManager.h"
+#include "CurlHttpService.h"
+
+#include "LoopbackHttpServer.h"
+
+#define HTTP_BINDING_STOP_TEST  "./data/http_binding_stop_test.xml"
+
+#define SKIP_TEST_ITEMS  2000
+
+// Time within which a response whose binding
+// completed early should have been received
+#define STOP_TIMEOUT  500
+
+using namespace binding;
+using namespace parser;
+
+
+// Binds the document's id, status and item names and
+// counts the elements the parser reported to the binder
+class SkipTestBinder : public DataBinder {
+
+public:
+	SkipTestBinder(bool bindNames) : elements(0) {
+		DataBinder::addEndRule("root/header/id", endId);
+		DataBinder::addEndRule("root/status", endStatus);
+
+		if (bindNames)
+			DataBinder::addEndRule("root/items/item/name", endName);
+	}
+
+	void reset() {
+
+		DataBinder::reset();
+
+		id.clear();
+		status.clear();
+		names.clear();
+		elements = 0;
+	}
+
+	void startElement(const char* name, const char** attribs) {
+
+		elements++;
+		DataBinder::startElement(name, attribs);
+	}
+
+	static void endId(void* binder, const char *element, const char *body) {
+
+		GET_BINDER(SkipTestBinder);
+		dataBinder->id = body;
+	}
+
+	static void endStatus(void* binder, const char *element, const char *body) {
+
+		GET_BINDER(SkipTestBinder);
+		dataBinder->status = body;
+	}
+
+	static void endName(void* binder, const char *element, const char *body) {
+
+		GET_BINDER(SkipTestBinder);
+		dataBinder->names.push_back(body);
+	}
+
+	std::string id;
+	std::string status;
+	std::vector<std::string> names;
+
+	long elements;
+};
+
+// A document whose items contain markup that a scan
+// for the end of an item could be mistaken by
+std::string createSkipTestDocument(const char* declaration = "") {
+
+	std::ostringstream xml;
+
+	xml << declaration << "<root><header><id>42</id></header><items>";
+
+	for (int i = 0; i < SKIP_TEST_ITEMS; i++) {
+
+		xml << "<item id=\"" << i << "\" note='a > b'>"
+			<< "<name>item" << i << "</name>"
+			<< "<desc><![CDATA[</item> ]] ]>]]><!-- </item> - > --><?pi </item>?>"
+			<< "<item nested=\"/>\"><name>nested</name></item><empty/><empty a=\"x\" /></desc>"
+			<< "</item>";
+	}
+
+	xml << "</items><status>ok</status></root>";
+
+	return xml.str();
+}
+
+void bindSkipTestDocument(XmlBinder& xmlBinder, const std::string& xml, int chunkSize, size_t length = std::string::npos) {
+
+	const char* data = xml.data();
+	int size = (int) std::min(length, xml.length());
+
+	for (int i = 0; i < size; i += chunkSize)
+		xmlBinder.parse(data + i, std::min(chunkSize, size - i), false);
+
+	xmlBinder.parse(data, 0, true);
+}
+
+BOOST_AUTO_TEST_CASE( xml_binding_skip_test ) {
+
+	std::cout << std::endl << "Begin XML binding skip tests..." << std::endl;
+
+	std::string xml = createSkipTestDocument();
+	int chunkSizes[] = { 1, 7, 1000, 65536, (int) xml.length() };
+
+	// Fully parsed for reference
+	SkipTestBinder fullBinder(true);
+	XmlBinder fullXmlBinder(&fullBinder);
+	fullXmlBinder.initialize();
+
+	bindSkipTestDocument(fullXmlBinder, xml, 4096);
+
+	BOOST_REQUIRE(fullBinder.id == "42" && fullBinder.status == "ok");
+	BOOST_REQUIRE_EQUAL(fullBinder.names.size(), (size_t) SKIP_TEST_ITEMS);
+
+	long fullElements = fullBinder.elements;
+
+	// Items are skipped when their names are not bound
+	SkipTestBinder binder(false);
+	binder.setSkipUnbound(true);
+
+	XmlBinder xmlBinder(&binder);
+	xmlBinder.initialize();
+
+	for (size_t i = 0; i < sizeof(chunkSizes) / sizeof(int); i++) {
+
+		xmlBinder.reset();
+		bindSkipTestDocument(xmlBinder, xml, chunkSizes[i]);
+
+		std::cout << "Chunks of " << chunkSizes[i] << " bytes: " << binder.elements << " of " << fullElements << " elements parsed" << std::endl;
+
+		BOOST_CHECK_MESSAGE(binder.id == "42" && binder.status == "ok", "Skipping elements changed the bound values.");
+		BOOST_CHECK_MESSAGE(binder.elements < 10, "The unbound items were not skipped.");
+	}
+
+	// Bound elements within skipped elements are still bound
+	SkipTestBinder namesBinder(true);
+	namesBinder.setSkipUnbound(true);
+
+	XmlBinder namesXmlBinder(&namesBinder);
+	namesXmlBinder.initialize();
+
+	for (size_t i = 0; i < sizeof(chunkSizes) / sizeof(int); i++) {
+
+		namesXmlBinder.reset();
+		bindSkipTestDocument(namesXmlBinder, xml, chunkSizes[i]);
+
+		BOOST_CHECK(namesBinder.id == "42" && namesBinder.status == "ok");
+		BOOST_CHECK_MESSAGE(namesBinder.names == fullBinder.names, "Skipping elements changed the bound names.");
+	}
+
+	// Documents not encoded as UTF-8 are parsed in full
+	std::string latin1 = createSkipTestDocument("<?xml version=\"1.0\" encoding=\"ISO-8859-1\"?>");
+
+	xmlBinder.reset();
+	bindSkipTestDocument(xmlBinder, latin1, 1000);
+
+	BOOST_CHECK(binder.id == "42" && binder.status == "ok");
+	BOOST_CHECK_EQUAL(binder.elements, fullElements);
+
+	// Binding once stops the parse after the first name
+	SkipTestBinder onceBinder(true);
+	onceBinder.setSkipUnbound(true);
+	onceBinder.setBindOnce(true);
+
+	XmlBinder onceXmlBinder(&onceBinder);
+	onceXmlBinder.initialize();
+
+	std::string first = fullBinder.names[0];
+
+	// The status precedes the items so that binding completes early
+	std::string statusFirst = "<root><header><id>42</id></header><status>ok</status>" + xml.substr(xml.find("<items>"));
+
+	for (size_t i = 0; i < sizeof(chunkSizes) / sizeof(int); i++) {
+
+		onceXmlBinder.reset();
+
+		// The rest of the document is discarded even if it is truncated
+		bindSkipTestDocument(onceXmlBinder, statusFirst, chunkSizes[i], statusFirst.length() / 2);
+
+		BOOST_CHECK_MESSAGE(onceXmlBinder.isComplete(), "The binding did not complete.");
+		BOOST_CHECK(onceBinder.id == "42" && onceBinder.status == "ok");
+		BOOST_CHECK_MESSAGE(onceBinder.names.size() == 1 && onceBinder.names[0] == first, "A path was bound more than once.");
+		BOOST_CHECK_MESSAGE(onceBinder.elements < 10, "The parse did not stop once the binding was complete.");
+	}
+
+	// Binding modes given by a binding configuration
+	DynaModelBindingConfig config;
+	std::map<std::string, std::string> attribs;
+
+	attribs["skipUnbound"] = "true";
+	attribs["bindOnce"] = "true";
+	config.beginBindingsConfigElement(attribs);
+
+	attribs.clear();
+	attribs["path"] = "root/status";
+	attribs["key"] = "status";
+	config.beginBindingConfigElement(attribs);
+	config.endBindingConfigElement();
+
+	DynaModelBinder modelBinder(&config);
+	XmlBinder modelXmlBinder(&modelBinder);
+	modelXmlBinder.initialize();
+
+	bindSkipTestDocument(modelXmlBinder, xml, 4096);
+
+	BOOST_CHECK_MESSAGE(modelXmlBinder.isComplete(), "The model binding did not complete.");
+
+	DynaModelNode status = modelBinder.getRootPtr()->get("status");
+	BOOST_CHECK(status && status->value() && strcmp(status->value(), "ok") == 0);
+
+	std::cout << std::endl << "End XML binding skip tests..." << std::endl;
+}
+
+
+// Binds the first item of a response only
+class FirstItemBinder : public TypedDataBinder<long> {
+
+public:
+	FirstItemBinder() {
+		DataBinder::addEndRule("items/item", endItem);
+		DataBinder::setBindOnce(true);
+	}
+
+	void beginBinding() {
+		this->setRoot(new long(0));
+	}
+
+	static void endItem(void* binder, const char *element, const char *body) {
+
+		GET_BINDER(FirstItemBinder);
+		GET_BINDING_ROOT(count, long);
+
+		(*count)++;
+	}
+};
+
+struct StopTestResponse {
+
+	StopTestResponse() : received(false) { }
+
+	static void handleResponse(void* context, mb::MessagePtr message) {
+
+		StopTestResponse* result = (StopTestResponse *) context;
+
+		boost::lock_guard<boost::mutex> lock(result->lock);
+		result->response = message;
+		result->received = true;
+		result->done.notify_all();
+	}
+
+	bool wait(long millis) {
+
+		boost::unique_lock<boost::mutex> lock(this->lock);
+		const boost::system_time timeout = boost::get_system_time() + boost::posix_time::milliseconds(millis);
+
+		while (!received)
+			if (!done.timed_wait(lock, timeout))
+				return received;
+
+		return true;
+	}
+
+	boost::mutex lock;
+	boost::condition_variable done;
+
+	mb::MessagePtr response;
+	bool received;
+};
+
+BOOST_AUTO_TEST_CASE( http_binding_stop_test ) {
+
+	std::cout << std::endl << "Begin HTTP binding stop tests..." << std::endl;
+
+	// A response that takes over a second to stream
+	LoopbackHttpServer::Config serverConfig;
+	serverConfig.payloadSize = 65536;
+	serverConfig.chunkSize = 1024;
+	serverConfig.chunkDelay = 20;
+
+	LoopbackHttpServer server(serverConfig);
+	server.start();
+
+	mb::MessageBusManager::initialize();
+	mb::ServiceConfigManager::initialize();
+
+	mb::ServiceConfigManager* configManager = mb::ServiceConfigManager::instance();
+	configManager->addToken("LOOPBACK_STOP_URL", server.getUrl().c_str());
+	configManager->loadConfigFile(HTTP_BINDING_STOP_TEST);
+
+	mb::MessageBusManager* manager = mb::MessageBusManager::instance();
+	StopTestResponse result;
+
+	mb::MessagePtr message = manager->createMessage("bindingStopTestXml");
+	((mb::P2PMessage *) message.get())->setCallback(&result, StopTestResponse::handleResponse);
+	message->setDataBinder(binding::DataBinderPtr(new FirstItemBinder()));
+
+	long long postTime = currentTimeMillis();
+	BOOST_REQUIRE(manager->postMessage(message));
+
+	BOOST_REQUIRE_MESSAGE(result.wait(STOP_TIMEOUT * 10), "No response was received.");
+	std::cout << "Bound response received after " << currentTimeMillis() - postTime << " ms" << std::endl;
+
+	BOOST_CHECK_MESSAGE(currentTimeMillis() - postTime < STOP_TIMEOUT, "The transfer was not stopped once the binding completed.");
+	BOOST_CHECK_MESSAGE(result.response->getError() == mb::Message::ERR_NONE, "A stopped transfer was reported as an error.");
+
+	BOOST_REQUIRE(result.response->getContentType() == mb::Message::CNT_MODEL && result.response->getData());
+	mb::Datum<long> count(result.response);
+	BOOST_CHECK_EQUAL(*count, 1);
+
+	server.stop();
+
+	std::cout << std::endl << "End HTTP binding stop tests..." << std::endl;
+}
@@ -0,0 +1,424 @@
+// The MIT License
+//
+// Copyright (c) 2011 Mevan Samaratunga
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <stdio.h>
+#include <string.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+#include "exception.h"
+
+#include "XmlStreamParser.h"
+#include "XmlInSituParser.h"
+#include "DynaModel.h"
+#include "MessageBusManager.h"
+#include "UnmarshallerPool.h"
+
+#define GENERIC_BINDING_TEST  "./data/generic_binding_test.xml"
+
+#define DOCUMENT_TEST_SUBJECT  "documentTest"
+#define DOCUMENT_TEST_TIMEOUT  5000
+
+using namespace binding;
+using namespace parser;
+
+
+// Records the events reported to the binder
+class RecordingBinder : public DataBinder {
+
+public:
+	void reset() {
+
+		DataBinder::reset();
+		events.str("");
+	}
+
+	void startElement(const char* name, const char** attribs) {
+
+		events << '<' << name;
+		for (int i = 0; attribs[i]; i += 2)
+			events << ' ' << attribs[i] << "=\"" << attribs[i + 1] << '"';
+		events << '>';
+
+		DataBinder::startElement(name, attribs);
+	}
+
+	void endElement(const char* name) {
+
+		events << "</" << name << '>';
+		DataBinder::endElement(name);
+	}
+
+	void characters(const char* text, int len) {
+
+		events.write(text, len);
+		DataBinder::characters(text, len);
+	}
+
+	void startCDataSection() {
+		events << "<![CDATA[";
+	}
+	void endCDataSection() {
+		events << "]]>";
+	}
+
+	std::ostringstream events;
+};
+
+// Binds the items of a document to their count
+class DocumentTestBinder : public TypedDataBinder<long> {
+
+public:
+	DocumentTestBinder() {
+		DataBinder::addEndRule("items/item", endItem);
+	}
+
+	void beginBinding() {
+		this->setRoot(new long(0));
+	}
+
+	static void endItem(void* binder, const char* element, const char* body) {
+
+		GET_BINDER(DocumentTestBinder);
+		GET_BINDING_ROOT(count, long);
+
+		(*count)++;
+	}
+};
+
+// Document parser created by a custom factory
+class CountingDocumentBinder : public XmlDocumentBinder {
+
+public:
+	CountingDocumentBinder() {
+		_created++;
+	}
+
+	void parseDocument(char* buffer, int size) {
+
+		_parsed++;
+		XmlDocumentBinder::parseDocument(buffer, size);
+	}
+
+	static Unmarshaller* create() {
+		return new CountingDocumentBinder();
+	}
+
+	static int _created;
+	static int _parsed;
+};
+
+int CountingDocumentBinder::_created = 0;
+int CountingDocumentBinder::_parsed = 0;
+
+// Responds with a document either as a string
+// or as a stream whose data is sent whole
+class DocumentTestService : public mb::Service {
+
+public:
+	DocumentTestService() : stream(false) { }
+
+	const char* getSubject() {
+		return DOCUMENT_TEST_SUBJECT;
+	}
+
+	void intialize() { }
+	void destroy() { }
+
+	void pause(std::ostream* output = NULL) { }
+	void resume(std::istream* input = NULL) { }
+
+	mb::Message* createMessage() {
+
+		mb::Message* message = new mb::P2PMessage();
+		mb::Service::initMessage(message);
+		return message;
+	}
+
+	void onMessage(mb::MessagePtr message) {
+
+		mb::MessagePtr response;
+		mb::Listener* callback = dynamic_cast<mb::Listener *>(message.get());
+
+		if (stream) {
+
+			response = mb::MessagePtr(new mb::StreamMessage());
+			mb::Service::initMessage(message.get(), response.get(), mb::Message::MSG_RESP_STREAM, mb::Message::CNT_XML);
+
+			mb::MessageBusManager::instance()->postMessage(response, callback);
+
+			((mb::StreamMessage *) response.get())->sendCompleteData(response, (void *) document.data(), document.length());
+			((mb::StreamMessage *) response.get())->sendData(response, NULL, 0);
+
+		} else {
+
+			response = mb::MessagePtr(new mb::StringMessage());
+			mb::Service::initMessage(message.get(), response.get(), mb::Message::MSG_RESP_STRING, mb::Message::CNT_XML);
+			response->setData((void *) document.c_str());
+
+			mb::MessageBusManager::instance()->postMessage(response, callback);
+		}
+	}
+
+	std::string document;
+	bool stream;
+};
+
+struct DocumentTestResponse {
+
+	DocumentTestResponse() : received(false) { }
+
+	static void handleResponse(void* context, mb::MessagePtr message) {
+
+		DocumentTestResponse* result = (DocumentTestResponse *) context;
+
+		boost::lock_guard<boost::mutex> lock(result->lock);
+		result->response = message;
+		result->received = true;
+		result->done.notify_all();
+	}
+
+	bool wait(long millis) {
+
+		boost::unique_lock<boost::mutex> lock(this->lock);
+		const boost::system_time timeout = boost::get_system_time() + boost::posix_time::milliseconds(millis);
+
+		while (!received)
+			if (!done.timed_wait(lock, timeout))
+				return received;
+
+		return true;
+	}
+
+	boost::mutex lock;
+	boost::condition_variable done;
+
+	mb::MessagePtr response;
+	bool received;
+};
+
+
+std::string streamEvents(const std::string& document) {
+
+	RecordingBinder binder;
+	XmlBinder xmlBinder(&binder);
+	xmlBinder.initialize();
+
+	xmlBinder.parse(document.data(), (int) document.length(), true);
+	return binder.events.str();
+}
+
+std::string inSituEvents(const std::string& document) {
+
+	RecordingBinder binder;
+	XmlDocumentBinder documentBinder(&binder);
+	documentBinder.initialize();
+
+	std::string buffer = document;
+	documentBinder.parseDocument(&buffer[0], (int) buffer.length());
+	return binder.events.str();
+}
+
+void checkSameEvents(const std::string& document) {
+
+	std::string expected = streamEvents(document);
+	std::string events = inSituEvents(document);
+
+	BOOST_CHECK_MESSAGE(events == expected, "In place parse of " << document << " reported " << events << " instead of " << expected);
+}
+
+std::string bindDocument(Unmarshaller& unmarshaller, DynaModelBinder& dynaBinder, const std::string& document) {
+
+	std::string buffer = document;
+	unmarshaller.parseDocument(&buffer[0], (int) buffer.length());
+
+	std::ostringstream output;
+	output << dynaBinder.getRootPtr();
+
+	unmarshaller.reset();
+	return output.str();
+}
+
+// Shared with the JSON parser tests
+std::string readFile(const char* path);
+void addGenericBindings(DynaModelBinder& dynaBinder);
+
+long postDocument(mb::MessageBusManager* manager) {
+
+	DocumentTestResponse result;
+
+	mb::MessagePtr message = manager->createMessage(DOCUMENT_TEST_SUBJECT);
+	((mb::P2PMessage *) message.get())->setCallback(&result, DocumentTestResponse::handleResponse);
+	message->setDataBinder(DataBinderPtr(new DocumentTestBinder()));
+
+	BOOST_REQUIRE(manager->postMessage(message));
+	BOOST_REQUIRE_MESSAGE(result.wait(DOCUMENT_TEST_TIMEOUT), "No response was received for the document.");
+	BOOST_REQUIRE_MESSAGE(result.response->getError() == mb::Message::ERR_NONE, result.response->getErrorDescription());
+	BOOST_REQUIRE(result.response->getContentType() == mb::Message::CNT_MODEL);
+
+	mb::Datum<long> count(result.response);
+	return *count;
+}
+
+BOOST_AUTO_TEST_CASE( xml_in_situ_parser_test ) {
+
+	std::cout << std::endl << "Begin in-situ XML parser tests..." << std::endl;
+
+	// Documents parsed in place report the same events as expat
+	checkSameEvents("<a>b</a>");
+	checkSameEvents("\xEF\xBB\xBF<a>b</a>");
+	checkSameEvents("<a><b><c/></b>text<d e=\"f\"></d><g h='i' j = \"k\" /></a>");
+	checkSameEvents("<x:a xmlns:x=\"urn:x\"><x:b>1</x:b></x:a>");
+
+	checkSameEvents(
+		"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<!-- comment -->\n"
+		"<root a=\"1\" b='two'>\r\n"
+		"  <item id=\"x&amp;y\" note=\"a&#9;b\tc\nd\r\ne\">Tom &amp; Jerry &lt;3 &#169; &#x1F600; &gt;</item>\n"
+		"  <empty/><empty2 x=\"1\" />\n"
+		"  <![CDATA[<raw> & \r\nstuff]]><![CDATA[]]>\n"
+		"  <?pi data?><!-- <a> -->\n"
+		"  <n>caf\xC3\xA9 &quot;q&quot; &apos;s&apos;</n>\r"
+		"</root>\n<!-- trailing -->\n<?pi?>\n" );
+
+	// Documents that are not well-formed
+	const char* malformed[] = {
+		"", "   ", "text", "<a>", "<a", "<a><b></a>", "<a></a><b/>", "<a></a>text",
+		"<a>&foo;</a>", "<a>&#0;</a>", "<a>&#xD800;</a>", "<a>&amp</a>", "<a x='1' x='2'/>",
+		"<a x=1/>", "<a x='1'y='2'/>", "<a x='<'/>", "<a><![CDATA[x</a>", "<a><!-- x</a>",
+		"</a>", "<a></b>", "<a/ >", "<1a/>", NULL
+	};
+
+	for (int i = 0; malformed[i]; i++) {
+
+		BOOST_CHECK_THROW(streamEvents(malformed[i]), CException*);
+		BOOST_CHECK_THROW(inSituEvents(malformed[i]), CException*);
+	}
+
+	// Documents with a type declaration or in other encodings are left to expat
+	std::string doctype = "<?xml version=\"1.0\"?>\n<!DOCTYPE a [<!ENTITY e \"entity\">]>\n<a>&e;</a>";
+	std::string latin1 = "<?xml version=\"1.0\" encoding=\"ISO-8859-1\"?><a b=\"\xE9\">caf\xE9</a>";
+	std::string utf16("\xFF\xFE<\0a\0/\0>\0", 10);
+
+	BOOST_CHECK(!XmlInSituParser::canParseInSitu(doctype.data(), (int) doctype.length()));
+	BOOST_CHECK(!XmlInSituParser::canParseInSitu(latin1.data(), (int) latin1.length()));
+	BOOST_CHECK(!XmlInSituParser::canParseInSitu(utf16.data(), (int) utf16.length()));
+	BOOST_CHECK(XmlInSituParser::canParseInSitu("<?xml version='1.0' encoding='utf-8'?><a/>", 42));
+
+	checkSameEvents(doctype);
+	checkSameEvents(latin1);
+	checkSameEvents(utf16);
+
+	// Generic binding of a document with and without skipping unbound elements
+	std::string document = readFile(GENERIC_BINDING_TEST);
+
+	for (int skip = 0; skip < 2; skip++) {
+
+		DynaModelBinder dynaBinder;
+		addGenericBindings(dynaBinder);
+		dynaBinder.setSkipUnbound(skip == 1);
+
+		XmlBinder xmlBinder(&dynaBinder);
+		xmlBinder.initialize();
+		XmlDocumentBinder documentBinder(&dynaBinder);
+		documentBinder.initialize();
+
+		std::string expected = bindDocument(xmlBinder, dynaBinder, document);
+		std::string bound = bindDocument(documentBinder, dynaBinder, document);
+
+		BOOST_CHECK_MESSAGE(expected.length() > 0, "The generic document was not bound.");
+		BOOST_CHECK_MESSAGE(bound == expected, "The document bound in place differs from the document bound by expat.");
+
+		// Chunks given to the document binder are collected until the last
+		documentBinder.parse(document.data(), (int) document.length() / 2, false);
+		documentBinder.parse(document.data() + document.length() / 2, (int) (document.length() - document.length() / 2), false);
+		documentBinder.parse("", 0, true);
+
+		std::ostringstream chunked;
+		chunked << dynaBinder.getRootPtr();
+		documentBinder.reset();
+
+		BOOST_CHECK_MESSAGE(chunked.str() == expected, "The document bound from chunks differs from the document bound by expat.");
+	}
+
+	std::cout << std::endl << "End in-situ XML parser tests..." << std::endl;
+}
+
+BOOST_AUTO_TEST_CASE( xml_document_binding_test ) {
+
+	std::cout << std::endl << "Begin XML document binding tests..." << std::endl;
+
+	mb::MessageBusManager::initialize();
+	mb::MessageBusManager* manager = mb::MessageBusManager::instance();
+
+	// The pool parses whole documents in place and falls back to the
+	// unmarshallers of the content type if it has no document factory
+	{
+		mb::UnmarshallerPool pool;
+		DataBinderPtr binder(new DocumentTestBinder());
+
+		mb::UnmarshallerPtr document = pool.getUnmarshaller(mb::Message::CNT_XML, binder, true);
+		BOOST_CHECK_MESSAGE(dynamic_cast<XmlDocumentBinder *>(document.get()), "Whole XML documents are not parsed in place.");
+		pool.returnUnmarshaller(mb::Message::CNT_XML, document, true);
+
+		mb::UnmarshallerPtr json = pool.getUnmarshaller(mb::Message::CNT_JSON, binder, true);
+		BOOST_CHECK_MESSAGE(!dynamic_cast<XmlDocumentBinder *>(json.get()), "A whole JSON document was parsed as XML.");
+		pool.returnUnmarshaller(mb::Message::CNT_JSON, json, true);
+
+		mb::UnmarshallerPtr unknown = pool.getUnmarshaller(mb::Message::CNT_UNKNOWN, binder, true);
+		BOOST_CHECK_MESSAGE(unknown.get() == document.get(), "Whole documents of unknown type were not parsed as XML.");
+		pool.returnUnmarshaller(mb::Message::CNT_UNKNOWN, unknown, true);
+
+		BOOST_CHECK_EQUAL(pool.getCreatedCount(), 2);
+		BOOST_CHECK_EQUAL(pool.getUnallocatedPoolSize(), 2);
+	}
+
+	DocumentTestService service;
+	manager->registerService(&service);
+	service.getUnmarshallerPool()->setDocumentFactory(mb::Message::CNT_XML, CountingDocumentBinder::create);
+
+	service.document = "<?xml version=\"1.0\"?>\r\n<items><item>1</item><item>&#50;</item><item><![CDATA[3]]></item></items>";
+
+	// String responses are parsed in place
+	BOOST_CHECK_EQUAL(postDocument(manager), 3);
+	BOOST_CHECK_EQUAL(CountingDocumentBinder::_parsed, 1);
+
+	// Stream data sent whole is parsed as a document
+	service.stream = true;
+
+	BOOST_CHECK_EQUAL(postDocument(manager), 3);
+	BOOST_CHECK_EQUAL(postDocument(manager), 3);
+	BOOST_CHECK_EQUAL(CountingDocumentBinder::_created, 1);
+
+	// A document in another encoding is bound by expat
+	service.stream = false;
+	service.document = "<?xml version=\"1.0\" encoding=\"ISO-8859-1\"?><items><item>\xE9</item></items>";
+
+	BOOST_CHECK_EQUAL(postDocument(manager), 1);
+	BOOST_CHECK_EQUAL(CountingDocumentBinder::_created, 1);
+
+	manager->unregisterService(&service);
+
+	std::cout << std::endl << "End XML document binding tests..." << std::endl;
+}